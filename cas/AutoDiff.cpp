@@ -0,0 +1,225 @@
+#include "AutoDiff.h"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+
+// Local derivative rules shared by both modes: the result of one operation
+// and its partials with respect to each operand
+
+struct UnaryStep {
+    double value;
+    double slope;   // d value / d operand
+};
+
+struct BinaryStep {
+    double value;
+    double slopeLeft;
+    double slopeRight;
+};
+
+UnaryStep unaryStep(SymbolicUnaryOp::OpType op, double u) {
+    switch (op) {
+        case SymbolicUnaryOp::OpType::POSITIVE: return {u, 1};
+        case SymbolicUnaryOp::OpType::NEGATIVE: return {-u, -1};
+        case SymbolicUnaryOp::OpType::SIN: return {std::sin(u), std::cos(u)};
+        case SymbolicUnaryOp::OpType::COS: return {std::cos(u), -std::sin(u)};
+        case SymbolicUnaryOp::OpType::TAN: {
+            double c = std::cos(u);
+            return {std::tan(u), 1 / (c * c)};
+        }
+        case SymbolicUnaryOp::OpType::LOG:
+            if (u <= 0) throw std::runtime_error("Log of non-positive number");
+            return {std::log10(u), 1 / (u * std::log(10.0))};
+        case SymbolicUnaryOp::OpType::LN:
+            if (u <= 0) throw std::runtime_error("Natural log of non-positive number");
+            return {std::log(u), 1 / u};
+        case SymbolicUnaryOp::OpType::SQRT: {
+            if (u < 0) throw std::runtime_error("Square root of negative number");
+            double root = std::sqrt(u);
+            return {root, 0.5 / root};
+        }
+        case SymbolicUnaryOp::OpType::ABS: return {std::abs(u), u > 0 ? 1.0 : (u < 0 ? -1.0 : 0.0)};
+    }
+    throw std::runtime_error("Unknown unary operation");
+}
+
+// Builtins and registered single-argument functions; the registry's slope
+// of a registered function is a central difference of its kernel
+UnaryStep functionStep(const SymbolicFunction& func, double u) {
+    double value = FunctionRegistry::call(func.functionId, &u, nullptr);
+    return {value, FunctionRegistry::slope(func.functionId, &u, 0)};
+}
+
+const SymbolicExpression& functionArgument(const SymbolicFunction& func) {
+    if (func.functionId != FunctionRegistry::kUnknown && FunctionRegistry::arity(func.functionId) != 1) {
+        throw std::runtime_error("Automatic differentiation not implemented for multi-argument functions");
+    }
+    FunctionRegistry::checkCall(func.functionId, func.functionName, func.arguments.size());
+    return *func.arguments[0];
+}
+
+// slopeRight of a power is only used when the exponent actually varies;
+// callers skip it otherwise so u <= 0 with a constant exponent stays finite
+BinaryStep binaryStep(SymbolicBinaryOp::OpType op, double a, double b) {
+    switch (op) {
+        case SymbolicBinaryOp::OpType::ADD: return {a + b, 1, 1};
+        case SymbolicBinaryOp::OpType::SUBTRACT: return {a - b, 1, -1};
+        case SymbolicBinaryOp::OpType::MULTIPLY: return {a * b, b, a};
+        case SymbolicBinaryOp::OpType::DIVIDE:
+            if (b == 0) throw std::runtime_error("Division by zero");
+            return {a / b, 1 / b, -a / (b * b)};
+        case SymbolicBinaryOp::OpType::POWER: {
+            double value = std::pow(a, b);
+            return {value, b * std::pow(a, b - 1), value * std::log(a)};
+        }
+    }
+    throw std::runtime_error("Unknown binary operation");
+}
+
+double lookup(const std::map<std::string, double>& variables, const std::string& name) {
+    auto it = variables.find(name);
+    if (it == variables.end()) {
+        throw std::runtime_error("Undefined variable: " + name);
+    }
+    return it->second;
+}
+
+// Forward mode: (value, tangent) pairs; a zero tangent marks an operand that
+// does not depend on the variable, and its slope is never multiplied in
+struct DualEvaluator {
+    const std::map<std::string, double>& variables;
+    const std::string& variable;
+
+    DualValue operator()(const SymbolicNumber& num) const { return {num.value, 0}; }
+
+    DualValue operator()(const SymbolicVariable& var) const {
+        return {lookup(variables, var.name), var.name == variable ? 1.0 : 0.0};
+    }
+
+    DualValue operator()(const SymbolicBinaryOp& op) const {
+        DualValue a = visitSymbolic(*op.left, *this);
+        DualValue b = visitSymbolic(*op.right, *this);
+        BinaryStep step = binaryStep(op.op, a.value, b.value);
+        double derivative = 0;
+        if (a.derivative != 0) derivative += step.slopeLeft * a.derivative;
+        if (b.derivative != 0) derivative += step.slopeRight * b.derivative;
+        return {step.value, derivative};
+    }
+
+    DualValue operator()(const SymbolicUnaryOp& op) const {
+        DualValue u = visitSymbolic(*op.operand, *this);
+        UnaryStep step = unaryStep(op.op, u.value);
+        return {step.value, u.derivative != 0 ? step.slope * u.derivative : 0};
+    }
+
+    DualValue operator()(const SymbolicFunction& func) const {
+        DualValue u = visitSymbolic(functionArgument(func), *this);
+        UnaryStep step = functionStep(func, u.value);
+        return {step.value, u.derivative != 0 ? step.slope * u.derivative : 0};
+    }
+};
+
+// Reverse mode: one tape entry per node, operands always recorded first.
+// Entries that depend on no wrt variable are inactive and never receive
+// adjoints, which keeps slopes into constant subtrees (e.g. the ln of a
+// negative base under a constant exponent) out of the result.
+struct TapeEntry {
+    double value;
+    uint32_t operands[2];
+    double slopes[2];
+    uint8_t operandCount;
+    bool active;
+    int32_t variable;   // index into wrt for variable leaves, else -1
+};
+
+struct TapeRecorder {
+    const std::map<std::string, double>& variables;
+    const std::vector<std::string>& wrt;
+    std::vector<TapeEntry>& tape;
+
+    uint32_t record(double value, bool active, int32_t variable = -1) {
+        tape.push_back(TapeEntry{value, {0, 0}, {0, 0}, 0, active, variable});
+        return static_cast<uint32_t>(tape.size() - 1);
+    }
+
+    uint32_t operator()(const SymbolicNumber& num) { return record(num.value, false); }
+
+    uint32_t operator()(const SymbolicVariable& var) {
+        double value = lookup(variables, var.name);
+        for (size_t i = 0; i < wrt.size(); ++i) {
+            if (wrt[i] == var.name) return record(value, true, static_cast<int32_t>(i));
+        }
+        return record(value, false);
+    }
+
+    uint32_t operator()(const SymbolicBinaryOp& op) {
+        uint32_t a = visitSymbolic(*op.left, *this);
+        uint32_t b = visitSymbolic(*op.right, *this);
+        BinaryStep step = binaryStep(op.op, tape[a].value, tape[b].value);
+        uint32_t index = record(step.value, tape[a].active || tape[b].active);
+        tape[index].operands[0] = a;
+        tape[index].operands[1] = b;
+        tape[index].slopes[0] = step.slopeLeft;
+        tape[index].slopes[1] = step.slopeRight;
+        tape[index].operandCount = 2;
+        return index;
+    }
+
+    uint32_t unary(uint32_t operand, const UnaryStep& step) {
+        uint32_t index = record(step.value, tape[operand].active);
+        tape[index].operands[0] = operand;
+        tape[index].slopes[0] = step.slope;
+        tape[index].operandCount = 1;
+        return index;
+    }
+
+    uint32_t operator()(const SymbolicUnaryOp& op) {
+        uint32_t operand = visitSymbolic(*op.operand, *this);
+        return unary(operand, unaryStep(op.op, tape[operand].value));
+    }
+
+    uint32_t operator()(const SymbolicFunction& func) {
+        uint32_t operand = visitSymbolic(functionArgument(func), *this);
+        return unary(operand, functionStep(func, tape[operand].value));
+    }
+};
+
+} // namespace
+
+DualValue AutoDiff::derivative(const SymbolicExpression& expr, const std::map<std::string, double>& variables,
+                               const std::string& variable) {
+    return visitSymbolic(expr, DualEvaluator{variables, variable});
+}
+
+GradientValue AutoDiff::gradient(const SymbolicExpression& expr, const std::map<std::string, double>& variables,
+                                 const std::vector<std::string>& wrt) {
+    GradientValue result;
+    if (wrt.empty()) {
+        for (const auto& binding : variables) result.variables.push_back(binding.first);
+    } else {
+        result.variables = wrt;
+    }
+    result.partials.assign(result.variables.size(), 0.0);
+
+    std::vector<TapeEntry> tape;
+    uint32_t output = visitSymbolic(expr, TapeRecorder{variables, result.variables, tape});
+    result.value = tape[output].value;
+
+    std::vector<double> adjoints(tape.size(), 0.0);
+    adjoints[output] = 1;
+    for (size_t i = tape.size(); i-- > 0;) {
+        const TapeEntry& entry = tape[i];
+        if (!entry.active || adjoints[i] == 0) continue;
+        if (entry.variable >= 0) {
+            result.partials[entry.variable] += adjoints[i];
+        }
+        for (uint8_t k = 0; k < entry.operandCount; ++k) {
+            if (tape[entry.operands[k]].active) {
+                adjoints[entry.operands[k]] += entry.slopes[k] * adjoints[i];
+            }
+        }
+    }
+    return result;
+}
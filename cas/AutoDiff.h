@@ -0,0 +1,47 @@
+#ifndef AUTO_DIFF_H
+#define AUTO_DIFF_H
+
+#include "SymbolicEngine.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// Value of an expression and its derivative along one variable
+struct DualValue {
+    double value = 0;
+    double derivative = 0;
+};
+
+// Value and partial derivatives; partials[i] belongs to variables[i]
+struct GradientValue {
+    double value = 0;
+    std::vector<std::string> variables;
+    std::vector<double> partials;
+};
+
+// AutoDiff - numeric derivatives straight from a SymbolicExpression tree,
+// without building a derivative tree first.
+//
+// derivative() carries dual numbers (value, tangent) up the tree in a single
+// pass; gradient() records the same pass on a tape and sweeps it backwards
+// once (reverse mode), so a gradient over any number of variables costs about
+// two evaluations. Values are computed exactly as SymbolicExpression::evaluate
+// would and errors (undefined variable, division by zero, log/sqrt domain,
+// unknown function) throw the same messages. Unlike symbolic differentiate,
+// variable exponents are supported: d(u^v) = u^v (v' ln u + v u'/u), falling
+// back to the power rule when v is locally constant. Points where a
+// derivative does not exist (sqrt at 0, u^v with u <= 0 and varying v) give
+// inf or NaN rather than throwing.
+class AutoDiff {
+public:
+    // f and df/dvariable at variables
+    static DualValue derivative(const SymbolicExpression& expr, const std::map<std::string, double>& variables,
+                                const std::string& variable);
+
+    // f and its partials with respect to each of wrt (every bound variable, in
+    // map order, when wrt is empty)
+    static GradientValue gradient(const SymbolicExpression& expr, const std::map<std::string, double>& variables,
+                                  const std::vector<std::string>& wrt = {});
+};
+
+#endif // AUTO_DIFF_H
@@ -0,0 +1,138 @@
+#include "Expression.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const ParsedExpression& require(const std::shared_ptr<const ParsedExpression>& data) {
+    if (!data) {
+        throw std::runtime_error("Empty expression");
+    }
+    return *data;
+}
+
+} // namespace
+
+Expression Expression::parse(std::string_view text) {
+    std::string error;
+    std::shared_ptr<const ParsedExpression> parsed = ExpressionCache::shared().get(text, &error);
+    if (!parsed) {
+        throw std::runtime_error(error);
+    }
+    return Expression(std::move(parsed));
+}
+
+bool Expression::tryParse(std::string_view text, Expression& out, std::string* error) {
+    try {
+        std::shared_ptr<const ParsedExpression> parsed = ExpressionCache::shared().get(text, error);
+        if (!parsed) {
+            return false;
+        }
+        out = Expression(std::move(parsed));
+        return true;
+    } catch (const std::exception& e) {
+        if (error) *error = e.what();
+        return false;
+    }
+}
+
+Expression Expression::fromSymbolic(std::unique_ptr<SymbolicExpression> expr) {
+    if (!expr) {
+        throw std::runtime_error("Null symbolic expression");
+    }
+    auto parsed = std::make_shared<ParsedExpression>();
+    parsed->text = expr->toString();
+    try {
+        expr->compile(parsed->program);
+    } catch (const std::exception&) {
+        parsed->program = CompiledExpression();
+    }
+    parsed->symbolic = std::move(expr);
+    parsed->bytes = ExpressionCache::footprint(*parsed);
+    return Expression(std::move(parsed));
+}
+
+double Expression::evaluate(const std::map<std::string, double>& variables) const {
+    const ParsedExpression& parsed = require(data);
+    if (parsed.program.empty()) {
+        return parsed.symbolic->evaluate(variables);
+    }
+    return parsed.program.evaluate(variables);
+}
+
+double Expression::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    const ParsedExpression& parsed = require(data);
+    if (!parsed.program.empty()) {
+        return parsed.program.evaluate(variables, status);
+    }
+    try {
+        return parsed.symbolic->evaluate(variables);
+    } catch (const std::exception&) {
+        // Only programs the compiler rejected (unknown functions) get here,
+        // and the tree evaluator reports failures by throwing
+        recordStatus(status, EvalStatus::UNKNOWN_FUNCTION);
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+void Expression::evaluateBatch(const double* xs, double* out, size_t n, const std::string& variable) const {
+    const ParsedExpression& parsed = require(data);
+    const CompiledExpression& program = parsed.program;
+    if (program.empty()) {
+        std::map<std::string, double> vars;
+        for (size_t i = 0; i < n; ++i) {
+            vars[variable] = xs[i];
+            try {
+                out[i] = parsed.symbolic->evaluate(vars);
+            } catch (const std::exception&) {
+                out[i] = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+        return;
+    }
+
+    for (const auto& name : program.getSlotNames()) {
+        if (name != variable) {
+            throw std::runtime_error("Undefined variable: " + name);
+        }
+    }
+    program.evalBatch(&xs, out, n);
+}
+
+Expression Expression::differentiate(const std::string& variable) const {
+    return fromSymbolic(require(data).symbolic->differentiate(variable));
+}
+
+DualValue Expression::derivativeAt(const std::map<std::string, double>& variables, const std::string& variable) const {
+    return AutoDiff::derivative(*require(data).symbolic, variables, variable);
+}
+
+GradientValue Expression::gradientAt(const std::map<std::string, double>& variables,
+                                     const std::vector<std::string>& wrt) const {
+    return AutoDiff::gradient(*require(data).symbolic, variables, wrt);
+}
+
+const SymbolicExpression& Expression::symbolic() const {
+    return *require(data).symbolic;
+}
+
+std::shared_ptr<const SymbolicExpression> Expression::sharedSymbolic() const {
+    return require(data).symbolic;
+}
+
+const CompiledExpression& Expression::program() const {
+    return require(data).program;
+}
+
+const ASTNode* Expression::ast() const {
+    return require(data).ast.get();
+}
+
+const std::string& Expression::text() const {
+    return require(data).text;
+}
+
+std::string Expression::toString() const {
+    return require(data).symbolic->toString();
+}
@@ -0,0 +1,70 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "AutoDiff.h"
+#include "ExpressionCache.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Expression - immutable, reference-counted handle to a parsed formula.
+//
+// Copies share one ParsedExpression (AST, symbolic tree and bytecode), so
+// handing a formula to N threads costs N reference counts rather than N deep
+// clones. Nothing reachable from a handle is ever modified, which makes
+// every const member safe to call concurrently without locks. Mutable work
+// (memoized calculus, simplification) stays in SymbolicEngine, which can
+// load a handle with parseFromExpression().
+class Expression {
+private:
+    std::shared_ptr<const ParsedExpression> data;
+
+    explicit Expression(std::shared_ptr<const ParsedExpression> parsed) : data(std::move(parsed)) {}
+
+public:
+    // Empty handle; everything but valid() throws
+    Expression() = default;
+
+    // Parse through ExpressionCache::shared(); throws std::runtime_error with
+    // the parser's message on a syntax error
+    static Expression parse(std::string_view text);
+
+    // Non-throwing parse; leaves out untouched and fills *error on failure
+    static bool tryParse(std::string_view text, Expression& out, std::string* error = nullptr);
+
+    // Handle over a symbolic tree built elsewhere (no AST)
+    static Expression fromSymbolic(std::unique_ptr<SymbolicExpression> expr);
+
+    bool valid() const { return data != nullptr; }
+    long useCount() const { return data.use_count(); }
+
+    // Evaluation through the bytecode, or the symbolic tree when the
+    // expression could not be compiled; throws on domain errors
+    double evaluate(const std::map<std::string, double>& variables = {}) const;
+
+    // Status mode: NaN plus a status instead of an exception
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const;
+
+    // n values of a single variable in one pass; NaN where undefined. Throws
+    // if the expression uses any other variable.
+    void evaluateBatch(const double* xs, double* out, size_t n, const std::string& variable = "x") const;
+
+    // New handle for the derivative (symbolic tree rules, not simplified)
+    Expression differentiate(const std::string& variable) const;
+
+    // Derivative values without building a derivative tree (see AutoDiff)
+    DualValue derivativeAt(const std::map<std::string, double>& variables, const std::string& variable) const;
+    GradientValue gradientAt(const std::map<std::string, double>& variables,
+                             const std::vector<std::string>& wrt = {}) const;
+
+    // Shared parts; valid for as long as any copy of the handle lives
+    const SymbolicExpression& symbolic() const;
+    std::shared_ptr<const SymbolicExpression> sharedSymbolic() const;
+    const CompiledExpression& program() const;
+    const ASTNode* ast() const;
+    const std::string& text() const;
+    std::string toString() const;
+};
+
+#endif // EXPRESSION_H
@@ -0,0 +1,117 @@
+#include "ExpressionCache.h"
+#include "../evaluator/FunctionRegistry.h"
+#include <cctype>
+
+namespace {
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+size_t stringBytes(const std::string& text) {
+    // Short strings live inside the object
+    return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+struct ASTBytes {
+    size_t operator()(const NumberNode&) const { return sizeof(NumberNode); }
+    size_t operator()(const VariableNode& node) const { return sizeof(VariableNode) + stringBytes(node.name); }
+    size_t operator()(const BinaryOpNode& node) const {
+        return sizeof(BinaryOpNode) + visitAST(*node.left, *this) + visitAST(*node.right, *this);
+    }
+    size_t operator()(const UnaryOpNode& node) const { return sizeof(UnaryOpNode) + visitAST(*node.operand, *this); }
+    size_t operator()(const FunctionNode& node) const {
+        size_t total = sizeof(FunctionNode) + stringBytes(node.functionName) +
+                       node.arguments.capacity() * sizeof(node.arguments[0]);
+        for (const auto& arg : node.arguments) total += visitAST(*arg, *this);
+        return total;
+    }
+};
+
+struct SymbolicBytes {
+    size_t operator()(const SymbolicNumber&) const { return sizeof(SymbolicNumber); }
+    size_t operator()(const SymbolicVariable& var) const { return sizeof(SymbolicVariable) + stringBytes(var.name); }
+    size_t operator()(const SymbolicBinaryOp& op) const {
+        return sizeof(SymbolicBinaryOp) + visitSymbolic(*op.left, *this) + visitSymbolic(*op.right, *this);
+    }
+    size_t operator()(const SymbolicUnaryOp& op) const {
+        return sizeof(SymbolicUnaryOp) + visitSymbolic(*op.operand, *this);
+    }
+    size_t operator()(const SymbolicFunction& func) const {
+        size_t total = sizeof(SymbolicFunction) + stringBytes(func.functionName) +
+                       func.arguments.capacity() * sizeof(func.arguments[0]);
+        for (const auto& arg : func.arguments) total += visitSymbolic(*arg, *this);
+        return total;
+    }
+};
+
+size_t programBytes(const CompiledExpression& program) {
+    size_t total = program.getCode().capacity() * sizeof(Instruction);
+    for (const auto& name : program.getSlotNames()) total += sizeof(name) + stringBytes(name);
+    return total;
+}
+
+} // namespace
+
+ExpressionCache::ExpressionCache(size_t maxEntries, size_t maxBytes) : cache(maxEntries, maxBytes) {}
+
+std::string ExpressionCache::normalize(std::string_view text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+    bool pendingSpace = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = true;
+            continue;
+        }
+        if (pendingSpace && !normalized.empty() && isWordChar(normalized.back()) && isWordChar(c)) {
+            normalized += ' ';
+        }
+        pendingSpace = false;
+        normalized += c;
+    }
+    return normalized;
+}
+
+std::shared_ptr<const ParsedExpression> ExpressionCache::get(std::string_view text, std::string* error) {
+    // Registering a function changes how a text parses (g(x) becomes a call
+    // instead of g * x), so entries are keyed by the registry size as well
+    std::string normalized = normalize(text);
+    std::string key = normalized + '\n' + std::to_string(FunctionRegistry::size());
+    if (auto cached = cache.find(key)) {
+        return cached;
+    }
+
+    // Parse the caller's text so error positions refer to it
+    ExpressionParser parser;
+    if (!parser.parse(text)) {
+        if (error) *error = parser.getError();
+        return nullptr;
+    }
+
+    auto parsed = std::make_shared<ParsedExpression>();
+    parsed->symbolic = SymbolicEngine::convertASTToSymbolic(parser.getAST());
+    parsed->ast = parser.cloneAST();
+    try {
+        parsed->program = parser.compile();
+    } catch (const std::exception&) {
+        // Leave the program empty; callers fall back to the symbolic form
+    }
+    parsed->text = std::move(normalized);
+    parsed->bytes = footprint(*parsed);
+
+    size_t bytes = parsed->bytes;
+    return cache.insert(key, std::move(parsed), bytes);
+}
+
+size_t ExpressionCache::footprint(const ParsedExpression& parsed) {
+    size_t total = sizeof(ParsedExpression) + stringBytes(parsed.text) + programBytes(parsed.program);
+    if (parsed.ast) total += visitAST(*parsed.ast, ASTBytes{});
+    if (parsed.symbolic) total += visitSymbolic(*parsed.symbolic, SymbolicBytes{});
+    return total;
+}
+
+ExpressionCache& ExpressionCache::shared() {
+    static ExpressionCache cache;
+    return cache;
+}
@@ -0,0 +1,53 @@
+#ifndef EXPRESSION_CACHE_H
+#define EXPRESSION_CACHE_H
+
+#include "SymbolicEngine.h"
+#include "../util/LruCache.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Everything derived from one expression text without per-caller state.
+// Immutable once built, so it can be shared freely between threads.
+struct ParsedExpression {
+    std::string text;                                   // normalized source
+    std::unique_ptr<const ASTNode> ast;                 // null when built from a symbolic tree
+    std::shared_ptr<const SymbolicExpression> symbolic;
+    CompiledExpression program;                         // slots in order of first use; empty if compile failed
+    size_t bytes = 0;                                   // approximate heap footprint
+};
+
+// ExpressionCache - bounded LRU map from normalized expression text to its
+// ParsedExpression, so repeated formulas skip lexing, parsing and AST
+// conversion. Texts that fail to parse are not cached. Entries parsed
+// before a FunctionRegistry::add are not reused after it. Thread-safe.
+class ExpressionCache {
+private:
+    LruCache<std::string, const ParsedExpression> cache;
+
+public:
+    explicit ExpressionCache(size_t maxEntries = 4096, size_t maxBytes = 64 * 1024 * 1024);
+
+    // Bundle for text, built on a miss. Returns null when the text does not
+    // parse, with the parser's message (positions in the original text) in
+    // *error. Throws std::runtime_error if AST conversion fails.
+    std::shared_ptr<const ParsedExpression> get(std::string_view text, std::string* error = nullptr);
+
+    // Hit rate and memory use (bytes is the sum of ParsedExpression::bytes)
+    LruCacheStats getStats() const { return cache.getStats(); }
+    void setCapacity(size_t maxEntries, size_t maxBytes) { cache.setCapacity(maxEntries, maxBytes); }
+    void clear() { cache.clear(); }
+
+    // Cache key: whitespace trimmed, and dropped except single spaces
+    // between two word characters (where removing it would merge tokens)
+    static std::string normalize(std::string_view text);
+
+    // Approximate heap bytes held by parsed, for ParsedExpression::bytes
+    static size_t footprint(const ParsedExpression& parsed);
+
+    // Process-wide cache behind SymbolicEngine::parseFromString
+    static ExpressionCache& shared();
+};
+
+#endif // EXPRESSION_CACHE_H
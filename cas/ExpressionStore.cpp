@@ -0,0 +1,925 @@
+#include "ExpressionStore.h"
+#include "../util/Instrumentation.h"
+#include <cmath>
+#include <functional>
+#include <new>
+#include <stdexcept>
+
+namespace {
+
+// Arena block size; large requests get a dedicated block
+constexpr size_t kArenaBlockSize = 16 * 1024;
+
+size_t combineHash(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+} // namespace
+
+// ============================================================================
+// NodeArena Implementation
+// ============================================================================
+
+NodeArena::NodeArena() : cursor(nullptr), remaining(0), used(0), reserved(0) {}
+
+void* NodeArena::allocate(size_t size, size_t alignment) {
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    if (cursor == nullptr || padding + size > remaining) {
+        size_t blockSize = (size + alignment > kArenaBlockSize) ? size + alignment : kArenaBlockSize;
+        blocks.emplace_back(new char[blockSize]);
+        cursor = blocks.back().get();
+        remaining = blockSize;
+        reserved += blockSize;
+        CAS_COUNT_N(ARENA_BYTES, blockSize);
+        padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    }
+    char* result = cursor + padding;
+    cursor += padding + size;
+    remaining -= padding + size;
+    used += size;
+    return result;
+}
+
+void NodeArena::clear() {
+    blocks.clear();
+    cursor = nullptr;
+    remaining = 0;
+    used = 0;
+    reserved = 0;
+}
+
+// ============================================================================
+// ExpressionStore Implementation
+// ============================================================================
+
+bool ExpressionStore::NodeEqual::operator()(const ExprNode* a, const ExprNode* b) const {
+    if (a->kind != b->kind || a->op != b->op || a->arity != b->arity || a->name != b->name) {
+        return false;
+    }
+    if (a->kind == ExprNode::Kind::NUMBER && !a->exact->identical(*b->exact)) {
+        return false;
+    }
+    // Children are already interned, so pointer comparison is structural comparison
+    for (uint32_t i = 0; i < a->arity; ++i) {
+        if (a->children[i] != b->children[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ExpressionStore::ExpressionStore() : nextId(0) {}
+
+const std::string* ExpressionStore::internName(const std::string& name) {
+    return &*names.insert(name).first;
+}
+
+const ExprNode* ExpressionStore::internNode(ExprNode::Kind kind, uint8_t op, const Number* value, const std::string* name,
+                                            const ExprNode* const* children, uint32_t arity) {
+    size_t hash = combineHash(static_cast<size_t>(kind), op);
+    hash = combineHash(hash, value ? value->hash() : 0);
+    hash = combineHash(hash, std::hash<const void*>()(name));
+    bool constant = (kind != ExprNode::Kind::VARIABLE);
+    for (uint32_t i = 0; i < arity; ++i) {
+        hash = combineHash(hash, children[i]->id);
+        constant = constant && children[i]->constant;
+    }
+
+    double approximation = value ? value->toDouble() : 0.0;
+    ExprNode probe{kind, op, 0, arity, 0, constant, hash, approximation, value, name, children};
+    auto it = nodes.find(&probe);
+    if (it != nodes.end()) {
+        return *it;
+    }
+
+    // New node: copy the child array into the arena alongside it
+    CAS_COUNT(NODES_CREATED);
+    const ExprNode** storedChildren = nullptr;
+    if (arity > 0) {
+        storedChildren = static_cast<const ExprNode**>(
+            arena.allocate(arity * sizeof(const ExprNode*), alignof(const ExprNode*)));
+        for (uint32_t i = 0; i < arity; ++i) {
+            storedChildren[i] = children[i];
+        }
+    }
+
+    const Number* storedValue = nullptr;
+    if (value) {
+        numbers.push_back(*value);
+        storedValue = &numbers.back();
+    }
+
+    // Functions are resolved once, when their node is first built
+    static_assert(FunctionRegistry::kUnknown <= UINT16_MAX, "function ids fit ExprNode::function");
+    uint16_t function = static_cast<uint16_t>(
+        kind == ExprNode::Kind::FUNCTION ? FunctionRegistry::find(*name) : FunctionRegistry::kUnknown);
+
+    void* memory = arena.allocate(sizeof(ExprNode), alignof(ExprNode));
+    ExprNode* node = new (memory) ExprNode{kind, op, function, arity, nextId++, constant, hash, approximation,
+                                           storedValue, name, storedChildren};
+    nodes.insert(node);
+    return node;
+}
+
+const ExprNode* ExpressionStore::number(double value) {
+    Number exact = Number::fromDouble(value);
+    return internNode(ExprNode::Kind::NUMBER, 0, &exact, nullptr, nullptr, 0);
+}
+
+const ExprNode* ExpressionStore::number(const Number& value) {
+    return internNode(ExprNode::Kind::NUMBER, 0, &value, nullptr, nullptr, 0);
+}
+
+const ExprNode* ExpressionStore::variable(const std::string& name) {
+    return internNode(ExprNode::Kind::VARIABLE, 0, nullptr, internName(name), nullptr, 0);
+}
+
+const ExprNode* ExpressionStore::binary(SymbolicBinaryOp::OpType op, const ExprNode* left, const ExprNode* right) {
+    const ExprNode* children[] = {left, right};
+    return internNode(ExprNode::Kind::BINARY, static_cast<uint8_t>(op), nullptr, nullptr, children, 2);
+}
+
+const ExprNode* ExpressionStore::unary(SymbolicUnaryOp::OpType op, const ExprNode* operand) {
+    const ExprNode* children[] = {operand};
+    return internNode(ExprNode::Kind::UNARY, static_cast<uint8_t>(op), nullptr, nullptr, children, 1);
+}
+
+const ExprNode* ExpressionStore::function(const std::string& name, const std::vector<const ExprNode*>& args) {
+    return internNode(ExprNode::Kind::FUNCTION, 0, nullptr, internName(name), args.data(),
+                      static_cast<uint32_t>(args.size()));
+}
+
+namespace {
+
+// Rebuilds a tree bottom-up in the store, one visit per tree node
+struct InternVisitor {
+    ExpressionStore& store;
+    
+    const ExprNode* operator()(const SymbolicNumber& number) const {
+        return store.number(number.exact);
+    }
+    const ExprNode* operator()(const SymbolicVariable& var) const {
+        return store.variable(var.name);
+    }
+    const ExprNode* operator()(const SymbolicBinaryOp& binaryOp) const {
+        const ExprNode* left = visitSymbolic(*binaryOp.left, *this);
+        const ExprNode* right = visitSymbolic(*binaryOp.right, *this);
+        return store.binary(binaryOp.op, left, right);
+    }
+    const ExprNode* operator()(const SymbolicUnaryOp& unaryOp) const {
+        return store.unary(unaryOp.op, visitSymbolic(*unaryOp.operand, *this));
+    }
+    const ExprNode* operator()(const SymbolicFunction& func) const {
+        std::vector<const ExprNode*> args;
+        for (const auto& arg : func.arguments) {
+            args.push_back(visitSymbolic(*arg, *this));
+        }
+        return store.function(func.functionName, args);
+    }
+};
+
+} // namespace
+
+const ExprNode* ExpressionStore::intern(const SymbolicExpression* expr) {
+    if (!expr) {
+        throw std::runtime_error("Null symbolic expression");
+    }
+    return visitSymbolic(*expr, InternVisitor{*this});
+}
+
+std::unique_ptr<SymbolicExpression> ExpressionStore::toSymbolic(const ExprNode* node) const {
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+            return makeSymbolicNumber(*node->exact);
+        case ExprNode::Kind::VARIABLE:
+            return makeSymbolicVariable(*node->name);
+        case ExprNode::Kind::BINARY:
+            return makeSymbolicBinaryOp(node->binaryOp(), toSymbolic(node->child(0)), toSymbolic(node->child(1)));
+        case ExprNode::Kind::UNARY:
+            return makeSymbolicUnaryOp(node->unaryOp(), toSymbolic(node->child(0)));
+        case ExprNode::Kind::FUNCTION: {
+            std::vector<std::unique_ptr<SymbolicExpression>> args;
+            for (uint32_t i = 0; i < node->arity; ++i) {
+                args.push_back(toSymbolic(node->child(i)));
+            }
+            return makeSymbolicFunction(*node->name, node->function, std::move(args));
+        }
+    }
+    throw std::runtime_error("Unknown expression node kind");
+}
+
+size_t ExpressionStore::MemoKeyHash::operator()(const MemoKey& key) const {
+    size_t hash = combineHash(key.node->hash, static_cast<size_t>(key.operation));
+    return combineHash(hash, std::hash<const void*>()(key.variable));
+}
+
+const ExprNode* ExpressionStore::lookup(const MemoKey& key, MemoCounters& counters) const {
+    auto it = memo.find(key);
+    if (it == memo.end()) {
+        counters.misses++;
+        return nullptr;
+    }
+    counters.hits++;
+    return it->second;
+}
+
+const ExprNode* ExpressionStore::differentiate(const ExprNode* node, const std::string& variable) {
+    CAS_TIME_PHASE(DIFFERENTIATE);
+    CAS_COUNT(DIFFERENTIATE_CALLS);
+    CAS_COUNT_GROWTH(DIFFERENTIATE_NODES, nodes.size());
+    return differentiateNode(node, internName(variable));
+}
+
+const ExprNode* ExpressionStore::differentiateNode(const ExprNode* node, const std::string* variable) {
+    // Shared subexpressions are differentiated once for the lifetime of the store
+    MemoKey key{node, variable, MemoOp::DIFFERENTIATE};
+    if (const ExprNode* cached = lookup(key, stats.differentiate)) {
+        return cached;
+    }
+
+    using BinOp = SymbolicBinaryOp::OpType;
+    using UnOp = SymbolicUnaryOp::OpType;
+    const std::string& var = *variable;
+    const ExprNode* result = nullptr;
+
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+            result = number(0.0);
+            break;
+        case ExprNode::Kind::VARIABLE:
+            result = number(*node->name == var ? 1.0 : 0.0);
+            break;
+        case ExprNode::Kind::BINARY: {
+            const ExprNode* u = node->child(0);
+            const ExprNode* v = node->child(1);
+            switch (node->binaryOp()) {
+                case BinOp::ADD:
+                case BinOp::SUBTRACT: {
+                    const ExprNode* du = differentiateNode(u, variable);
+                    const ExprNode* dv = differentiateNode(v, variable);
+                    result = binary(node->binaryOp(), du, dv);
+                    break;
+                }
+                case BinOp::MULTIPLY: {
+                    // Product rule: d/dx(u*v) = u*dv/dx + v*du/dx
+                    const ExprNode* du = differentiateNode(u, variable);
+                    const ExprNode* dv = differentiateNode(v, variable);
+                    result = binary(BinOp::ADD, binary(BinOp::MULTIPLY, u, dv), binary(BinOp::MULTIPLY, v, du));
+                    break;
+                }
+                case BinOp::DIVIDE: {
+                    // Quotient rule: d/dx(u/v) = (v*du/dx - u*dv/dx) / v^2
+                    const ExprNode* du = differentiateNode(u, variable);
+                    const ExprNode* dv = differentiateNode(v, variable);
+                    const ExprNode* numerator = binary(BinOp::SUBTRACT, binary(BinOp::MULTIPLY, v, du),
+                                                       binary(BinOp::MULTIPLY, u, dv));
+                    result = binary(BinOp::DIVIDE, numerator, binary(BinOp::POWER, v, number(2.0)));
+                    break;
+                }
+                case BinOp::POWER: {
+                    // Power rule for constant exponents: d/dx(u^n) = u^(n-1) * (n * du/dx)
+                    if (!v->constant) {
+                        throw std::runtime_error("Differentiation of variable exponents not implemented");
+                    }
+                    Number expVal = constantValue(v);
+                    const ExprNode* powerTerm = binary(BinOp::POWER, u, number(expVal - 1));
+                    const ExprNode* du = differentiateNode(u, variable);
+                    result = binary(BinOp::MULTIPLY, powerTerm, binary(BinOp::MULTIPLY, number(expVal), du));
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Unknown binary operation in differentiation");
+            }
+            break;
+        }
+        case ExprNode::Kind::UNARY: {
+            const ExprNode* u = node->child(0);
+            const ExprNode* du = differentiateNode(u, variable);
+            switch (node->unaryOp()) {
+                case UnOp::POSITIVE:
+                    result = du;
+                    break;
+                case UnOp::NEGATIVE:
+                    result = unary(UnOp::NEGATIVE, du);
+                    break;
+                case UnOp::SIN:
+                    result = binary(BinOp::MULTIPLY, unary(UnOp::COS, u), du);
+                    break;
+                case UnOp::COS:
+                    result = binary(BinOp::MULTIPLY, unary(UnOp::NEGATIVE, unary(UnOp::SIN, u)), du);
+                    break;
+                case UnOp::TAN: {
+                    const ExprNode* cosSquared = binary(BinOp::POWER, unary(UnOp::COS, u), number(2.0));
+                    result = binary(BinOp::MULTIPLY, binary(BinOp::DIVIDE, number(1.0), cosSquared), du);
+                    break;
+                }
+                case UnOp::LN:
+                    result = binary(BinOp::MULTIPLY, binary(BinOp::DIVIDE, number(1.0), u), du);
+                    break;
+                case UnOp::SQRT: {
+                    const ExprNode* twoSqrtU = binary(BinOp::MULTIPLY, number(2.0), unary(UnOp::SQRT, u));
+                    result = binary(BinOp::MULTIPLY, binary(BinOp::DIVIDE, number(1.0), twoSqrtU), du);
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Differentiation not implemented for this unary operation");
+            }
+            break;
+        }
+        case ExprNode::Kind::FUNCTION:
+            result = differentiateFunction(node, variable);
+            break;
+    }
+
+    memo.emplace(key, result);
+    stats.entries = memo.size();
+    return result;
+}
+
+const ExprNode* ExpressionStore::differentiateFunction(const ExprNode* node, const std::string* variable) {
+    using BinOp = SymbolicBinaryOp::OpType;
+    using UnOp = SymbolicUnaryOp::OpType;
+    using Builtin = FunctionRegistry::Builtin;
+    const std::string& name = *node->name;
+
+    if (node->function != FunctionRegistry::kUnknown && !FunctionRegistry::isBuiltin(node->function)) {
+        // Chain rule through the registered partials
+        FunctionRegistry::checkCall(node->function, name, node->arity);
+        const FunctionRegistry::UserFunction& function = FunctionRegistry::user(node->function);
+        if (!function.derivative) {
+            throw std::runtime_error("Differentiation not implemented for function: " + name);
+        }
+        const ExprNode* result = nullptr;
+        for (uint32_t i = 0; i < node->arity; ++i) {
+            const ExprNode* partial = function.derivative(*this, node->children, i);
+            const ExprNode* term = binary(BinOp::MULTIPLY, partial, differentiateNode(node->child(i), variable));
+            result = result ? binary(BinOp::ADD, result, term) : term;
+        }
+        return result;
+    }
+
+    if (node->arity != 1) {
+        throw std::runtime_error("Differentiation not implemented for multi-argument functions");
+    }
+    const ExprNode* arg = node->child(0);
+    const ExprNode* argDeriv = differentiateNode(arg, variable);
+    switch (static_cast<Builtin>(node->function)) {
+        case Builtin::SIN:
+            return binary(BinOp::MULTIPLY, unary(UnOp::COS, arg), argDeriv);
+        case Builtin::COS:
+            return binary(BinOp::MULTIPLY, unary(UnOp::NEGATIVE, unary(UnOp::SIN, arg)), argDeriv);
+        case Builtin::LN:
+            return binary(BinOp::MULTIPLY, binary(BinOp::DIVIDE, number(1.0), arg), argDeriv);
+        default:
+            break;
+    }
+    throw std::runtime_error("Differentiation not implemented for function: " + name);
+}
+
+bool ExpressionStore::isZero(const ExprNode* node) {
+    // Mirrors SymbolicExpression::isZero: unary nodes defer to their operand
+    while (node->kind == ExprNode::Kind::UNARY) {
+        node = node->child(0);
+    }
+    return node->isNumber(0.0);
+}
+
+bool ExpressionStore::isOne(const ExprNode* node) {
+    return node->isNumber(1.0);
+}
+
+Number ExpressionStore::constantValue(const ExprNode* node) {
+    const ExprNode* folded = simplifyNode(node);
+    return folded->kind == ExprNode::Kind::NUMBER ? *folded->exact : Number::fromDouble(evaluate(node));
+}
+
+const ExprNode* ExpressionStore::foldConstants(SymbolicBinaryOp::OpType op, const ExprNode* left,
+                                               const ExprNode* right) {
+    using BinOp = SymbolicBinaryOp::OpType;
+    if (left->kind == ExprNode::Kind::NUMBER && right->kind == ExprNode::Kind::NUMBER) {
+        const Number& a = *left->exact;
+        const Number& b = *right->exact;
+        switch (op) {
+            case BinOp::ADD: return number(a + b);
+            case BinOp::SUBTRACT: return number(a - b);
+            case BinOp::MULTIPLY: return number(a * b);
+            case BinOp::DIVIDE: return number(a / b);
+            case BinOp::POWER: return number(a.pow(b));
+        }
+    }
+    double a = evaluate(left);
+    double b = evaluate(right);
+    switch (op) {
+        case BinOp::ADD: return number(a + b);
+        case BinOp::SUBTRACT: return number(a - b);
+        case BinOp::MULTIPLY: return number(a * b);
+        case BinOp::DIVIDE: return number(a / b);
+        case BinOp::POWER: return number(std::pow(a, b));
+    }
+    return nullptr;
+}
+
+bool ExpressionStore::printsAsVariable(const ExprNode* node, const std::string& variable) const {
+    // The tree rules compare operand->toString() against the variable name; the
+    // printer drops a unit coefficient, so 1*x also prints as x
+    while (node->kind == ExprNode::Kind::BINARY && node->binaryOp() == SymbolicBinaryOp::OpType::MULTIPLY) {
+        const ExprNode* left = node->child(0);
+        const ExprNode* right = node->child(1);
+        if (left->isNumber(1.0) && !right->constant) {
+            node = right;
+        } else if (right->isNumber(1.0) && !left->constant) {
+            node = left;
+        } else {
+            return false;
+        }
+    }
+    return node->kind == ExprNode::Kind::VARIABLE && *node->name == variable;
+}
+
+const ExprNode* ExpressionStore::simplify(const ExprNode* node) {
+    CAS_TIME_PHASE(SIMPLIFY);
+    CAS_COUNT(SIMPLIFY_CALLS);
+    CAS_COUNT_GROWTH(SIMPLIFY_NODES, nodes.size());
+    return simplifyNode(node);
+}
+
+const ExprNode* ExpressionStore::simplifyNode(const ExprNode* node) {
+    MemoKey key{node, nullptr, MemoOp::SIMPLIFY};
+    if (const ExprNode* cached = lookup(key, stats.simplify)) {
+        return cached;
+    }
+
+    using BinOp = SymbolicBinaryOp::OpType;
+    using UnOp = SymbolicUnaryOp::OpType;
+    const ExprNode* result = node;
+
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+        case ExprNode::Kind::VARIABLE:
+            break;
+        case ExprNode::Kind::BINARY: {
+            const ExprNode* left = simplifyNode(node->child(0));
+            const ExprNode* right = simplifyNode(node->child(1));
+            bool bothConstant = left->constant && right->constant;
+            result = nullptr;
+
+            switch (node->binaryOp()) {
+                case BinOp::ADD:
+                    if (isZero(left)) result = right;
+                    else if (isZero(right)) result = left;
+                    else if (bothConstant) result = foldConstants(BinOp::ADD, left, right);
+                    break;
+                case BinOp::SUBTRACT:
+                    if (isZero(right)) result = left;
+                    else if (isZero(left)) result = unary(UnOp::NEGATIVE, right);
+                    else if (bothConstant) result = foldConstants(BinOp::SUBTRACT, left, right);
+                    break;
+                case BinOp::MULTIPLY:
+                    if (isZero(left) || isZero(right)) result = number(0.0);
+                    else if (isOne(left)) result = right;
+                    else if (isOne(right)) result = left;
+                    else if (bothConstant) result = foldConstants(BinOp::MULTIPLY, left, right);
+                    break;
+                case BinOp::DIVIDE:
+                    if (isZero(right)) throw std::runtime_error("Division by zero");
+                    if (isZero(left)) result = number(0.0);
+                    else if (isOne(right)) result = left;
+                    else if (bothConstant) result = foldConstants(BinOp::DIVIDE, left, right);
+                    break;
+                case BinOp::POWER:
+                    if (isZero(right)) result = number(1.0);
+                    else if (isOne(right)) result = left;
+                    else if (isZero(left)) result = number(0.0);
+                    else if (isOne(left)) result = number(1.0);
+                    else if (bothConstant) result = foldConstants(BinOp::POWER, left, right);
+                    break;
+            }
+            if (!result) {
+                result = binary(node->binaryOp(), left, right);
+            }
+            break;
+        }
+        case ExprNode::Kind::UNARY: {
+            const ExprNode* operand = simplifyNode(node->child(0));
+            UnOp op = node->unaryOp();
+            if (op == UnOp::POSITIVE) {
+                result = operand;
+            } else if (op == UnOp::NEGATIVE && isZero(operand)) {
+                result = number(0.0);
+            } else if (op == UnOp::NEGATIVE && operand->kind == ExprNode::Kind::UNARY &&
+                       operand->unaryOp() == UnOp::NEGATIVE) {
+                // Double negative
+                result = operand->child(0);
+            } else if (op == UnOp::NEGATIVE && operand->kind == ExprNode::Kind::NUMBER) {
+                result = number(-*operand->exact);
+            } else if (operand->constant) {
+                result = number(evaluate(node));
+            } else {
+                result = unary(op, operand);
+            }
+            break;
+        }
+        case ExprNode::Kind::FUNCTION: {
+            std::vector<const ExprNode*> args;
+            bool allConstant = true;
+            for (uint32_t i = 0; i < node->arity; ++i) {
+                args.push_back(simplifyNode(node->child(i)));
+                allConstant = allConstant && args.back()->constant;
+            }
+            result = allConstant ? number(evaluate(node)) : function(*node->name, args);
+            break;
+        }
+    }
+
+    memo.emplace(key, result);
+    stats.entries = memo.size();
+    return result;
+}
+
+const ExprNode* ExpressionStore::integrate(const ExprNode* node, const std::string& variable) {
+    return integrateNode(node, internName(variable));
+}
+
+const ExprNode* ExpressionStore::integrateNode(const ExprNode* node, const std::string* variable) {
+    MemoKey key{node, variable, MemoOp::INTEGRATE};
+    if (const ExprNode* cached = lookup(key, stats.integrate)) {
+        return cached;
+    }
+
+    using BinOp = SymbolicBinaryOp::OpType;
+    using UnOp = SymbolicUnaryOp::OpType;
+    const std::string& var = *variable;
+    const ExprNode* x = this->variable(var);
+    const ExprNode* result = nullptr;
+
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+            result = binary(BinOp::MULTIPLY, node, x);
+            break;
+        case ExprNode::Kind::VARIABLE:
+            if (*node->name == var) {
+                // ∫x dx = x²/2
+                result = binary(BinOp::DIVIDE, binary(BinOp::POWER, x, number(2.0)), number(2.0));
+            } else {
+                // ∫y dx = y*x (treating y as constant)
+                result = binary(BinOp::MULTIPLY, node, x);
+            }
+            break;
+        case ExprNode::Kind::BINARY: {
+            const ExprNode* left = node->child(0);
+            const ExprNode* right = node->child(1);
+            switch (node->binaryOp()) {
+                case BinOp::ADD:
+                case BinOp::SUBTRACT: {
+                    // Left first, so errors surface in the same order as the tree rules
+                    const ExprNode* leftIntegral = integrateNode(left, variable);
+                    const ExprNode* rightIntegral = integrateNode(right, variable);
+                    result = binary(node->binaryOp(), leftIntegral, rightIntegral);
+                    break;
+                }
+                case BinOp::MULTIPLY:
+                    if (left->constant && !right->constant) {
+                        result = binary(BinOp::MULTIPLY, left, integrateNode(right, variable));
+                    } else if (!left->constant && right->constant) {
+                        result = binary(BinOp::MULTIPLY, integrateNode(left, variable), right);
+                    } else {
+                        throw std::runtime_error("Integration by parts not implemented for general multiplication");
+                    }
+                    break;
+                case BinOp::DIVIDE:
+                    if (!left->constant || !printsAsVariable(right, var)) {
+                        throw std::runtime_error("Complex division integration not implemented");
+                    }
+                    // ∫c/x dx = c*ln(x)
+                    result = binary(BinOp::MULTIPLY, left, unary(UnOp::LN, x));
+                    break;
+                case BinOp::POWER: {
+                    if (!printsAsVariable(left, var) || !right->constant) {
+                        throw std::runtime_error("Complex power integration not implemented");
+                    }
+                    Number expVal = constantValue(right);
+                    if (expVal == -1) {
+                        result = unary(UnOp::LN, x);
+                    } else {
+                        const ExprNode* newExponent = number(expVal + 1);
+                        result = binary(BinOp::DIVIDE, binary(BinOp::POWER, x, newExponent), newExponent);
+                    }
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Integration not implemented for this binary operation");
+            }
+            break;
+        }
+        case ExprNode::Kind::UNARY: {
+            const ExprNode* operand = node->child(0);
+            switch (node->unaryOp()) {
+                case UnOp::POSITIVE:
+                    result = integrateNode(operand, variable);
+                    break;
+                case UnOp::NEGATIVE:
+                    result = unary(UnOp::NEGATIVE, integrateNode(operand, variable));
+                    break;
+                case UnOp::SIN:
+                    if (!printsAsVariable(operand, var)) {
+                        throw std::runtime_error("Complex sine integration not implemented");
+                    }
+                    result = unary(UnOp::NEGATIVE, unary(UnOp::COS, x));
+                    break;
+                case UnOp::COS:
+                    if (!printsAsVariable(operand, var)) {
+                        throw std::runtime_error("Complex cosine integration not implemented");
+                    }
+                    result = unary(UnOp::SIN, x);
+                    break;
+                case UnOp::LN:
+                    if (!printsAsVariable(operand, var)) {
+                        throw std::runtime_error("Complex logarithm integration not implemented");
+                    }
+                    result = binary(BinOp::SUBTRACT, binary(BinOp::MULTIPLY, x, unary(UnOp::LN, x)), x);
+                    break;
+                default:
+                    throw std::runtime_error("Integration not implemented for this unary operation");
+            }
+            break;
+        }
+        case ExprNode::Kind::FUNCTION:
+            result = integrateFunction(node, variable);
+            break;
+    }
+
+    memo.emplace(key, result);
+    stats.entries = memo.size();
+    return result;
+}
+
+const ExprNode* ExpressionStore::integrateFunction(const ExprNode* node, const std::string* variable) {
+    using BinOp = SymbolicBinaryOp::OpType;
+    using UnOp = SymbolicUnaryOp::OpType;
+    if (node->arity != 1) {
+        throw std::runtime_error("Integration not implemented for multi-argument functions");
+    }
+
+    using Builtin = FunctionRegistry::Builtin;
+    const std::string& name = *node->name;
+    const ExprNode* x = this->variable(*variable);
+    if (printsAsVariable(node->child(0), *variable)) {
+        switch (static_cast<Builtin>(node->function)) {
+            case Builtin::SIN:
+                return unary(UnOp::NEGATIVE, unary(UnOp::COS, x));
+            case Builtin::COS:
+                return unary(UnOp::SIN, x);
+            case Builtin::LN:
+                return binary(BinOp::SUBTRACT, binary(BinOp::MULTIPLY, x, unary(UnOp::LN, x)), x);
+            default:
+                break;
+        }
+    }
+    throw std::runtime_error("Integration not implemented for function: " + name);
+}
+
+double ExpressionStore::apply(const ExprNode* node, const double* operands) {
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+            return node->value;
+        case ExprNode::Kind::VARIABLE:
+            throw std::runtime_error("Undefined variable: " + *node->name);
+        case ExprNode::Kind::BINARY: {
+            double leftVal = operands[0];
+            double rightVal = operands[1];
+            switch (node->binaryOp()) {
+                case SymbolicBinaryOp::OpType::ADD: return leftVal + rightVal;
+                case SymbolicBinaryOp::OpType::SUBTRACT: return leftVal - rightVal;
+                case SymbolicBinaryOp::OpType::MULTIPLY: return leftVal * rightVal;
+                case SymbolicBinaryOp::OpType::DIVIDE:
+                    if (rightVal == 0) throw std::runtime_error("Division by zero");
+                    return leftVal / rightVal;
+                case SymbolicBinaryOp::OpType::POWER: return std::pow(leftVal, rightVal);
+                default: throw std::runtime_error("Unknown binary operation");
+            }
+        }
+        case ExprNode::Kind::UNARY: {
+            double val = operands[0];
+            switch (node->unaryOp()) {
+                case SymbolicUnaryOp::OpType::POSITIVE: return val;
+                case SymbolicUnaryOp::OpType::NEGATIVE: return -val;
+                case SymbolicUnaryOp::OpType::SIN: return std::sin(val);
+                case SymbolicUnaryOp::OpType::COS: return std::cos(val);
+                case SymbolicUnaryOp::OpType::TAN: return std::tan(val);
+                case SymbolicUnaryOp::OpType::LOG:
+                    if (val <= 0) throw std::runtime_error("Log of non-positive number");
+                    return std::log10(val);
+                case SymbolicUnaryOp::OpType::LN:
+                    if (val <= 0) throw std::runtime_error("Natural log of non-positive number");
+                    return std::log(val);
+                case SymbolicUnaryOp::OpType::SQRT:
+                    if (val < 0) throw std::runtime_error("Square root of negative number");
+                    return std::sqrt(val);
+                case SymbolicUnaryOp::OpType::ABS: return std::abs(val);
+                default: throw std::runtime_error("Unknown unary operation");
+            }
+        }
+        case ExprNode::Kind::FUNCTION:
+            FunctionRegistry::checkCall(node->function, *node->name, node->arity);
+            return FunctionRegistry::call(node->function, operands, nullptr);
+    }
+    throw std::runtime_error("Unknown node kind");
+}
+
+double ExpressionStore::evaluate(const ExprNode* node, const std::map<std::string, double>& variables) const {
+    CAS_COUNT(EVALUATE_CALLS);
+    // Memoized per call so shared subexpressions are evaluated once
+    std::unordered_map<const ExprNode*, double> values;
+    std::function<double(const ExprNode*)> visit = [&](const ExprNode* n) -> double {
+        auto it = values.find(n);
+        if (it != values.end()) {
+            return it->second;
+        }
+
+        double result = 0.0;
+        if (n->kind == ExprNode::Kind::VARIABLE) {
+            auto var = variables.find(*n->name);
+            if (var == variables.end()) {
+                throw std::runtime_error("Undefined variable: " + *n->name);
+            }
+            result = var->second;
+        } else {
+            if (n->kind == ExprNode::Kind::FUNCTION) {
+                FunctionRegistry::checkCall(n->function, *n->name, n->arity);
+            }
+            double operands[FunctionRegistry::kMaxArity] = {};
+            for (uint32_t i = 0; i < n->arity; ++i) {
+                operands[i] = visit(n->child(i));
+            }
+            result = apply(n, operands);
+        }
+
+        values.emplace(n, result);
+        return result;
+    };
+    return visit(node);
+}
+
+CompiledExpression ExpressionStore::compile(const ExprNode* root, const std::vector<std::string>& slots) const {
+    CAS_TIME_PHASE(COMPILE);
+    // Pass 1: fold constant subtrees and count how many computed parents use each node
+    std::unordered_map<const ExprNode*, double> folded;
+    std::unordered_map<const ExprNode*, uint32_t> uses;
+    std::unordered_set<const ExprNode*> seen;
+    std::vector<const ExprNode*> pending = {root};
+    while (!pending.empty()) {
+        const ExprNode* node = pending.back();
+        pending.pop_back();
+        if (!seen.insert(node).second || node->arity == 0) {
+            continue;
+        }
+        if (node->constant) {
+            try {
+                folded.emplace(node, evaluate(node));
+                continue;
+            } catch (const std::exception&) {
+                // Keep the failing operation so evaluation reports it
+            }
+        }
+        for (uint32_t i = 0; i < node->arity; ++i) {
+            uses[node->child(i)]++;
+            pending.push_back(node->child(i));
+        }
+    }
+
+    // Pass 2: emit in evaluation order; a temporary is released after its last use
+    CompiledExpression program(slots);
+    std::unordered_map<const ExprNode*, uint32_t> live;
+    std::unordered_map<const ExprNode*, uint32_t> remaining;
+    std::vector<uint32_t> freeTemps;
+    uint32_t nextTemp = 0;
+
+    std::function<void(const ExprNode*)> emit = [&](const ExprNode* node) {
+        auto temp = live.find(node);
+        if (temp != live.end()) {
+            program.emitLoad(temp->second);
+            if (--remaining[node] == 0) {
+                freeTemps.push_back(temp->second);
+                live.erase(temp);
+            }
+            return;
+        }
+        auto constant = folded.find(node);
+        if (constant != folded.end()) {
+            program.emitConstant(constant->second);
+            return;
+        }
+
+        switch (node->kind) {
+            case ExprNode::Kind::NUMBER:
+                program.emitConstant(node->value);
+                return;
+            case ExprNode::Kind::VARIABLE:
+                program.emitVariable(*node->name);
+                return;
+            case ExprNode::Kind::BINARY:
+                emit(node->child(0));
+                emit(node->child(1));
+                switch (node->binaryOp()) {
+                    case SymbolicBinaryOp::OpType::ADD: program.emit(OpCode::ADD); break;
+                    case SymbolicBinaryOp::OpType::SUBTRACT: program.emit(OpCode::SUBTRACT); break;
+                    case SymbolicBinaryOp::OpType::MULTIPLY: program.emit(OpCode::MULTIPLY); break;
+                    case SymbolicBinaryOp::OpType::DIVIDE: program.emit(OpCode::DIVIDE); break;
+                    case SymbolicBinaryOp::OpType::POWER: program.emit(OpCode::POWER); break;
+                    default: throw std::runtime_error("Unknown binary operation");
+                }
+                break;
+            case ExprNode::Kind::UNARY:
+                emit(node->child(0));
+                switch (node->unaryOp()) {
+                    case SymbolicUnaryOp::OpType::POSITIVE: break;
+                    case SymbolicUnaryOp::OpType::NEGATIVE: program.emit(OpCode::NEGATE); break;
+                    case SymbolicUnaryOp::OpType::SIN: program.emit(OpCode::SIN); break;
+                    case SymbolicUnaryOp::OpType::COS: program.emit(OpCode::COS); break;
+                    case SymbolicUnaryOp::OpType::TAN: program.emit(OpCode::TAN); break;
+                    case SymbolicUnaryOp::OpType::LOG: program.emit(OpCode::LOG); break;
+                    case SymbolicUnaryOp::OpType::LN: program.emit(OpCode::LN); break;
+                    case SymbolicUnaryOp::OpType::SQRT: program.emit(OpCode::SQRT); break;
+                    case SymbolicUnaryOp::OpType::ABS: program.emit(OpCode::ABS); break;
+                    default: throw std::runtime_error("Unknown unary operation");
+                }
+                break;
+            case ExprNode::Kind::FUNCTION:
+                FunctionRegistry::checkCall(node->function, *node->name, node->arity);
+                for (uint32_t i = 0; i < node->arity; ++i) {
+                    emit(node->child(i));
+                }
+                program.emitCall(node->function);
+                break;
+        }
+
+        uint32_t count = uses[node];
+        if (count > 1) {
+            uint32_t slot = nextTemp;
+            if (!freeTemps.empty()) {
+                slot = freeTemps.back();
+                freeTemps.pop_back();
+            } else {
+                nextTemp++;
+            }
+            program.emitStore(slot);
+            live.emplace(node, slot);
+            remaining[node] = count - 1;
+        }
+    };
+
+    emit(root);
+    return program;
+}
+
+void ExpressionStore::clearCache() {
+    memo.clear();
+    stats = CacheStats();
+}
+
+void ExpressionStore::clear() {
+    clearCache();
+    nodes.clear();
+    names.clear();
+    numbers.clear();
+    arena.clear();
+    nextId = 0;
+}
+
+size_t ExpressionStore::dagSize(const ExprNode* root) {
+    std::unordered_set<const ExprNode*> seen;
+    std::vector<const ExprNode*> pending = {root};
+    while (!pending.empty()) {
+        const ExprNode* node = pending.back();
+        pending.pop_back();
+        if (!seen.insert(node).second) {
+            continue;
+        }
+        for (uint32_t i = 0; i < node->arity; ++i) {
+            pending.push_back(node->child(i));
+        }
+    }
+    return seen.size();
+}
+
+double ExpressionStore::treeSize(const ExprNode* root) {
+    // Memoized so each shared subtree is measured once
+    std::unordered_map<const ExprNode*, double> sizes;
+    std::function<double(const ExprNode*)> visit = [&](const ExprNode* node) -> double {
+        auto it = sizes.find(node);
+        if (it != sizes.end()) {
+            return it->second;
+        }
+        double total = 1.0;
+        for (uint32_t i = 0; i < node->arity; ++i) {
+            total += visit(node->child(i));
+        }
+        sizes.emplace(node, total);
+        return total;
+    };
+    return visit(root);
+}
+
+std::string ExpressionStore::toString(const ExprNode* node) const {
+    return toSymbolic(node)->toString();
+}
@@ -0,0 +1,200 @@
+#ifndef EXPRESSION_STORE_H
+#define EXPRESSION_STORE_H
+
+#include "SymbolicEngine.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Node in a hash-consed expression DAG. Nodes are immutable and unique within
+// their ExpressionStore, so two nodes are structurally equal exactly when their
+// pointers are equal.
+struct ExprNode {
+    enum class Kind : uint8_t {
+        NUMBER,
+        VARIABLE,
+        BINARY,
+        UNARY,
+        FUNCTION
+    };
+
+    Kind kind;
+    uint8_t op;                       // SymbolicBinaryOp::OpType or SymbolicUnaryOp::OpType
+    uint16_t function;                // FUNCTION only: FunctionRegistry id (kUnknown if none)
+    uint32_t arity;                   // number of children
+    uint32_t id;                      // dense index in creation order
+    bool constant;                    // no variables anywhere below
+    size_t hash;
+    double value;                     // NUMBER only
+    const Number* exact;              // NUMBER only: exact value, owned by the store
+    const std::string* name;          // VARIABLE / FUNCTION only (interned by the store)
+    const ExprNode* const* children;  // arena-allocated, arity entries
+
+    const ExprNode* child(size_t i) const { return children[i]; }
+    SymbolicBinaryOp::OpType binaryOp() const { return static_cast<SymbolicBinaryOp::OpType>(op); }
+    SymbolicUnaryOp::OpType unaryOp() const { return static_cast<SymbolicUnaryOp::OpType>(op); }
+    bool isNumber(double v) const { return kind == Kind::NUMBER && value == v; }
+};
+
+// Bump allocator for nodes and child arrays. Memory is released all at once
+// when the arena is cleared or destroyed.
+class NodeArena {
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor;
+    size_t remaining;
+    size_t used;
+    size_t reserved;
+
+public:
+    NodeArena();
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+    void clear();
+
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+};
+
+// ExpressionStore - interns structurally identical nodes so every unique
+// subexpression exists once. Derivatives built here share their operands
+// instead of cloning them, so repeated differentiation grows the DAG
+// polynomially rather than exponentially.
+class ExpressionStore {
+public:
+    // Hit/miss counters for one memoized operation
+    struct MemoCounters {
+        size_t hits = 0;
+        size_t misses = 0;
+        
+        double hitRate() const { return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+    };
+    
+    struct CacheStats {
+        MemoCounters differentiate;
+        MemoCounters simplify;
+        MemoCounters integrate;
+        size_t entries = 0;
+    };
+
+private:
+    enum class MemoOp : uint8_t {
+        DIFFERENTIATE,
+        SIMPLIFY,
+        INTEGRATE
+    };
+    
+    struct MemoKey {
+        const ExprNode* node;
+        const std::string* variable;   // interned; null for simplify
+        MemoOp operation;
+        
+        bool operator==(const MemoKey& other) const {
+            return node == other.node && variable == other.variable && operation == other.operation;
+        }
+    };
+    struct MemoKeyHash {
+        size_t operator()(const MemoKey& key) const;
+    };
+
+    struct NodeHash {
+        size_t operator()(const ExprNode* node) const { return node->hash; }
+    };
+    struct NodeEqual {
+        bool operator()(const ExprNode* a, const ExprNode* b) const;
+    };
+
+    NodeArena arena;
+    std::unordered_set<const ExprNode*, NodeHash, NodeEqual> nodes;
+    std::unordered_set<std::string> names;
+    std::deque<Number> numbers;        // values of NUMBER nodes (stable addresses)
+    uint32_t nextId;
+    
+    // Results of differentiate/simplify/integrate keyed on node identity
+    std::unordered_map<MemoKey, const ExprNode*, MemoKeyHash> memo;
+    CacheStats stats;
+
+    const ExprNode* internNode(ExprNode::Kind kind, uint8_t op, const Number* value, const std::string* name,
+                               const ExprNode* const* children, uint32_t arity);
+    const std::string* internName(const std::string& name);
+
+    const ExprNode* lookup(const MemoKey& key, MemoCounters& counters) const;
+    
+    const ExprNode* differentiateNode(const ExprNode* node, const std::string* variable);
+    const ExprNode* differentiateFunction(const ExprNode* node, const std::string* variable);
+    const ExprNode* simplifyNode(const ExprNode* node);
+    const ExprNode* integrateNode(const ExprNode* node, const std::string* variable);
+    const ExprNode* integrateFunction(const ExprNode* node, const std::string* variable);
+    
+    // True when the node prints exactly as the given variable name
+    bool printsAsVariable(const ExprNode* node, const std::string& variable) const;
+    static bool isZero(const ExprNode* node);
+    static bool isOne(const ExprNode* node);
+    // Folds two constant operands, exactly when both are numbers
+    const ExprNode* foldConstants(SymbolicBinaryOp::OpType op, const ExprNode* left, const ExprNode* right);
+    // Value of a constant subtree, exact when it folds to a number (1/2)
+    Number constantValue(const ExprNode* node);
+
+public:
+    ExpressionStore();
+    ExpressionStore(const ExpressionStore&) = delete;
+    ExpressionStore& operator=(const ExpressionStore&) = delete;
+
+    // Node constructors; return the existing node when one is structurally identical
+    const ExprNode* number(double value);
+    const ExprNode* number(const Number& value);
+    const ExprNode* variable(const std::string& name);
+    const ExprNode* binary(SymbolicBinaryOp::OpType op, const ExprNode* left, const ExprNode* right);
+    const ExprNode* unary(SymbolicUnaryOp::OpType op, const ExprNode* operand);
+    const ExprNode* function(const std::string& name, const std::vector<const ExprNode*>& args);
+
+    // Conversion to and from the tree representation
+    const ExprNode* intern(const SymbolicExpression* expr);
+    std::unique_ptr<SymbolicExpression> toSymbolic(const ExprNode* node) const;
+
+    // Memoized calculus over the DAG, following the same rules as the
+    // SymbolicExpression methods of the same name; Simplifier builds on these
+    // nodes for canonical simplification
+    const ExprNode* differentiate(const ExprNode* node, const std::string& variable);
+    const ExprNode* simplify(const ExprNode* node);
+    const ExprNode* integrate(const ExprNode* node, const std::string& variable);
+    
+    // Numeric evaluation with the tree semantics (throws on domain errors)
+    double evaluate(const ExprNode* node, const std::map<std::string, double>& variables = {}) const;
+    // One step of it: the value of node from its operands' values (unused for
+    // NUMBER; VARIABLE nodes are resolved by the caller)
+    static double apply(const ExprNode* node, const double* operands);
+
+    // Compile to bytecode with common subexpression elimination: every shared
+    // node is computed once per point, kept in a temporary and reloaded at its
+    // other uses. Constant subtrees are folded.
+    CompiledExpression compile(const ExprNode* root, const std::vector<std::string>& slots = {}) const;
+
+    // Memo cache statistics and control
+    const CacheStats& getCacheStats() const { return stats; }
+    void clearCache();
+
+    // Drop every node; previously returned pointers become invalid
+    void clear();
+
+    // Statistics
+    size_t nodeCount() const { return nodes.size(); }
+    size_t bytesUsed() const { return arena.bytesUsed(); }
+    size_t bytesReserved() const { return arena.bytesReserved(); }
+
+    // Unique nodes reachable from root, and the node count of the equivalent tree
+    static size_t dagSize(const ExprNode* root);
+    static double treeSize(const ExprNode* root);
+
+    // Readable form, matching the tree printer
+    std::string toString(const ExprNode* node) const;
+};
+
+#endif // EXPRESSION_STORE_H
@@ -0,0 +1,446 @@
+#include "FormulaPack.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'A', 'S', 'P', 'A', 'C', 'K', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrder = 0x01020304;
+
+// The image stores these exactly as laid out in memory
+static_assert(sizeof(FormulaPackHeader) == 128, "FormulaPackHeader layout");
+static_assert(sizeof(FormulaPackEntry) == 40, "FormulaPackEntry layout");
+static_assert(sizeof(FormulaPackNode) == 24, "FormulaPackNode layout");
+static_assert(sizeof(FormulaPackString) == 8, "FormulaPackString layout");
+static_assert(sizeof(Instruction) == 8 && offsetof(Instruction, operand) == 4, "Instruction layout");
+
+[[noreturn]] void invalid(const std::string& what) {
+    throw std::runtime_error("Invalid formula pack: " + what);
+}
+
+uint32_t checkedCount(size_t count) {
+    if (count > 0xffffffffu) {
+        throw std::runtime_error("Formula pack too large");
+    }
+    return static_cast<uint32_t>(count);
+}
+
+// Appends count items at the next 8-byte boundary and returns their offset
+template <typename T>
+uint64_t appendSection(std::vector<char>& image, const T* items, size_t count) {
+    image.resize((image.size() + 7) & ~static_cast<size_t>(7));
+    uint64_t offset = image.size();
+    if (count > 0) {
+        image.resize(image.size() + count * sizeof(T));
+        std::memcpy(image.data() + offset, items, count * sizeof(T));
+    }
+    return offset;
+}
+
+// Exact node values are written with Number::toString: "-3", "1/3"
+Number parseExact(std::string_view text) {
+    bool negative = !text.empty() && text[0] == '-';
+    if (negative) text.remove_prefix(1);
+    size_t slash = text.find('/');
+    Number value = Number::parse(text.substr(0, slash));
+    if (slash != std::string_view::npos) {
+        value = value / Number::parse(text.substr(slash + 1));
+    }
+    return negative ? -value : value;
+}
+
+} // namespace
+
+// ============================================================================
+// FormulaPackWriter Implementation
+// ============================================================================
+
+size_t FormulaPackWriter::add(const std::string& text) {
+    ExpressionParser parser;
+    if (!parser.parse(text)) {
+        throw std::runtime_error("Cannot add '" + text + "' to formula pack: " + parser.getError());
+    }
+    return add(text, *SymbolicEngine::convertASTToSymbolic(parser.getAST()));
+}
+
+size_t FormulaPackWriter::add(const std::string& source, const SymbolicExpression& expr) {
+    const ExprNode* root = store.intern(&expr);
+    CompiledExpression program = store.compile(root);
+    // Registered function ids depend on the process that registered them
+    for (const Instruction& ins : program.getCode()) {
+        if (ins.op == OpCode::CALL) {
+            throw std::runtime_error("Cannot add '" + source + "' to formula pack: it calls registered function " +
+                                     std::string(FunctionRegistry::name(ins.operand)));
+        }
+    }
+    formulas.push_back({source, root, std::move(program)});
+    return formulas.size() - 1;
+}
+
+std::vector<char> FormulaPackWriter::serialize() const {
+    // Every node reachable from a root, in creation order: children are
+    // always created before their parents
+    std::vector<const ExprNode*> order;
+    std::unordered_set<const ExprNode*> seen;
+    for (const Formula& formula : formulas) {
+        std::vector<const ExprNode*> pending = {formula.root};
+        while (!pending.empty()) {
+            const ExprNode* node = pending.back();
+            pending.pop_back();
+            if (!seen.insert(node).second) continue;
+            order.push_back(node);
+            for (uint32_t i = 0; i < node->arity; ++i) pending.push_back(node->child(i));
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const ExprNode* a, const ExprNode* b) { return a->id < b->id; });
+    std::unordered_map<const ExprNode*, uint32_t> index;
+    for (size_t i = 0; i < order.size(); ++i) index.emplace(order[i], static_cast<uint32_t>(i));
+
+    std::vector<std::string_view> stringList;
+    std::unordered_map<std::string_view, uint32_t> stringIndex;
+    std::deque<std::string> exactTexts;   // owns number texts until the image is built
+    auto addString = [&](std::string_view text) {
+        auto inserted = stringIndex.emplace(text, static_cast<uint32_t>(stringList.size()));
+        if (inserted.second) stringList.push_back(text);
+        return inserted.first->second;
+    };
+
+    std::vector<FormulaPackNode> packedNodes(order.size());
+    std::vector<uint32_t> childTable;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const ExprNode* node = order[i];
+        FormulaPackNode& packed = packedNodes[i];
+        packed.kind = static_cast<uint8_t>(node->kind);
+        packed.op = node->op;
+        packed.arity = node->arity;
+        packed.children = checkedCount(childTable.size());
+        packed.text = FormulaPackNode::kNoText;
+        for (uint32_t c = 0; c < node->arity; ++c) childTable.push_back(index.at(node->child(c)));
+        if (node->kind == ExprNode::Kind::NUMBER) {
+            packed.value = node->value;
+            if (node->exact->isExact()) {
+                exactTexts.push_back(node->exact->toString());
+                packed.text = addString(exactTexts.back());
+            }
+        } else if (node->name) {
+            packed.text = addString(*node->name);
+        }
+    }
+
+    std::vector<FormulaPackEntry> entries(formulas.size());
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<uint32_t> slots;
+    for (size_t i = 0; i < formulas.size(); ++i) {
+        const Formula& formula = formulas[i];
+        const CompiledExpression& program = formula.program;
+        FormulaPackEntry& entry = entries[i];
+        entry.source = addString(formula.source);
+        entry.root = index.at(formula.root);
+        entry.codeBegin = checkedCount(code.size());
+        entry.codeLength = checkedCount(program.size());
+        code.insert(code.end(), program.getCode().begin(), program.getCode().end());
+        entry.constantBegin = checkedCount(constants.size());
+        entry.constantCount = checkedCount(program.getConstantCount());
+        for (size_t c = 0; c < program.getConstantCount(); ++c) constants.push_back(program.getConstant(c));
+        entry.slotBegin = checkedCount(slots.size());
+        entry.slotCount = checkedCount(program.getSlotCount());
+        for (const std::string& name : program.getSlotNames()) slots.push_back(addString(name));
+        entry.maxStackDepth = checkedCount(program.getMaxStackDepth());
+        entry.tempCount = checkedCount(program.getTempCount());
+    }
+
+    // Instructions go out field by field so padding bytes are zero
+    std::vector<char> codeBytes(code.size() * sizeof(Instruction));
+    for (size_t i = 0; i < code.size(); ++i) {
+        codeBytes[i * sizeof(Instruction)] = static_cast<char>(code[i].op);
+        std::memcpy(&codeBytes[i * sizeof(Instruction) + offsetof(Instruction, operand)], &code[i].operand,
+                    sizeof(uint32_t));
+    }
+
+    std::vector<FormulaPackString> stringTable(stringList.size());
+    std::vector<char> stringData;
+    for (size_t i = 0; i < stringList.size(); ++i) {
+        stringTable[i] = {checkedCount(stringData.size()), checkedCount(stringList[i].size())};
+        stringData.insert(stringData.end(), stringList[i].begin(), stringList[i].end());
+        stringData.push_back('\0');
+    }
+    checkedCount(stringData.size());
+
+    FormulaPackHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrder;
+    header.formulaCount = checkedCount(entries.size());
+    header.nodeCount = checkedCount(packedNodes.size());
+    header.childCount = checkedCount(childTable.size());
+    header.stringCount = checkedCount(stringTable.size());
+    header.instructionCount = checkedCount(code.size());
+    header.constantCount = checkedCount(constants.size());
+    header.slotCount = checkedCount(slots.size());
+
+    std::vector<char> image(sizeof(FormulaPackHeader));
+    header.formulaOffset = appendSection(image, entries.data(), entries.size());
+    header.nodeOffset = appendSection(image, packedNodes.data(), packedNodes.size());
+    header.childOffset = appendSection(image, childTable.data(), childTable.size());
+    header.stringOffset = appendSection(image, stringTable.data(), stringTable.size());
+    header.instructionOffset = appendSection(image, codeBytes.data(), codeBytes.size());
+    header.constantOffset = appendSection(image, constants.data(), constants.size());
+    header.slotOffset = appendSection(image, slots.data(), slots.size());
+    header.stringDataOffset = appendSection(image, stringData.data(), stringData.size());
+    header.stringDataSize = stringData.size();
+    image.resize((image.size() + 7) & ~static_cast<size_t>(7));
+    header.fileSize = image.size();
+    std::memcpy(image.data(), &header, sizeof(header));
+    return image;
+}
+
+void FormulaPackWriter::write(const std::string& path) const {
+    std::vector<char> image = serialize();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(image.data(), static_cast<std::streamsize>(image.size()))) {
+        throw std::runtime_error("Cannot write formula pack: " + path);
+    }
+}
+
+// ============================================================================
+// FormulaPack Implementation
+// ============================================================================
+
+FormulaPack::FormulaPack(std::shared_ptr<const void> storage, const void* data, size_t size)
+    : storage(std::move(storage)), base(static_cast<const char*>(data)), bytes(size) {
+    validate();
+}
+
+FormulaPack FormulaPack::open(const std::string& path) {
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open formula pack: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot open formula pack: " + path);
+    }
+    if (info.st_size == 0) {
+        ::close(fd);
+        invalid("truncated header");
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Cannot map formula pack: " + path);
+    }
+    std::shared_ptr<const void> mapping(memory, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+    return FormulaPack(std::move(mapping), memory, size);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open formula pack: " + path);
+    }
+    std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return fromBytes(std::move(image));
+#endif
+}
+
+FormulaPack FormulaPack::fromBytes(std::vector<char> image) {
+    auto owned = std::make_shared<std::vector<char>>(std::move(image));
+    std::shared_ptr<const void> storage(owned, owned->data());
+    return FormulaPack(storage, owned->data(), owned->size());
+}
+
+FormulaPack FormulaPack::view(const void* data, size_t size) {
+    return FormulaPack(nullptr, data, size);
+}
+
+void FormulaPack::validate() {
+    if (reinterpret_cast<uintptr_t>(base) % 8 != 0) invalid("image is not 8-byte aligned");
+    if (bytes < sizeof(FormulaPackHeader)) invalid("truncated header");
+    header = reinterpret_cast<const FormulaPackHeader*>(base);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) invalid("bad magic");
+    if (header->byteOrder != kByteOrder) invalid("byte order differs from this host");
+    if (header->version != kVersion) invalid("unsupported version " + std::to_string(header->version));
+    if (header->fileSize != bytes) invalid("size mismatch");
+
+    auto section = [this](uint64_t offset, uint64_t count, size_t size, const char* name) {
+        if (offset % 8 != 0 || offset > bytes || count > (bytes - offset) / size) {
+            invalid(std::string(name) + " section out of bounds");
+        }
+        return base + offset;
+    };
+    entries = reinterpret_cast<const FormulaPackEntry*>(
+        section(header->formulaOffset, header->formulaCount, sizeof(FormulaPackEntry), "formula"));
+    nodes = reinterpret_cast<const FormulaPackNode*>(
+        section(header->nodeOffset, header->nodeCount, sizeof(FormulaPackNode), "node"));
+    childTable = reinterpret_cast<const uint32_t*>(
+        section(header->childOffset, header->childCount, sizeof(uint32_t), "child"));
+    strings = reinterpret_cast<const FormulaPackString*>(
+        section(header->stringOffset, header->stringCount, sizeof(FormulaPackString), "string"));
+    code = reinterpret_cast<const Instruction*>(
+        section(header->instructionOffset, header->instructionCount, sizeof(Instruction), "instruction"));
+    constants = reinterpret_cast<const double*>(
+        section(header->constantOffset, header->constantCount, sizeof(double), "constant"));
+    slots = reinterpret_cast<const uint32_t*>(
+        section(header->slotOffset, header->slotCount, sizeof(uint32_t), "slot"));
+    stringData = section(header->stringDataOffset, header->stringDataSize, 1, "string data");
+
+    for (uint32_t i = 0; i < header->stringCount; ++i) {
+        uint64_t end = static_cast<uint64_t>(strings[i].offset) + strings[i].length;
+        if (end >= header->stringDataSize || stringData[end] != '\0') invalid("bad string " + std::to_string(i));
+    }
+
+    using BinOp = SymbolicBinaryOp::OpType;
+    using UnOp = SymbolicUnaryOp::OpType;
+    for (uint32_t i = 0; i < header->nodeCount; ++i) {
+        const FormulaPackNode& node = nodes[i];
+        bool named = node.kind == static_cast<uint8_t>(ExprNode::Kind::VARIABLE) ||
+                     node.kind == static_cast<uint8_t>(ExprNode::Kind::FUNCTION);
+        bool ok;
+        switch (static_cast<ExprNode::Kind>(node.kind)) {
+            case ExprNode::Kind::NUMBER:
+            case ExprNode::Kind::VARIABLE: ok = node.arity == 0; break;
+            case ExprNode::Kind::BINARY: ok = node.arity == 2 && node.op <= static_cast<uint8_t>(BinOp::POWER); break;
+            case ExprNode::Kind::UNARY: ok = node.arity == 1 && node.op <= static_cast<uint8_t>(UnOp::ABS); break;
+            case ExprNode::Kind::FUNCTION: ok = true; break;
+            default: ok = false; break;
+        }
+        ok = ok && (named ? node.text < header->stringCount
+                          : node.text == FormulaPackNode::kNoText || node.text < header->stringCount);
+        ok = ok && static_cast<uint64_t>(node.children) + node.arity <= header->childCount;
+        // Children come first, so loading is one forward pass
+        for (uint32_t c = 0; ok && c < node.arity; ++c) ok = childTable[node.children + c] < i;
+        if (!ok) invalid("bad node " + std::to_string(i));
+    }
+
+    for (uint32_t f = 0; f < header->formulaCount; ++f) {
+        const FormulaPackEntry& entry = entries[f];
+        std::string name = "formula " + std::to_string(f);
+        if (entry.source >= header->stringCount || entry.root >= header->nodeCount) invalid(name);
+        if (static_cast<uint64_t>(entry.codeBegin) + entry.codeLength > header->instructionCount ||
+            static_cast<uint64_t>(entry.constantBegin) + entry.constantCount > header->constantCount ||
+            static_cast<uint64_t>(entry.slotBegin) + entry.slotCount > header->slotCount ||
+            entry.maxStackDepth > entry.codeLength || entry.tempCount > entry.codeLength) {
+            invalid(name + " ranges out of bounds");
+        }
+        for (uint32_t s = 0; s < entry.slotCount; ++s) {
+            if (slots[entry.slotBegin + s] >= header->stringCount) invalid(name + " bad slot name");
+        }
+
+        // Operands in range and stack depths within the recorded frame, so
+        // the interpreter never reads or writes outside its buffers
+        std::vector<char> stored(entry.tempCount);
+        uint32_t depth = 0;
+        for (uint32_t pc = 0; pc < entry.codeLength; ++pc) {
+            const Instruction& ins = code[entry.codeBegin + pc];
+            bool ok = true;
+            switch (ins.op) {
+                case OpCode::PUSH_CONST: ok = ins.operand < entry.constantCount; depth++; break;
+                case OpCode::LOAD_SLOT: ok = ins.operand < entry.slotCount; depth++; break;
+                case OpCode::STORE_TEMP:
+                    ok = ins.operand < entry.tempCount && depth >= 1;
+                    if (ok) stored[ins.operand] = 1;
+                    break;
+                case OpCode::LOAD_TEMP: ok = ins.operand < entry.tempCount && stored[ins.operand]; depth++; break;
+                case OpCode::ADD:
+                case OpCode::SUBTRACT:
+                case OpCode::MULTIPLY:
+                case OpCode::DIVIDE:
+                case OpCode::POWER: ok = depth >= 2; depth--; break;
+                case OpCode::NEGATE:
+                case OpCode::SIN:
+                case OpCode::COS:
+                case OpCode::TAN:
+                case OpCode::LOG:
+                case OpCode::LN:
+                case OpCode::SQRT:
+                case OpCode::ABS: ok = depth >= 1; break;
+                default: ok = false; break;
+            }
+            if (!ok || depth > entry.maxStackDepth) invalid(name + " bad instruction " + std::to_string(pc));
+        }
+        if (entry.codeLength > 0 && depth != 1) invalid(name + " leaves " + std::to_string(depth) + " values");
+    }
+}
+
+std::string_view FormulaPack::string(uint32_t index) const {
+    return std::string_view(stringData + strings[index].offset, strings[index].length);
+}
+
+ProgramView FormulaPack::program(size_t formula) const {
+    const FormulaPackEntry& entry = entries[formula];
+    return ProgramView{code + entry.codeBegin, entry.codeLength, constants + entry.constantBegin,
+                       entry.maxStackDepth, entry.tempCount};
+}
+
+double FormulaPack::evaluate(size_t formula, const std::map<std::string, double>& variables) const {
+    std::vector<double> values(slotCount(formula));
+    for (size_t i = 0; i < values.size(); ++i) {
+        auto it = variables.find(std::string(slotName(formula, i)));
+        if (it == variables.end()) {
+            throw std::runtime_error("Undefined variable: " + std::string(slotName(formula, i)));
+        }
+        values[i] = it->second;
+    }
+    return eval(formula, values.data());
+}
+
+const ExprNode* FormulaPack::load(size_t formula, ExpressionStore& store) const {
+    // Nodes reachable from the root, rebuilt in index order (children first)
+    std::vector<uint32_t> reachable;
+    std::unordered_set<uint32_t> seen;
+    std::vector<uint32_t> pending = {entries[formula].root};
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        pending.pop_back();
+        if (!seen.insert(index).second) continue;
+        reachable.push_back(index);
+        for (uint32_t c = 0; c < nodes[index].arity; ++c) pending.push_back(childTable[nodes[index].children + c]);
+    }
+    std::sort(reachable.begin(), reachable.end());
+
+    std::unordered_map<uint32_t, const ExprNode*> built;
+    std::vector<const ExprNode*> args;
+    for (uint32_t index : reachable) {
+        const FormulaPackNode& node = nodes[index];
+        args.clear();
+        for (uint32_t c = 0; c < node.arity; ++c) args.push_back(built.at(childTable[node.children + c]));
+
+        const ExprNode* result = nullptr;
+        switch (static_cast<ExprNode::Kind>(node.kind)) {
+            case ExprNode::Kind::NUMBER:
+                result = node.text == FormulaPackNode::kNoText ? store.number(node.value)
+                                                               : store.number(parseExact(string(node.text)));
+                break;
+            case ExprNode::Kind::VARIABLE:
+                result = store.variable(std::string(string(node.text)));
+                break;
+            case ExprNode::Kind::BINARY:
+                result = store.binary(static_cast<SymbolicBinaryOp::OpType>(node.op), args[0], args[1]);
+                break;
+            case ExprNode::Kind::UNARY:
+                result = store.unary(static_cast<SymbolicUnaryOp::OpType>(node.op), args[0]);
+                break;
+            case ExprNode::Kind::FUNCTION:
+                result = store.function(std::string(string(node.text)), args);
+                break;
+        }
+        built.emplace(index, result);
+    }
+    return built.at(entries[formula].root);
+}
@@ -0,0 +1,186 @@
+#ifndef FORMULA_PACK_H
+#define FORMULA_PACK_H
+
+#include "ExpressionStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Formula pack - versioned binary image of many parsed and compiled
+// formulas, meant to be memory-mapped and evaluated in place.
+//
+// Layout (version 1). Integers are in the producer's byte order, recorded
+// in the header and checked on open. Every section starts on an 8-byte
+// boundary, and references are section indices or offsets from the start
+// of the image, so a pack is position independent.
+//
+//   FormulaPackHeader
+//   FormulaPackEntry[formulaCount]    source text, DAG root, program ranges
+//   FormulaPackNode[nodeCount]        expression DAG, children before parents
+//   uint32_t[childCount]              child node indices
+//   FormulaPackString[stringCount]    (offset, length) into the string data
+//   Instruction[instructionCount]     bytecode in the in-memory layout
+//   double[constantCount]             program constants
+//   uint32_t[slotCount]               slot names as string indices
+//   char[stringDataSize]              string data, each string NUL-terminated
+//
+// Equal subexpressions and names are stored once across the whole pack.
+// Programs run straight from the image through ProgramView; the DAG can be
+// loaded into an ExpressionStore for symbolic work.
+
+struct FormulaPackHeader {
+    char magic[8];                 // "CASPACK" and a NUL
+    uint32_t version;
+    uint32_t byteOrder;            // 0x01020304 as the producer stored it
+    uint64_t fileSize;
+    uint32_t formulaCount;
+    uint32_t nodeCount;
+    uint32_t childCount;
+    uint32_t stringCount;
+    uint32_t instructionCount;
+    uint32_t constantCount;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t formulaOffset;
+    uint64_t nodeOffset;
+    uint64_t childOffset;
+    uint64_t stringOffset;
+    uint64_t instructionOffset;
+    uint64_t constantOffset;
+    uint64_t slotOffset;
+    uint64_t stringDataOffset;
+    uint64_t stringDataSize;
+};
+
+struct FormulaPackEntry {
+    uint32_t source;               // string index of the formula text
+    uint32_t root;                 // node index of the DAG root
+    uint32_t codeBegin;            // program: instructions,
+    uint32_t codeLength;
+    uint32_t constantBegin;        // constants (operands are relative to constantBegin),
+    uint32_t constantCount;
+    uint32_t slotBegin;            // and slot names, slot i at slots[slotBegin + i]
+    uint32_t slotCount;
+    uint32_t maxStackDepth;
+    uint32_t tempCount;
+};
+
+struct FormulaPackNode {
+    static constexpr uint32_t kNoText = 0xffffffffu;
+
+    uint8_t kind;                  // ExprNode::Kind
+    uint8_t op;                    // SymbolicBinaryOp::OpType or SymbolicUnaryOp::OpType
+    uint16_t reserved;
+    uint32_t arity;
+    uint32_t children;             // first index into the child table
+    uint32_t text;                 // VARIABLE / FUNCTION name; NUMBER exact value ("-1/3"), kNoText if inexact
+    double value;                  // NUMBER only
+};
+
+struct FormulaPackString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// FormulaPackWriter - collects formulas and produces a pack image. Formulas
+// share one ExpressionStore, so common subexpressions are written once.
+class FormulaPackWriter {
+private:
+    struct Formula {
+        std::string source;
+        const ExprNode* root;
+        CompiledExpression program;
+    };
+
+    ExpressionStore store;
+    std::vector<Formula> formulas;
+
+public:
+    FormulaPackWriter() = default;
+    FormulaPackWriter(const FormulaPackWriter&) = delete;
+    FormulaPackWriter& operator=(const FormulaPackWriter&) = delete;
+
+    // Parses and compiles text; throws std::runtime_error on parse errors
+    // and for calls of registered functions, whose ids only hold in this
+    // process. Returns the formula's index in the pack.
+    size_t add(const std::string& text);
+    // An already converted expression, stored under source
+    size_t add(const std::string& source, const SymbolicExpression& expr);
+
+    size_t size() const { return formulas.size(); }
+
+    // The complete image, and the same written to a file (throws
+    // std::runtime_error when the file cannot be written)
+    std::vector<char> serialize() const;
+    void write(const std::string& path) const;
+};
+
+// FormulaPack - read-only view of a pack image. Opening validates the whole
+// image once (bounds, opcodes, operand ranges, stack depths), after which
+// every accessor is a plain array lookup and nothing is copied; evaluation
+// runs the bytecode in place. Copies share the mapping, and all members are
+// safe to call concurrently.
+class FormulaPack {
+private:
+    std::shared_ptr<const void> storage;   // keeps the mapping or buffer alive
+    const char* base = nullptr;
+    size_t bytes = 0;
+
+    const FormulaPackHeader* header = nullptr;
+    const FormulaPackEntry* entries = nullptr;
+    const FormulaPackNode* nodes = nullptr;
+    const uint32_t* childTable = nullptr;
+    const FormulaPackString* strings = nullptr;
+    const Instruction* code = nullptr;
+    const double* constants = nullptr;
+    const uint32_t* slots = nullptr;
+    const char* stringData = nullptr;
+
+    FormulaPack(std::shared_ptr<const void> storage, const void* data, size_t size);
+    void validate();
+    std::string_view string(uint32_t index) const;
+
+public:
+    // An empty pack
+    FormulaPack() = default;
+
+    // Maps a pack file read-only; throws std::runtime_error when the file
+    // cannot be read or is not a valid pack
+    static FormulaPack open(const std::string& path);
+    // Takes ownership of an image such as FormulaPackWriter::serialize()
+    static FormulaPack fromBytes(std::vector<char> image);
+    // Views an image owned by the caller, which must stay alive and
+    // 8-byte aligned
+    static FormulaPack view(const void* data, size_t size);
+
+    size_t size() const { return header ? header->formulaCount : 0; }
+    size_t nodeCount() const { return header ? header->nodeCount : 0; }
+    size_t byteSize() const { return bytes; }
+
+    std::string_view source(size_t formula) const { return string(entries[formula].source); }
+
+    // Bytecode of a formula, evaluated straight from the image
+    ProgramView program(size_t formula) const;
+    size_t slotCount(size_t formula) const { return entries[formula].slotCount; }
+    std::string_view slotName(size_t formula, size_t slot) const {
+        return string(slots[entries[formula].slotBegin + slot]);
+    }
+
+    // Evaluation with slots[i] holding the value of slotName(formula, i)
+    double eval(size_t formula, const double* slotValues) const { return program(formula).eval(slotValues); }
+    double eval(size_t formula, const double* slotValues, EvalStatus& status) const {
+        return program(formula).eval(slotValues, status);
+    }
+    // Through a name -> value map; throws for variables missing from it
+    double evaluate(size_t formula, const std::map<std::string, double>& variables = {}) const;
+
+    // Rebuilds a formula's DAG in store and returns its root; exact numbers
+    // keep their exact values
+    const ExprNode* load(size_t formula, ExpressionStore& store) const;
+};
+
+#endif // FORMULA_PACK_H
@@ -0,0 +1,195 @@
+#include "LiveExpression.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+// Bitwise comparison: an update that only flips the sign of a zero still
+// reaches the parents (1/x), while a NaN that stays NaN does not
+bool sameValue(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+} // namespace
+
+LiveExpression::LiveExpression(const SymbolicExpression& expr, const std::map<std::string, double>& variables)
+    : ownedStore(std::make_shared<ExpressionStore>()) {
+    build(ownedStore->intern(&expr));
+    set(variables);
+}
+
+LiveExpression::LiveExpression(const ExprNode* root, const std::map<std::string, double>& variables) {
+    build(root);
+    set(variables);
+}
+
+void LiveExpression::build(const ExprNode* root) {
+    std::unordered_set<const ExprNode*> seen = {root};
+    std::vector<const ExprNode*> stack = {root};
+    while (!stack.empty()) {
+        const ExprNode* node = stack.back();
+        stack.pop_back();
+        nodes.push_back(node);
+        for (uint32_t i = 0; i < node->arity; ++i) {
+            if (seen.insert(node->child(i)).second) {
+                stack.push_back(node->child(i));
+            }
+        }
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const ExprNode* a, const ExprNode* b) { return a->id < b->id; });
+
+    std::unordered_map<const ExprNode*, uint32_t> index;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        index.emplace(nodes[i], i);
+    }
+
+    // Operand and parent tables; a node used twice by one parent (x * x)
+    // lists that parent once
+    std::vector<uint32_t> parentCount(nodes.size(), 0);
+    operandBegin.reserve(nodes.size() + 1);
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        operandBegin.push_back(static_cast<uint32_t>(operandList.size()));
+        for (uint32_t c = 0; c < nodes[i]->arity; ++c) {
+            uint32_t operand = index.at(nodes[i]->child(c));
+            bool repeated = std::find(operandList.begin() + operandBegin[i], operandList.end(), operand) !=
+                            operandList.end();
+            operandList.push_back(operand);
+            if (!repeated) parentCount[operand]++;
+        }
+    }
+    operandBegin.push_back(static_cast<uint32_t>(operandList.size()));
+
+    parentBegin.assign(nodes.size() + 1, 0);
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        parentBegin[i + 1] = parentBegin[i] + parentCount[i];
+    }
+    parentList.resize(parentBegin.back());
+    std::vector<uint32_t> fill(parentBegin.begin(), parentBegin.end() - 1);
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        for (uint32_t k = operandBegin[i]; k < operandBegin[i + 1]; ++k) {
+            uint32_t operand = operandList[k];
+            if (fill[operand] == parentBegin[operand] || parentList[fill[operand] - 1] != i) {
+                parentList[fill[operand]++] = i;
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, uint32_t>> found;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i]->kind == ExprNode::Kind::VARIABLE) {
+            found.emplace_back(*nodes[i]->name, i);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    for (const auto& [name, node] : found) {
+        variableIndex.emplace(name, static_cast<uint32_t>(names.size()));
+        names.push_back(name);
+        variableNode.push_back(node);
+    }
+    bindings.assign(names.size(), 0.0);
+    bound.assign(names.size(), 0);
+
+    values.assign(nodes.size(), 0.0);
+    queued.assign(nodes.size(), 0);
+}
+
+void LiveExpression::schedule(uint32_t node) {
+    if (!queued[node]) {
+        queued[node] = 1;
+        pending.push(node);
+    }
+}
+
+double LiveExpression::compute(uint32_t node) {
+    const ExprNode* n = nodes[node];
+    if (n->kind == ExprNode::Kind::VARIABLE) {
+        uint32_t variable = variableIndex.at(*n->name);
+        if (!bound[variable]) {
+            throw std::runtime_error("Undefined variable: " + *n->name);
+        }
+        return bindings[variable];
+    }
+    scratch.clear();
+    for (uint32_t k = operandBegin[node]; k < operandBegin[node + 1]; ++k) {
+        scratch.push_back(values[operandList[k]]);
+    }
+    return ExpressionStore::apply(n, scratch.data());
+}
+
+void LiveExpression::set(const std::string& name, double value) {
+    auto it = variableIndex.find(name);
+    if (it == variableIndex.end()) {
+        return;
+    }
+    uint32_t variable = it->second;
+    if (bound[variable] && sameValue(bindings[variable], value)) {
+        return;
+    }
+    bindings[variable] = value;
+    bound[variable] = 1;
+    if (evaluated) {
+        schedule(variableNode[variable]);
+    }
+}
+
+void LiveExpression::set(const std::map<std::string, double>& variables) {
+    for (const auto& [name, value] : variables) {
+        set(name, value);
+    }
+}
+
+double LiveExpression::value() {
+    recomputed = 0;
+    if (!evaluated) {
+        // First evaluation (or a retry after it failed): every node, in order
+        for (uint32_t i = 0; i < nodes.size(); ++i) {
+            values[i] = compute(i);
+            ++recomputed;
+        }
+        evaluated = true;
+        return values.back();
+    }
+
+    // Smallest index first, so a node is recomputed once, after all of its
+    // stale operands. A node that throws stays queued.
+    while (!pending.empty()) {
+        uint32_t node = pending.top();
+        double result = compute(node);
+        pending.pop();
+        queued[node] = 0;
+        ++recomputed;
+        if (sameValue(result, values[node])) {
+            continue;
+        }
+        values[node] = result;
+        for (uint32_t k = parentBegin[node]; k < parentBegin[node + 1]; ++k) {
+            schedule(parentList[k]);
+        }
+    }
+    return values.back();
+}
+
+size_t LiveExpression::affectedBy(const std::string& name) const {
+    auto it = variableIndex.find(name);
+    if (it == variableIndex.end()) {
+        return 0;
+    }
+    std::vector<char> reached(nodes.size(), 0);
+    std::vector<uint32_t> stack = {variableNode[it->second]};
+    reached[stack.back()] = 1;
+    size_t count = 0;
+    while (!stack.empty()) {
+        uint32_t node = stack.back();
+        stack.pop_back();
+        ++count;
+        for (uint32_t k = parentBegin[node]; k < parentBegin[node + 1]; ++k) {
+            if (!reached[parentList[k]]) {
+                reached[parentList[k]] = 1;
+                stack.push_back(parentList[k]);
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,78 @@
+#ifndef LIVE_EXPRESSION_H
+#define LIVE_EXPRESSION_H
+
+#include "ExpressionStore.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// LiveExpression - an expression kept evaluated while its variable bindings
+// change. Every DAG node caches its value and knows its parents, so after
+// set() only the nodes above the changed variables are recomputed, children
+// before parents, and propagation stops wherever a value comes out
+// unchanged. With many slow-moving parameters an update costs the affected
+// path to the root instead of a full evaluation.
+//
+// Values follow ExpressionStore::evaluate, and value() throws the same
+// errors; a failed update stays pending and is retried by the next value().
+class LiveExpression {
+private:
+    std::shared_ptr<ExpressionStore> ownedStore;   // when built from a tree
+
+    // Reachable nodes in creation order, so operands come before their users
+    // and the root is last
+    std::vector<const ExprNode*> nodes;
+    std::vector<double> values;
+    std::vector<uint32_t> operandBegin;   // operands of node i: operandList[operandBegin[i] .. operandBegin[i + 1])
+    std::vector<uint32_t> operandList;
+    std::vector<uint32_t> parentBegin;    // users of node i, likewise
+    std::vector<uint32_t> parentList;
+
+    // Variables of the expression; a variable is a single node of the DAG
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> variableIndex;
+    std::vector<uint32_t> variableNode;
+    std::vector<double> bindings;
+    std::vector<char> bound;
+
+    // Nodes waiting to be recomputed, smallest index first
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> pending;
+    std::vector<char> queued;
+    bool evaluated = false;
+    size_t recomputed = 0;
+
+    std::vector<double> scratch;
+
+    void build(const ExprNode* root);
+    void schedule(uint32_t node);
+    double compute(uint32_t node);
+
+public:
+    // Tracks a copy of expr in a private store
+    explicit LiveExpression(const SymbolicExpression& expr, const std::map<std::string, double>& variables = {});
+    // Tracks a DAG owned by a caller's store, which must outlive this object
+    explicit LiveExpression(const ExprNode* root, const std::map<std::string, double>& variables = {});
+
+    // Rebinds variables; names the expression does not use are ignored
+    void set(const std::string& name, double value);
+    void set(const std::map<std::string, double>& variables);
+
+    // Current value, bringing every stale node up to date first
+    double value();
+
+    // Variables of the expression, sorted, and whether it uses one
+    const std::vector<std::string>& variables() const { return names; }
+    bool dependsOn(const std::string& name) const { return variableIndex.count(name) != 0; }
+    // Nodes that depend on a variable: the most one change of it recomputes
+    size_t affectedBy(const std::string& name) const;
+
+    size_t nodeCount() const { return nodes.size(); }
+    // Nodes recomputed by the last value() call
+    size_t lastRecomputed() const { return recomputed; }
+};
+
+#endif // LIVE_EXPRESSION_H
@@ -0,0 +1,928 @@
+#include "Polynomial.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// Doubles represent every integer up to here exactly
+constexpr double kExactLimit = 9007199254740992.0;   // 2^53
+
+// Products up to this many cells per product term accumulate densely
+constexpr uint64_t kDenseRatio = 4;
+constexpr uint64_t kDenseSlack = 256;
+
+// Rational root candidates come from divisors found by trial division, so
+// coefficients above this are not searched
+constexpr int64_t kDivisorLimit = int64_t(1) << 40;
+
+// Integer coefficients stay below 2^62 in magnitude, so one product or sum
+// of two checked values never overflows int64 before the check
+constexpr int64_t kMagnitude = int64_t(1) << 62;
+
+// Dense univariate integer polynomial, lowest power first, no trailing
+// zeros (empty is the zero polynomial)
+using IntPoly = std::vector<int64_t>;
+
+int64_t mulExact(int64_t a, int64_t b) {
+    if (a != 0 && std::llabs(b) > kMagnitude / std::llabs(a)) {
+        throw std::overflow_error("Polynomial coefficients exceed 64 bits");
+    }
+    return a * b;
+}
+
+int64_t subExact(int64_t a, int64_t b) {
+    int64_t difference = a - b;
+    if (difference > kMagnitude || difference < -kMagnitude) {
+        throw std::overflow_error("Polynomial coefficients exceed 64 bits");
+    }
+    return difference;
+}
+
+int64_t gcdInt(int64_t a, int64_t b) {
+    a = std::llabs(a);
+    b = std::llabs(b);
+    while (b != 0) {
+        int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+void trim(IntPoly& p) {
+    while (!p.empty() && p.back() == 0) p.pop_back();
+}
+
+int degreeOf(const IntPoly& p) {
+    return static_cast<int>(p.size()) - 1;
+}
+
+int64_t contentOf(const IntPoly& p) {
+    int64_t c = 0;
+    for (int64_t v : p) c = gcdInt(c, v);
+    return c;
+}
+
+// p divided by its content, with a positive leading coefficient
+IntPoly primitive(IntPoly p) {
+    int64_t c = contentOf(p);
+    if (c == 0) return p;
+    if (p.back() < 0) c = -c;
+    for (int64_t& v : p) v /= c;
+    return p;
+}
+
+IntPoly derivativeOf(const IntPoly& p) {
+    IntPoly d;
+    for (size_t i = 1; i < p.size(); ++i) d.push_back(mulExact(p[i], static_cast<int64_t>(i)));
+    trim(d);
+    return d;
+}
+
+IntPoly subtract(IntPoly a, const IntPoly& b) {
+    if (a.size() < b.size()) a.resize(b.size(), 0);
+    for (size_t i = 0; i < b.size(); ++i) a[i] = subExact(a[i], b[i]);
+    trim(a);
+    return a;
+}
+
+// True when b divides a over the integers, with the quotient in *quotient.
+// Coefficients the int64 range cannot hold count as not dividing.
+bool exactDivide(const IntPoly& a, const IntPoly& b, IntPoly* quotient) {
+    if (b.empty()) return false;
+    if (a.empty()) {
+        if (quotient) quotient->clear();
+        return true;
+    }
+    int db = degreeOf(b);
+    int shift = degreeOf(a) - db;
+    if (shift < 0) return false;
+    try {
+        IntPoly r = a;
+        IntPoly q(shift + 1, 0);
+        int64_t lead = b.back();
+        for (int k = shift; k >= 0; --k) {
+            int64_t c = r[k + db];
+            if (c % lead != 0) return false;
+            q[k] = c / lead;
+            if (q[k] == 0) continue;
+            for (int j = 0; j <= db; ++j) r[k + j] = subExact(r[k + j], mulExact(q[k], b[j]));
+        }
+        for (int j = 0; j < db; ++j) {
+            if (r[j] != 0) return false;
+        }
+        if (quotient) *quotient = std::move(q);
+        return true;
+    } catch (const std::overflow_error&) {
+        return false;
+    }
+}
+
+IntPoly divideExact(const IntPoly& a, const IntPoly& b) {
+    IntPoly q;
+    if (!exactDivide(a, b, &q)) {
+        throw std::runtime_error("Inexact polynomial division");
+    }
+    return q;
+}
+
+// ---------------------------------------------------------------------------
+// Arithmetic modulo word-sized primes
+
+using ModPoly = std::vector<uint64_t>;
+
+const std::vector<uint64_t>& gcdPrimes() {
+    static const std::vector<uint64_t> primes = [] {
+        std::vector<uint64_t> found;
+        for (uint64_t n = (uint64_t(1) << 31) - 1; found.size() < 32; n -= 2) {
+            bool prime = true;
+            for (uint64_t d = 3; d * d <= n; d += 2) {
+                if (n % d == 0) {
+                    prime = false;
+                    break;
+                }
+            }
+            if (prime) found.push_back(n);
+        }
+        return found;
+    }();
+    return primes;
+}
+
+uint64_t reduce(int64_t value, uint64_t p) {
+    int64_t r = value % static_cast<int64_t>(p);
+    return static_cast<uint64_t>(r < 0 ? r + static_cast<int64_t>(p) : r);
+}
+
+uint64_t powMod(uint64_t base, uint64_t exponent, uint64_t p) {
+    uint64_t result = 1;
+    base %= p;
+    while (exponent) {
+        if (exponent & 1) result = result * base % p;
+        base = base * base % p;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+uint64_t inverseMod(uint64_t a, uint64_t p) {
+    return powMod(a, p - 2, p);
+}
+
+void trim(ModPoly& p) {
+    while (!p.empty() && p.back() == 0) p.pop_back();
+}
+
+ModPoly reduce(const IntPoly& a, uint64_t p) {
+    ModPoly r(a.size());
+    for (size_t i = 0; i < a.size(); ++i) r[i] = reduce(a[i], p);
+    trim(r);
+    return r;
+}
+
+// a mod b in place (b nonzero)
+void remainderMod(ModPoly& a, const ModPoly& b, uint64_t p) {
+    uint64_t leadInverse = inverseMod(b.back(), p);
+    size_t db = b.size() - 1;
+    while (a.size() > db && !a.empty()) {
+        size_t shift = a.size() - 1 - db;
+        uint64_t factor = a.back() * leadInverse % p;
+        for (size_t j = 0; j <= db; ++j) {
+            a[shift + j] = (a[shift + j] + p - factor * b[j] % p) % p;
+        }
+        trim(a);
+    }
+}
+
+// Monic gcd of a and b over Z/p
+ModPoly gcdMod(ModPoly a, ModPoly b, uint64_t p) {
+    while (!b.empty()) {
+        remainderMod(a, b, p);
+        std::swap(a, b);
+    }
+    if (!a.empty()) {
+        uint64_t leadInverse = inverseMod(a.back(), p);
+        for (uint64_t& v : a) v = v * leadInverse % p;
+    }
+    return a;
+}
+
+// gcd of two primitive polynomials of positive degree: the image of
+// gamma * gcd (gamma = gcd of the leading coefficients) is computed modulo
+// one prime, or two combined by CRT, and its primitive part is accepted
+// once it divides both inputs. Primes dividing a leading coefficient are
+// skipped; an image of higher degree than seen before is unlucky and
+// dropped, one of lower degree restarts the lifting.
+IntPoly modularGcd(const IntPoly& a, const IntPoly& b) {
+    int64_t gamma = gcdInt(a.back(), b.back());
+    int bestDegree = std::min(degreeOf(a), degreeOf(b)) + 1;
+    ModPoly image;
+    uint64_t modulus = 0;
+    size_t lifted = 0;   // primes combined into image
+
+    for (uint64_t p : gcdPrimes()) {
+        if (reduce(a.back(), p) == 0 || reduce(b.back(), p) == 0) continue;
+        ModPoly g = gcdMod(reduce(a, p), reduce(b, p), p);
+        int d = static_cast<int>(g.size()) - 1;
+        if (d == 0) return IntPoly{1};
+        if (d > bestDegree) continue;
+
+        uint64_t scale = reduce(gamma, p);
+        for (uint64_t& v : g) v = v * scale % p;
+        if (d < bestDegree || lifted == 0 || lifted == 2) {
+            bestDegree = d;
+            image = std::move(g);
+            modulus = p;
+            lifted = 1;
+        } else {
+            // h + modulus * t matches both residues; below 2^62
+            uint64_t inverse = inverseMod(modulus % p, p);
+            for (size_t i = 0; i < image.size(); ++i) {
+                uint64_t t = (g[i] + p - image[i] % p) % p * inverse % p;
+                image[i] += modulus * t;
+            }
+            modulus *= p;
+            lifted = 2;
+        }
+
+        IntPoly candidate(image.size());
+        for (size_t i = 0; i < image.size(); ++i) {
+            candidate[i] = image[i] > modulus / 2 ? static_cast<int64_t>(image[i]) - static_cast<int64_t>(modulus)
+                                                  : static_cast<int64_t>(image[i]);
+        }
+        trim(candidate);
+        candidate = primitive(candidate);
+        if (degreeOf(candidate) == d && exactDivide(a, candidate, nullptr) && exactDivide(b, candidate, nullptr)) {
+            return candidate;
+        }
+    }
+    throw std::runtime_error("Polynomial GCD coefficients exceed 64 bits");
+}
+
+// gcd with positive leading coefficient; gcd(0, b) is b up to sign
+IntPoly gcdOf(const IntPoly& a, const IntPoly& b) {
+    if (a.empty() || b.empty()) {
+        IntPoly g = a.empty() ? b : a;
+        if (!g.empty() && g.back() < 0) {
+            for (int64_t& v : g) v = -v;
+        }
+        return g;
+    }
+    int64_t ca = contentOf(a);
+    int64_t cb = contentOf(b);
+    int64_t c = gcdInt(ca, cb);
+    IntPoly g{1};
+    if (degreeOf(a) > 0 && degreeOf(b) > 0) {
+        g = modularGcd(primitive(a), primitive(b));
+    }
+    for (int64_t& v : g) v = mulExact(v, c);
+    return g;
+}
+
+// Yun's algorithm; f primitive of positive degree
+std::vector<std::pair<IntPoly, unsigned>> squareFreeOf(const IntPoly& f) {
+    std::vector<std::pair<IntPoly, unsigned>> parts;
+    IntPoly df = derivativeOf(f);
+    IntPoly g = primitive(gcdOf(f, df));
+    IntPoly b = divideExact(f, g);
+    IntPoly c = divideExact(df, g);
+    IntPoly d = subtract(c, derivativeOf(b));
+    for (unsigned i = 1; degreeOf(b) > 0; ++i) {
+        IntPoly a = primitive(gcdOf(b, d));
+        if (degreeOf(a) > 0) parts.emplace_back(a, i);
+        b = divideExact(b, a);
+        c = divideExact(d, a);
+        d = subtract(c, derivativeOf(b));
+    }
+    return parts;
+}
+
+std::vector<int64_t> divisorsOf(int64_t n) {
+    std::vector<int64_t> small;
+    std::vector<int64_t> large;
+    for (int64_t d = 1; d * d <= n; ++d) {
+        if (n % d != 0) continue;
+        small.push_back(d);
+        if (d != n / d) large.push_back(n / d);
+    }
+    small.insert(small.end(), large.rbegin(), large.rend());
+    return small;
+}
+
+// f(x0) for x0 = +1 or -1; 0 when the sum overflows (disables the filter)
+int64_t valueAtUnit(const IntPoly& f, int64_t x0) {
+    int64_t sum = 0;
+    try {
+        for (size_t i = 0; i < f.size(); ++i) {
+            sum = subExact(sum, (i % 2 == 1 && x0 < 0) ? f[i] : -f[i]);
+        }
+    } catch (const std::overflow_error&) {
+        return 0;
+    }
+    return sum;
+}
+
+// Splits a square-free primitive polynomial into linear factors q x - p for
+// its rational roots p/q and the remaining cofactor. Candidates satisfy
+// p | f(0) and q | lead(f), and are pre-filtered by (q - p) | f(1) and
+// (q + p) | f(-1).
+std::vector<IntPoly> splitRationalRoots(IntPoly f) {
+    std::vector<IntPoly> pieces;
+    if (degreeOf(f) >= 2 && f.front() != 0 && std::llabs(f.front()) <= kDivisorLimit &&
+        std::llabs(f.back()) <= kDivisorLimit) {
+        std::vector<int64_t> numerators = divisorsOf(std::llabs(f.front()));
+        std::vector<int64_t> denominators = divisorsOf(std::llabs(f.back()));
+        int64_t atOne = valueAtUnit(f, 1);
+        int64_t atMinusOne = valueAtUnit(f, -1);
+        for (int64_t q : denominators) {
+            for (int64_t magnitude : numerators) {
+                if (gcdInt(magnitude, q) != 1) continue;
+                for (int64_t p : {magnitude, -magnitude}) {
+                    if (degreeOf(f) < 2) break;
+                    if (f.front() % p != 0 || f.back() % q != 0) continue;
+                    if (q != p && atOne % (q - p) != 0) continue;
+                    if (q != -p && atMinusOne % (q + p) != 0) continue;
+                    IntPoly linear{-p, q};
+                    IntPoly quotient;
+                    if (exactDivide(f, linear, &quotient)) {
+                        pieces.push_back(linear);
+                        f = std::move(quotient);
+                        atOne = valueAtUnit(f, 1);
+                        atMinusOne = valueAtUnit(f, -1);
+                    }
+                }
+            }
+        }
+    }
+    if (degreeOf(f) > 0) pieces.push_back(f);
+    return pieces;
+}
+
+} // namespace
+
+// ============================================================================
+// Construction and layout
+// ============================================================================
+
+Polynomial Polynomial::constant(double value) {
+    Polynomial p;
+    if (value != 0) p.coeffs.push_back(value);
+    return p;
+}
+
+Polynomial Polynomial::variable(const std::string& name) {
+    Polynomial p;
+    p.vars.push_back(name);
+    p.exps.push_back(1);
+    p.coeffs.push_back(1);
+    return p;
+}
+
+Polynomial Polynomial::fromCoefficients(const std::string& name, const std::vector<double>& coefficients) {
+    Polynomial p;
+    p.vars.push_back(name);
+    for (size_t i = coefficients.size(); i-- > 0;) {
+        if (coefficients[i] == 0) continue;
+        p.exps.push_back(static_cast<uint32_t>(i));
+        p.coeffs.push_back(coefficients[i]);
+    }
+    p.compact();
+    return p;
+}
+
+std::vector<std::string> Polynomial::mergeVariables(const Polynomial& a, const Polynomial& b) {
+    if (a.vars == b.vars) return a.vars;
+    std::vector<std::string> names;
+    std::set_union(a.vars.begin(), a.vars.end(), b.vars.begin(), b.vars.end(), std::back_inserter(names));
+    return names;
+}
+
+Polynomial Polynomial::over(const std::vector<std::string>& names) const {
+    if (names == vars) return *this;
+    // Inserting all-zero columns keeps the lexicographic order of the terms
+    std::vector<size_t> column(vars.size());
+    for (size_t v = 0; v < vars.size(); ++v) {
+        column[v] = std::lower_bound(names.begin(), names.end(), vars[v]) - names.begin();
+    }
+    Polynomial p;
+    p.vars = names;
+    p.coeffs = coeffs;
+    p.exps.assign(coeffs.size() * names.size(), 0);
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        for (size_t v = 0; v < vars.size(); ++v) p.exps[t * names.size() + column[v]] = row(t)[v];
+    }
+    return p;
+}
+
+void Polynomial::normalize() {
+    size_t n = vars.size();
+    std::vector<size_t> order(coeffs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::lexicographical_compare(row(b), row(b) + n, row(a), row(a) + n);
+    });
+
+    std::vector<uint32_t> sortedExps;
+    std::vector<double> sortedCoeffs;
+    sortedExps.reserve(exps.size());
+    sortedCoeffs.reserve(coeffs.size());
+    for (size_t i = 0; i < order.size();) {
+        const uint32_t* r = row(order[i]);
+        double sum = 0;
+        size_t j = i;
+        for (; j < order.size() && std::equal(r, r + n, row(order[j])); ++j) sum += coeffs[order[j]];
+        if (sum != 0) {
+            sortedExps.insert(sortedExps.end(), r, r + n);
+            sortedCoeffs.push_back(sum);
+        }
+        i = j;
+    }
+    exps = std::move(sortedExps);
+    coeffs = std::move(sortedCoeffs);
+    compact();
+}
+
+void Polynomial::compact() {
+    size_t n = vars.size();
+    std::vector<bool> used(n, false);
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        for (size_t v = 0; v < n; ++v) {
+            if (row(t)[v] != 0) used[v] = true;
+        }
+    }
+    if (std::find(used.begin(), used.end(), false) == used.end()) return;
+
+    std::vector<std::string> keptVars;
+    for (size_t v = 0; v < n; ++v) {
+        if (used[v]) keptVars.push_back(vars[v]);
+    }
+    std::vector<uint32_t> keptExps;
+    keptExps.reserve(coeffs.size() * keptVars.size());
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        for (size_t v = 0; v < n; ++v) {
+            if (used[v]) keptExps.push_back(row(t)[v]);
+        }
+    }
+    vars = std::move(keptVars);
+    exps = std::move(keptExps);
+}
+
+// ============================================================================
+// Conversion from and to symbolic trees
+// ============================================================================
+
+namespace {
+
+struct ToPolynomial {
+    Polynomial operator()(const SymbolicNumber& num) const { return Polynomial::constant(num.value); }
+    Polynomial operator()(const SymbolicVariable& var) const { return Polynomial::variable(var.name); }
+
+    Polynomial operator()(const SymbolicBinaryOp& op) const {
+        Polynomial left = visitSymbolic(*op.left, *this);
+        Polynomial right = visitSymbolic(*op.right, *this);
+        switch (op.op) {
+            case SymbolicBinaryOp::OpType::ADD: return left + right;
+            case SymbolicBinaryOp::OpType::SUBTRACT: return left - right;
+            case SymbolicBinaryOp::OpType::MULTIPLY: return left * right;
+            case SymbolicBinaryOp::OpType::DIVIDE: {
+                if (!right.isConstant()) {
+                    throw std::runtime_error("Not a polynomial: division by " + op.right->toString());
+                }
+                double divisor = right.leadingCoefficient();
+                if (divisor == 0) throw std::runtime_error("Division by zero");
+                return left.scaled(1.0 / divisor);
+            }
+            case SymbolicBinaryOp::OpType::POWER: {
+                if (!right.isConstant()) {
+                    throw std::runtime_error("Not a polynomial: variable exponent " + op.right->toString());
+                }
+                double exponent = right.leadingCoefficient();
+                if (left.isConstant()) return Polynomial::constant(std::pow(left.leadingCoefficient(), exponent));
+                if (exponent < 0 || exponent != std::floor(exponent) || exponent > 4294967295.0) {
+                    throw std::runtime_error("Not a polynomial: exponent " + op.right->toString());
+                }
+                return left.pow(static_cast<unsigned>(exponent));
+            }
+        }
+        throw std::runtime_error("Unknown binary operation");
+    }
+
+    Polynomial operator()(const SymbolicUnaryOp& op) const {
+        Polynomial operand = visitSymbolic(*op.operand, *this);
+        if (op.op == SymbolicUnaryOp::OpType::POSITIVE) return operand;
+        if (op.op == SymbolicUnaryOp::OpType::NEGATIVE) return -operand;
+        if (operand.isConstant()) return Polynomial::constant(op.evaluate());
+        throw std::runtime_error("Not a polynomial: " + op.toString());
+    }
+
+    Polynomial operator()(const SymbolicFunction& func) const {
+        if (func.isConstant()) return Polynomial::constant(func.evaluate());
+        throw std::runtime_error("Not a polynomial: " + func.toString());
+    }
+};
+
+} // namespace
+
+Polynomial Polynomial::fromSymbolic(const SymbolicExpression& expr) {
+    return visitSymbolic(expr, ToPolynomial{});
+}
+
+std::unique_ptr<SymbolicExpression> Polynomial::toSymbolic() const {
+    using OpType = SymbolicBinaryOp::OpType;
+    if (isZero()) return makeSymbolicNumber(0.0);
+
+    std::unique_ptr<SymbolicExpression> sum;
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        std::unique_ptr<SymbolicExpression> monomial;
+        for (size_t v = 0; v < vars.size(); ++v) {
+            uint32_t e = row(t)[v];
+            if (e == 0) continue;
+            std::unique_ptr<SymbolicExpression> factor = makeSymbolicVariable(vars[v]);
+            if (e > 1) factor = makeSymbolicBinaryOp(OpType::POWER, std::move(factor), makeSymbolicNumber(e));
+            monomial = monomial ? makeSymbolicBinaryOp(OpType::MULTIPLY, std::move(monomial), std::move(factor))
+                                : std::move(factor);
+        }
+
+        // Later terms carry their sign in the operator
+        double c = sum ? std::abs(coeffs[t]) : coeffs[t];
+        std::unique_ptr<SymbolicExpression> term;
+        if (!monomial) {
+            term = makeSymbolicNumber(c);
+        } else if (c == 1) {
+            term = std::move(monomial);
+        } else {
+            term = makeSymbolicBinaryOp(OpType::MULTIPLY, makeSymbolicNumber(c), std::move(monomial));
+        }
+
+        if (!sum) {
+            sum = std::move(term);
+        } else {
+            sum = makeSymbolicBinaryOp(coeffs[t] < 0 ? OpType::SUBTRACT : OpType::ADD, std::move(sum), std::move(term));
+        }
+    }
+    return sum;
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+bool Polynomial::isConstant() const {
+    // Only variables that occur are kept
+    return vars.empty();
+}
+
+int Polynomial::degree() const {
+    int best = -1;
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        int total = 0;
+        for (size_t v = 0; v < vars.size(); ++v) total += static_cast<int>(row(t)[v]);
+        best = std::max(best, total);
+    }
+    return best;
+}
+
+int Polynomial::degree(const std::string& name) const {
+    if (isZero()) return -1;
+    auto it = std::find(vars.begin(), vars.end(), name);
+    if (it == vars.end()) return 0;
+    size_t v = it - vars.begin();
+    // Lexicographic order puts the highest power of vars[0] first only
+    uint32_t best = 0;
+    for (size_t t = 0; t < coeffs.size(); ++t) best = std::max(best, row(t)[v]);
+    return static_cast<int>(best);
+}
+
+std::vector<double> Polynomial::coefficients(const std::string& name) const {
+    for (const auto& var : vars) {
+        if (var != name) throw std::runtime_error("Polynomial is not univariate in " + name);
+    }
+    std::vector<double> dense(std::max(degree(name), 0) + 1, 0.0);
+    for (size_t t = 0; t < coeffs.size(); ++t) dense[vars.empty() ? 0 : row(t)[0]] = coeffs[t];
+    if (isZero()) dense.clear();
+    return dense;
+}
+
+bool Polynomial::hasIntegerCoefficients() const {
+    for (double c : coeffs) {
+        if (c != std::floor(c) || std::abs(c) > kExactLimit) return false;
+    }
+    return true;
+}
+
+double Polynomial::evaluate(const std::map<std::string, double>& values) const {
+    std::vector<double> point(vars.size());
+    for (size_t v = 0; v < vars.size(); ++v) {
+        auto it = values.find(vars[v]);
+        if (it == values.end()) throw std::runtime_error("Undefined variable: " + vars[v]);
+        point[v] = it->second;
+    }
+    double total = 0;
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        double term = coeffs[t];
+        for (size_t v = 0; v < vars.size(); ++v) {
+            if (row(t)[v]) term *= std::pow(point[v], static_cast<double>(row(t)[v]));
+        }
+        total += term;
+    }
+    return total;
+}
+
+Polynomial Polynomial::derivative(const std::string& name) const {
+    auto it = std::find(vars.begin(), vars.end(), name);
+    if (it == vars.end()) return Polynomial();
+    size_t v = it - vars.begin();
+    // Lowering one column in every surviving term keeps their order
+    Polynomial d;
+    d.vars = vars;
+    for (size_t t = 0; t < coeffs.size(); ++t) {
+        uint32_t e = row(t)[v];
+        if (e == 0) continue;
+        d.exps.insert(d.exps.end(), row(t), row(t) + vars.size());
+        d.exps[d.exps.size() - vars.size() + v] = e - 1;
+        d.coeffs.push_back(coeffs[t] * e);
+    }
+    d.compact();
+    return d;
+}
+
+bool Polynomial::operator==(const Polynomial& other) const {
+    return vars == other.vars && exps == other.exps && coeffs == other.coeffs;
+}
+
+// ============================================================================
+// Arithmetic
+// ============================================================================
+
+Polynomial Polynomial::operator-() const {
+    Polynomial p = *this;
+    for (double& c : p.coeffs) c = -c;
+    return p;
+}
+
+Polynomial Polynomial::scaled(double factor) const {
+    Polynomial p = *this;
+    for (double& c : p.coeffs) c *= factor;
+    if (std::find(p.coeffs.begin(), p.coeffs.end(), 0.0) != p.coeffs.end()) p.normalize();
+    return p;
+}
+
+Polynomial Polynomial::operator+(const Polynomial& other) const {
+    std::vector<std::string> names = mergeVariables(*this, other);
+    Polynomial a = over(names);
+    Polynomial b = other.over(names);
+    size_t n = names.size();
+
+    // Both term lists are sorted, so one merge pass combines them
+    Polynomial sum;
+    sum.vars = names;
+    sum.exps.reserve(a.exps.size() + b.exps.size());
+    sum.coeffs.reserve(a.coeffs.size() + b.coeffs.size());
+    size_t i = 0, j = 0;
+    while (i < a.coeffs.size() || j < b.coeffs.size()) {
+        bool takeA = j == b.coeffs.size();
+        bool takeB = i == a.coeffs.size();
+        if (!takeA && !takeB) {
+            const uint32_t* ra = a.row(i);
+            const uint32_t* rb = b.row(j);
+            if (std::equal(ra, ra + n, rb)) {
+                double c = a.coeffs[i] + b.coeffs[j];
+                if (c != 0) {
+                    sum.exps.insert(sum.exps.end(), ra, ra + n);
+                    sum.coeffs.push_back(c);
+                }
+                ++i;
+                ++j;
+                continue;
+            }
+            takeA = std::lexicographical_compare(rb, rb + n, ra, ra + n);
+            takeB = !takeA;
+        }
+        if (takeA) {
+            sum.exps.insert(sum.exps.end(), a.row(i), a.row(i) + n);
+            sum.coeffs.push_back(a.coeffs[i++]);
+        } else {
+            sum.exps.insert(sum.exps.end(), b.row(j), b.row(j) + n);
+            sum.coeffs.push_back(b.coeffs[j++]);
+        }
+    }
+    sum.compact();
+    return sum;
+}
+
+Polynomial Polynomial::operator-(const Polynomial& other) const {
+    return *this + (-other);
+}
+
+Polynomial Polynomial::operator*(const Polynomial& other) const {
+    if (isZero() || other.isZero()) return Polynomial();
+    std::vector<std::string> names = mergeVariables(*this, other);
+    Polynomial a = over(names);
+    Polynomial b = other.over(names);
+    size_t n = names.size();
+    size_t na = a.coeffs.size();
+    size_t nb = b.coeffs.size();
+
+    Polynomial product;
+    product.vars = names;
+
+    // Mixed-radix monomial keys with radix deg_a(v) + deg_b(v) + 1 per
+    // variable (the first most significant): product keys are sums of the
+    // operands' keys, and decreasing keys are decreasing lexicographic order
+    std::vector<uint64_t> radix(n);
+    uint64_t box = 1;
+    bool boxFits = true;
+    for (size_t v = 0; v < n; ++v) {
+        uint64_t da = 0, db = 0;
+        for (size_t t = 0; t < na; ++t) da = std::max<uint64_t>(da, a.row(t)[v]);
+        for (size_t t = 0; t < nb; ++t) db = std::max<uint64_t>(db, b.row(t)[v]);
+        radix[v] = da + db + 1;
+        if (box > (uint64_t(1) << 62) / radix[v]) boxFits = false;
+        else box *= radix[v];
+    }
+
+    if (!boxFits) {
+        for (size_t i = 0; i < na; ++i) {
+            for (size_t j = 0; j < nb; ++j) {
+                for (size_t v = 0; v < n; ++v) product.exps.push_back(a.row(i)[v] + b.row(j)[v]);
+                product.coeffs.push_back(a.coeffs[i] * b.coeffs[j]);
+            }
+        }
+        product.normalize();
+        return product;
+    }
+
+    auto keysOf = [&](const Polynomial& p) {
+        std::vector<uint64_t> keys(p.coeffs.size());
+        for (size_t t = 0; t < keys.size(); ++t) {
+            uint64_t key = 0;
+            for (size_t v = 0; v < n; ++v) key = key * radix[v] + p.row(t)[v];
+            keys[t] = key;
+        }
+        return keys;
+    };
+    std::vector<uint64_t> keysA = keysOf(a);
+    std::vector<uint64_t> keysB = keysOf(b);
+
+    auto emit = [&](uint64_t key, double c) {
+        size_t base = product.exps.size();
+        product.exps.resize(base + n);
+        for (size_t v = n; v-- > 0;) {
+            product.exps[base + v] = static_cast<uint32_t>(key % radix[v]);
+            key /= radix[v];
+        }
+        product.coeffs.push_back(c);
+    };
+
+    uint64_t pairs = static_cast<uint64_t>(na) * nb;
+    if (box <= kDenseRatio * pairs + kDenseSlack) {
+        std::vector<double> dense(box, 0.0);
+        for (size_t i = 0; i < na; ++i) {
+            for (size_t j = 0; j < nb; ++j) dense[keysA[i] + keysB[j]] += a.coeffs[i] * b.coeffs[j];
+        }
+        for (uint64_t key = box; key-- > 0;) {
+            if (dense[key] != 0) emit(key, dense[key]);
+        }
+    } else {
+        std::unordered_map<uint64_t, double> terms;
+        terms.reserve(std::min<uint64_t>(pairs, box));
+        for (size_t i = 0; i < na; ++i) {
+            for (size_t j = 0; j < nb; ++j) terms[keysA[i] + keysB[j]] += a.coeffs[i] * b.coeffs[j];
+        }
+        std::vector<std::pair<uint64_t, double>> sorted(terms.begin(), terms.end());
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const auto& x, const auto& y) { return x.first > y.first; });
+        for (const auto& [key, c] : sorted) {
+            if (c != 0) emit(key, c);
+        }
+    }
+    product.compact();
+    return product;
+}
+
+Polynomial Polynomial::pow(unsigned exponent) const {
+    Polynomial result = constant(1);
+    Polynomial base = *this;
+    while (exponent) {
+        if (exponent & 1) result = result * base;
+        exponent >>= 1;
+        if (exponent) base = base * base;
+    }
+    return result;
+}
+
+// ============================================================================
+// GCD and factorization
+// ============================================================================
+
+namespace {
+
+IntPoly toIntPoly(const Polynomial& p, const std::string& name) {
+    std::vector<double> dense = p.coefficients(name);
+    return IntPoly(dense.begin(), dense.end());
+}
+
+Polynomial fromIntPoly(const std::string& name, const IntPoly& p) {
+    return Polynomial::fromCoefficients(name, std::vector<double>(p.begin(), p.end()));
+}
+
+// The one variable of a and b, or "" when both are constant
+std::string commonVariable(const Polynomial& a, const Polynomial& b, const char* operation) {
+    if (!a.hasIntegerCoefficients() || !b.hasIntegerCoefficients()) {
+        throw std::runtime_error(std::string(operation) + " needs integer coefficients");
+    }
+    std::string name;
+    for (const Polynomial* p : {&a, &b}) {
+        for (const auto& var : p->variables()) {
+            if (!name.empty() && var != name) {
+                throw std::runtime_error(std::string(operation) + " needs univariate polynomials");
+            }
+            name = var;
+        }
+    }
+    return name;
+}
+
+} // namespace
+
+Polynomial Polynomial::gcd(const Polynomial& a, const Polynomial& b) {
+    std::string name = commonVariable(a, b, "Polynomial GCD");
+    if (name.empty()) {
+        return constant(static_cast<double>(gcdInt(static_cast<int64_t>(a.leadingCoefficient()),
+                                                   static_cast<int64_t>(b.leadingCoefficient()))));
+    }
+    return fromIntPoly(name, gcdOf(toIntPoly(a, name), toIntPoly(b, name)));
+}
+
+std::vector<std::pair<Polynomial, unsigned>> Polynomial::squareFree() const {
+    std::string name = commonVariable(*this, *this, "Square-free decomposition");
+    std::vector<std::pair<Polynomial, unsigned>> parts;
+    if (name.empty()) return parts;
+    for (const auto& [part, multiplicity] : squareFreeOf(primitive(toIntPoly(*this, name)))) {
+        parts.emplace_back(fromIntPoly(name, part), multiplicity);
+    }
+    return parts;
+}
+
+PolynomialFactorization Polynomial::factor() const {
+    PolynomialFactorization result;
+    if (isConstant()) {
+        result.content = leadingCoefficient();
+        return result;
+    }
+
+    Polynomial rest = *this;
+    bool integral = hasIntegerCoefficients();
+    if (integral) {
+        int64_t content = 0;
+        for (double c : coeffs) content = gcdInt(content, static_cast<int64_t>(c));
+        double signedContent = leadingCoefficient() < 0 ? -static_cast<double>(content) : content;
+        for (double& c : rest.coeffs) c /= signedContent;
+        result.content = signedContent;
+    }
+
+    // Common monomial: the lowest power of each variable over all terms
+    size_t n = vars.size();
+    for (size_t v = 0; v < n; ++v) {
+        uint32_t lowest = rest.exponent(0, v);
+        for (size_t t = 1; t < rest.termCount(); ++t) lowest = std::min(lowest, rest.exponent(t, v));
+        if (lowest == 0) continue;
+        for (size_t t = 0; t < rest.termCount(); ++t) rest.exps[t * n + v] -= lowest;
+        result.factors.emplace_back(variable(vars[v]), lowest);
+    }
+    rest.compact();
+
+    if (rest.isConstant()) {
+        result.content *= rest.leadingCoefficient();
+    } else if (integral && rest.vars.size() == 1) {
+        const std::string& name = rest.vars[0];
+        for (const auto& [part, multiplicity] : squareFreeOf(toIntPoly(rest, name))) {
+            for (const IntPoly& piece : splitRationalRoots(part)) {
+                result.factors.emplace_back(fromIntPoly(name, piece), multiplicity);
+            }
+        }
+    } else {
+        result.factors.emplace_back(rest, 1);
+    }
+
+    std::stable_sort(result.factors.begin(), result.factors.end(), [](const auto& x, const auto& y) {
+        const Polynomial& a = x.first;
+        const Polynomial& b = y.first;
+        if (a.degree() != b.degree()) return a.degree() < b.degree();
+        if (a.vars != b.vars) return a.vars < b.vars;
+        if (a.coeffs != b.coeffs) return a.coeffs < b.coeffs;
+        return a.exps < b.exps;
+    });
+    return result;
+}
+
+Polynomial PolynomialFactorization::expand() const {
+    Polynomial product = Polynomial::constant(content);
+    for (const auto& [factor, multiplicity] : factors) product = product * factor.pow(multiplicity);
+    return product;
+}
@@ -0,0 +1,129 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include "SymbolicEngine.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct PolynomialFactorization;
+
+// Polynomial - sparse multivariate polynomial with double coefficients.
+//
+// Terms live in two parallel arrays: one coefficient per term, and the
+// exponent vectors of all terms packed row by row into a single uint32
+// array (one column per variable, variables sorted by name). Terms are kept
+// in strictly decreasing lexicographic order with no zero coefficients, so
+// equal polynomials have identical arrays and sums are linear merges.
+// Products accumulate into a dense array indexed by mixed-radix monomial
+// keys when the exponent box is small, and sort packed keys otherwise.
+//
+// Coefficients are exact while they stay integers below 2^53, which covers
+// expansions such as (x + 1)^50. gcd() and squareFree() require that and
+// throw otherwise; factor() instead leaves such a polynomial unsplit apart
+// from monomial factors, e.g. (x + 1)^60 comes back as one factor. Values
+// are immutable after construction apart from assignment, so const members
+// are safe to call concurrently.
+class Polynomial {
+private:
+    std::vector<std::string> vars;
+    std::vector<uint32_t> exps;     // termCount() x vars.size(), row-major
+    std::vector<double> coeffs;
+
+    const uint32_t* row(size_t term) const { return exps.data() + term * vars.size(); }
+
+    // Same polynomial over a superset of its variables (sorted)
+    Polynomial over(const std::vector<std::string>& names) const;
+    static std::vector<std::string> mergeVariables(const Polynomial& a, const Polynomial& b);
+
+    // Sorts terms, combines equal monomials and drops zeros
+    void normalize();
+    // Drops variables whose exponent is zero in every term
+    void compact();
+
+public:
+    // The zero polynomial
+    Polynomial() = default;
+
+    static Polynomial constant(double value);
+    static Polynomial variable(const std::string& name);
+
+    // sum coefficients[i] * name^i
+    static Polynomial fromCoefficients(const std::string& name, const std::vector<double>& coefficients);
+
+    // Expanded polynomial for a tree built from numbers, variables, + - *,
+    // division by constants and non-negative integer powers; constant
+    // subtrees (functions included) are folded to numbers. Throws
+    // std::runtime_error for anything else.
+    static Polynomial fromSymbolic(const SymbolicExpression& expr);
+
+    // Sum of terms in decreasing order, e.g. ((x ^ 2) + (2x)) + 1
+    std::unique_ptr<SymbolicExpression> toSymbolic() const;
+    std::string toString() const { return toSymbolic()->toString(); }
+
+    bool isZero() const { return coeffs.empty(); }
+    bool isConstant() const;
+    size_t termCount() const { return coeffs.size(); }
+    const std::vector<std::string>& variables() const { return vars; }
+
+    // Term access in storage order
+    double coefficient(size_t term) const { return coeffs[term]; }
+    uint32_t exponent(size_t term, size_t variableIndex) const { return row(term)[variableIndex]; }
+
+    // Total degree, and degree in one variable; -1 for the zero polynomial
+    int degree() const;
+    int degree(const std::string& name) const;
+    double leadingCoefficient() const { return coeffs.empty() ? 0.0 : coeffs.front(); }
+
+    // Dense coefficients in name, lowest power first; throws if any other
+    // variable occurs
+    std::vector<double> coefficients(const std::string& name) const;
+
+    bool hasIntegerCoefficients() const;
+
+    double evaluate(const std::map<std::string, double>& values) const;
+    Polynomial derivative(const std::string& name) const;
+
+    Polynomial operator+(const Polynomial& other) const;
+    Polynomial operator-(const Polynomial& other) const;
+    Polynomial operator*(const Polynomial& other) const;
+    Polynomial operator-() const;
+    Polynomial scaled(double factor) const;
+    Polynomial pow(unsigned exponent) const;
+
+    bool operator==(const Polynomial& other) const;
+    bool operator!=(const Polynomial& other) const { return !(*this == other); }
+
+    // Greatest common divisor of two univariate integer polynomials in the
+    // same variable, with positive leading coefficient. Computed modulo
+    // word-sized primes and lifted by Chinese remaindering, then verified
+    // by exact division. Throws std::runtime_error for multivariate or
+    // non-integer input, or when the result does not fit 64-bit integers.
+    static Polynomial gcd(const Polynomial& a, const Polynomial& b);
+
+    // Yun's square-free decomposition of a univariate integer polynomial:
+    // pairwise coprime primitive factors a_i with this = c * prod a_i^i
+    std::vector<std::pair<Polynomial, unsigned>> squareFree() const;
+
+    // Numeric content, monomial factors, then for univariate integer
+    // polynomials the square-free parts split by their rational roots.
+    // Factors of degree >= 2 without rational roots, multivariate
+    // remainders and remainders whose coefficients are not exact integers
+    // are left whole (no throw), so this is not complete factorization over
+    // the integers.
+    PolynomialFactorization factor() const;
+};
+
+struct PolynomialFactorization {
+    double content = 1;
+    std::vector<std::pair<Polynomial, unsigned>> factors;   // (factor, multiplicity), by degree
+
+    // content * prod factor^multiplicity
+    Polynomial expand() const;
+};
+
+#endif // POLYNOMIAL_H
@@ -0,0 +1,180 @@
+#include "Quadrature.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Kronrod abscissae on [-1, 1] (positive half; odd indices are the Gauss
+// points) and weights, from QUADPACK's qk15
+constexpr double kKronrodNodes[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+constexpr double kKronrodWeights[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+constexpr double kGaussWeights[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+constexpr size_t kNodesPerInterval = 15;
+
+// Points per parallelFor chunk in a large round
+constexpr size_t kParallelGrain = 1024;
+
+struct Interval {
+    double a;
+    double b;
+    double value;
+    double error;
+};
+
+// Node k of [a, b]: 0..6 left of the centre, 7 the centre, 8..14 to the right
+double nodeAt(double a, double b, size_t k) {
+    double centre = 0.5 * (a + b);
+    double half = 0.5 * (b - a);
+    if (k < 7) return centre - half * kKronrodNodes[k];
+    if (k == 7) return centre;
+    return centre + half * kKronrodNodes[14 - k];
+}
+
+// K15 and G7 from the 15 values laid out as nodeAt
+void estimate(Interval& interval, const double* f) {
+    double half = 0.5 * (interval.b - interval.a);
+    double centre = f[7];
+    double kronrod = centre * kKronrodWeights[7];
+    double gauss = centre * kGaussWeights[3];
+    for (size_t j = 0; j < 7; ++j) {
+        double pair = f[j] + f[14 - j];
+        kronrod += kKronrodWeights[j] * pair;
+        if (j % 2 == 1) gauss += kGaussWeights[j / 2] * pair;
+    }
+
+    // QUADPACK's error scaling: resasc measures how far f strays from its mean
+    double mean = 0.5 * kronrod;
+    double resasc = kKronrodWeights[7] * std::abs(centre - mean);
+    for (size_t j = 0; j < 7; ++j) {
+        resasc += kKronrodWeights[j] * (std::abs(f[j] - mean) + std::abs(f[14 - j] - mean));
+    }
+    resasc *= std::abs(half);
+    double error = std::abs((kronrod - gauss) * half);
+    if (resasc != 0 && error != 0) {
+        error = resasc * std::min(1.0, std::pow(200 * error / resasc, 1.5));
+    }
+
+    interval.value = kronrod * half;
+    interval.error = std::isfinite(interval.value) ? error : std::numeric_limits<double>::infinity();
+}
+
+} // namespace
+
+QuadratureResult Quadrature::integrate(const CompiledExpression& program, const std::string& variable,
+                                       const std::map<std::string, double>& parameters, double a, double b,
+                                       const QuadratureOptions& options, ThreadPool& pool) {
+    if (program.empty()) {
+        throw std::runtime_error("No expression compiled");
+    }
+    if (!std::isfinite(a) || !std::isfinite(b)) {
+        throw std::runtime_error("Integration bounds must be finite");
+    }
+
+    const std::vector<std::string>& names = program.getSlotNames();
+    int slot = program.getSlot(variable);
+    std::vector<double> bound(names.size(), 0.0);
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (static_cast<int>(i) == slot) continue;
+        auto it = parameters.find(names[i]);
+        if (it == parameters.end()) {
+            throw std::runtime_error("Undefined variable: " + names[i]);
+        }
+        bound[i] = it->second;
+    }
+
+    QuadratureResult result;
+    if (a == b) {
+        result.converged = true;
+        return result;
+    }
+
+    std::vector<Interval> accepted;
+    std::vector<Interval> pending{Interval{a, b, 0, 0}};
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<std::vector<double>> constantColumns;
+    double acceptedValue = 0;
+    double acceptedError = 0;
+    double width = std::abs(b - a);
+
+    while (!pending.empty()) {
+        // Evaluate the nodes of every pending interval in one batch
+        size_t points = pending.size() * kNodesPerInterval;
+        xs.resize(points);
+        ys.resize(points);
+        for (size_t i = 0; i < pending.size(); ++i) {
+            for (size_t k = 0; k < kNodesPerInterval; ++k) {
+                xs[i * kNodesPerInterval + k] = nodeAt(pending[i].a, pending[i].b, k);
+            }
+        }
+        constantColumns.resize(names.size());
+        std::vector<const double*> columns(names.size());
+        for (size_t s = 0; s < names.size(); ++s) {
+            if (static_cast<int>(s) == slot) {
+                columns[s] = xs.data();
+            } else {
+                constantColumns[s].assign(points, bound[s]);
+                columns[s] = constantColumns[s].data();
+            }
+        }
+        if (points < options.parallelPoints) {
+            program.evalBatch(columns.data(), ys.data(), points);
+        } else {
+            pool.parallelFor(points, kParallelGrain, [&](size_t begin, size_t end) {
+                std::vector<const double*> shifted(columns.size());
+                for (size_t s = 0; s < columns.size(); ++s) shifted[s] = columns[s] + begin;
+                program.evalBatch(shifted.data(), ys.data() + begin, end - begin);
+            });
+        }
+        result.evaluations += points;
+
+        double roundValue = acceptedValue;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            estimate(pending[i], ys.data() + i * kNodesPerInterval);
+            roundValue += pending[i].value;
+        }
+
+        // Accept intervals within their share of the tolerance, split the rest
+        double tolerance = std::max(options.absTolerance, options.relTolerance * std::abs(roundValue));
+        std::vector<Interval> next;
+        bool capacity = accepted.size() + 2 * pending.size() <= options.maxIntervals;
+        for (const Interval& interval : pending) {
+            double share = tolerance * std::abs(interval.b - interval.a) / width;
+            double middle = 0.5 * (interval.a + interval.b);
+            bool splittable = middle != interval.a && middle != interval.b;
+            if (interval.error <= share || !capacity || !splittable) {
+                accepted.push_back(interval);
+                acceptedValue += interval.value;
+                acceptedError += interval.error;
+            } else {
+                next.push_back(Interval{interval.a, middle, 0, 0});
+                next.push_back(Interval{middle, interval.b, 0, 0});
+            }
+        }
+        pending.swap(next);
+    }
+
+    // Sum in position order so the result does not depend on round structure
+    std::sort(accepted.begin(), accepted.end(), [](const Interval& l, const Interval& r) { return l.a < r.a; });
+    result.value = 0;
+    for (const Interval& interval : accepted) result.value += interval.value;
+    result.errorEstimate = acceptedError;
+    result.intervals = accepted.size();
+    double tolerance = std::max(options.absTolerance, options.relTolerance * std::abs(result.value));
+    result.converged = std::isfinite(result.value) && result.errorEstimate <= tolerance;
+    return result;
+}
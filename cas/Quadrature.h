@@ -0,0 +1,49 @@
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include "../evaluator/CompiledExpression.h"
+#include "../util/ThreadPool.h"
+#include <cstddef>
+#include <map>
+#include <string>
+
+struct QuadratureOptions {
+    double absTolerance = 1e-10;
+    double relTolerance = 1e-10;   // of |result|; the looser of the two governs
+    size_t maxIntervals = 4096;    // subintervals alive at once
+    size_t parallelPoints = 4096;  // rounds with fewer nodes run on the calling thread
+};
+
+struct QuadratureResult {
+    double value = 0;
+    double errorEstimate = 0;
+    size_t evaluations = 0;
+    size_t intervals = 0;      // subintervals in the final partition
+    bool converged = false;    // errorEstimate within tolerance
+    bool symbolic = false;     // value came from an antiderivative
+};
+
+// Quadrature - adaptive Gauss-Kronrod (G7/K15) integration of a compiled
+// program over a finite interval.
+//
+// Refinement runs in rounds: every subinterval whose error estimate exceeds
+// its share of the tolerance (abs or rel, scaled by its width) is bisected,
+// and the 15 nodes of all new halves are evaluated together with evalBatch,
+// split across the thread pool once a round is large enough. Error
+// estimates use the QUADPACK scaling of |K15 - G7|. Points outside the
+// domain (NaN) force further splitting; if they persist the result is NaN
+// and not converged. Integrable endpoint singularities are handled because
+// Kronrod nodes never touch the ends. Runs parallelFor, so it must not be
+// called from inside another parallelFor body on the same pool unless
+// parallelPoints keeps it on the calling thread.
+class Quadrature {
+public:
+    // Integral of program over variable from a to b (b < a gives the negated
+    // integral) with the remaining slots bound from parameters
+    static QuadratureResult integrate(const CompiledExpression& program, const std::string& variable,
+                                      const std::map<std::string, double>& parameters, double a, double b,
+                                      const QuadratureOptions& options = QuadratureOptions(),
+                                      ThreadPool& pool = ThreadPool::shared());
+};
+
+#endif // QUADRATURE_H
@@ -0,0 +1,217 @@
+#include "RootFinder.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Queries handed to one worker at a time; each is a full grid scan
+constexpr size_t kQueryGrain = 4;
+
+bool oppositeSigns(double a, double b) {
+    return (a < 0 && b > 0) || (a > 0 && b < 0);
+}
+
+} // namespace
+
+RootFinder::RootFinder(const CompiledExpression& program, const std::string& variable,
+                       const std::map<std::string, double>& parameters, const RootOptions& options)
+    : program(program), slots(program.getSlotCount(), 0.0), point(slots.size()), slot(program.getSlot(variable)),
+      options(options) {
+    if (program.empty()) {
+        throw std::runtime_error("No expression compiled");
+    }
+    const std::vector<std::string>& names = program.getSlotNames();
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (static_cast<int>(i) == slot) continue;
+        auto it = parameters.find(names[i]);
+        if (it == parameters.end()) {
+            throw std::runtime_error("Undefined variable: " + names[i]);
+        }
+        slots[i] = it->second;
+    }
+    if (this->options.samples == 0) {
+        this->options.samples = 1;
+    }
+}
+
+double RootFinder::value(double x) const {
+    point = slots;
+    if (slot >= 0) point[slot] = x;
+    EvalStatus status = EvalStatus::OK;
+    return program.eval(point.data(), status);
+}
+
+double RootFinder::value(double x, double& slope) const {
+    if (slot < 0) {
+        slope = 0;
+        return value(x);
+    }
+    point = slots;
+    point[slot] = x;
+    EvalStatus status = EvalStatus::OK;
+    return program.evalDerivative(point.data(), static_cast<size_t>(slot), slope, status);
+}
+
+bool RootFinder::converged(double step, double x) const {
+    return std::abs(step) <= options.xTolerance * std::max(1.0, std::abs(x));
+}
+
+bool RootFinder::bracket(double a, double b, Root& root) const {
+    double fa = value(a);
+    double fb = value(b);
+    root.bracketed = true;
+    root.iterations = 0;
+    if (fa == 0 || fb == 0) {
+        root.x = fa == 0 ? a : b;
+        root.residual = 0;
+        return true;
+    }
+    if (!oppositeSigns(fa, fb)) {
+        return false;
+    }
+
+    // Keep f(lo) < 0 < f(hi); Newton steps are taken only inside (lo, hi)
+    double lo = fa < 0 ? a : b;
+    double hi = fa < 0 ? b : a;
+    double x = 0.5 * (a + b);
+    double step = std::abs(b - a);
+    double previousStep = step;
+    double slope = 0;
+    double f = value(x, slope);
+
+    for (size_t iteration = 1; iteration <= options.maxIterations; ++iteration) {
+        root.iterations = iteration;
+        if (std::isnan(f)) {
+            return false;   // domain hole inside the bracket
+        }
+        bool newtonInside = std::isfinite(slope) && slope != 0 &&
+                            ((x - hi) * slope - f) * ((x - lo) * slope - f) < 0;
+        bool newtonFast = std::abs(2 * f) <= std::abs(previousStep * slope);
+        previousStep = step;
+        if (newtonInside && newtonFast) {
+            step = f / slope;
+            x -= step;
+        } else {
+            step = 0.5 * (hi - lo);
+            x = lo + step;
+        }
+        if (converged(step, x)) break;
+
+        f = value(x, slope);
+        if (f == 0) break;
+        if (f < 0) {
+            lo = x;
+        } else {
+            hi = x;
+        }
+    }
+
+    root.x = x;
+    root.residual = value(x);
+    // Across a pole |f| grows as the bracket closes; at a root it shrinks
+    return std::abs(root.residual) <= std::min(std::abs(fa), std::abs(fb));
+}
+
+bool RootFinder::newton(double x0, Root& root) const {
+    double x = x0;
+    root.bracketed = false;
+    for (size_t iteration = 1; iteration <= options.maxIterations; ++iteration) {
+        root.iterations = iteration;
+        double slope = 0;
+        double f = value(x, slope);
+        if (!std::isfinite(f)) return false;
+        if (f == 0) break;
+        if (!std::isfinite(slope) || slope == 0) return false;
+        double step = f / slope;
+        x -= step;
+        if (converged(step, x)) break;
+    }
+    root.x = x;
+    root.residual = value(x);
+    return std::abs(root.residual) <= options.residualTolerance;
+}
+
+std::vector<Root> RootFinder::findAll(double lo, double hi) const {
+    std::vector<Root> roots;
+    if (slot < 0 || !(lo <= hi)) {
+        return roots;   // f is constant in the variable, or an empty interval
+    }
+
+    // One batch evaluation over the grid; points outside the domain are NaN
+    size_t n = options.samples;
+    std::vector<double> xs(n + 1);
+    for (size_t i = 0; i <= n; ++i) {
+        xs[i] = (i == n) ? hi : lo + (hi - lo) * static_cast<double>(i) / n;
+    }
+    std::vector<std::vector<double>> constantColumns;
+    std::vector<const double*> columns(slots.size());
+    for (size_t s = 0; s < slots.size(); ++s) {
+        if (static_cast<int>(s) == slot) {
+            columns[s] = xs.data();
+        } else {
+            constantColumns.emplace_back(n + 1, slots[s]);
+            columns[s] = constantColumns.back().data();
+        }
+    }
+    std::vector<double> ys(n + 1);
+    program.evalBatch(columns.data(), ys.data(), n + 1);
+
+    Root root;
+    for (size_t i = 0; i <= n; ++i) {
+        // The batch kernels may differ from eval in the last bits, so every
+        // candidate is confirmed with scalar evaluation
+        if (ys[i] == 0 && value(xs[i]) == 0) {
+            roots.push_back(Root{xs[i], 0, 0, true});
+        }
+        // At an end there is no sign change or neighbour on the far side to
+        // go by, as for sin(x) on [0, pi] with pi rounded down; a small
+        // enough residual is the root
+        if ((i == 0 || i == n) && ys[i] != 0 && std::abs(ys[i]) <= options.residualTolerance) {
+            double residual = value(xs[i]);
+            if (std::abs(residual) <= options.residualTolerance) {
+                roots.push_back(Root{xs[i], residual, 0, false});
+            }
+        }
+        if (i < n && oppositeSigns(ys[i], ys[i + 1]) && bracket(xs[i], xs[i + 1], root)) {
+            roots.push_back(root);
+        }
+        if (i > 0 && i < n && std::isfinite(ys[i - 1]) && std::isfinite(ys[i + 1]) && ys[i] != 0 &&
+            !oppositeSigns(ys[i - 1], ys[i]) && !oppositeSigns(ys[i], ys[i + 1]) &&
+            std::abs(ys[i]) <= std::abs(ys[i - 1]) && std::abs(ys[i]) <= std::abs(ys[i + 1]) &&
+            newton(xs[i], root) && root.x >= xs[i - 1] && root.x <= xs[i + 1]) {
+            roots.push_back(root);
+        }
+    }
+
+    // Neighbouring intervals can converge on the same root
+    std::sort(roots.begin(), roots.end(), [](const Root& a, const Root& b) { return a.x < b.x; });
+    std::vector<Root> merged;
+    double spacing = (hi - lo) / n;
+    for (const Root& r : roots) {
+        double tolerance = std::max(1e3 * options.xTolerance * std::max(1.0, std::abs(r.x)), 1e-9 * spacing);
+        if (!merged.empty() && r.x - merged.back().x <= tolerance) {
+            if (std::abs(r.residual) < std::abs(merged.back().residual)) merged.back() = r;
+            continue;
+        }
+        merged.push_back(r);
+    }
+    return merged;
+}
+
+std::vector<RootResult> RootFinder::solveMany(const std::vector<RootQuery>& queries, const RootOptions& options,
+                                              ThreadPool& pool) {
+    std::vector<RootResult> results(queries.size());
+    pool.parallelFor(queries.size(), kQueryGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const RootQuery& query = queries[i];
+            try {
+                RootFinder finder(query.equation.program(), query.variable, query.parameters, options);
+                results[i].roots = finder.findAll(query.lo, query.hi);
+            } catch (const std::exception& e) {
+                results[i].error = e.what();
+            }
+        }
+    });
+    return results;
+}
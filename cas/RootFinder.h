@@ -0,0 +1,89 @@
+#ifndef ROOT_FINDER_H
+#define ROOT_FINDER_H
+
+#include "Expression.h"
+#include "../util/ThreadPool.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+struct RootOptions {
+    size_t samples = 256;              // grid intervals scanned by findAll
+    double xTolerance = 1e-12;         // step size (relative to max(1, |x|)) that ends refinement
+    double residualTolerance = 1e-10;  // |f| accepted for roots found without a sign change
+    size_t maxIterations = 100;
+};
+
+struct Root {
+    double x = 0;
+    double residual = 0;     // f(x)
+    size_t iterations = 0;
+    bool bracketed = false;  // true when refined inside a sign change
+};
+
+// One equation f(variable) = 0 on [lo, hi] with the other variables bound
+struct RootQuery {
+    Expression equation;
+    double lo = 0;
+    double hi = 0;
+    std::map<std::string, double> parameters;
+    std::string variable = "x";
+};
+
+struct RootResult {
+    std::vector<Root> roots;   // ascending
+    std::string error;         // empty unless the query could not be run
+};
+
+// RootFinder - numeric solutions of f(x) = 0 on a compiled program.
+//
+// findAll samples the interval with one batch evaluation, then refines every
+// sign change with a safeguarded Newton iteration: Newton steps use slopes
+// from forward-mode AD over the bytecode (evalDerivative) and fall back to
+// bisection whenever a step would leave the bracket or converge too slowly,
+// so refinement never diverges. Sign changes across poles (1/x) are
+// rejected because |f| grows instead of shrinking. Grid points where |f| has
+// a local minimum without a sign change are polished with plain Newton,
+// which finds touching roots such as (x - 1)^2. Evaluation never throws:
+// points outside the domain count as NaN and are skipped.
+//
+// A finder only reads the program, so finders on different threads can share
+// one program; a single finder is not thread-safe. solveMany spreads
+// independent queries over a thread pool.
+class RootFinder {
+private:
+    const CompiledExpression& program;
+    std::vector<double> slots;
+    mutable std::vector<double> point;   // scratch copy of slots for one evaluation
+    int slot;                 // index of the variable; -1 when f does not depend on it
+    RootOptions options;
+
+    double value(double x) const;
+    double value(double x, double& slope) const;
+    bool converged(double step, double x) const;
+
+public:
+    // Throws std::runtime_error when program is empty or uses a variable
+    // that is neither the unknown nor bound in parameters
+    RootFinder(const CompiledExpression& program, const std::string& variable = "x",
+               const std::map<std::string, double>& parameters = {}, const RootOptions& options = RootOptions());
+
+    // Refines a root between a and b; false unless f(a) and f(b) have
+    // opposite signs (or one is zero) and the sign change is a root
+    bool bracket(double a, double b, Root& root) const;
+
+    // Newton iteration from x0; false if it stalls, leaves the domain or ends
+    // with |f| above residualTolerance
+    bool newton(double x0, Root& root) const;
+
+    // Every root found in [lo, hi], ascending; near-duplicates merged
+    std::vector<Root> findAll(double lo, double hi) const;
+
+    // Runs findAll for each query in parallel; failures are reported per query
+    static std::vector<RootResult> solveMany(const std::vector<RootQuery>& queries,
+                                             const RootOptions& options = RootOptions(),
+                                             ThreadPool& pool = ThreadPool::shared());
+};
+
+#endif // ROOT_FINDER_H
@@ -0,0 +1,474 @@
+#include "Simplifier.h"
+#include "../util/Instrumentation.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+using BinOp = SymbolicBinaryOp::OpType;
+using UnOp = SymbolicUnaryOp::OpType;
+
+bool isBinary(const ExprNode* node, BinOp op) {
+    return node->kind == ExprNode::Kind::BINARY && node->binaryOp() == op;
+}
+
+bool isUnary(const ExprNode* node, UnOp op) {
+    return node->kind == ExprNode::Kind::UNARY && node->unaryOp() == op;
+}
+
+// Exact where Number::pow is; throws "Division by zero" for 0^-n
+Number raise(const Number& coefficient, const Number& exponent) {
+    return coefficient.pow(exponent);
+}
+
+// Polynomial degree of a term, used to order sums highest degree first.
+// Only product structure is followed, so the walk is linear in the term.
+double degree(const ExprNode* node) {
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+            return 0.0;
+        case ExprNode::Kind::VARIABLE:
+            return 1.0;
+        case ExprNode::Kind::BINARY: {
+            const ExprNode* left = node->child(0);
+            const ExprNode* right = node->child(1);
+            switch (node->binaryOp()) {
+                case BinOp::MULTIPLY: return degree(left) + degree(right);
+                case BinOp::DIVIDE: return degree(left) - degree(right);
+                case BinOp::POWER:
+                    return right->kind == ExprNode::Kind::NUMBER ? degree(left) * right->value : degree(left);
+                default: return 1.0;
+            }
+        }
+        case ExprNode::Kind::UNARY:
+            return node->unaryOp() == UnOp::NEGATIVE ? degree(node->child(0)) : 1.0;
+        case ExprNode::Kind::FUNCTION:
+            return 1.0;
+    }
+    return 1.0;
+}
+
+// Whether b^inner may be rewritten as b^outer. A non-integer inner exponent
+// confines b to b >= 0, and so must a non-integer outer one
+bool keepsDomain(const Number& inner, const Number& outer) {
+    return inner.isInteger() || !outer.isInteger();
+}
+
+} // namespace
+
+Simplifier::Simplifier(ExpressionStore& store, SimplifierOptions options)
+    : store(store), options(options) {}
+
+int Simplifier::compare(const ExprNode* a, const ExprNode* b) {
+    // Structurally equal subtrees are the same node, so the walk follows a
+    // single path down to the first difference
+    if (a == b) return 0;
+    if (a->kind != b->kind) return a->kind < b->kind ? -1 : 1;
+
+    switch (a->kind) {
+        case ExprNode::Kind::NUMBER: {
+            // Equal values of different kinds (1/2 and 0.5) order exact first
+            int order = Number::compare(*a->exact, *b->exact);
+            if (order != 0) return order;
+            if (a->exact->kind() != b->exact->kind()) return a->exact->kind() < b->exact->kind() ? -1 : 1;
+            return 0;
+        }
+        case ExprNode::Kind::VARIABLE:
+            return a->name->compare(*b->name) < 0 ? -1 : 1;
+        case ExprNode::Kind::FUNCTION:
+            if (*a->name != *b->name) return a->name->compare(*b->name) < 0 ? -1 : 1;
+            break;
+        default:
+            if (a->op != b->op) return a->op < b->op ? -1 : 1;
+            break;
+    }
+
+    if (a->arity != b->arity) return a->arity < b->arity ? -1 : 1;
+    for (uint32_t i = 0; i < a->arity; ++i) {
+        int result = compare(a->child(i), b->child(i));
+        if (result != 0) return result;
+    }
+    return 0;
+}
+
+const ExprNode* Simplifier::simplify(const ExprNode* node) {
+    CAS_TIME_PHASE(SIMPLIFY);
+    CAS_COUNT(SIMPLIFY_CALLS);
+    CAS_COUNT_GROWTH(SIMPLIFY_NODES, store.nodeCount());
+    stats = SimplifierStats();
+
+    auto cached = results.find(node);
+    if (cached != results.end()) {
+        stats.cacheHits++;
+        stats.converged = true;
+        return cached->second;
+    }
+
+    const ExprNode* current = node;
+    while (stats.passes < options.maxPasses) {
+        pass.clear();
+        const ExprNode* next = rewrite(current);
+        stats.passes++;
+        if (stats.steps >= options.maxSteps) {
+            current = next;
+            break;
+        }
+        if (next == current) {
+            stats.converged = true;
+            break;
+        }
+        current = next;
+    }
+
+    if (stats.converged) {
+        // Every node the final pass left unchanged is a fixed point too
+        for (const auto& entry : pass) {
+            if (entry.first == entry.second) {
+                results.emplace(entry.first, entry.second);
+            }
+        }
+        results.emplace(node, current);
+    }
+    pass.clear();
+    return current;
+}
+
+const ExprNode* Simplifier::rewrite(const ExprNode* node) {
+    auto cached = results.find(node);
+    if (cached != results.end()) {
+        stats.cacheHits++;
+        return cached->second;
+    }
+    auto done = pass.find(node);
+    if (done != pass.end()) {
+        return done->second;
+    }
+    if (stats.steps >= options.maxSteps) {
+        return node;
+    }
+    stats.steps++;
+
+    const ExprNode* result = node;
+    switch (node->kind) {
+        case ExprNode::Kind::NUMBER:
+        case ExprNode::Kind::VARIABLE:
+            break;
+        case ExprNode::Kind::BINARY:
+            switch (node->binaryOp()) {
+                case BinOp::ADD:
+                case BinOp::SUBTRACT:
+                    result = rewriteSum(node);
+                    break;
+                case BinOp::MULTIPLY:
+                case BinOp::DIVIDE:
+                    result = rewriteProduct(node);
+                    break;
+                case BinOp::POWER:
+                    result = rewritePower(node);
+                    break;
+            }
+            break;
+        case ExprNode::Kind::UNARY:
+            if (node->unaryOp() == UnOp::NEGATIVE) {
+                result = rewriteSum(node);
+            } else if (node->unaryOp() == UnOp::POSITIVE) {
+                result = rewrite(node->child(0));
+            } else {
+                result = rewriteApplication(node);
+            }
+            break;
+        case ExprNode::Kind::FUNCTION:
+            result = rewriteApplication(node);
+            break;
+    }
+
+    pass.emplace(node, result);
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// Sums
+// ----------------------------------------------------------------------------
+
+const ExprNode* Simplifier::rewriteSum(const ExprNode* node) {
+    std::vector<Term> terms;
+    collectTerms(node, 1, terms);
+    return buildSum(terms);
+}
+
+void Simplifier::collectTerms(const ExprNode* node, int sign, std::vector<Term>& terms, bool rewriteLeaves) {
+    // Walk the ADD/SUBTRACT/NEGATIVE chain; leaves are rewritten and may
+    // themselves come back as sums, which are flattened into this one
+    if (isBinary(node, BinOp::ADD)) {
+        collectTerms(node->child(0), sign, terms, rewriteLeaves);
+        collectTerms(node->child(1), sign, terms, rewriteLeaves);
+    } else if (isBinary(node, BinOp::SUBTRACT)) {
+        collectTerms(node->child(0), sign, terms, rewriteLeaves);
+        collectTerms(node->child(1), -sign, terms, rewriteLeaves);
+    } else if (isUnary(node, UnOp::NEGATIVE)) {
+        collectTerms(node->child(0), -sign, terms, rewriteLeaves);
+    } else if (isUnary(node, UnOp::POSITIVE)) {
+        collectTerms(node->child(0), sign, terms, rewriteLeaves);
+    } else {
+        const ExprNode* leaf = rewriteLeaves ? rewrite(node) : node;
+        if (leaf != node && (isBinary(leaf, BinOp::ADD) || isBinary(leaf, BinOp::SUBTRACT) ||
+                             isUnary(leaf, UnOp::NEGATIVE))) {
+            collectTerms(leaf, sign, terms, false);
+            return;
+        }
+        auto split = splitCoefficient(leaf);
+        terms.push_back({sign < 0 ? -split.first : split.first, split.second});
+    }
+}
+
+std::pair<Number, const ExprNode*> Simplifier::splitCoefficient(const ExprNode* node) {
+    // Inverse of buildTerm: separate the numeric coefficient from the rest
+    if (node->kind == ExprNode::Kind::NUMBER) {
+        return {*node->exact, nullptr};
+    }
+    if (isUnary(node, UnOp::NEGATIVE)) {
+        auto inner = splitCoefficient(node->child(0));
+        return {-inner.first, inner.second};
+    }
+    if (isBinary(node, BinOp::MULTIPLY) && node->child(0)->kind == ExprNode::Kind::NUMBER) {
+        return {*node->child(0)->exact, node->child(1)};
+    }
+    if (isBinary(node, BinOp::DIVIDE)) {
+        const ExprNode* numerator = node->child(0);
+        const ExprNode* denominator = node->child(1);
+        if (numerator->kind == ExprNode::Kind::NUMBER && !numerator->isNumber(1.0)) {
+            return {*numerator->exact, store.binary(BinOp::DIVIDE, store.number(1.0), denominator)};
+        }
+        if (isBinary(numerator, BinOp::MULTIPLY) && numerator->child(0)->kind == ExprNode::Kind::NUMBER) {
+            return {*numerator->child(0)->exact, store.binary(BinOp::DIVIDE, numerator->child(1), denominator)};
+        }
+        if (denominator->kind == ExprNode::Kind::NUMBER && !denominator->exact->isZero()) {
+            return {denominator->exact->reciprocal(), numerator};
+        }
+    }
+    return {Number(1), node};
+}
+
+const ExprNode* Simplifier::buildSum(std::vector<Term>& terms) {
+    // Merge like terms; hash-consing makes equal terms pointer-equal
+    std::vector<Term> merged;
+    std::unordered_map<const ExprNode*, size_t> index;
+    for (const Term& term : terms) {
+        auto inserted = index.emplace(term.rest, merged.size());
+        if (inserted.second) {
+            merged.push_back(term);
+        } else {
+            merged[inserted.first->second].coefficient += term.coefficient;
+        }
+    }
+    merged.erase(std::remove_if(merged.begin(), merged.end(),
+                                [](const Term& term) { return term.coefficient.isZero(); }),
+                 merged.end());
+
+    // Highest degree first, constant term last
+    std::stable_sort(merged.begin(), merged.end(), [](const Term& a, const Term& b) {
+        if (!a.rest || !b.rest) return b.rest == nullptr && a.rest != nullptr;
+        double degreeA = degree(a.rest);
+        double degreeB = degree(b.rest);
+        if (degreeA != degreeB) return degreeA > degreeB;
+        return compare(a.rest, b.rest) < 0;
+    });
+
+    if (merged.empty()) {
+        return store.number(0.0);
+    }
+    const ExprNode* result = buildTerm(merged[0].coefficient, merged[0].rest);
+    for (size_t i = 1; i < merged.size(); ++i) {
+        const Term& term = merged[i];
+        if (term.coefficient.sign() < 0) {
+            result = store.binary(BinOp::SUBTRACT, result, buildTerm(-term.coefficient, term.rest));
+        } else {
+            result = store.binary(BinOp::ADD, result, buildTerm(term.coefficient, term.rest));
+        }
+    }
+    return result;
+}
+
+const ExprNode* Simplifier::buildTerm(const Number& coefficient, const ExprNode* rest) {
+    if (!rest) {
+        return store.number(coefficient);
+    }
+    if (coefficient.isOne()) {
+        return rest;
+    }
+    if (coefficient == -1) {
+        return store.unary(UnOp::NEGATIVE, rest);
+    }
+    Number magnitude = coefficient.abs();
+    Number inverse = magnitude.isZero() ? Number(0) : magnitude.reciprocal();
+    if (!isBinary(rest, BinOp::DIVIDE) && inverse > 1 && inverse.isInteger() && inverse.reciprocal() == magnitude) {
+        // Reciprocal integer coefficients read better as a division: x^3/3
+        const ExprNode* quotient = store.binary(BinOp::DIVIDE, rest, store.number(inverse));
+        return coefficient.sign() < 0 ? store.unary(UnOp::NEGATIVE, quotient) : quotient;
+    }
+    if (isBinary(rest, BinOp::DIVIDE)) {
+        // Keep the coefficient in the numerator: 2/x rather than 2(1/x)
+        const ExprNode* numerator = rest->child(0);
+        const ExprNode* scaled = numerator->isNumber(1.0)
+            ? store.number(coefficient)
+            : store.binary(BinOp::MULTIPLY, store.number(coefficient), numerator);
+        return store.binary(BinOp::DIVIDE, scaled, rest->child(1));
+    }
+    return store.binary(BinOp::MULTIPLY, store.number(coefficient), rest);
+}
+
+// ----------------------------------------------------------------------------
+// Products and powers
+// ----------------------------------------------------------------------------
+
+const ExprNode* Simplifier::rewriteProduct(const ExprNode* node) {
+    Number coefficient(1);
+    std::vector<Factor> factors;
+    collectFactors(node, Number(1), coefficient, factors);
+    return buildProduct(coefficient, factors);
+}
+
+void Simplifier::collectFactors(const ExprNode* node, const Number& exponent, Number& coefficient,
+                                std::vector<Factor>& factors, bool rewriteLeaves) {
+    // exponent is always an integer here, so (b^e)^exponent = b^(e*exponent)
+    // and products may be distributed over it, except that a non-integer e
+    // confines b to b >= 0: (x^(1/2))^2 stays as it is rather than become x
+    if (isBinary(node, BinOp::MULTIPLY)) {
+        collectFactors(node->child(0), exponent, coefficient, factors, rewriteLeaves);
+        collectFactors(node->child(1), exponent, coefficient, factors, rewriteLeaves);
+        return;
+    }
+    if (isBinary(node, BinOp::DIVIDE)) {
+        collectFactors(node->child(0), exponent, coefficient, factors, rewriteLeaves);
+        collectFactors(node->child(1), -exponent, coefficient, factors, rewriteLeaves);
+        return;
+    }
+
+    const ExprNode* leaf = rewriteLeaves ? rewrite(node) : node;
+    if (leaf->kind == ExprNode::Kind::NUMBER) {
+        coefficient *= raise(*leaf->exact, exponent);
+    } else if (isUnary(leaf, UnOp::NEGATIVE)) {
+        coefficient *= raise(Number(-1), exponent);
+        collectFactors(leaf->child(0), exponent, coefficient, factors, false);
+    } else if (leaf != node && (isBinary(leaf, BinOp::MULTIPLY) || isBinary(leaf, BinOp::DIVIDE))) {
+        collectFactors(leaf, exponent, coefficient, factors, false);
+    } else if (isBinary(leaf, BinOp::POWER) && leaf->child(1)->kind == ExprNode::Kind::NUMBER &&
+               keepsDomain(*leaf->child(1)->exact, *leaf->child(1)->exact * exponent)) {
+        factors.push_back({leaf->child(0), *leaf->child(1)->exact * exponent});
+    } else {
+        factors.push_back({leaf, exponent});
+    }
+}
+
+const ExprNode* Simplifier::rewritePower(const ExprNode* node) {
+    const ExprNode* base = rewrite(node->child(0));
+    const ExprNode* exponent = rewrite(node->child(1));
+
+    if (exponent->kind != ExprNode::Kind::NUMBER) {
+        if (base->isNumber(0.0)) return store.number(0.0);
+        if (base->isNumber(1.0)) return store.number(1.0);
+        return store.binary(BinOp::POWER, base, exponent);
+    }
+
+    const Number& value = *exponent->exact;
+    if (value.isZero()) return store.number(1.0);
+    if (value.isOne()) return base;
+    if (base->kind == ExprNode::Kind::NUMBER) {
+        return store.number(raise(*base->exact, value));
+    }
+
+    Number coefficient(1);
+    std::vector<Factor> factors;
+    if (value.isInteger()) {
+        collectFactors(base, value, coefficient, factors, false);
+    } else {
+        // Non-integer powers do not distribute over products
+        factors.push_back({base, value});
+    }
+    return buildProduct(coefficient, factors);
+}
+
+const ExprNode* Simplifier::buildProduct(const Number& coefficient, std::vector<Factor>& factors) {
+    if (coefficient.isZero()) {
+        return store.number(0.0);
+    }
+
+    // Merge like bases by adding exponents. Non-integer powers merge only
+    // while the sum stays non-integer, so x^(1/2) * x^(1/2) is not x
+    // (which would be defined for x < 0 too); those are left as they are.
+    struct LikeBase {
+        const ExprNode* base;
+        Number integral;
+        std::vector<Number> fractional;
+    };
+    std::vector<LikeBase> groups;
+    std::unordered_map<const ExprNode*, size_t> index;
+    for (const Factor& factor : factors) {
+        auto inserted = index.emplace(factor.base, groups.size());
+        if (inserted.second) {
+            groups.push_back({factor.base, Number(0), {}});
+        }
+        LikeBase& group = groups[inserted.first->second];
+        if (factor.exponent.isInteger()) {
+            group.integral += factor.exponent;
+        } else {
+            group.fractional.push_back(factor.exponent);
+        }
+    }
+    std::vector<Factor> merged;
+    for (const LikeBase& group : groups) {
+        Number total = group.integral;
+        for (const Number& exponent : group.fractional) total += exponent;
+        if (group.fractional.empty() || !total.isInteger()) {
+            merged.push_back({group.base, total});
+        } else {
+            merged.push_back({group.base, group.integral});
+            for (const Number& exponent : group.fractional) merged.push_back({group.base, exponent});
+        }
+    }
+    merged.erase(std::remove_if(merged.begin(), merged.end(),
+                                [](const Factor& factor) { return factor.exponent.isZero(); }),
+                 merged.end());
+    std::stable_sort(merged.begin(), merged.end(), [](const Factor& a, const Factor& b) {
+        return compare(a.base, b.base) < 0;
+    });
+
+    const ExprNode* numerator = nullptr;
+    const ExprNode* denominator = nullptr;
+    for (const Factor& factor : merged) {
+        Number magnitude = factor.exponent.abs();
+        const ExprNode* power = magnitude.isOne()
+            ? factor.base
+            : store.binary(BinOp::POWER, factor.base, store.number(magnitude));
+        const ExprNode*& side = factor.exponent.sign() > 0 ? numerator : denominator;
+        side = side ? store.binary(BinOp::MULTIPLY, side, power) : power;
+    }
+
+    const ExprNode* rest = numerator;
+    if (denominator) {
+        rest = store.binary(BinOp::DIVIDE, numerator ? numerator : store.number(1.0), denominator);
+    }
+    return buildTerm(coefficient, rest);
+}
+
+// ----------------------------------------------------------------------------
+// Functions
+// ----------------------------------------------------------------------------
+
+const ExprNode* Simplifier::rewriteApplication(const ExprNode* node) {
+    std::vector<const ExprNode*> args;
+    bool allConstant = true;
+    for (uint32_t i = 0; i < node->arity; ++i) {
+        args.push_back(rewrite(node->child(i)));
+        allConstant = allConstant && args.back()->kind == ExprNode::Kind::NUMBER;
+    }
+
+    const ExprNode* rebuilt = node->kind == ExprNode::Kind::UNARY
+        ? store.unary(node->unaryOp(), args[0])
+        : store.function(*node->name, args);
+    if (allConstant && node->arity > 0) {
+        return store.number(store.evaluate(rebuilt));
+    }
+    return rebuilt;
+}
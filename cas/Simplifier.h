@@ -0,0 +1,88 @@
+#ifndef SIMPLIFIER_H
+#define SIMPLIFIER_H
+
+#include "ExpressionStore.h"
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Limits for one simplify() call
+struct SimplifierOptions {
+    size_t maxPasses = 16;       // rewrite passes before giving up on a fixed point
+    size_t maxSteps = 100000;    // node rewrites across all passes
+};
+
+// What the last simplify() call did
+struct SimplifierStats {
+    size_t passes = 0;
+    size_t steps = 0;
+    size_t cacheHits = 0;        // subexpressions answered from earlier calls
+    bool converged = false;      // false when a budget ran out first
+};
+
+// Simplifier - rule-based canonicalizer over the expression DAG.
+//
+// Each pass flattens ADD/SUBTRACT/NEGATIVE chains into n-ary sums of
+// (coefficient, term) pairs and MULTIPLY/DIVIDE/POWER chains into n-ary
+// products of (base, exponent) pairs, merges like terms and like bases, folds
+// constants exactly (coefficients and exponents are Numbers, so x/3 + x/6
+// is x/2) and sorts operands into a canonical order before lowering back to
+// binary nodes. Passes repeat until the result stops changing; because nodes
+// are hash-consed this is a pointer comparison. Equal canonical forms are
+// therefore the same node, so x + x and 2x simplify to one result.
+class Simplifier {
+private:
+    struct Term {
+        Number coefficient;
+        const ExprNode* rest;    // non-numeric part; null for the constant term
+    };
+    struct Factor {
+        const ExprNode* base;
+        Number exponent;
+    };
+
+    ExpressionStore& store;
+    SimplifierOptions options;
+    SimplifierStats stats;
+
+    // Fixed points from earlier calls, valid for the lifetime of the store's nodes
+    std::unordered_map<const ExprNode*, const ExprNode*> results;
+    std::unordered_map<const ExprNode*, const ExprNode*> pass;
+
+    const ExprNode* rewrite(const ExprNode* node);
+    const ExprNode* rewriteSum(const ExprNode* node);
+    const ExprNode* rewriteProduct(const ExprNode* node);
+    const ExprNode* rewritePower(const ExprNode* node);
+    const ExprNode* rewriteApplication(const ExprNode* node);
+
+    // rewriteLeaves is false when node is already a rewritten result
+    void collectTerms(const ExprNode* node, int sign, std::vector<Term>& terms, bool rewriteLeaves = true);
+    void collectFactors(const ExprNode* node, const Number& exponent, Number& coefficient, std::vector<Factor>& factors,
+                        bool rewriteLeaves = true);
+    std::pair<Number, const ExprNode*> splitCoefficient(const ExprNode* node);
+
+    const ExprNode* buildSum(std::vector<Term>& terms);
+    const ExprNode* buildProduct(const Number& coefficient, std::vector<Factor>& factors);
+    const ExprNode* buildTerm(const Number& coefficient, const ExprNode* rest);
+
+public:
+    explicit Simplifier(ExpressionStore& store, SimplifierOptions options = SimplifierOptions());
+    Simplifier(const Simplifier&) = delete;
+    Simplifier& operator=(const Simplifier&) = delete;
+
+    // Canonical form of node, or the best form reached when a budget runs out
+    const ExprNode* simplify(const ExprNode* node);
+
+    void setOptions(const SimplifierOptions& newOptions) { options = newOptions; }
+    const SimplifierOptions& getOptions() const { return options; }
+    const SimplifierStats& getLastRun() const { return stats; }
+
+    // Forget cached fixed points (required after the store is cleared)
+    void clearCache() { results.clear(); }
+
+    // Total order on nodes used to sort operands; 0 when structurally equal
+    static int compare(const ExprNode* a, const ExprNode* b);
+};
+
+#endif // SIMPLIFIER_H
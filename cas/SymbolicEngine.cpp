@@ -1,20 +1,98 @@
 #include "SymbolicEngine.h"
+#include "ExpressionStore.h"
+#include "Simplifier.h"
+#include "ExpressionCache.h"
+#include "Expression.h"
+#include "RootFinder.h"
+#include "Polynomial.h"
+#include "../util/Instrumentation.h"
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 // ============================================================================
 // Symbolic Expression Implementations
 // ============================================================================
 
-// SymbolicNumber implementation
-std::string SymbolicNumber::toString() const {
+namespace {
+
+// Exact numbers print as integers, short terminating decimals (0.5, 0.125)
+// or parenthesized fractions such as (1/3); inexact ones as before
+std::string numberText(const Number& number) {
+    if (!number.isExact()) {
+        std::ostringstream oss;
+        oss << number.toDouble();
+        return oss.str();
+    }
+    if (number.isInteger()) return number.toString();
+
+    Number scaled = number.abs();
+    for (size_t digits = 1; digits <= 6; ++digits) {
+        scaled *= Number(10);
+        if (scaled.isInteger()) {
+            std::string text = scaled.toString();
+            if (text.size() <= digits) text.insert(0, digits + 1 - text.size(), '0');
+            text.insert(text.size() - digits, ".");
+            return (number.sign() < 0 ? "-" : "") + text;
+        }
+    }
+    return "(" + number.toString() + ")";
+}
+
+// Coefficient in front of a product, e.g. the 2 in 2x
+std::string coefficientText(const Number& coefficient) {
+    if (coefficient.isExact()) return numberText(coefficient);
+    double value = coefficient.toDouble();
     std::ostringstream oss;
-    oss << value;
+    if (std::floor(value) == value) oss << (long long)value; else oss << value;
     return oss.str();
 }
 
+// Value of a constant subtree, exact when it folds to a number (1/2)
+Number constantValue(const SymbolicExpression& expr) {
+    if (auto number = symbolicCast<SymbolicNumber>(&expr)) return number->exact;
+    auto folded = expr.simplify();
+    if (auto number = symbolicCast<SymbolicNumber>(folded.get())) return number->exact;
+    return Number::fromDouble(expr.evaluate());
+}
+
+// Folds two constant operands, exactly when both are numbers
+std::unique_ptr<SymbolicExpression> foldConstants(SymbolicBinaryOp::OpType op,
+                                                  const SymbolicExpression& left,
+                                                  const SymbolicExpression& right) {
+    using OpType = SymbolicBinaryOp::OpType;
+    const SymbolicNumber* lnum = symbolicCast<SymbolicNumber>(&left);
+    const SymbolicNumber* rnum = symbolicCast<SymbolicNumber>(&right);
+    if (lnum && rnum) {
+        switch (op) {
+            case OpType::ADD: return std::make_unique<SymbolicNumber>(lnum->exact + rnum->exact);
+            case OpType::SUBTRACT: return std::make_unique<SymbolicNumber>(lnum->exact - rnum->exact);
+            case OpType::MULTIPLY: return std::make_unique<SymbolicNumber>(lnum->exact * rnum->exact);
+            case OpType::DIVIDE: return std::make_unique<SymbolicNumber>(lnum->exact / rnum->exact);
+            case OpType::POWER: return std::make_unique<SymbolicNumber>(lnum->exact.pow(rnum->exact));
+        }
+    }
+    double a = left.evaluate();
+    double b = right.evaluate();
+    switch (op) {
+        case OpType::ADD: return std::make_unique<SymbolicNumber>(a + b);
+        case OpType::SUBTRACT: return std::make_unique<SymbolicNumber>(a - b);
+        case OpType::MULTIPLY: return std::make_unique<SymbolicNumber>(a * b);
+        case OpType::DIVIDE: return std::make_unique<SymbolicNumber>(a / b);
+        case OpType::POWER: return std::make_unique<SymbolicNumber>(std::pow(a, b));
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// SymbolicNumber implementation
+std::string SymbolicNumber::toString() const {
+    return numberText(exact);
+}
+
 std::unique_ptr<SymbolicExpression> SymbolicNumber::differentiate(const std::string& variable) const {
     (void)variable; // Suppress unused parameter warning
     return std::make_unique<SymbolicNumber>(0.0); // Derivative of constant is 0
@@ -23,16 +101,19 @@ std::unique_ptr<SymbolicExpression> SymbolicNumber::differentiate(const std::str
 std::unique_ptr<SymbolicExpression> SymbolicNumber::integrate(const std::string& variable) const {
     (void)variable; // Suppress unused parameter warning
     return std::make_unique<SymbolicBinaryOp>(SymbolicBinaryOp::OpType::MULTIPLY,
-                                             std::make_unique<SymbolicNumber>(value),
+                                             std::make_unique<SymbolicNumber>(exact),
                                              std::make_unique<SymbolicVariable>(variable));
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicNumber::simplify() const {
-    return std::make_unique<SymbolicNumber>(value);
+    return clone();
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicNumber::clone() const {
-    return std::make_unique<SymbolicNumber>(value);
+    CAS_COUNT(CLONES);
+    auto copy = std::make_unique<SymbolicNumber>(exact);
+    copy->value = value;
+    return copy;
 }
 
 double SymbolicNumber::evaluate(const std::map<std::string, double>& variables) const {
@@ -40,6 +121,10 @@ double SymbolicNumber::evaluate(const std::map<std::string, double>& variables)
     return value;
 }
 
+void SymbolicNumber::compile(CompiledExpression& program) const {
+    program.emitConstant(value);
+}
+
 // SymbolicVariable implementation
 std::string SymbolicVariable::toString() const {
     return name;
@@ -74,6 +159,7 @@ std::unique_ptr<SymbolicExpression> SymbolicVariable::simplify() const {
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicVariable::clone() const {
+    CAS_COUNT(CLONES);
     return std::make_unique<SymbolicVariable>(name);
 }
 
@@ -85,53 +171,50 @@ double SymbolicVariable::evaluate(const std::map<std::string, double>& variables
     return it->second;
 }
 
+void SymbolicVariable::compile(CompiledExpression& program) const {
+    program.emitVariable(name);
+}
+
 // SymbolicBinaryOp implementation
 std::string SymbolicBinaryOp::toString() const {
     // Pretty-printing with special handling for multiplication
     if (op == OpType::MULTIPLY) {
         // If both sides are constant numbers, multiply and return a single number
         if (left->isConstant() && right->isConstant()) {
-            const SymbolicNumber* lnum = dynamic_cast<const SymbolicNumber*>(left.get());
-            const SymbolicNumber* rnum = dynamic_cast<const SymbolicNumber*>(right.get());
+            const SymbolicNumber* lnum = symbolicCast<SymbolicNumber>(left.get());
+            const SymbolicNumber* rnum = symbolicCast<SymbolicNumber>(right.get());
             if (lnum && rnum) {
-                double prod = lnum->value * rnum->value;
-                std::ostringstream oss;
-                if (std::floor(prod) == prod) oss << (long long)prod; else oss << prod;
-                return oss.str();
+                return coefficientText(lnum->exact * rnum->exact);
             }
         }
 
         // If one side is constant, print coefficient first (e.g., 2*x -> 2x)
         if (left->isConstant() && !right->isConstant()) {
-            const SymbolicNumber* lnum = dynamic_cast<const SymbolicNumber*>(left.get());
+            const SymbolicNumber* lnum = symbolicCast<SymbolicNumber>(left.get());
             if (lnum) {
-                double coeff = lnum->value;
+                const Number& coeff = lnum->exact;
                 std::string rhs = right->toString();
-                if (coeff == 1.0) return rhs;
-                if (coeff == -1.0) return std::string("-") + rhs;
-                std::ostringstream oss;
-                if (std::floor(coeff) == coeff) oss << (long long)coeff; else oss << coeff;
+                if (coeff == 1) return rhs;
+                if (coeff == -1) return std::string("-") + rhs;
                 // If rhs is a simple variable or function call, omit the *
-                bool needParens = (dynamic_cast<const SymbolicVariable*>(right.get()) == nullptr &&
-                                   dynamic_cast<const SymbolicFunction*>(right.get()) == nullptr &&
-                                   dynamic_cast<const SymbolicUnaryOp*>(right.get()) == nullptr);
-                return oss.str() + (needParens ? "(" + rhs + ")" : rhs);
+                bool needParens = (symbolicCast<SymbolicVariable>(right.get()) == nullptr &&
+                                   symbolicCast<SymbolicFunction>(right.get()) == nullptr &&
+                                   symbolicCast<SymbolicUnaryOp>(right.get()) == nullptr);
+                return coefficientText(coeff) + (needParens ? "(" + rhs + ")" : rhs);
             }
         }
 
         if (!left->isConstant() && right->isConstant()) {
-            const SymbolicNumber* rnum = dynamic_cast<const SymbolicNumber*>(right.get());
+            const SymbolicNumber* rnum = symbolicCast<SymbolicNumber>(right.get());
             if (rnum) {
-                double coeff = rnum->value;
+                const Number& coeff = rnum->exact;
                 std::string lhs = left->toString();
-                if (coeff == 1.0) return lhs;
-                if (coeff == -1.0) return std::string("-") + lhs;
-                std::ostringstream oss;
-                if (std::floor(coeff) == coeff) oss << (long long)coeff; else oss << coeff;
-                bool needParens = (dynamic_cast<const SymbolicVariable*>(left.get()) == nullptr &&
-                                   dynamic_cast<const SymbolicFunction*>(left.get()) == nullptr &&
-                                   dynamic_cast<const SymbolicUnaryOp*>(left.get()) == nullptr);
-                return oss.str() + (needParens ? "(" + lhs + ")" : lhs);
+                if (coeff == 1) return lhs;
+                if (coeff == -1) return std::string("-") + lhs;
+                bool needParens = (symbolicCast<SymbolicVariable>(left.get()) == nullptr &&
+                                   symbolicCast<SymbolicFunction>(left.get()) == nullptr &&
+                                   symbolicCast<SymbolicUnaryOp>(left.get()) == nullptr);
+                return coefficientText(coeff) + (needParens ? "(" + lhs + ")" : lhs);
             }
         }
 
@@ -198,8 +281,8 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::differentiate(const std::s
         case OpType::POWER: {
             // Power rule for constant exponents: d/dx(x^n) = n*x^(n-1)
             if (right->isConstant()) {
-                double expVal = right->evaluate();
-                auto newExponent = std::make_unique<SymbolicNumber>(expVal - 1.0);
+                Number expVal = constantValue(*right);
+                auto newExponent = std::make_unique<SymbolicNumber>(expVal - 1);
                 auto powerTerm = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::POWER, 
                                                     left->clone(), std::move(newExponent));
                 auto baseDeriv = left->differentiate(variable);
@@ -226,7 +309,7 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::simplify() const {
         if (simplifiedLeft->isZero()) return simplifiedRight;
         if (simplifiedRight->isZero()) return simplifiedLeft;
         if (simplifiedLeft->isConstant() && simplifiedRight->isConstant()) {
-            return std::make_unique<SymbolicNumber>(simplifiedLeft->evaluate() + simplifiedRight->evaluate());
+            return foldConstants(op, *simplifiedLeft, *simplifiedRight);
         }
     } else if (op == OpType::SUBTRACT) {
         if (simplifiedRight->isZero()) return simplifiedLeft;
@@ -234,7 +317,7 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::simplify() const {
             return makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::NEGATIVE, std::move(simplifiedRight));
         }
         if (simplifiedLeft->isConstant() && simplifiedRight->isConstant()) {
-            return std::make_unique<SymbolicNumber>(simplifiedLeft->evaluate() - simplifiedRight->evaluate());
+            return foldConstants(op, *simplifiedLeft, *simplifiedRight);
         }
     } else if (op == OpType::MULTIPLY) {
         if (simplifiedLeft->isZero() || simplifiedRight->isZero()) {
@@ -243,7 +326,7 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::simplify() const {
         if (simplifiedLeft->isOne()) return simplifiedRight;
         if (simplifiedRight->isOne()) return simplifiedLeft;
         if (simplifiedLeft->isConstant() && simplifiedRight->isConstant()) {
-            return std::make_unique<SymbolicNumber>(simplifiedLeft->evaluate() * simplifiedRight->evaluate());
+            return foldConstants(op, *simplifiedLeft, *simplifiedRight);
         }
     } else if (op == OpType::DIVIDE) {
         if (simplifiedRight->isZero()) {
@@ -254,7 +337,7 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::simplify() const {
         }
         if (simplifiedRight->isOne()) return simplifiedLeft;
         if (simplifiedLeft->isConstant() && simplifiedRight->isConstant()) {
-            return std::make_unique<SymbolicNumber>(simplifiedLeft->evaluate() / simplifiedRight->evaluate());
+            return foldConstants(op, *simplifiedLeft, *simplifiedRight);
         }
     } else if (op == OpType::POWER) {
         if (simplifiedRight->isZero()) {
@@ -268,7 +351,7 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::simplify() const {
             return std::make_unique<SymbolicNumber>(1.0);
         }
         if (simplifiedLeft->isConstant() && simplifiedRight->isConstant()) {
-            return std::make_unique<SymbolicNumber>(std::pow(simplifiedLeft->evaluate(), simplifiedRight->evaluate()));
+            return foldConstants(op, *simplifiedLeft, *simplifiedRight);
         }
     }
     
@@ -315,18 +398,18 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::integrate(const std::strin
         case OpType::POWER: {
             // For simple cases like ∫x^n dx where n is constant
             if (left->toString() == variable && right->isConstant()) {
-                double expVal = right->evaluate();
+                Number expVal = constantValue(*right);
                 if (expVal == -1) {
                     // ∫1/x dx = ln(x)
                     return makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::LN,
                                              std::make_unique<SymbolicVariable>(variable));
                 } else if (expVal != -1) {
                     // ∫x^n dx = x^(n+1)/(n+1) for n != -1
-                    auto newExponent = std::make_unique<SymbolicNumber>(expVal + 1.0);
+                    auto newExponent = std::make_unique<SymbolicNumber>(expVal + 1);
                     auto powerTerm = makeSymbolicBinaryOp(OpType::POWER,
                                                         std::make_unique<SymbolicVariable>(variable),
                                                         std::move(newExponent));
-                    auto denominator = std::make_unique<SymbolicNumber>(expVal + 1.0);
+                    auto denominator = std::make_unique<SymbolicNumber>(expVal + 1);
                     return makeSymbolicBinaryOp(OpType::DIVIDE, std::move(powerTerm), std::move(denominator));
                 }
             }
@@ -338,6 +421,7 @@ std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::integrate(const std::strin
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicBinaryOp::clone() const {
+    CAS_COUNT(CLONES);
     return makeSymbolicBinaryOp(op, left->clone(), right->clone());
 }
 
@@ -361,6 +445,20 @@ bool SymbolicBinaryOp::isConstant() const {
     return left->isConstant() && right->isConstant();
 }
 
+void SymbolicBinaryOp::compile(CompiledExpression& program) const {
+    left->compile(program);
+    right->compile(program);
+    
+    switch (op) {
+        case OpType::ADD: program.emit(OpCode::ADD); break;
+        case OpType::SUBTRACT: program.emit(OpCode::SUBTRACT); break;
+        case OpType::MULTIPLY: program.emit(OpCode::MULTIPLY); break;
+        case OpType::DIVIDE: program.emit(OpCode::DIVIDE); break;
+        case OpType::POWER: program.emit(OpCode::POWER); break;
+        default: throw std::runtime_error("Unknown binary operation");
+    }
+}
+
 bool SymbolicBinaryOp::isZero() const {
     return false; // Would need more complex logic for this
 }
@@ -454,8 +552,11 @@ std::unique_ptr<SymbolicExpression> SymbolicUnaryOp::simplify() const {
         if (simplifiedOperand->isZero()) {
             return std::make_unique<SymbolicNumber>(0.0);
         }
+        if (auto number = symbolicCast<SymbolicNumber>(simplifiedOperand.get())) {
+            return std::make_unique<SymbolicNumber>(-number->exact);
+        }
         // Double negative
-        if (auto unaryOp = dynamic_cast<SymbolicUnaryOp*>(simplifiedOperand.get())) {
+        if (auto unaryOp = symbolicCast<SymbolicUnaryOp>(simplifiedOperand.get())) {
             if (unaryOp->op == OpType::NEGATIVE) {
                 return unaryOp->operand->clone();
             }
@@ -497,10 +598,11 @@ std::unique_ptr<SymbolicExpression> SymbolicUnaryOp::integrate(const std::string
         case OpType::LN: {
             // ∫ln(x) dx = x*ln(x) - x
             if (operand->toString() == variable) {
+                // Build both copies of x before the call; argument evaluation order is unspecified
                 auto x = std::make_unique<SymbolicVariable>(variable);
+                auto lnX = makeSymbolicUnaryOp(OpType::LN, x->clone());
                 auto xLnX = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY,
-                                                x->clone(),
-                                                makeSymbolicUnaryOp(OpType::LN, std::move(x)));
+                                                std::move(x), std::move(lnX));
                 return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::SUBTRACT,
                                           std::move(xLnX),
                                           std::make_unique<SymbolicVariable>(variable));
@@ -513,6 +615,7 @@ std::unique_ptr<SymbolicExpression> SymbolicUnaryOp::integrate(const std::string
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicUnaryOp::clone() const {
+    CAS_COUNT(CLONES);
     return makeSymbolicUnaryOp(op, operand->clone());
 }
 
@@ -543,6 +646,23 @@ bool SymbolicUnaryOp::isConstant() const {
     return operand->isConstant();
 }
 
+void SymbolicUnaryOp::compile(CompiledExpression& program) const {
+    operand->compile(program);
+    
+    switch (op) {
+        case OpType::POSITIVE: break;
+        case OpType::NEGATIVE: program.emit(OpCode::NEGATE); break;
+        case OpType::SIN: program.emit(OpCode::SIN); break;
+        case OpType::COS: program.emit(OpCode::COS); break;
+        case OpType::TAN: program.emit(OpCode::TAN); break;
+        case OpType::LOG: program.emit(OpCode::LOG); break;
+        case OpType::LN: program.emit(OpCode::LN); break;
+        case OpType::SQRT: program.emit(OpCode::SQRT); break;
+        case OpType::ABS: program.emit(OpCode::ABS); break;
+        default: throw std::runtime_error("Unknown unary operation");
+    }
+}
+
 bool SymbolicUnaryOp::isZero() const {
     return operand->isZero();
 }
@@ -562,29 +682,67 @@ std::string SymbolicFunction::toString() const {
     return result;
 }
 
+namespace {
+
+// Chain rule through a registered function's derivative rule: the partials
+// are built in a scratch store and come back as trees
+std::unique_ptr<SymbolicExpression> differentiateRegistered(const SymbolicFunction& func, const std::string& variable) {
+    FunctionRegistry::checkCall(func.functionId, func.functionName, func.arguments.size());
+    const FunctionRegistry::UserFunction& function = FunctionRegistry::user(func.functionId);
+    if (!function.derivative) {
+        throw std::runtime_error("Differentiation not implemented for function: " + func.functionName);
+    }
+    
+    ExpressionStore store;
+    std::vector<const ExprNode*> args;
+    for (const auto& arg : func.arguments) {
+        args.push_back(store.intern(arg.get()));
+    }
+    std::unique_ptr<SymbolicExpression> result;
+    for (uint32_t i = 0; i < function.arity; ++i) {
+        auto term = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY,
+                                         store.toSymbolic(function.derivative(store, args.data(), i)),
+                                         func.arguments[i]->differentiate(variable));
+        result = result ? makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::ADD, std::move(result), std::move(term))
+                        : std::move(term);
+    }
+    return result;
+}
+
+} // namespace
+
 std::unique_ptr<SymbolicExpression> SymbolicFunction::differentiate(const std::string& variable) const {
-    // For now, we'll handle basic functions
+    using Builtin = FunctionRegistry::Builtin;
+    if (functionId != FunctionRegistry::kUnknown && !FunctionRegistry::isBuiltin(functionId)) {
+        return differentiateRegistered(*this, variable);
+    }
     if (arguments.size() != 1) {
         throw std::runtime_error("Differentiation not implemented for multi-argument functions");
     }
     
     auto argDeriv = arguments[0]->differentiate(variable);
     
-    if (functionName == "sin") {
-        auto cosExpr = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::COS, arguments[0]->clone());
-        return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY, 
-                                  std::move(cosExpr), std::move(argDeriv));
-    } else if (functionName == "cos") {
-        auto sinExpr = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::SIN, arguments[0]->clone());
-        auto negSin = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::NEGATIVE, std::move(sinExpr));
-        return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY, 
-                                  std::move(negSin), std::move(argDeriv));
-    } else if (functionName == "ln") {
-        auto oneOverArg = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::DIVIDE,
-                                              std::make_unique<SymbolicNumber>(1.0),
-                                              arguments[0]->clone());
-        return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY,
-                                  std::move(oneOverArg), std::move(argDeriv));
+    switch (static_cast<Builtin>(functionId)) {
+        case Builtin::SIN: {
+            auto cosExpr = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::COS, arguments[0]->clone());
+            return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY, 
+                                      std::move(cosExpr), std::move(argDeriv));
+        }
+        case Builtin::COS: {
+            auto sinExpr = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::SIN, arguments[0]->clone());
+            auto negSin = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::NEGATIVE, std::move(sinExpr));
+            return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY, 
+                                      std::move(negSin), std::move(argDeriv));
+        }
+        case Builtin::LN: {
+            auto oneOverArg = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::DIVIDE,
+                                                  std::make_unique<SymbolicNumber>(1.0),
+                                                  arguments[0]->clone());
+            return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY,
+                                      std::move(oneOverArg), std::move(argDeriv));
+        }
+        default:
+            break;
     }
     
     throw std::runtime_error("Differentiation not implemented for function: " + functionName);
@@ -609,7 +767,7 @@ std::unique_ptr<SymbolicExpression> SymbolicFunction::simplify() const {
         return std::make_unique<SymbolicNumber>(evaluate());
     }
     
-    return makeSymbolicFunction(functionName, std::move(simplifiedArgs));
+    return makeSymbolicFunction(functionName, functionId, std::move(simplifiedArgs));
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicFunction::integrate(const std::string& variable) const {
@@ -618,21 +776,23 @@ std::unique_ptr<SymbolicExpression> SymbolicFunction::integrate(const std::strin
         throw std::runtime_error("Integration not implemented for multi-argument functions");
     }
     
-    if (functionName == "sin" && arguments[0]->toString() == variable) {
+    using Builtin = FunctionRegistry::Builtin;
+    Builtin builtin = static_cast<Builtin>(functionId);
+    if (builtin == Builtin::SIN && arguments[0]->toString() == variable) {
         // ∫sin(x) dx = -cos(x)
         return makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::NEGATIVE,
                                  makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::COS,
                                                     std::make_unique<SymbolicVariable>(variable)));
-    } else if (functionName == "cos" && arguments[0]->toString() == variable) {
+    } else if (builtin == Builtin::COS && arguments[0]->toString() == variable) {
         // ∫cos(x) dx = sin(x)
         return makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::SIN,
                                  std::make_unique<SymbolicVariable>(variable));
-    } else if (functionName == "ln" && arguments[0]->toString() == variable) {
+    } else if (builtin == Builtin::LN && arguments[0]->toString() == variable) {
         // ∫ln(x) dx = x*ln(x) - x
         auto x = std::make_unique<SymbolicVariable>(variable);
+        auto lnX = makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::LN, x->clone());
         auto xLnX = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::MULTIPLY,
-                                        x->clone(),
-                                        makeSymbolicUnaryOp(SymbolicUnaryOp::OpType::LN, std::move(x)));
+                                        std::move(x), std::move(lnX));
         return makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::SUBTRACT,
                                   std::move(xLnX),
                                   std::make_unique<SymbolicVariable>(variable));
@@ -642,38 +802,22 @@ std::unique_ptr<SymbolicExpression> SymbolicFunction::integrate(const std::strin
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicFunction::clone() const {
+    CAS_COUNT(CLONES);
     std::vector<std::unique_ptr<SymbolicExpression>> clonedArgs;
     for (const auto& arg : arguments) {
         clonedArgs.push_back(arg->clone());
     }
-    return makeSymbolicFunction(functionName, std::move(clonedArgs));
+    return makeSymbolicFunction(functionName, functionId, std::move(clonedArgs));
 }
 
 double SymbolicFunction::evaluate(const std::map<std::string, double>& variables) const {
-    if (arguments.size() != 1) {
-        throw std::runtime_error("Function " + functionName + " expects 1 argument");
-    }
+    FunctionRegistry::checkCall(functionId, functionName, arguments.size());
     
-    double arg = arguments[0]->evaluate(variables);
-    
-    if (functionName == "sin") return std::sin(arg);
-    if (functionName == "cos") return std::cos(arg);
-    if (functionName == "tan") return std::tan(arg);
-    if (functionName == "log") {
-        if (arg <= 0) throw std::runtime_error("Log of non-positive number");
-        return std::log10(arg);
-    }
-    if (functionName == "ln") {
-        if (arg <= 0) throw std::runtime_error("Natural log of non-positive number");
-        return std::log(arg);
-    }
-    if (functionName == "sqrt") {
-        if (arg < 0) throw std::runtime_error("Square root of negative number");
-        return std::sqrt(arg);
-    }
-    if (functionName == "abs") return std::abs(arg);
-    
-    throw std::runtime_error("Unknown function: " + functionName);
+    double args[FunctionRegistry::kMaxArity];
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        args[i] = arguments[i]->evaluate(variables);
+    }
+    return FunctionRegistry::call(functionId, args, nullptr);
 }
 
 bool SymbolicFunction::isConstant() const {
@@ -683,6 +827,15 @@ bool SymbolicFunction::isConstant() const {
     return true;
 }
 
+void SymbolicFunction::compile(CompiledExpression& program) const {
+    FunctionRegistry::checkCall(functionId, functionName, arguments.size());
+    
+    for (const auto& arg : arguments) {
+        arg->compile(program);
+    }
+    program.emitCall(functionId);
+}
+
 bool SymbolicFunction::isZero() const {
     return false; // Would need more complex logic for this
 }
@@ -695,13 +848,17 @@ bool SymbolicFunction::isOne() const {
 // SymbolicEngine Implementation
 // ============================================================================
 
-SymbolicEngine::SymbolicEngine() {}
+SymbolicEngine::SymbolicEngine()
+    : store(std::make_unique<ExpressionStore>()), simplifier(std::make_unique<Simplifier>(*store)), root(nullptr) {}
+
+SymbolicEngine::~SymbolicEngine() = default;
 
 bool SymbolicEngine::parseFromAST(const ASTNode* ast) {
     if (!ast) return false;
     
     try {
         expression = convertASTToSymbolic(ast);
+        root = store->intern(expression.get());
         return true;
     } catch (const std::exception& e) {
         std::cerr << "AST conversion error: " << e.what() << std::endl;
@@ -710,94 +867,174 @@ bool SymbolicEngine::parseFromAST(const ASTNode* ast) {
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicEngine::convertASTToSymbolic(const ASTNode* ast) {
+    CAS_TIME_PHASE(CONVERT);
     if (!ast) {
         throw std::runtime_error("Null AST node");
     }
     
-    // Dynamic cast to determine the type of AST node
-    if (auto numberNode = dynamic_cast<const NumberNode*>(ast)) {
-        return std::make_unique<SymbolicNumber>(numberNode->value);
-    }
-    else if (auto variableNode = dynamic_cast<const VariableNode*>(ast)) {
-        return std::make_unique<SymbolicVariable>(variableNode->name);
-    }
-    else if (auto binaryOpNode = dynamic_cast<const BinaryOpNode*>(ast)) {
-        auto left = convertASTToSymbolic(binaryOpNode->left.get());
-        auto right = convertASTToSymbolic(binaryOpNode->right.get());
-        
-        SymbolicBinaryOp::OpType opType;
-        switch (binaryOpNode->op) {
-            case BinaryOpNode::OpType::ADD: opType = SymbolicBinaryOp::OpType::ADD; break;
-            case BinaryOpNode::OpType::SUBTRACT: opType = SymbolicBinaryOp::OpType::SUBTRACT; break;
-            case BinaryOpNode::OpType::MULTIPLY: opType = SymbolicBinaryOp::OpType::MULTIPLY; break;
-            case BinaryOpNode::OpType::DIVIDE: opType = SymbolicBinaryOp::OpType::DIVIDE; break;
-            case BinaryOpNode::OpType::POWER: opType = SymbolicBinaryOp::OpType::POWER; break;
-            default: throw std::runtime_error("Unknown binary operation");
+    // Dispatch on the node's kind tag
+    switch (ast->kind()) {
+        case ASTKind::NUMBER: {
+            auto numberNode = static_cast<const NumberNode*>(ast);
+            auto number = std::make_unique<SymbolicNumber>(numberNode->exact);
+            number->value = numberNode->value;
+            return number;
         }
-        
-        return makeSymbolicBinaryOp(opType, std::move(left), std::move(right));
-    }
-    else if (auto unaryOpNode = dynamic_cast<const UnaryOpNode*>(ast)) {
-        auto operand = convertASTToSymbolic(unaryOpNode->operand.get());
-        
-        SymbolicUnaryOp::OpType opType;
-        switch (unaryOpNode->op) {
-            case UnaryOpNode::OpType::POSITIVE: opType = SymbolicUnaryOp::OpType::POSITIVE; break;
-            case UnaryOpNode::OpType::NEGATIVE: opType = SymbolicUnaryOp::OpType::NEGATIVE; break;
-            case UnaryOpNode::OpType::SIN: opType = SymbolicUnaryOp::OpType::SIN; break;
-            case UnaryOpNode::OpType::COS: opType = SymbolicUnaryOp::OpType::COS; break;
-            case UnaryOpNode::OpType::TAN: opType = SymbolicUnaryOp::OpType::TAN; break;
-            case UnaryOpNode::OpType::LOG: opType = SymbolicUnaryOp::OpType::LOG; break;
-            case UnaryOpNode::OpType::LN: opType = SymbolicUnaryOp::OpType::LN; break;
-            case UnaryOpNode::OpType::SQRT: opType = SymbolicUnaryOp::OpType::SQRT; break;
-            case UnaryOpNode::OpType::ABS: opType = SymbolicUnaryOp::OpType::ABS; break;
-            default: throw std::runtime_error("Unknown unary operation");
+        case ASTKind::VARIABLE: {
+            auto variableNode = static_cast<const VariableNode*>(ast);
+            return std::make_unique<SymbolicVariable>(variableNode->name);
         }
-        
-        return makeSymbolicUnaryOp(opType, std::move(operand));
-    }
-    else if (auto functionNode = dynamic_cast<const FunctionNode*>(ast)) {
-        std::vector<std::unique_ptr<SymbolicExpression>> args;
-        for (const auto& arg : functionNode->arguments) {
-            args.push_back(convertASTToSymbolic(arg.get()));
+        case ASTKind::BINARY_OP: {
+            auto binaryOpNode = static_cast<const BinaryOpNode*>(ast);
+            auto left = convertASTToSymbolic(binaryOpNode->left.get());
+            auto right = convertASTToSymbolic(binaryOpNode->right.get());
+            
+            SymbolicBinaryOp::OpType opType;
+            switch (binaryOpNode->op) {
+                case BinaryOpNode::OpType::ADD: opType = SymbolicBinaryOp::OpType::ADD; break;
+                case BinaryOpNode::OpType::SUBTRACT: opType = SymbolicBinaryOp::OpType::SUBTRACT; break;
+                case BinaryOpNode::OpType::MULTIPLY: opType = SymbolicBinaryOp::OpType::MULTIPLY; break;
+                case BinaryOpNode::OpType::DIVIDE: opType = SymbolicBinaryOp::OpType::DIVIDE; break;
+                case BinaryOpNode::OpType::POWER: opType = SymbolicBinaryOp::OpType::POWER; break;
+                default: throw std::runtime_error("Unknown binary operation");
+            }
+            
+            return makeSymbolicBinaryOp(opType, std::move(left), std::move(right));
+        }
+        case ASTKind::UNARY_OP: {
+            auto unaryOpNode = static_cast<const UnaryOpNode*>(ast);
+            auto operand = convertASTToSymbolic(unaryOpNode->operand.get());
+            
+            SymbolicUnaryOp::OpType opType;
+            switch (unaryOpNode->op) {
+                case UnaryOpNode::OpType::POSITIVE: opType = SymbolicUnaryOp::OpType::POSITIVE; break;
+                case UnaryOpNode::OpType::NEGATIVE: opType = SymbolicUnaryOp::OpType::NEGATIVE; break;
+                case UnaryOpNode::OpType::SIN: opType = SymbolicUnaryOp::OpType::SIN; break;
+                case UnaryOpNode::OpType::COS: opType = SymbolicUnaryOp::OpType::COS; break;
+                case UnaryOpNode::OpType::TAN: opType = SymbolicUnaryOp::OpType::TAN; break;
+                case UnaryOpNode::OpType::LOG: opType = SymbolicUnaryOp::OpType::LOG; break;
+                case UnaryOpNode::OpType::LN: opType = SymbolicUnaryOp::OpType::LN; break;
+                case UnaryOpNode::OpType::SQRT: opType = SymbolicUnaryOp::OpType::SQRT; break;
+                case UnaryOpNode::OpType::ABS: opType = SymbolicUnaryOp::OpType::ABS; break;
+                default: throw std::runtime_error("Unknown unary operation");
+            }
+            
+            return makeSymbolicUnaryOp(opType, std::move(operand));
+        }
+        case ASTKind::FUNCTION: {
+            auto functionNode = static_cast<const FunctionNode*>(ast);
+            std::vector<std::unique_ptr<SymbolicExpression>> args;
+            for (const auto& arg : functionNode->arguments) {
+                args.push_back(convertASTToSymbolic(arg.get()));
+            }
+            
+            return makeSymbolicFunction(functionNode->functionName, functionNode->functionId, std::move(args));
         }
-        
-        return makeSymbolicFunction(functionNode->functionName, std::move(args));
-    }
-    else {
-        throw std::runtime_error("Unknown AST node type");
     }
+    throw std::runtime_error("Unknown AST node type");
 }
 
 bool SymbolicEngine::parseFromString(const std::string& expressionStr) {
-    ExpressionParser parser;
-    if (parser.parse(expressionStr)) {
-        return parseFromAST(parser.getAST());
+    // The parsed tree is shared with the cache; only the DAG is per engine
+    std::shared_ptr<const ParsedExpression> parsed;
+    try {
+        parsed = ExpressionCache::shared().get(expressionStr);
+    } catch (const std::exception& e) {
+        std::cerr << "AST conversion error: " << e.what() << std::endl;
+        return false;
+    }
+    if (!parsed) {
+        return false;
     }
-    return false;
+    expression = parsed->symbolic;
+    root = store->intern(expression.get());
+    return true;
+}
+
+bool SymbolicEngine::parseFromExpression(const Expression& handle) {
+    if (!handle.valid()) {
+        return false;
+    }
+    expression = handle.sharedSymbolic();
+    root = store->intern(expression.get());
+    return true;
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicEngine::differentiate(const std::string& variable) const {
     if (!expression) {
         throw std::runtime_error("No expression to differentiate");
     }
-    return expression->differentiate(variable);
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store->toSymbolic(store->differentiate(root, variable));
+}
+
+const ExprNode* SymbolicEngine::differentiateNode(const std::string& variable, int order) {
+    if (!root) {
+        throw std::runtime_error("No expression to differentiate");
+    }
+    const ExprNode* result = root;
+    for (int i = 0; i < order; ++i) {
+        result = store->differentiate(result, variable);
+    }
+    return result;
+}
+
+const ExprNode* SymbolicEngine::simplifyNode() {
+    if (!root) {
+        throw std::runtime_error("No expression to simplify");
+    }
+    return simplifier->simplify(root);
+}
+
+const ExprNode* SymbolicEngine::integrateNode(const std::string& variable) {
+    if (!root) {
+        throw std::runtime_error("No expression to integrate");
+    }
+    return store->integrate(root, variable);
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicEngine::simplify() const {
     if (!expression) {
         throw std::runtime_error("No expression to simplify");
     }
-    return expression->simplify();
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store->toSymbolic(simplifier->simplify(root));
+}
+
+std::unique_ptr<SymbolicExpression> SymbolicEngine::simplify(const SymbolicExpression& expr) const {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store->toSymbolic(simplifier->simplify(store->intern(&expr)));
 }
 
 double SymbolicEngine::evaluate(const std::map<std::string, double>& variables) const {
     if (!expression) {
         throw std::runtime_error("No expression to evaluate");
     }
+    CAS_COUNT(EVALUATE_CALLS);
     return expression->evaluate(variables);
 }
 
+void SymbolicEngine::evaluateBatch(const double* xs, double* out, size_t n, const std::string& variable) const {
+    CompiledExpression program = compile({variable});
+    if (program.getSlotCount() > 1) {
+        throw std::runtime_error("Undefined variable: " + program.getSlotNames()[1]);
+    }
+    program.evalBatch(&xs, out, n);
+}
+
+CompiledExpression SymbolicEngine::compile(const std::vector<std::string>& slots) const {
+    if (!expression) {
+        throw std::runtime_error("No expression to compile");
+    }
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store->compile(root, slots);
+}
+
+CompiledExpression SymbolicEngine::compile(const SymbolicExpression& expr, const std::vector<std::string>& slots) const {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store->compile(store->intern(&expr), slots);
+}
+
 std::string SymbolicEngine::toString() const {
     if (!expression) {
         return "No expression";
@@ -812,7 +1049,8 @@ std::unique_ptr<SymbolicExpression> SymbolicEngine::integrate(const std::string&
     if (!expression) {
         throw std::runtime_error("No expression to integrate");
     }
-    return expression->integrate(variable);
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store->toSymbolic(store->integrate(root, variable));
 }
 
 std::unique_ptr<SymbolicExpression> SymbolicEngine::solve(const std::string& variable) const {
@@ -828,7 +1066,7 @@ std::unique_ptr<SymbolicExpression> SymbolicEngine::solve(const std::string& var
         auto simplified = expression->simplify();
         
         // Check if it's a linear equation in the variable
-        if (auto binaryOp = dynamic_cast<const SymbolicBinaryOp*>(simplified.get())) {
+        if (auto binaryOp = symbolicCast<SymbolicBinaryOp>(simplified.get())) {
             if (binaryOp->op == SymbolicBinaryOp::OpType::ADD || 
                 binaryOp->op == SymbolicBinaryOp::OpType::SUBTRACT) {
                 
@@ -855,6 +1093,55 @@ std::unique_ptr<SymbolicExpression> SymbolicEngine::solve(const std::string& var
     }
 }
 
+QuadratureResult SymbolicEngine::integrateNumeric(const std::string& variable, double a, double b, double tolerance,
+                                                  const std::map<std::string, double>& parameters) const {
+    if (!expression) {
+        throw std::runtime_error("No expression to integrate");
+    }
+
+    double difference = std::numeric_limits<double>::quiet_NaN();
+    try {
+        std::unique_ptr<SymbolicExpression> antiderivative = integrate(variable);
+        std::map<std::string, double> at = parameters;
+        at[variable] = b;
+        double upper = antiderivative->evaluate(at);
+        at[variable] = a;
+        difference = upper - antiderivative->evaluate(at);
+    } catch (const std::exception&) {
+        // No antiderivative, or it is undefined at an end
+    }
+
+    QuadratureOptions options;
+    options.absTolerance = tolerance;
+    options.relTolerance = tolerance;
+    QuadratureResult result = Quadrature::integrate(compile({variable}), variable, parameters, a, b, options);
+
+    // F(b) - F(a) is only the integral when the integrand has no pole in
+    // between (x^-2 on [-1, 2] would give -1.5), which no finite set of
+    // samples can rule out; it is taken only when converged quadrature
+    // agrees with it
+    if (std::isfinite(difference) && result.converged &&
+        std::abs(difference - result.value) <= result.errorEstimate + tolerance * std::max(1.0, std::abs(difference))) {
+        result.value = difference;
+        result.evaluations += 2;
+        result.symbolic = true;
+    }
+    return result;
+}
+
+std::vector<double> SymbolicEngine::solveNumeric(const std::string& variable, double lo, double hi,
+                                                 const std::map<std::string, double>& parameters) const {
+    if (!expression) {
+        throw std::runtime_error("No expression to solve");
+    }
+    CompiledExpression program = compile({variable});
+    std::vector<double> roots;
+    for (const Root& root : RootFinder(program, variable, parameters).findAll(lo, hi)) {
+        roots.push_back(root.x);
+    }
+    return roots;
+}
+
 std::vector<std::unique_ptr<SymbolicExpression>> SymbolicEngine::factor() const {
     if (!expression) {
         throw std::runtime_error("No expression to factor");
@@ -865,8 +1152,30 @@ std::vector<std::unique_ptr<SymbolicExpression>> SymbolicEngine::factor() const
     try {
         auto simplified = expression->simplify();
         
-        // For now, implement basic factoring
-        if (auto binaryOp = dynamic_cast<const SymbolicBinaryOp*>(simplified.get())) {
+        // Polynomials factor through the sparse representation; anything
+        // else (or a polynomial with no nontrivial factors) keeps the tree
+        try {
+            PolynomialFactorization split = Polynomial::fromSymbolic(*expression).factor();
+            bool trivial = split.content == 1.0 && split.factors.size() == 1 && split.factors[0].second == 1;
+            if (!trivial) {
+                if (split.content != 1.0 || split.factors.empty()) {
+                    factors.push_back(makeSymbolicNumber(split.content));
+                }
+                for (const auto& [part, multiplicity] : split.factors) {
+                    auto factor = part.toSymbolic();
+                    if (multiplicity > 1) {
+                        factor = makeSymbolicBinaryOp(SymbolicBinaryOp::OpType::POWER, std::move(factor),
+                                                      makeSymbolicNumber(multiplicity));
+                    }
+                    factors.push_back(std::move(factor));
+                }
+                return factors;
+            }
+        } catch (const std::runtime_error&) {
+            // Not a polynomial
+        }
+        
+        if (auto binaryOp = symbolicCast<SymbolicBinaryOp>(simplified.get())) {
             if (binaryOp->op == SymbolicBinaryOp::OpType::MULTIPLY) {
                 // Already factored
                 factors.push_back(binaryOp->left->clone());
@@ -875,7 +1184,7 @@ std::vector<std::unique_ptr<SymbolicExpression>> SymbolicEngine::factor() const
             } else if (binaryOp->op == SymbolicBinaryOp::OpType::ADD) {
                 // Try to factor out common terms
                 // For example: x^2 + x = x(x + 1)
-                if (auto leftPower = dynamic_cast<const SymbolicBinaryOp*>(binaryOp->left.get())) {
+                if (auto leftPower = symbolicCast<SymbolicBinaryOp>(binaryOp->left.get())) {
                     if (leftPower->op == SymbolicBinaryOp::OpType::POWER && 
                         leftPower->left->toString() == "x" && leftPower->right->toString() == "2") {
                         
@@ -903,6 +1212,13 @@ std::vector<std::unique_ptr<SymbolicExpression>> SymbolicEngine::factor() const
     }
 }
 
+std::unique_ptr<SymbolicExpression> SymbolicEngine::expand() const {
+    if (!expression) {
+        throw std::runtime_error("No expression to expand");
+    }
+    return Polynomial::fromSymbolic(*expression).toSymbolic();
+}
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
@@ -911,6 +1227,10 @@ std::unique_ptr<SymbolicExpression> makeSymbolicNumber(double value) {
     return std::make_unique<SymbolicNumber>(value);
 }
 
+std::unique_ptr<SymbolicExpression> makeSymbolicNumber(const Number& value) {
+    return std::make_unique<SymbolicNumber>(value);
+}
+
 std::unique_ptr<SymbolicExpression> makeSymbolicVariable(const std::string& name) {
     return std::make_unique<SymbolicVariable>(name);
 }
@@ -930,3 +1250,8 @@ std::unique_ptr<SymbolicExpression> makeSymbolicFunction(const std::string& func
                                                         std::vector<std::unique_ptr<SymbolicExpression>> args) {
     return std::make_unique<SymbolicFunction>(funcName, std::move(args));
 }
+
+std::unique_ptr<SymbolicExpression> makeSymbolicFunction(const std::string& funcName, uint32_t functionId,
+                                                        std::vector<std::unique_ptr<SymbolicExpression>> args) {
+    return std::make_unique<SymbolicFunction>(funcName, functionId, std::move(args));
+}
@@ -2,7 +2,10 @@
 #define SYMBOLIC_ENGINE_H
 
 #include "../parser/ExpressionParser.h"
+#include "Quadrature.h"
+#include "../util/Number.h"
 #include <memory>
+#include <mutex>
 #include <string>
 #include <map>
 #include <vector>
@@ -14,11 +17,30 @@ class SymbolicUnaryOp;
 class SymbolicNumber;
 class SymbolicVariable;
 class SymbolicFunction;
+class ExpressionStore;
+class Simplifier;
+struct ExprNode;
+
+// Concrete symbolic node type, for switch-based dispatch without RTTI
+enum class SymbolicKind : uint8_t {
+    NUMBER,
+    VARIABLE,
+    BINARY_OP,
+    UNARY_OP,
+    FUNCTION
+};
 
 // Symbolic expression base class
 class SymbolicExpression {
+private:
+    SymbolicKind nodeKind;
+
+protected:
+    explicit SymbolicExpression(SymbolicKind kind) : nodeKind(kind) {}
+
 public:
     virtual ~SymbolicExpression() = default;
+    SymbolicKind kind() const { return nodeKind; }
     virtual std::string toString() const = 0;
     virtual std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const = 0;
     virtual std::unique_ptr<SymbolicExpression> integrate(const std::string& variable) const = 0;
@@ -28,11 +50,16 @@ public:
     virtual bool isConstant() const = 0;
     virtual bool isZero() const = 0;
     virtual bool isOne() const = 0;
+    
+    // Lower this subtree into postfix bytecode
+    virtual void compile(CompiledExpression& program) const = 0;
 };
 
 // Symbolic binary operation
 class SymbolicBinaryOp : public SymbolicExpression {
 public:
+    static constexpr SymbolicKind kKind = SymbolicKind::BINARY_OP;
+    
     enum class OpType {
         ADD,
         SUBTRACT,
@@ -46,7 +73,7 @@ public:
     std::unique_ptr<SymbolicExpression> right;
     
     SymbolicBinaryOp(OpType operation, std::unique_ptr<SymbolicExpression> l, std::unique_ptr<SymbolicExpression> r)
-        : op(operation), left(std::move(l)), right(std::move(r)) {}
+        : SymbolicExpression(kKind), op(operation), left(std::move(l)), right(std::move(r)) {}
     
     std::string toString() const override;
     std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const override;
@@ -54,6 +81,7 @@ public:
     std::unique_ptr<SymbolicExpression> simplify() const override;
     std::unique_ptr<SymbolicExpression> clone() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    void compile(CompiledExpression& program) const override;
     bool isConstant() const override;
     bool isZero() const override;
     bool isOne() const override;
@@ -62,6 +90,8 @@ public:
 // Symbolic unary operation
 class SymbolicUnaryOp : public SymbolicExpression {
 public:
+    static constexpr SymbolicKind kKind = SymbolicKind::UNARY_OP;
+    
     enum class OpType {
         POSITIVE,
         NEGATIVE,
@@ -78,7 +108,7 @@ public:
     std::unique_ptr<SymbolicExpression> operand;
     
     SymbolicUnaryOp(OpType operation, std::unique_ptr<SymbolicExpression> op)
-        : op(operation), operand(std::move(op)) {}
+        : SymbolicExpression(kKind), op(operation), operand(std::move(op)) {}
     
     std::string toString() const override;
     std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const override;
@@ -86,6 +116,7 @@ public:
     std::unique_ptr<SymbolicExpression> simplify() const override;
     std::unique_ptr<SymbolicExpression> clone() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    void compile(CompiledExpression& program) const override;
     bool isConstant() const override;
     bool isZero() const override;
     bool isOne() const override;
@@ -94,9 +125,13 @@ public:
 // Symbolic number
 class SymbolicNumber : public SymbolicExpression {
 public:
+    static constexpr SymbolicKind kKind = SymbolicKind::NUMBER;
+    
     double value;
+    Number exact;           // exact value when known (parsed literals, folded constants)
     
-    SymbolicNumber(double val) : value(val) {}
+    SymbolicNumber(double val) : SymbolicExpression(kKind), value(val), exact(Number::fromDouble(val)) {}
+    explicit SymbolicNumber(Number val) : SymbolicExpression(kKind), value(val.toDouble()), exact(std::move(val)) {}
     
     std::string toString() const override;
     std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const override;
@@ -104,17 +139,20 @@ public:
     std::unique_ptr<SymbolicExpression> simplify() const override;
     std::unique_ptr<SymbolicExpression> clone() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    void compile(CompiledExpression& program) const override;
     bool isConstant() const override { return true; }
-    bool isZero() const override { return value == 0.0; }
-    bool isOne() const override { return value == 1.0; }
+    bool isZero() const override { return exact.isZero(); }
+    bool isOne() const override { return exact.isOne(); }
 };
 
 // Symbolic variable
 class SymbolicVariable : public SymbolicExpression {
 public:
+    static constexpr SymbolicKind kKind = SymbolicKind::VARIABLE;
+    
     std::string name;
     
-    SymbolicVariable(const std::string& varName) : name(varName) {}
+    SymbolicVariable(const std::string& varName) : SymbolicExpression(kKind), name(varName) {}
     
     std::string toString() const override;
     std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const override;
@@ -122,6 +160,7 @@ public:
     std::unique_ptr<SymbolicExpression> simplify() const override;
     std::unique_ptr<SymbolicExpression> clone() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    void compile(CompiledExpression& program) const override;
     bool isConstant() const override { return false; }
     bool isZero() const override { return false; }
     bool isOne() const override { return false; }
@@ -130,11 +169,16 @@ public:
 // Symbolic function
 class SymbolicFunction : public SymbolicExpression {
 public:
+    static constexpr SymbolicKind kKind = SymbolicKind::FUNCTION;
+    
     std::string functionName;
+    uint32_t functionId;   // FunctionRegistry id, or FunctionRegistry::kUnknown
     std::vector<std::unique_ptr<SymbolicExpression>> arguments;
     
     SymbolicFunction(const std::string& funcName, std::vector<std::unique_ptr<SymbolicExpression>> args)
-        : functionName(funcName), arguments(std::move(args)) {}
+        : SymbolicFunction(funcName, FunctionRegistry::find(funcName), std::move(args)) {}
+    SymbolicFunction(const std::string& funcName, uint32_t id, std::vector<std::unique_ptr<SymbolicExpression>> args)
+        : SymbolicExpression(kKind), functionName(funcName), functionId(id), arguments(std::move(args)) {}
     
     std::string toString() const override;
     std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const override;
@@ -142,15 +186,56 @@ public:
     std::unique_ptr<SymbolicExpression> simplify() const override;
     std::unique_ptr<SymbolicExpression> clone() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    void compile(CompiledExpression& program) const override;
     bool isConstant() const override;
     bool isZero() const override;
     bool isOne() const override;
 };
 
+// Checked downcasts through the kind tag; return null when the kind differs
+template <typename T>
+const T* symbolicCast(const SymbolicExpression* expr) {
+    return (expr && expr->kind() == T::kKind) ? static_cast<const T*>(expr) : nullptr;
+}
+
+template <typename T>
+T* symbolicCast(SymbolicExpression* expr) {
+    return (expr && expr->kind() == T::kKind) ? static_cast<T*>(expr) : nullptr;
+}
+
+// Calls visitor with the expression downcast to its concrete type
+template <typename Visitor>
+decltype(auto) visitSymbolic(const SymbolicExpression& expr, Visitor&& visitor) {
+    switch (expr.kind()) {
+        case SymbolicKind::NUMBER: return visitor(static_cast<const SymbolicNumber&>(expr));
+        case SymbolicKind::VARIABLE: return visitor(static_cast<const SymbolicVariable&>(expr));
+        case SymbolicKind::BINARY_OP: return visitor(static_cast<const SymbolicBinaryOp&>(expr));
+        case SymbolicKind::UNARY_OP: return visitor(static_cast<const SymbolicUnaryOp&>(expr));
+        case SymbolicKind::FUNCTION: return visitor(static_cast<const SymbolicFunction&>(expr));
+    }
+    throw std::runtime_error("Unknown symbolic expression type");
+}
+
+class Expression;
+
 // Main Symbolic Engine class
+//
+// Threading: const members may be called concurrently on one engine. Those
+// that work on the DAG (differentiate, simplify, integrate, compile and
+// what builds on them) add to its store and memos, and take a lock to do
+// so. Non-const members, and any use of getStore(), getSimplifier() or the
+// nodes they return, need exclusive access to the engine.
 class SymbolicEngine {
 private:
-    std::unique_ptr<SymbolicExpression> expression;
+    // Immutable tree, possibly shared with ExpressionCache
+    std::shared_ptr<const SymbolicExpression> expression;
+    
+    // Hash-consed DAG of the expression and everything derived from it.
+    // const members intern nodes and fill memos, so they hold storeMutex.
+    std::unique_ptr<ExpressionStore> store;
+    std::unique_ptr<Simplifier> simplifier;
+    const ExprNode* root;
+    mutable std::mutex storeMutex;
     
     // Helper functions for simplification
     std::unique_ptr<SymbolicExpression> simplifyBinaryOp(SymbolicBinaryOp::OpType op, 
@@ -159,29 +244,42 @@ private:
     std::unique_ptr<SymbolicExpression> simplifyUnaryOp(SymbolicUnaryOp::OpType op,
                                                        std::unique_ptr<SymbolicExpression> operand) const;
     
-    // AST to symbolic conversion
-    std::unique_ptr<SymbolicExpression> convertASTToSymbolic(const ASTNode* ast);
-    
-
-    
 public:
     SymbolicEngine();
+    ~SymbolicEngine();
     
     // Convert from AST to symbolic expression
     bool parseFromAST(const ASTNode* ast);
     
-    // Parse from string
+    // Share the tree of an immutable handle instead of parsing again
+    bool parseFromExpression(const Expression& handle);
+    
+    // AST to symbolic conversion
+    static std::unique_ptr<SymbolicExpression> convertASTToSymbolic(const ASTNode* ast);
+    
+    // Parse from string; repeated texts are served from ExpressionCache::shared()
     bool parseFromString(const std::string& expression);
     
-    // Differentiation
+    // Differentiation, simplification and integration run on the shared DAG and
+    // are memoized per engine, so repeated subexpressions are processed once
     std::unique_ptr<SymbolicExpression> differentiate(const std::string& variable) const;
     
-    // Simplification
+    // Simplification to canonical form (like terms collected, constants folded)
     std::unique_ptr<SymbolicExpression> simplify() const;
+    std::unique_ptr<SymbolicExpression> simplify(const SymbolicExpression& expr) const;
     
     // Evaluation
     double evaluate(const std::map<std::string, double>& variables = {}) const;
     
+    // Evaluate at n values of a single variable in one pass;
+    // points with domain errors come back as NaN
+    void evaluateBatch(const double* xs, double* out, size_t n, const std::string& variable = "x") const;
+    
+    // Compile to bytecode for fast repeated evaluation; shared subexpressions
+    // (e.g. in derivatives) are computed once per point
+    CompiledExpression compile(const std::vector<std::string>& slots = {}) const;
+    CompiledExpression compile(const SymbolicExpression& expr, const std::vector<std::string>& slots = {}) const;
+    
     // String representation
     std::string toString() const;
     
@@ -189,14 +287,48 @@ public:
     bool hasExpression() const { return expression != nullptr; }
     const SymbolicExpression* getExpression() const { return expression.get(); }
     
+    // Shared DAG representation; nodes live in this engine's arena
+    const ExprNode* getNode() const { return root; }
+    ExpressionStore& getStore() { return *store; }
+    const ExpressionStore& getStore() const { return *store; }
+    
+    // n-th derivative built in the DAG, sharing subexpressions instead of cloning them
+    const ExprNode* differentiateNode(const std::string& variable, int order = 1);
+    const ExprNode* simplifyNode();
+    Simplifier& getSimplifier() { return *simplifier; }
+    const ExprNode* integrateNode(const std::string& variable);
+    
     // Advanced operations (future)
     std::unique_ptr<SymbolicExpression> integrate(const std::string& variable) const;
     std::unique_ptr<SymbolicExpression> solve(const std::string& variable) const;
+    
+    // Definite integral over [a, b] by adaptive quadrature to within
+    // tolerance (see Quadrature). When integrate() succeeds, F is defined at
+    // both ends and the converged quadrature agrees with F(b) - F(a), the
+    // exact difference is returned instead (symbolic = true); a divergent
+    // integral never converges, whatever its antiderivative says
+    QuadratureResult integrateNumeric(const std::string& variable, double a, double b, double tolerance = 1e-10,
+                                      const std::map<std::string, double>& parameters = {}) const;
+    
+    // Numeric roots in [lo, hi], ascending (see RootFinder); other variables
+    // are bound from parameters
+    std::vector<double> solveNumeric(const std::string& variable, double lo, double hi,
+                                     const std::map<std::string, double>& parameters = {}) const;
+    
+    // Factors of a polynomial (see Polynomial::factor): a numeric content
+    // first when it is not 1, then factors by degree, repeated ones as
+    // powers. Other expressions come back whole, or split at a top-level
+    // product.
     std::vector<std::unique_ptr<SymbolicExpression>> factor() const;
+    
+    // Fully expanded polynomial, terms in decreasing order; throws if the
+    // expression is not a polynomial
+    std::unique_ptr<SymbolicExpression> expand() const;
 };
 
 // Utility functions for creating symbolic expressions
 std::unique_ptr<SymbolicExpression> makeSymbolicNumber(double value);
+std::unique_ptr<SymbolicExpression> makeSymbolicNumber(const Number& value);
 std::unique_ptr<SymbolicExpression> makeSymbolicVariable(const std::string& name);
 std::unique_ptr<SymbolicExpression> makeSymbolicBinaryOp(SymbolicBinaryOp::OpType op,
                                                         std::unique_ptr<SymbolicExpression> left,
@@ -205,5 +337,8 @@ std::unique_ptr<SymbolicExpression> makeSymbolicUnaryOp(SymbolicUnaryOp::OpType
                                                        std::unique_ptr<SymbolicExpression> operand);
 std::unique_ptr<SymbolicExpression> makeSymbolicFunction(const std::string& funcName,
                                                         std::vector<std::unique_ptr<SymbolicExpression>> args);
+// With the FunctionRegistry id already resolved
+std::unique_ptr<SymbolicExpression> makeSymbolicFunction(const std::string& funcName, uint32_t functionId,
+                                                        std::vector<std::unique_ptr<SymbolicExpression>> args);
 
 #endif // SYMBOLIC_ENGINE_H
@@ -0,0 +1,310 @@
+// Microbenchmarks for the parser, the symbolic engine, evaluation and the
+// console grapher. Besides time, each benchmark reports allocations per
+// iteration ("allocs") and the size of what it works on ("nodes": tree nodes,
+// "dag": unique DAG nodes, "tokens"), so a regression can be told apart from
+// a change in the amount of work.
+//
+//   ./cas_bench --benchmark_filter=Differentiate
+//   ./cas_bench --benchmark_format=json > bench_output.txt
+
+#include "parser/ExpressionParser.h"
+#include "cas/SymbolicEngine.h"
+#include "cas/ExpressionStore.h"
+#include "cas/Simplifier.h"
+#include "grapher/ConsoleGrapher.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// Allocation counting for the whole process; benchmarks report the
+// difference across their timing loop. The replacements stay out of line:
+// once inlined, GCC sees malloc paired with delete and free paired with new
+// and warns (-Wmismatched-new-delete).
+#if defined(__GNUC__) || defined(__clang__)
+#define CAS_BENCH_NOINLINE __attribute__((noinline))
+#else
+#define CAS_BENCH_NOINLINE
+#endif
+
+static std::atomic<size_t> allocationCount{0};
+
+CAS_BENCH_NOINLINE void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+CAS_BENCH_NOINLINE void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+CAS_BENCH_NOINLINE void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+namespace {
+
+class AllocationCounter {
+private:
+    size_t start;
+
+public:
+    AllocationCounter() : start(allocationCount.load(std::memory_order_relaxed)) {}
+
+    void report(benchmark::State& state) const {
+        double allocations = static_cast<double>(allocationCount.load(std::memory_order_relaxed) - start);
+        state.counters["allocs"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    }
+};
+
+// Swallows the console grapher's output
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// A sum of terms mixing every operator and a function call
+std::string polynomialText(int terms) {
+    std::string text;
+    for (int i = 0; i < terms; ++i) {
+        std::string c = std::to_string(i + 1);
+        if (i) text += " + ";
+        text += "(" + c + " * x^" + std::to_string(i % 5) + " - sin(x / " + c + "))";
+    }
+    return text;
+}
+
+const char* kDerivativeBase = "sin(x^2) * ln(x + 1) / (x^2 + 1)";
+const char* kEvaluated = "sin(x) * x^2 + sqrt(x + 1) / (x^2 + 1)";
+
+std::unique_ptr<SymbolicExpression> parseSymbolic(const std::string& text) {
+    ExpressionParser parser;
+    parser.parse(text);
+    return SymbolicEngine::convertASTToSymbolic(parser.getAST());
+}
+
+std::unique_ptr<SymbolicExpression> derivativeTree(int order) {
+    auto expr = parseSymbolic(kDerivativeBase);
+    for (int i = 0; i < order; ++i) {
+        expr = expr->differentiate("x");
+    }
+    return expr;
+}
+
+void reportSize(benchmark::State& state, const SymbolicExpression& expr) {
+    ExpressionStore store;
+    const ExprNode* root = store.intern(&expr);
+    state.counters["nodes"] = ExpressionStore::treeSize(root);
+    state.counters["dag"] = static_cast<double>(ExpressionStore::dagSize(root));
+}
+
+// Points in the domain of kEvaluated
+std::vector<double> samplePoints(size_t n) {
+    std::vector<double> xs(n);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = 0.1 + 10.0 * static_cast<double>(i) / static_cast<double>(n);
+    }
+    return xs;
+}
+
+// ---- Parser ----
+
+void BM_LexerTokens(benchmark::State& state) {
+    std::string text = polynomialText(static_cast<int>(state.range(0)));
+    size_t tokens = 0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        Lexer lexer(text);
+        tokens = 0;
+        while (lexer.getNextToken().type != TokenType::END_OF_FILE) {
+            ++tokens;
+        }
+        benchmark::DoNotOptimize(tokens);
+    }
+    allocations.report(state);
+    state.counters["tokens"] = static_cast<double>(tokens);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_LexerTokens)->RangeMultiplier(4)->Range(4, 256);
+
+void BM_Parse(benchmark::State& state) {
+    std::string text = polynomialText(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        Parser parser(text);
+        auto ast = parser.parse();
+        benchmark::DoNotOptimize(ast.get());
+    }
+    allocations.report(state);
+    reportSize(state, *parseSymbolic(text));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_Parse)->RangeMultiplier(4)->Range(4, 256);
+
+void BM_ConvertASTToSymbolic(benchmark::State& state) {
+    std::string text = polynomialText(static_cast<int>(state.range(0)));
+    ExpressionParser parser;
+    parser.parse(text);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        auto expr = SymbolicEngine::convertASTToSymbolic(parser.getAST());
+        benchmark::DoNotOptimize(expr.get());
+    }
+    allocations.report(state);
+    reportSize(state, *parseSymbolic(text));
+}
+BENCHMARK(BM_ConvertASTToSymbolic)->RangeMultiplier(4)->Range(4, 256);
+
+// ---- Symbolic engine, by derivative order ----
+
+// Repeated SymbolicExpression::differentiate: the tree grows exponentially
+void BM_DifferentiateTree(benchmark::State& state) {
+    int order = static_cast<int>(state.range(0));
+    auto base = parseSymbolic(kDerivativeBase);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        auto expr = base->differentiate("x");
+        for (int i = 1; i < order; ++i) {
+            expr = expr->differentiate("x");
+        }
+        benchmark::DoNotOptimize(expr.get());
+    }
+    allocations.report(state);
+    reportSize(state, *derivativeTree(order));
+}
+BENCHMARK(BM_DifferentiateTree)->DenseRange(1, 4);
+
+// The same in a fresh ExpressionStore, sharing subexpressions
+void BM_DifferentiateDag(benchmark::State& state) {
+    int order = static_cast<int>(state.range(0));
+    auto base = parseSymbolic(kDerivativeBase);
+    size_t dag = 0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        ExpressionStore store;
+        const ExprNode* node = store.intern(base.get());
+        for (int i = 0; i < order; ++i) {
+            node = store.differentiate(node, "x");
+        }
+        dag = ExpressionStore::dagSize(node);
+        benchmark::DoNotOptimize(node);
+    }
+    allocations.report(state);
+    state.counters["dag"] = static_cast<double>(dag);
+}
+BENCHMARK(BM_DifferentiateDag)->DenseRange(1, 6);
+
+// Legacy tree simplification of the n-th derivative
+void BM_SimplifyTree(benchmark::State& state) {
+    auto expr = derivativeTree(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        auto simplified = expr->simplify();
+        benchmark::DoNotOptimize(simplified.get());
+    }
+    allocations.report(state);
+    reportSize(state, *expr);
+}
+BENCHMARK(BM_SimplifyTree)->DenseRange(1, 4);
+
+// Canonical simplification in a fresh store (no memo carried over)
+void BM_SimplifyCanonical(benchmark::State& state) {
+    auto expr = derivativeTree(static_cast<int>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        ExpressionStore store;
+        Simplifier simplifier(store);
+        const ExprNode* simplified = simplifier.simplify(store.intern(expr.get()));
+        benchmark::DoNotOptimize(simplified);
+    }
+    allocations.report(state);
+    reportSize(state, *expr);
+}
+BENCHMARK(BM_SimplifyCanonical)->DenseRange(1, 4);
+
+// ---- Evaluation, per point and in batches ----
+
+void BM_EvaluateTree(benchmark::State& state) {
+    auto expr = parseSymbolic(kEvaluated);
+    std::vector<double> xs = samplePoints(static_cast<size_t>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        double sum = 0;
+        for (double x : xs) {
+            sum += expr->evaluate({{"x", x}});
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    allocations.report(state);
+    reportSize(state, *expr);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * xs.size()));
+}
+BENCHMARK(BM_EvaluateTree)->Arg(4096);
+
+void BM_EvaluateCompiled(benchmark::State& state) {
+    SymbolicEngine engine;
+    engine.parseFromString(kEvaluated);
+    CompiledExpression program = engine.compile({"x"});
+    std::vector<double> xs = samplePoints(static_cast<size_t>(state.range(0)));
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        double sum = 0;
+        for (double x : xs) {
+            sum += program.eval(&x);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    allocations.report(state);
+    state.counters["instructions"] = static_cast<double>(program.size());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * xs.size()));
+}
+BENCHMARK(BM_EvaluateCompiled)->Arg(4096);
+
+void BM_EvaluateBatch(benchmark::State& state) {
+    SymbolicEngine engine;
+    engine.parseFromString(kEvaluated);
+    std::vector<double> xs = samplePoints(static_cast<size_t>(state.range(0)));
+    std::vector<double> out(xs.size());
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        engine.evaluateBatch(xs.data(), out.data(), xs.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * xs.size()));
+}
+BENCHMARK(BM_EvaluateBatch)->Arg(4096);
+
+// ---- Console grapher ----
+
+void BM_ConsoleGrapherPlot(benchmark::State& state) {
+    ConsoleGrapher::PlotSettings settings;
+    settings.width = static_cast<int>(state.range(0));
+    settings.height = static_cast<int>(state.range(0)) / 3;
+    ConsoleGrapher grapher(settings);
+    grapher.addFunction("sin(x) * x");
+    grapher.addFunction("x^2 / 10 - 5", "", '#');
+
+    NullBuffer sink;
+    std::streambuf* console = std::cout.rdbuf(&sink);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        grapher.plot();
+    }
+    allocations.report(state);
+    std::cout.rdbuf(console);
+    state.counters["cells"] = static_cast<double>(settings.width) * settings.height;
+}
+BENCHMARK(BM_ConsoleGrapherPlot)->Arg(80)->Arg(240);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,156 @@
+#include "server/EvalServer.h"
+#include "util/ThreadPool.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CAS_HAVE_SOCKETS 1
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// A client that disconnects mid-response must fail the send, not raise
+// SIGPIPE and end the server; BSDs have SO_NOSIGPIPE instead of the flag
+#if defined(CAS_HAVE_SOCKETS) && defined(MSG_NOSIGNAL)
+#define CAS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define CAS_SEND_FLAGS 0
+#endif
+
+void printUsage() {
+    std::cerr << "Usage: cas_server [--port <n>] [--threads <n>] [--cache <n>]" << std::endl;
+    std::cerr << "  Serves requests on stdin/stdout, or on a TCP port (one thread per connection)." << std::endl;
+    std::cerr << "  Requests: eval <expr> [; x=1 y=2] | diff <expr> [; var] | integrate <expr> [; var]" << std::endl;
+    std::cerr << "            simplify <expr> | parse <expr> | roots <expr> ; [var] lo hi [a=1 ...]" << std::endl;
+    std::cerr << "            stats | batch <n> | quit" << std::endl;
+}
+
+#if defined(CAS_HAVE_SOCKETS)
+// Buffered iostream adapter over a connected socket
+class SocketBuffer : public std::streambuf {
+private:
+    int fd;
+    char input[4096];
+    char output[4096];
+
+public:
+    explicit SocketBuffer(int socket) : fd(socket) {
+#if defined(SO_NOSIGPIPE)
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        setg(input, input, input);
+        setp(output, output + sizeof(output));
+    }
+    ~SocketBuffer() override {
+        sync();
+        close(fd);
+    }
+
+protected:
+    int_type underflow() override {
+        ssize_t received = recv(fd, input, sizeof(input), 0);
+        if (received <= 0) return traits_type::eof();
+        setg(input, input, input + received);
+        return traits_type::to_int_type(input[0]);
+    }
+
+    int_type overflow(int_type c) override {
+        if (sync() != 0) return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        const char* data = pbase();
+        while (data < pptr()) {
+            ssize_t sent = send(fd, data, pptr() - data, CAS_SEND_FLAGS);
+            if (sent <= 0) return -1;
+            data += sent;
+        }
+        setp(output, output + sizeof(output));
+        return 0;
+    }
+};
+
+int serveSocket(EvalServer& server, int port) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: Could not create socket" << std::endl;
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0) {
+        std::cerr << "Error: Could not listen on port " << port << std::endl;
+        close(listener);
+        return 1;
+    }
+    std::cerr << "Listening on 127.0.0.1:" << port << std::endl;
+
+    while (true) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) continue;
+        std::thread([&server, connection]() {
+            SocketBuffer buffer(connection);
+            std::iostream stream(&buffer);
+            server.serve(stream, stream);
+        }).detach();
+    }
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    int port = 0;
+    size_t threads = 0;
+    ServerOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--port" || arg == "--threads" || arg == "--cache") && i + 1 < argc) {
+            long value = std::strtol(argv[++i], nullptr, 10);
+            if (value < 0) value = 0;
+            if (arg == "--port") port = static_cast<int>(value);
+            else if (arg == "--threads") threads = static_cast<size_t>(value);
+            else options.cacheCapacity = static_cast<size_t>(value);
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 0) {
+        pool = std::make_unique<ThreadPool>(threads);
+        options.pool = pool.get();
+    }
+    EvalServer server(options);
+
+    if (port > 0) {
+#if defined(CAS_HAVE_SOCKETS)
+        return serveSocket(server, port);
+#else
+        std::cerr << "Error: Sockets are not supported on this platform" << std::endl;
+        return 1;
+#endif
+    }
+
+    std::ios::sync_with_stdio(false);
+    server.serve(std::cin, std::cout);
+    return 0;
+}
@@ -0,0 +1,361 @@
+#include "BatchKernels.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CAS_BATCH_AVX2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CAS_BATCH_NEON 1
+#endif
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Inputs larger than this fall back to libm, where the three-part
+// Cody-Waite reduction below would start losing precision
+constexpr double kTrigReductionLimit = 1.0e5;
+
+// Cephes sin/cos coefficients on [-pi/4, pi/4]
+constexpr double kPiOver4Inv = 1.27323954473516268615; // 4/pi
+constexpr double kDP1 = 7.85398125648498535156E-1;
+constexpr double kDP2 = 3.77489470793079817668E-8;
+constexpr double kDP3 = 2.69515142907905952645E-15;
+
+inline double sinPoly(double z, double zz) {
+    double p = 1.58962301576546568060E-10;
+    p = p * zz - 2.50507477628578072866E-8;
+    p = p * zz + 2.75573136213857245213E-6;
+    p = p * zz - 1.98412698295895385996E-4;
+    p = p * zz + 8.33333333332211858878E-3;
+    p = p * zz - 1.66666666666666307295E-1;
+    return z + z * zz * p;
+}
+
+inline double cosPoly(double zz) {
+    double p = -1.13585365213876817300E-11;
+    p = p * zz + 2.08757008419747316778E-9;
+    p = p * zz - 2.75573141792967388112E-7;
+    p = p * zz + 2.48015872888517045348E-5;
+    p = p * zz - 1.38888888888730564116E-3;
+    p = p * zz + 4.16666666666665929218E-2;
+    return 1.0 - 0.5 * zz + zz * zz * p;
+}
+
+// Branch-free sin/cos for |x| <= kTrigReductionLimit
+inline double reducedSinCos(double x, bool cosine) {
+    double ax = std::fabs(x);
+    double y = std::floor(ax * kPiOver4Inv);
+    int64_t j = static_cast<int64_t>(y);
+    // Map to the even octant so the reduced argument stays in [-pi/4, pi/4]
+    int64_t odd = j & 1;
+    j += odd;
+    y += static_cast<double>(odd);
+    j &= 7;
+
+    double z = ((ax - y * kDP1) - y * kDP2) - y * kDP3;
+    double zz = z * z;
+    double s = sinPoly(z, zz);
+    double c = cosPoly(zz);
+
+    bool swap = (j == 2 || j == 6);
+    bool negate;
+    if (cosine) {
+        negate = (j == 2 || j == 4);
+    } else {
+        negate = (j >= 4) != (x < 0);
+    }
+    double r = (swap != cosine) ? c : s;
+    return negate ? -r : r;
+}
+
+// Cephes log rational approximation coefficients
+inline double reducedLogRatio(double x) {
+    double p = 1.01875663804580931796E-4;
+    p = p * x + 4.97494994976747001425E-1;
+    p = p * x + 4.70579119878881725854E0;
+    p = p * x + 1.44989225341610930846E1;
+    p = p * x + 1.79368678507819816313E1;
+    p = p * x + 7.70838733755885391666E0;
+
+    double q = x + 1.12873587189167450590E1;
+    q = q * x + 4.52279145837532221105E1;
+    q = q * x + 8.29875266912776603211E1;
+    q = q * x + 7.11544750618563894466E1;
+    q = q * x + 2.31251620126765340583E1;
+    return p / q;
+}
+
+// Natural log for positive normal x, using exponent bits instead of frexp
+inline double reducedLn(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    double e = static_cast<double>(static_cast<int64_t>((bits >> 52) & 0x7ff) - 1022);
+    bits = (bits & 0x000fffffffffffffULL) | 0x3fe0000000000000ULL;
+    double m;
+    std::memcpy(&m, &bits, sizeof(m));   // m in [0.5, 1)
+
+    bool small = m < 0.70710678118654752440;
+    e = small ? e - 1.0 : e;
+    double f = small ? (m + m) - 1.0 : m - 1.0;
+
+    double z = f * f;
+    double y = f * (z * reducedLogRatio(f));
+    y = y - e * 2.121944400546905827679e-4;
+    y = y - 0.5 * z;
+    return (f + y) + e * 0.693359375;
+}
+
+template <typename Exact>
+void fixupTrig(double* a, const double* original, size_t n, Exact exact) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!(std::fabs(original[i]) <= kTrigReductionLimit)) {
+            a[i] = exact(original[i]);
+        }
+    }
+}
+
+template <bool Cosine>
+void batchSinCos(double* a, size_t n) {
+    constexpr size_t kChunk = 256;
+    double original[kChunk];
+    for (size_t base = 0; base < n; base += kChunk) {
+        size_t count = (n - base < kChunk) ? n - base : kChunk;
+        double* col = a + base;
+        bool needsFixup = false;
+        for (size_t i = 0; i < count; ++i) {
+            original[i] = col[i];
+            needsFixup |= !(std::fabs(col[i]) <= kTrigReductionLimit);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            double x = (std::fabs(original[i]) <= kTrigReductionLimit) ? original[i] : 0.0;
+            col[i] = reducedSinCos(x, Cosine);
+        }
+        if (needsFixup) {
+            fixupTrig(col, original, count, [](double x) { return Cosine ? std::cos(x) : std::sin(x); });
+        }
+    }
+}
+
+} // namespace
+
+void batchFill(double* a, double value, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = value;
+    }
+}
+
+void batchAdd(double* a, const double* b, size_t n) {
+    size_t i = 0;
+#if defined(CAS_BATCH_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+#elif defined(CAS_BATCH_NEON)
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(a + i, vaddq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] += b[i];
+    }
+}
+
+void batchSubtract(double* a, const double* b, size_t n) {
+    size_t i = 0;
+#if defined(CAS_BATCH_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(a + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+#elif defined(CAS_BATCH_NEON)
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(a + i, vsubq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] -= b[i];
+    }
+}
+
+void batchMultiply(double* a, const double* b, size_t n) {
+    size_t i = 0;
+#if defined(CAS_BATCH_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+#elif defined(CAS_BATCH_NEON)
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(a + i, vmulq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] *= b[i];
+    }
+}
+
+void batchDivide(double* a, const double* b, size_t n) {
+    size_t i = 0;
+#if defined(CAS_BATCH_AVX2)
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d nan = _mm256_set1_pd(kNaN);
+    for (; i + 4 <= n; i += 4) {
+        __m256d denom = _mm256_loadu_pd(b + i);
+        __m256d quotient = _mm256_div_pd(_mm256_loadu_pd(a + i), denom);
+        __m256d isZero = _mm256_cmp_pd(denom, zero, _CMP_EQ_OQ);
+        _mm256_storeu_pd(a + i, _mm256_blendv_pd(quotient, nan, isZero));
+    }
+#elif defined(CAS_BATCH_NEON)
+    const float64x2_t nan = vdupq_n_f64(kNaN);
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t denom = vld1q_f64(b + i);
+        float64x2_t quotient = vdivq_f64(vld1q_f64(a + i), denom);
+        uint64x2_t isZero = vceqzq_f64(denom);
+        vst1q_f64(a + i, vbslq_f64(isZero, nan, quotient));
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] = (b[i] == 0) ? kNaN : a[i] / b[i];
+    }
+}
+
+void batchPower(double* a, const double* b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = std::pow(a[i], b[i]);
+    }
+}
+
+void batchPowerInteger(double* a, int exponent, size_t n) {
+    if (exponent == 0) {
+        batchFill(a, 1.0, n);
+        return;
+    }
+
+    // Square-and-multiply over whole columns so every step is a vector multiply
+    constexpr size_t kChunk = 256;
+    double base[kChunk];
+    double result[kChunk];
+    unsigned int magnitude = static_cast<unsigned int>(exponent < 0 ? -exponent : exponent);
+    for (size_t start = 0; start < n; start += kChunk) {
+        size_t count = (n - start < kChunk) ? n - start : kChunk;
+        double* col = a + start;
+        std::memcpy(base, col, count * sizeof(double));
+        batchFill(result, 1.0, count);
+        for (unsigned int e = magnitude; e != 0; e >>= 1) {
+            if (e & 1) {
+                batchMultiply(result, base, count);
+            }
+            if (e > 1) {
+                batchMultiply(base, base, count);
+            }
+        }
+        if (exponent < 0) {
+            for (size_t i = 0; i < count; ++i) {
+                col[i] = 1.0 / result[i];
+            }
+        } else {
+            std::memcpy(col, result, count * sizeof(double));
+        }
+    }
+}
+
+void batchNegate(double* a, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = -a[i];
+    }
+}
+
+void batchAbs(double* a, size_t n) {
+    size_t i = 0;
+#if defined(CAS_BATCH_AVX2)
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(a + i, _mm256_andnot_pd(signMask, _mm256_loadu_pd(a + i)));
+    }
+#elif defined(CAS_BATCH_NEON)
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(a + i, vabsq_f64(vld1q_f64(a + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] = std::fabs(a[i]);
+    }
+}
+
+void batchSqrt(double* a, size_t n) {
+    size_t i = 0;
+#if defined(CAS_BATCH_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(a + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+    }
+#elif defined(CAS_BATCH_NEON)
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(a + i, vsqrtq_f64(vld1q_f64(a + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] = (a[i] < 0) ? kNaN : std::sqrt(a[i]);
+    }
+}
+
+void batchSin(double* a, size_t n) {
+    batchSinCos<false>(a, n);
+}
+
+void batchCos(double* a, size_t n) {
+    batchSinCos<true>(a, n);
+}
+
+void batchTan(double* a, size_t n) {
+    constexpr size_t kChunk = 256;
+    double cosine[kChunk];
+    for (size_t start = 0; start < n; start += kChunk) {
+        size_t count = (n - start < kChunk) ? n - start : kChunk;
+        double* col = a + start;
+        std::memcpy(cosine, col, count * sizeof(double));
+        batchSin(col, count);
+        batchCos(cosine, count);
+        for (size_t i = 0; i < count; ++i) {
+            col[i] /= cosine[i];
+        }
+    }
+}
+
+void batchLn(double* a, size_t n) {
+    constexpr size_t kChunk = 256;
+    double original[kChunk];
+    for (size_t start = 0; start < n; start += kChunk) {
+        size_t count = (n - start < kChunk) ? n - start : kChunk;
+        double* col = a + start;
+        bool needsFixup = false;
+        for (size_t i = 0; i < count; ++i) {
+            double x = col[i];
+            bool normal = x >= std::numeric_limits<double>::min() &&
+                          x <= std::numeric_limits<double>::max();
+            original[i] = x;
+            needsFixup |= !normal;
+            col[i] = reducedLn(normal ? x : 1.0);
+        }
+        if (!needsFixup) {
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            double x = original[i];
+            if (!(x >= std::numeric_limits<double>::min() && x <= std::numeric_limits<double>::max())) {
+                // Positive subnormals and +inf are still in the domain
+                col[i] = (x > 0) ? std::log(x) : kNaN;
+            }
+        }
+    }
+}
+
+void batchLog10(double* a, size_t n) {
+    constexpr double kInvLn10 = 0.43429448190325182765;
+    batchLn(a, n);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] *= kInvLn10;
+    }
+}
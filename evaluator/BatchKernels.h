@@ -0,0 +1,32 @@
+#ifndef BATCH_KERNELS_H
+#define BATCH_KERNELS_H
+
+#include <cstddef>
+
+// Column kernels used by CompiledExpression::evalBatch.
+// Binary kernels update the left column in place (a[i] = a[i] op b[i]);
+// unary kernels update their column in place. Domain errors (division by
+// zero, log of non-positive, sqrt of negative) produce NaN instead of throwing.
+//
+// Arithmetic and sqrt use AVX2 or NEON intrinsics when the compiler targets
+// them; sin/cos/ln use branch-free polynomial approximations written so the
+// compiler can vectorize them, with a scalar fix-up pass for inputs outside
+// the reduced range.
+
+void batchFill(double* a, double value, size_t n);
+void batchAdd(double* a, const double* b, size_t n);
+void batchSubtract(double* a, const double* b, size_t n);
+void batchMultiply(double* a, const double* b, size_t n);
+void batchDivide(double* a, const double* b, size_t n);
+void batchPower(double* a, const double* b, size_t n);
+void batchPowerInteger(double* a, int exponent, size_t n);
+void batchNegate(double* a, size_t n);
+void batchAbs(double* a, size_t n);
+void batchSqrt(double* a, size_t n);
+void batchSin(double* a, size_t n);
+void batchCos(double* a, size_t n);
+void batchTan(double* a, size_t n);
+void batchLn(double* a, size_t n);
+void batchLog10(double* a, size_t n);
+
+#endif // BATCH_KERNELS_H
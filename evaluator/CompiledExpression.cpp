@@ -0,0 +1,613 @@
+#include "CompiledExpression.h"
+#include "BatchKernels.h"
+#include "FunctionRegistry.h"
+#include "../util/Instrumentation.h"
+#include <sstream>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Programs this shallow run on a stack buffer with no allocation
+constexpr size_t kInlineStackSize = 64;
+
+// Points per column block in evalBatch; small enough that a full stack of
+// columns stays in L1/L2 for typical expression depths
+constexpr size_t kBatchBlockSize = 256;
+
+// Integer exponents up to this magnitude are expanded into multiplies
+constexpr double kMaxExpandedExponent = 64;
+
+// Throws when status is null; otherwise records the failure and yields NaN
+double domainError(EvalStatus* status, EvalStatus failure) {
+    if (!status) {
+        throw std::runtime_error(evalStatusMessage(failure));
+    }
+    recordStatus(*status, failure);
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+double runProgram(const Instruction* code, size_t length, const double* constants,
+                  const double* slots, double* stack, double* temps, EvalStatus* status) {
+    size_t top = 0;
+    for (size_t pc = 0; pc < length; ++pc) {
+        const Instruction& ins = code[pc];
+        switch (ins.op) {
+            case OpCode::PUSH_CONST: stack[top++] = constants[ins.operand]; break;
+            case OpCode::LOAD_SLOT: stack[top++] = slots[ins.operand]; break;
+            case OpCode::STORE_TEMP: temps[ins.operand] = stack[top - 1]; break;
+            case OpCode::LOAD_TEMP: stack[top++] = temps[ins.operand]; break;
+            case OpCode::ADD: --top; stack[top - 1] += stack[top]; break;
+            case OpCode::SUBTRACT: --top; stack[top - 1] -= stack[top]; break;
+            case OpCode::MULTIPLY: --top; stack[top - 1] *= stack[top]; break;
+            case OpCode::DIVIDE:
+                --top;
+                if (stack[top] == 0) {
+                    stack[top - 1] = domainError(status, EvalStatus::DIVISION_BY_ZERO);
+                } else {
+                    stack[top - 1] /= stack[top];
+                }
+                break;
+            case OpCode::POWER: --top; stack[top - 1] = std::pow(stack[top - 1], stack[top]); break;
+            case OpCode::NEGATE: stack[top - 1] = -stack[top - 1]; break;
+            case OpCode::SIN: stack[top - 1] = std::sin(stack[top - 1]); break;
+            case OpCode::COS: stack[top - 1] = std::cos(stack[top - 1]); break;
+            case OpCode::TAN: stack[top - 1] = std::tan(stack[top - 1]); break;
+            case OpCode::LOG:
+                stack[top - 1] = (stack[top - 1] <= 0) ? domainError(status, EvalStatus::LOG_DOMAIN)
+                                                      : std::log10(stack[top - 1]);
+                break;
+            case OpCode::LN:
+                stack[top - 1] = (stack[top - 1] <= 0) ? domainError(status, EvalStatus::LN_DOMAIN)
+                                                      : std::log(stack[top - 1]);
+                break;
+            case OpCode::SQRT:
+                stack[top - 1] = (stack[top - 1] < 0) ? domainError(status, EvalStatus::SQRT_DOMAIN)
+                                                     : std::sqrt(stack[top - 1]);
+                break;
+            case OpCode::ABS: stack[top - 1] = std::abs(stack[top - 1]); break;
+            case OpCode::CALL:
+                top -= FunctionRegistry::arity(ins.operand) - 1;
+                stack[top - 1] = FunctionRegistry::call(ins.operand, stack + top - 1, status);
+                break;
+            default: throw std::runtime_error("Unknown opcode");
+        }
+    }
+    return stack[0];
+}
+
+// Forward-mode twin of runProgram over (value, tangent) pairs. Values follow
+// runProgram exactly; a zero tangent marks an operand independent of the
+// seeded slot, whose slope is never multiplied in (so e.g. (-2)^3 keeps a
+// finite derivative although d/db a^b = a^b ln a is NaN there).
+struct Dual {
+    double value;
+    double tangent;
+};
+
+double runDualProgram(const Instruction* code, size_t length, const double* constants, const double* slots,
+                      size_t seed, Dual* stack, Dual* temps, double& derivative, EvalStatus& status) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    auto chain = [](double tangent, double slope) { return tangent != 0 ? tangent * slope : 0.0; };
+    size_t top = 0;
+    for (size_t pc = 0; pc < length; ++pc) {
+        const Instruction& ins = code[pc];
+        switch (ins.op) {
+            case OpCode::PUSH_CONST: stack[top++] = {constants[ins.operand], 0}; continue;
+            case OpCode::LOAD_SLOT: stack[top++] = {slots[ins.operand], ins.operand == seed ? 1.0 : 0.0}; continue;
+            case OpCode::STORE_TEMP: temps[ins.operand] = stack[top - 1]; continue;
+            case OpCode::LOAD_TEMP: stack[top++] = temps[ins.operand]; continue;
+            case OpCode::CALL: {
+                uint32_t arity = FunctionRegistry::arity(ins.operand);
+                top -= arity;
+                double args[FunctionRegistry::kMaxArity];
+                for (uint32_t i = 0; i < arity; ++i) args[i] = stack[top + i].value;
+                Dual result = {FunctionRegistry::call(ins.operand, args, &status), 0};
+                for (uint32_t i = 0; i < arity; ++i) {
+                    result.tangent += chain(stack[top + i].tangent, FunctionRegistry::slope(ins.operand, args, i));
+                }
+                if (std::isnan(result.value)) result.tangent = nan;
+                stack[top++] = result;
+                continue;
+            }
+            default: break;
+        }
+
+        // Binary ops fold b into a; unary ops rewrite a in place
+        if (ins.op >= OpCode::ADD && ins.op <= OpCode::POWER) --top;
+        Dual& a = stack[top - 1];
+        const Dual* b = stack + top;   // valid for binary ops only
+        switch (ins.op) {
+            case OpCode::ADD: a = {a.value + b->value, a.tangent + b->tangent}; break;
+            case OpCode::SUBTRACT: a = {a.value - b->value, a.tangent - b->tangent}; break;
+            case OpCode::MULTIPLY:
+                a = {a.value * b->value, chain(a.tangent, b->value) + chain(b->tangent, a.value)};
+                break;
+            case OpCode::DIVIDE:
+                if (b->value == 0) {
+                    a = {domainError(&status, EvalStatus::DIVISION_BY_ZERO), nan};
+                } else {
+                    a = {a.value / b->value,
+                         chain(a.tangent, 1 / b->value) + chain(b->tangent, -a.value / (b->value * b->value))};
+                }
+                break;
+            case OpCode::POWER: {
+                double value = std::pow(a.value, b->value);
+                a = {value, chain(a.tangent, b->value * std::pow(a.value, b->value - 1)) +
+                                chain(b->tangent, value * std::log(a.value))};
+                break;
+            }
+            case OpCode::NEGATE: a = {-a.value, -a.tangent}; break;
+            case OpCode::SIN: a = {std::sin(a.value), chain(a.tangent, std::cos(a.value))}; break;
+            case OpCode::COS: a = {std::cos(a.value), chain(a.tangent, -std::sin(a.value))}; break;
+            case OpCode::TAN: {
+                double c = std::cos(a.value);
+                a = {std::tan(a.value), chain(a.tangent, 1 / (c * c))};
+                break;
+            }
+            case OpCode::LOG:
+                a = (a.value <= 0) ? Dual{domainError(&status, EvalStatus::LOG_DOMAIN), nan}
+                                   : Dual{std::log10(a.value), chain(a.tangent, 1 / (a.value * std::log(10.0)))};
+                break;
+            case OpCode::LN:
+                a = (a.value <= 0) ? Dual{domainError(&status, EvalStatus::LN_DOMAIN), nan}
+                                   : Dual{std::log(a.value), chain(a.tangent, 1 / a.value)};
+                break;
+            case OpCode::SQRT:
+                if (a.value < 0) {
+                    a = {domainError(&status, EvalStatus::SQRT_DOMAIN), nan};
+                } else {
+                    double root = std::sqrt(a.value);
+                    a = {root, chain(a.tangent, 0.5 / root)};
+                }
+                break;
+            case OpCode::ABS:
+                a = {std::abs(a.value), chain(a.tangent, a.value > 0 ? 1.0 : (a.value < 0 ? -1.0 : 0.0))};
+                break;
+            default: throw std::runtime_error("Unknown opcode");
+        }
+    }
+    derivative = stack[0].tangent;
+    return stack[0].value;
+}
+
+// runProgram on a stack buffer when the frame is small, else on the heap
+double runView(const ProgramView& program, const double* slots, EvalStatus* status) {
+    if (program.maxStackDepth + program.tempCount <= kInlineStackSize) {
+        double stack[kInlineStackSize];
+        return runProgram(program.code, program.length, program.constants, slots, stack,
+                          stack + program.maxStackDepth, status);
+    }
+
+    std::vector<double> stack(program.maxStackDepth + program.tempCount);
+    return runProgram(program.code, program.length, program.constants, slots, stack.data(),
+                      stack.data() + program.maxStackDepth, status);
+}
+
+const char* opCodeName(OpCode op) {
+    switch (op) {
+        case OpCode::PUSH_CONST: return "PUSH_CONST";
+        case OpCode::LOAD_SLOT: return "LOAD_SLOT";
+        case OpCode::STORE_TEMP: return "STORE_TEMP";
+        case OpCode::LOAD_TEMP: return "LOAD_TEMP";
+        case OpCode::ADD: return "ADD";
+        case OpCode::SUBTRACT: return "SUBTRACT";
+        case OpCode::MULTIPLY: return "MULTIPLY";
+        case OpCode::DIVIDE: return "DIVIDE";
+        case OpCode::POWER: return "POWER";
+        case OpCode::NEGATE: return "NEGATE";
+        case OpCode::SIN: return "SIN";
+        case OpCode::COS: return "COS";
+        case OpCode::TAN: return "TAN";
+        case OpCode::LOG: return "LOG";
+        case OpCode::LN: return "LN";
+        case OpCode::SQRT: return "SQRT";
+        case OpCode::ABS: return "ABS";
+        case OpCode::CALL: return "CALL";
+        default: return "UNKNOWN";
+    }
+}
+
+} // namespace
+
+const char* evalStatusMessage(EvalStatus status) {
+    switch (status) {
+        case EvalStatus::OK: return "OK";
+        case EvalStatus::DIVISION_BY_ZERO: return "Division by zero";
+        case EvalStatus::LOG_DOMAIN: return "Log of non-positive number";
+        case EvalStatus::LN_DOMAIN: return "Natural log of non-positive number";
+        case EvalStatus::SQRT_DOMAIN: return "Square root of negative number";
+        case EvalStatus::UNDEFINED_VARIABLE: return "Undefined variable";
+        case EvalStatus::UNKNOWN_FUNCTION: return "Unknown function";
+        case EvalStatus::WRONG_ARITY: return "Wrong number of function arguments";
+        case EvalStatus::NO_EXPRESSION: return "No expression compiled";
+        case EvalStatus::FUNCTION_DOMAIN: return "Argument outside the domain of a function";
+    }
+    return "Unknown status";
+}
+
+// ============================================================================
+// ProgramView Implementation
+// ============================================================================
+
+double ProgramView::eval(const double* slots) const {
+    if (length == 0) {
+        throw std::runtime_error("No expression compiled");
+    }
+    return runView(*this, slots, nullptr);
+}
+
+double ProgramView::eval(const double* slots, EvalStatus& status) const {
+    if (length == 0) {
+        return domainError(&status, EvalStatus::NO_EXPRESSION);
+    }
+    return runView(*this, slots, &status);
+}
+
+double ProgramView::evalDerivative(const double* slots, size_t slot, double& derivative, EvalStatus& status) const {
+    if (length == 0) {
+        derivative = std::numeric_limits<double>::quiet_NaN();
+        return domainError(&status, EvalStatus::NO_EXPRESSION);
+    }
+    if (maxStackDepth + tempCount <= kInlineStackSize) {
+        Dual stack[kInlineStackSize];
+        return runDualProgram(code, length, constants, slots, slot, stack, stack + maxStackDepth, derivative, status);
+    }
+    std::vector<Dual> stack(maxStackDepth + tempCount);
+    return runDualProgram(code, length, constants, slots, slot, stack.data(), stack.data() + maxStackDepth,
+                          derivative, status);
+}
+
+void ProgramView::evalBatch(const double* const* columns, double* out, size_t n) const {
+    if (length == 0) {
+        throw std::runtime_error("No expression compiled");
+    }
+    CAS_COUNT_N(POINTS_EVALUATED, n);
+
+    // One column per stack entry; constant entries remember their value so
+    // POWER can expand small integer exponents into vector multiplies
+    std::vector<double> workspace(maxStackDepth * kBatchBlockSize);
+    std::vector<char> isConstant(maxStackDepth);
+    std::vector<double> constantValue(maxStackDepth);
+    std::vector<double> temps(tempCount * kBatchBlockSize);
+    std::vector<char> tempConstant(tempCount);
+    std::vector<double> tempValue(tempCount);
+
+    for (size_t start = 0; start < n; start += kBatchBlockSize) {
+        size_t count = (n - start < kBatchBlockSize) ? n - start : kBatchBlockSize;
+        size_t top = 0;
+
+        for (size_t pc = 0; pc < length; ++pc) {
+            const Instruction& ins = code[pc];
+            // Unary ops work on the top column; binary ops fold top into the one below
+            double* topCol = (top >= 1) ? &workspace[(top - 1) * kBatchBlockSize] : nullptr;
+            double* belowCol = (top >= 2) ? &workspace[(top - 2) * kBatchBlockSize] : nullptr;
+
+            switch (ins.op) {
+                case OpCode::PUSH_CONST: {
+                    double* col = &workspace[top * kBatchBlockSize];
+                    batchFill(col, constants[ins.operand], count);
+                    isConstant[top] = 1;
+                    constantValue[top] = constants[ins.operand];
+                    ++top;
+                    continue;
+                }
+                case OpCode::LOAD_SLOT: {
+                    double* col = &workspace[top * kBatchBlockSize];
+                    std::copy(columns[ins.operand] + start, columns[ins.operand] + start + count, col);
+                    isConstant[top] = 0;
+                    ++top;
+                    continue;
+                }
+                case OpCode::STORE_TEMP:
+                    std::copy(topCol, topCol + count, &temps[ins.operand * kBatchBlockSize]);
+                    tempConstant[ins.operand] = isConstant[top - 1];
+                    tempValue[ins.operand] = constantValue[top - 1];
+                    continue;
+                case OpCode::LOAD_TEMP: {
+                    const double* temp = &temps[ins.operand * kBatchBlockSize];
+                    std::copy(temp, temp + count, &workspace[top * kBatchBlockSize]);
+                    isConstant[top] = tempConstant[ins.operand];
+                    constantValue[top] = tempValue[ins.operand];
+                    ++top;
+                    continue;
+                }
+                case OpCode::ADD: batchAdd(belowCol, topCol, count); break;
+                case OpCode::SUBTRACT: batchSubtract(belowCol, topCol, count); break;
+                case OpCode::MULTIPLY: batchMultiply(belowCol, topCol, count); break;
+                case OpCode::DIVIDE: batchDivide(belowCol, topCol, count); break;
+                case OpCode::POWER: {
+                    double exponent = constantValue[top - 1];
+                    if (isConstant[top - 1] && std::floor(exponent) == exponent &&
+                        std::abs(exponent) <= kMaxExpandedExponent) {
+                        batchPowerInteger(belowCol, static_cast<int>(exponent), count);
+                    } else {
+                        batchPower(belowCol, topCol, count);
+                    }
+                    break;
+                }
+                case OpCode::NEGATE: batchNegate(topCol, count); break;
+                case OpCode::SIN: batchSin(topCol, count); break;
+                case OpCode::COS: batchCos(topCol, count); break;
+                case OpCode::TAN: batchTan(topCol, count); break;
+                case OpCode::LOG: batchLog10(topCol, count); break;
+                case OpCode::LN: batchLn(topCol, count); break;
+                case OpCode::SQRT: batchSqrt(topCol, count); break;
+                case OpCode::ABS: batchAbs(topCol, count); break;
+                case OpCode::CALL: {
+                    // Arguments are the top arity columns; the result replaces the first
+                    uint32_t arity = FunctionRegistry::arity(ins.operand);
+                    const double* args[FunctionRegistry::kMaxArity];
+                    for (uint32_t i = 0; i < arity; ++i) {
+                        args[i] = &workspace[(top - arity + i) * kBatchBlockSize];
+                    }
+                    top -= arity - 1;
+                    FunctionRegistry::callBatch(ins.operand, args, &workspace[(top - 1) * kBatchBlockSize], count);
+                    break;
+                }
+                default: throw std::runtime_error("Unknown opcode");
+            }
+
+            // Binary operations consume their right operand column
+            switch (ins.op) {
+                case OpCode::ADD:
+                case OpCode::SUBTRACT:
+                case OpCode::MULTIPLY:
+                case OpCode::DIVIDE:
+                case OpCode::POWER:
+                    --top;
+                    break;
+                default:
+                    break;
+            }
+            isConstant[top - 1] = 0;
+        }
+
+        std::copy(workspace.begin(), workspace.begin() + count, out + start);
+    }
+}
+
+// ============================================================================
+// CompiledExpression Implementation
+// ============================================================================
+
+CompiledExpression::CompiledExpression() : stackDepth(0), maxStackDepth(0), tempCount(0) {}
+
+CompiledExpression::CompiledExpression(const std::vector<std::string>& slots)
+    : slotNames(slots), stackDepth(0), maxStackDepth(0), tempCount(0) {}
+
+void CompiledExpression::push(size_t count) {
+    stackDepth += count;
+    if (stackDepth > maxStackDepth) {
+        maxStackDepth = stackDepth;
+    }
+}
+
+void CompiledExpression::pop(size_t count) {
+    if (stackDepth < count) {
+        throw std::runtime_error("Stack underflow while compiling expression");
+    }
+    stackDepth -= count;
+}
+
+void CompiledExpression::invalidateNative() {
+#ifdef CAS_ENABLE_JIT
+    jit.reset();
+#endif
+}
+
+void CompiledExpression::emitConstant(double value) {
+    invalidateNative();
+    code.emplace_back(OpCode::PUSH_CONST, static_cast<uint32_t>(constants.size()));
+    constants.push_back(value);
+    push();
+}
+
+void CompiledExpression::emitVariable(const std::string& name) {
+    invalidateNative();
+    int slot = getSlot(name);
+    if (slot < 0) {
+        slot = static_cast<int>(slotNames.size());
+        slotNames.push_back(name);
+    }
+    code.emplace_back(OpCode::LOAD_SLOT, static_cast<uint32_t>(slot));
+    push();
+}
+
+void CompiledExpression::emit(OpCode op) {
+    invalidateNative();
+    switch (op) {
+        case OpCode::PUSH_CONST:
+        case OpCode::LOAD_SLOT:
+        case OpCode::STORE_TEMP:
+        case OpCode::LOAD_TEMP:
+        case OpCode::CALL:
+            throw std::runtime_error(
+                "Use emitConstant/emitVariable/emitStore/emitLoad/emitCall for operand-carrying opcodes");
+        case OpCode::ADD:
+        case OpCode::SUBTRACT:
+        case OpCode::MULTIPLY:
+        case OpCode::DIVIDE:
+        case OpCode::POWER:
+            pop(2);
+            break;
+        default:
+            pop(1);
+            break;
+    }
+    code.emplace_back(op);
+    push();
+}
+
+void CompiledExpression::emitCall(uint32_t function) {
+    if (FunctionRegistry::isBuiltin(function)) {
+        emit(FunctionRegistry::opcode(function));
+        return;
+    }
+    invalidateNative();
+    pop(FunctionRegistry::arity(function));
+    code.emplace_back(OpCode::CALL, function);
+    push();
+}
+
+void CompiledExpression::emitStore(uint32_t temp) {
+    invalidateNative();
+    if (stackDepth == 0) {
+        throw std::runtime_error("Stack underflow while compiling expression");
+    }
+    code.emplace_back(OpCode::STORE_TEMP, temp);
+    tempCount = std::max(tempCount, static_cast<size_t>(temp) + 1);
+}
+
+void CompiledExpression::emitLoad(uint32_t temp) {
+    invalidateNative();
+    if (temp >= tempCount) {
+        throw std::runtime_error("Load of unassigned temporary");
+    }
+    code.emplace_back(OpCode::LOAD_TEMP, temp);
+    push();
+}
+
+double CompiledExpression::run(const double* slots, EvalStatus* status) const {
+    return runView(view(), slots, status);
+}
+
+#ifdef CAS_ENABLE_JIT
+double CompiledExpression::runNative(const NativeCode& native, const double* slots, EvalStatus* status) const {
+    bool failed = false;
+    double result;
+    if (native.frameSize() <= kInlineStackSize) {
+        double frame[kInlineStackSize];
+        result = native.call(slots, frame, failed);
+    } else {
+        std::vector<double> frame(native.frameSize());
+        result = native.call(slots, frame.data(), failed);
+    }
+    // The interpreter reports the failure (throw or status) exactly as usual
+    return failed ? run(slots, status) : result;
+}
+#endif
+
+double CompiledExpression::eval(const double* slots) const {
+    if (code.empty()) {
+        throw std::runtime_error("No expression compiled");
+    }
+#ifdef CAS_ENABLE_JIT
+    if (const NativeCode* native = jit.hot(*this)) {
+        return runNative(*native, slots, nullptr);
+    }
+#endif
+    return run(slots, nullptr);
+}
+
+double CompiledExpression::eval(const double* slots, EvalStatus& status) const {
+    if (code.empty()) {
+        return domainError(&status, EvalStatus::NO_EXPRESSION);
+    }
+#ifdef CAS_ENABLE_JIT
+    if (const NativeCode* native = jit.hot(*this)) {
+        return runNative(*native, slots, &status);
+    }
+#endif
+    return run(slots, &status);
+}
+
+double CompiledExpression::evalDerivative(const double* slots, size_t slot, double& derivative,
+                                          EvalStatus& status) const {
+    return view().evalDerivative(slots, slot, derivative, status);
+}
+
+double CompiledExpression::evaluate(const std::map<std::string, double>& variables) const {
+    CAS_COUNT(EVALUATE_CALLS);
+    std::vector<double> slots(slotNames.size());
+    for (size_t i = 0; i < slotNames.size(); ++i) {
+        auto it = variables.find(slotNames[i]);
+        if (it == variables.end()) {
+            throw std::runtime_error("Undefined variable: " + slotNames[i]);
+        }
+        slots[i] = it->second;
+    }
+    return eval(slots.data());
+}
+
+double CompiledExpression::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    CAS_COUNT(EVALUATE_CALLS);
+    std::vector<double> slots(slotNames.size());
+    for (size_t i = 0; i < slotNames.size(); ++i) {
+        auto it = variables.find(slotNames[i]);
+        if (it == variables.end()) {
+            recordStatus(status, EvalStatus::UNDEFINED_VARIABLE);
+            slots[i] = std::numeric_limits<double>::quiet_NaN();
+        } else {
+            slots[i] = it->second;
+        }
+    }
+    return eval(slots.data(), status);
+}
+
+void CompiledExpression::evalBatch(const double* const* columns, double* out, size_t n) const {
+    view().evalBatch(columns, out, n);
+}
+
+int CompiledExpression::getSlot(const std::string& name) const {
+    for (size_t i = 0; i < slotNames.size(); ++i) {
+        if (slotNames[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string CompiledExpression::toString() const {
+    std::ostringstream oss;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& ins = code[pc];
+        oss << pc << ": " << opCodeName(ins.op);
+        if (ins.op == OpCode::PUSH_CONST) {
+            oss << " " << constants[ins.operand];
+        } else if (ins.op == OpCode::LOAD_SLOT) {
+            oss << " " << slotNames[ins.operand];
+        } else if (ins.op == OpCode::STORE_TEMP || ins.op == OpCode::LOAD_TEMP) {
+            oss << " t" << ins.operand;
+        } else if (ins.op == OpCode::CALL) {
+            oss << " " << FunctionRegistry::name(ins.operand);
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+bool CompiledExpression::jitAvailable() {
+#ifdef CAS_ENABLE_JIT
+    return NativeCode::supported();
+#else
+    return false;
+#endif
+}
+
+bool CompiledExpression::isNative() const {
+#ifdef CAS_ENABLE_JIT
+    return jit.current() != nullptr;
+#else
+    return false;
+#endif
+}
+
+void CompiledExpression::setJitThreshold(size_t evaluations) {
+#ifdef CAS_ENABLE_JIT
+    JitTier::setThreshold(evaluations);
+#else
+    (void)evaluations;
+#endif
+}
+
+bool CompiledExpression::lookupFunction(const std::string& name, OpCode& op) {
+    uint32_t id = FunctionRegistry::builtin(name);
+    if (id == FunctionRegistry::kUnknown) {
+        return false;
+    }
+    op = FunctionRegistry::opcode(id);
+    return true;
+}
@@ -0,0 +1,188 @@
+#ifndef COMPILED_EXPRESSION_H
+#define COMPILED_EXPRESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+#ifdef CAS_ENABLE_JIT
+#include "JitCompiler.h"
+#endif
+
+// Bytecode operations for the stack-based evaluator
+enum class OpCode : uint8_t {
+    PUSH_CONST,   // push constants[operand]
+    LOAD_SLOT,    // push slots[operand]
+    STORE_TEMP,   // temps[operand] = top of stack (value stays on the stack)
+    LOAD_TEMP,    // push temps[operand]
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    POWER,
+    NEGATE,
+    SIN,
+    COS,
+    TAN,
+    LOG,
+    LN,
+    SQRT,
+    ABS,
+    CALL          // registered function operand (a FunctionRegistry id) on its arguments
+};
+
+// Outcome of one evaluation in status mode. Status-mode evaluation never
+// throws: a failing operation yields NaN, the first failure is recorded and
+// evaluation runs to completion.
+enum class EvalStatus : uint8_t {
+    OK,
+    DIVISION_BY_ZERO,
+    LOG_DOMAIN,           // log of a non-positive number
+    LN_DOMAIN,            // ln of a non-positive number
+    SQRT_DOMAIN,          // sqrt of a negative number
+    UNDEFINED_VARIABLE,
+    UNKNOWN_FUNCTION,
+    WRONG_ARITY,
+    NO_EXPRESSION,
+    FUNCTION_DOMAIN       // registered function outside its domain
+};
+
+// Message for a status, matching what the throwing evaluators report
+const char* evalStatusMessage(EvalStatus status);
+
+// Keep the first failure: status stays at its earliest non-OK value
+inline void recordStatus(EvalStatus& status, EvalStatus failure) {
+    if (status == EvalStatus::OK) status = failure;
+}
+
+// Single bytecode instruction
+struct Instruction {
+    OpCode op;
+    uint32_t operand;
+
+    Instruction(OpCode o, uint32_t arg = 0) : op(o), operand(arg) {}
+};
+
+// ProgramView - non-owning view of a program whose arrays live elsewhere,
+// such as a memory-mapped formula pack (cas/FormulaPack.h). Evaluation runs
+// the same interpreter as CompiledExpression, so results are identical; the
+// arrays must outlive the view and hold a well-formed program.
+struct ProgramView {
+    const Instruction* code = nullptr;
+    size_t length = 0;
+    const double* constants = nullptr;
+    size_t maxStackDepth = 0;
+    size_t tempCount = 0;
+
+    // Same contracts as the CompiledExpression members of the same name
+    double eval(const double* slots) const;
+    double eval(const double* slots, EvalStatus& status) const;
+    double evalDerivative(const double* slots, size_t slot, double& derivative, EvalStatus& status) const;
+    void evalBatch(const double* const* columns, double* out, size_t n) const;
+};
+
+// CompiledExpression - a flat, postfix program lowered from an expression tree.
+// Variables are resolved to slot indices at compile time, so evaluation is a
+// single linear pass with no virtual dispatch and no map lookups.
+class CompiledExpression {
+private:
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<std::string> slotNames;
+    size_t stackDepth;
+    size_t maxStackDepth;
+    size_t tempCount;
+#ifdef CAS_ENABLE_JIT
+    JitTier jit;   // native code once the program is hot
+#endif
+
+    void push(size_t count = 1);
+    void pop(size_t count);
+
+    // Called by every emit*: generated code no longer matches the program
+    void invalidateNative();
+
+    // Shared by eval overloads; null status means throw on domain errors
+    double run(const double* slots, EvalStatus* status) const;
+
+#ifdef CAS_ENABLE_JIT
+    // run() through native code; a point that hits a domain error is re-run
+    // through the interpreter
+    double runNative(const NativeCode& native, const double* slots, EvalStatus* status) const;
+#endif
+
+public:
+    CompiledExpression();
+
+    // Pre-assign slots so callers know where each variable lives
+    explicit CompiledExpression(const std::vector<std::string>& slots);
+
+    // Emission interface used by ASTNode::compile and SymbolicExpression::compile
+    void emitConstant(double value);
+    void emitVariable(const std::string& name);
+    void emit(OpCode op);
+    // Call of a FunctionRegistry function on the values on top of the stack:
+    // builtins lower to their own opcode, registered functions to CALL
+    void emitCall(uint32_t function);
+
+    // Temporaries let a shared subexpression be computed once and reloaded
+    void emitStore(uint32_t temp);
+    void emitLoad(uint32_t temp);
+
+    // Evaluate with slots[i] holding the value of getSlotNames()[i]. With
+    // CAS_ENABLE_JIT, a program evaluated more than the JIT threshold times
+    // switches to native code with identical results.
+    double eval(const double* slots) const;
+
+    // Status mode: NaN plus a status instead of an exception
+    double eval(const double* slots, EvalStatus& status) const;
+
+    // Value and derivative with respect to slots[slot] in one pass (forward-mode
+    // dual numbers). Status mode only: domain errors give NaN and a status.
+    // Points where the derivative does not exist give inf or NaN slopes.
+    double evalDerivative(const double* slots, size_t slot, double& derivative, EvalStatus& status) const;
+
+    // Convenience evaluation through a name -> value map (resolves slots once per call)
+    double evaluate(const std::map<std::string, double>& variables = {}) const;
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const;
+
+    // Evaluate n points at once; columns[i] points at n values for slot i.
+    // Each instruction runs across a whole block of points before the next one,
+    // and domain errors yield NaN for the affected points instead of throwing.
+    // Always interpreted: the vector kernels already amortize dispatch and
+    // beat per-point native calls.
+    void evalBatch(const double* const* columns, double* out, size_t n) const;
+
+    // Slot lookup; returns -1 if the variable does not occur in the program
+    int getSlot(const std::string& name) const;
+    const std::vector<std::string>& getSlotNames() const { return slotNames; }
+    size_t getSlotCount() const { return slotNames.size(); }
+
+    // Program inspection
+    bool empty() const { return code.empty(); }
+    size_t size() const { return code.size(); }
+    size_t getMaxStackDepth() const { return maxStackDepth; }
+    size_t getTempCount() const { return tempCount; }
+    const std::vector<Instruction>& getCode() const { return code; }
+    double getConstant(size_t index) const { return constants[index]; }
+    size_t getConstantCount() const { return constants.size(); }
+    std::string toString() const;
+
+    // The program's arrays, valid until the next emit* call (interpreter only)
+    ProgramView view() const {
+        return ProgramView{code.data(), code.size(), constants.data(), maxStackDepth, tempCount};
+    }
+
+    // JIT tier: whether this build can generate native code, whether this
+    // program already runs natively, and how many evaluations make it hot
+    // (default 64; 0 compiles on first use)
+    static bool jitAvailable();
+    bool isNative() const;
+    static void setJitThreshold(size_t evaluations);
+
+    // Map a builtin function name to its opcode; returns false otherwise
+    static bool lookupFunction(const std::string& name, OpCode& op);
+};
+
+#endif // COMPILED_EXPRESSION_H
@@ -0,0 +1,239 @@
+#include "FunctionRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+using Builtin = FunctionRegistry::Builtin;
+
+struct BuiltinFunction {
+    std::string_view name;
+    OpCode op;
+    double (*kernel)(double);
+    double (*slope)(double);
+    bool (*outOfDomain)(double);   // null for functions defined everywhere
+    EvalStatus domain;
+};
+
+// Indexed by builtin id
+constexpr BuiltinFunction kBuiltins[] = {
+    {"sin", OpCode::SIN, [](double u) { return std::sin(u); }, [](double u) { return std::cos(u); }, nullptr,
+     EvalStatus::OK},
+    {"cos", OpCode::COS, [](double u) { return std::cos(u); }, [](double u) { return -std::sin(u); }, nullptr,
+     EvalStatus::OK},
+    {"tan", OpCode::TAN, [](double u) { return std::tan(u); },
+     [](double u) {
+         double c = std::cos(u);
+         return 1 / (c * c);
+     },
+     nullptr, EvalStatus::OK},
+    {"log", OpCode::LOG, [](double u) { return std::log10(u); }, [](double u) { return 1 / (u * std::log(10.0)); },
+     [](double u) { return u <= 0; }, EvalStatus::LOG_DOMAIN},
+    {"ln", OpCode::LN, [](double u) { return std::log(u); }, [](double u) { return 1 / u; },
+     [](double u) { return u <= 0; }, EvalStatus::LN_DOMAIN},
+    {"sqrt", OpCode::SQRT, [](double u) { return std::sqrt(u); }, [](double u) { return 0.5 / std::sqrt(u); },
+     [](double u) { return u < 0; }, EvalStatus::SQRT_DOMAIN},
+    {"abs", OpCode::ABS, [](double u) { return std::abs(u); },
+     [](double u) { return u > 0 ? 1.0 : (u < 0 ? -1.0 : 0.0); }, nullptr, EvalStatus::OK},
+};
+
+constexpr uint32_t builtinId(std::string_view name) {
+    // (length, first character) selects at most one candidate
+    uint32_t candidate = FunctionRegistry::kUnknown;
+    switch (name.size()) {
+        case 2: candidate = static_cast<uint32_t>(Builtin::LN); break;
+        case 3:
+            switch (name[0]) {
+                case 's': candidate = static_cast<uint32_t>(Builtin::SIN); break;
+                case 'c': candidate = static_cast<uint32_t>(Builtin::COS); break;
+                case 't': candidate = static_cast<uint32_t>(Builtin::TAN); break;
+                case 'l': candidate = static_cast<uint32_t>(Builtin::LOG); break;
+                case 'a': candidate = static_cast<uint32_t>(Builtin::ABS); break;
+            }
+            break;
+        case 4: candidate = static_cast<uint32_t>(Builtin::SQRT); break;
+    }
+    if (candidate != FunctionRegistry::kUnknown && kBuiltins[candidate].name == name) {
+        return candidate;
+    }
+    return FunctionRegistry::kUnknown;
+}
+
+// The table, the Builtin ids, the opcodes and the hash must agree
+constexpr bool builtinTableConsistent() {
+    for (uint32_t id = 0; id < FunctionRegistry::kBuiltinCount; ++id) {
+        if (builtinId(kBuiltins[id].name) != id) return false;
+        if (static_cast<uint32_t>(kBuiltins[id].op) != static_cast<uint32_t>(OpCode::SIN) + id) return false;
+    }
+    return true;
+}
+
+static_assert(std::size(kBuiltins) == FunctionRegistry::kBuiltinCount, "one table entry per builtin");
+static_assert(builtinTableConsistent(), "builtin table out of order");
+static_assert(builtinId("sinh") == FunctionRegistry::kUnknown && builtinId("lg") == FunctionRegistry::kUnknown,
+              "perfect hash accepts a non-builtin");
+
+// Registered functions, published by bumping functionCount after the entry
+// is stored; readers only index ids below a count they have observed
+std::mutex registrationMutex;
+std::atomic<uint32_t> functionCount{FunctionRegistry::kBuiltinCount};
+std::unique_ptr<FunctionRegistry::UserFunction>
+    userFunctions[FunctionRegistry::kMaxFunctions - FunctionRegistry::kBuiltinCount];
+
+// Guarded by registrationMutex
+std::unordered_map<std::string, uint32_t>& userIds() {
+    static std::unordered_map<std::string, uint32_t> ids;
+    return ids;
+}
+
+bool isIdentifier(const std::string& name) {
+    if (name.empty() || !(std::isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_')) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(),
+                       [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+}
+
+// Step of the central difference: cube root of the machine epsilon
+// balances truncation against rounding
+constexpr double kDifferenceStep = 6.0554544523933395e-6;
+
+} // namespace
+
+uint32_t FunctionRegistry::add(UserFunction function) {
+    if (!isIdentifier(function.name)) {
+        throw std::runtime_error("Invalid function name: '" + function.name + "'");
+    }
+    if (function.arity < 1 || function.arity > kMaxArity) {
+        throw std::runtime_error("Function " + function.name + " must take 1 to " + std::to_string(kMaxArity) +
+                                 " arguments");
+    }
+    if (!function.kernel) {
+        throw std::runtime_error("Function " + function.name + " has no kernel");
+    }
+
+    std::lock_guard<std::mutex> lock(registrationMutex);
+    if (builtinId(function.name) != kUnknown || userIds().count(function.name)) {
+        throw std::runtime_error("Function already registered: " + function.name);
+    }
+    uint32_t id = functionCount.load(std::memory_order_relaxed);
+    if (id >= kMaxFunctions) {
+        throw std::runtime_error("Function registry is full");
+    }
+    userIds().emplace(function.name, id);
+    userFunctions[id - kBuiltinCount] = std::make_unique<UserFunction>(std::move(function));
+    functionCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+uint32_t FunctionRegistry::find(std::string_view name) {
+    uint32_t id = builtinId(name);
+    if (id != kUnknown || functionCount.load(std::memory_order_acquire) == kBuiltinCount) {
+        return id;
+    }
+    std::lock_guard<std::mutex> lock(registrationMutex);
+    auto found = userIds().find(std::string(name));
+    return found != userIds().end() ? found->second : kUnknown;
+}
+
+uint32_t FunctionRegistry::builtin(std::string_view name) {
+    return builtinId(name);
+}
+
+uint32_t FunctionRegistry::size() {
+    return functionCount.load(std::memory_order_acquire);
+}
+
+std::string_view FunctionRegistry::name(uint32_t id) {
+    return isBuiltin(id) ? kBuiltins[id].name : std::string_view(user(id).name);
+}
+
+uint32_t FunctionRegistry::arity(uint32_t id) {
+    return isBuiltin(id) ? 1 : user(id).arity;
+}
+
+OpCode FunctionRegistry::opcode(uint32_t id) {
+    return isBuiltin(id) ? kBuiltins[id].op : OpCode::CALL;
+}
+
+const FunctionRegistry::UserFunction& FunctionRegistry::user(uint32_t id) {
+    return *userFunctions[id - kBuiltinCount];
+}
+
+void FunctionRegistry::checkCall(uint32_t id, const std::string& name, size_t count) {
+    if (id == kUnknown) {
+        throw std::runtime_error("Unknown function: " + name);
+    }
+    uint32_t expected = arity(id);
+    if (count != expected) {
+        throw std::runtime_error("Function " + name + " expects " + std::to_string(expected) +
+                                 (expected == 1 ? " argument" : " arguments"));
+    }
+}
+
+double FunctionRegistry::call(uint32_t id, const double* args, EvalStatus* status) {
+    if (isBuiltin(id)) {
+        const BuiltinFunction& function = kBuiltins[id];
+        if (function.outOfDomain && function.outOfDomain(args[0])) {
+            if (!status) {
+                throw std::runtime_error(evalStatusMessage(function.domain));
+            }
+            recordStatus(*status, function.domain);
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return function.kernel(args[0]);
+    }
+
+    // A NaN from defined arguments is the kernel reporting a domain error
+    const UserFunction& function = user(id);
+    double value = function.kernel(args);
+    if (std::isnan(value) && std::none_of(args, args + function.arity, [](double a) { return std::isnan(a); })) {
+        if (!status) {
+            throw std::runtime_error("Argument outside the domain of " + function.name);
+        }
+        recordStatus(*status, EvalStatus::FUNCTION_DOMAIN);
+    }
+    return value;
+}
+
+void FunctionRegistry::callBatch(uint32_t id, const double* const* args, double* out, size_t n) {
+    const UserFunction& function = user(id);
+    if (function.batch) {
+        function.batch(args, out, n);
+        return;
+    }
+    double point[kMaxArity];
+    for (size_t i = 0; i < n; ++i) {
+        for (uint32_t a = 0; a < function.arity; ++a) {
+            point[a] = args[a][i];
+        }
+        out[i] = function.kernel(point);
+    }
+}
+
+double FunctionRegistry::slope(uint32_t id, const double* args, uint32_t argument) {
+    if (isBuiltin(id)) {
+        return kBuiltins[id].slope(args[0]);
+    }
+
+    const UserFunction& function = user(id);
+    double point[kMaxArity];
+    std::copy(args, args + function.arity, point);
+    double x = args[argument];
+    double h = kDifferenceStep * std::max(1.0, std::abs(x));
+    point[argument] = x + h;
+    double above = function.kernel(point);
+    double upper = point[argument];
+    point[argument] = x - h;
+    double below = function.kernel(point);
+    // The step actually taken, after rounding x +- h
+    return (above - below) / (upper - point[argument]);
+}
@@ -0,0 +1,97 @@
+#ifndef FUNCTION_REGISTRY_H
+#define FUNCTION_REGISTRY_H
+
+#include "CompiledExpression.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+struct ExprNode;
+class ExpressionStore;
+
+// FunctionRegistry - the one place function names are resolved. Every
+// function has a dense id that is looked up once, when an expression is
+// lexed or a node is built; evaluation, compilation and differentiation
+// then dispatch on the id without comparing strings.
+//
+// The builtins occupy ids 0..kBuiltinCount-1. A constexpr table holds their
+// kernels and opcodes, and a perfect hash on (length, first character)
+// recognizes their names; both are checked at compile time. Functions
+// registered at run time take the ids after them, in registration order.
+// Registration is append-only and thread safe. Register a function before
+// parsing text that uses it: a name that is not a function when lexed reads
+// as a variable.
+class FunctionRegistry {
+public:
+    enum class Builtin : uint32_t {
+        SIN,
+        COS,
+        TAN,
+        LOG,
+        LN,
+        SQRT,
+        ABS,
+        COUNT
+    };
+
+    static constexpr uint32_t kBuiltinCount = static_cast<uint32_t>(Builtin::COUNT);
+    static constexpr uint32_t kMaxFunctions = 1024;       // builtins included
+    static constexpr uint32_t kUnknown = kMaxFunctions;   // id of a name that is not a function
+    static constexpr uint32_t kMaxArity = 8;
+
+    // Value at args[0..arity-1], or NaN for arguments outside the domain.
+    // Must not throw.
+    using Kernel = std::function<double(const double* args)>;
+    // Optional: out[i] = f(args[0][i], ..., args[arity-1][i]) for n points;
+    // out may alias args[0]. Without one, batches call the kernel per point.
+    using BatchKernel = std::function<void(const double* const* args, double* out, size_t n)>;
+    // Optional: the partial derivative with respect to args[argument], built
+    // in store. Without one, symbolic differentiation of the function throws.
+    using DerivativeRule =
+        std::function<const ExprNode*(ExpressionStore& store, const ExprNode* const* args, uint32_t argument)>;
+
+    struct UserFunction {
+        std::string name;
+        uint32_t arity = 1;
+        Kernel kernel;
+        BatchKernel batch;
+        DerivativeRule derivative;
+    };
+
+    // Adds a function and returns its id. Throws std::runtime_error when the
+    // name is not an identifier or already names a function, the arity is
+    // outside 1..kMaxArity, the kernel is missing or the registry is full.
+    static uint32_t add(UserFunction function);
+
+    // Id of a function name, or kUnknown
+    static uint32_t find(std::string_view name);
+    static uint32_t builtin(std::string_view name);   // builtins only
+
+    // Ids below size() are valid
+    static uint32_t size();
+    static bool isBuiltin(uint32_t id) { return id < kBuiltinCount; }
+    static std::string_view name(uint32_t id);
+    static uint32_t arity(uint32_t id);
+    // Bytecode of a builtin; OpCode::CALL for registered functions
+    static OpCode opcode(uint32_t id);
+    // Registered functions only (id >= kBuiltinCount)
+    static const UserFunction& user(uint32_t id);
+
+    // Throws the evaluators' errors ("Unknown function: f", "Function f
+    // expects 1 argument") unless id is a function taking count arguments;
+    // name is the one written in the expression
+    static void checkCall(uint32_t id, const std::string& name, size_t count);
+
+    // Value at args. A domain error throws when status is null; otherwise it
+    // is recorded in *status and yields NaN.
+    static double call(uint32_t id, const double* args, EvalStatus* status);
+    // n points at once for a registered function; NaN where undefined
+    static void callBatch(uint32_t id, const double* const* args, double* out, size_t n);
+    // d f / d args[argument] at args: exact for builtins, a central
+    // difference of the kernel for registered functions
+    static double slope(uint32_t id, const double* args, uint32_t argument);
+};
+
+#endif // FUNCTION_REGISTRY_H
@@ -0,0 +1,305 @@
+#include "JitCompiler.h"
+#include "CompiledExpression.h"
+#include <cmath>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define CAS_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+std::atomic<size_t> JitTier::threshold{64};
+
+#ifdef CAS_JIT_X86_64
+
+namespace {
+
+// Registers as encoded in ModRM/REX
+constexpr int RAX = 0;
+constexpr int RBX = 3;    // slots
+constexpr int R15 = 15;   // frame
+
+using UnaryFunction = double (*)(double);
+using BinaryFunction = double (*)(double, double);
+
+// Just enough of an x86-64 assembler for straight-line scalar code
+class Assembler {
+private:
+    std::vector<uint8_t> bytes;
+
+public:
+    void emit(std::initializer_list<uint8_t> values) { bytes.insert(bytes.end(), values); }
+
+    void emit32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void emit64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) bytes.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    // prefix [REX.B] 0F opcode with a [base + disp32] memory operand
+    void sseMemory(uint8_t prefix, uint8_t opcode, int xmm, int base, size_t index) {
+        bytes.push_back(prefix);
+        if (base >= 8) bytes.push_back(0x41);
+        emit({0x0F, opcode, static_cast<uint8_t>(0x80 | (xmm << 3) | (base & 7))});
+        emit32(static_cast<uint32_t>(index * sizeof(double)));
+    }
+
+    void loadXmm(int xmm, int base, size_t index) { sseMemory(0xF2, 0x10, xmm, base, index); }   // movsd xmm, [m]
+    void storeXmm0(size_t index) { sseMemory(0xF2, 0x11, 0, R15, index); }                       // movsd [m], xmm0
+
+    // mov rax, imm64
+    void loadRax(uint64_t value) {
+        emit({0x48, 0xB8});
+        emit64(value);
+    }
+
+    // movq xmm, rax
+    void moveRaxToXmm(int xmm) { emit({0x66, 0x48, 0x0F, 0x6E, static_cast<uint8_t>(0xC0 | (xmm << 3) | RAX)}); }
+
+    void call(const void* function) {
+        loadRax(reinterpret_cast<uint64_t>(function));
+        emit({0xFF, 0xD0});   // call rax
+    }
+
+    // mov qword [r15 + disp32], imm32
+    void storeFlag(size_t index, uint32_t value) {
+        emit({0x49, 0xC7, 0x87});
+        emit32(static_cast<uint32_t>(index * sizeof(double)));
+        emit32(value);
+    }
+
+    // Sets the domain flag unless xmm0 compares (against xmm2 = 0) so that
+    // one of the given skip conditions holds. Each skip is a Jcc rel8 opcode;
+    // NaN always skips, matching the interpreter's comparisons.
+    void flagUnless(uint8_t skip, size_t flagIndex) {
+        emit({0x66, 0x0F, 0x57, 0xD2});   // xorpd xmm2, xmm2
+        emit({0x66, 0x0F, 0x2E, 0xC2});   // ucomisd xmm0, xmm2
+        emit({0x7A, 13});                 // jp over the skip and the 11-byte store
+        emit({skip, 11});
+        storeFlag(flagIndex, 1);
+    }
+
+    const std::vector<uint8_t>& code() const { return bytes; }
+};
+
+constexpr uint8_t JNE = 0x75;
+constexpr uint8_t JA = 0x77;
+constexpr uint8_t JAE = 0x73;
+
+UnaryFunction unaryFunction(OpCode op) {
+    switch (op) {
+        case OpCode::SIN: return static_cast<UnaryFunction>(std::sin);
+        case OpCode::COS: return static_cast<UnaryFunction>(std::cos);
+        case OpCode::TAN: return static_cast<UnaryFunction>(std::tan);
+        case OpCode::LOG: return static_cast<UnaryFunction>(std::log10);
+        case OpCode::LN: return static_cast<UnaryFunction>(std::log);
+        default: return nullptr;
+    }
+}
+
+bool generate(const CompiledExpression& program, Assembler& as, size_t& frameSlots) {
+    const size_t stackBase = 0;
+    const size_t tempBase = program.getMaxStackDepth();
+    const size_t flagIndex = tempBase + program.getTempCount();
+    frameSlots = flagIndex + 1;
+
+    // Prologue: keep the (callee-saved) argument registers and realign rsp
+    as.emit({0x53});                     // push rbx
+    as.emit({0x41, 0x57});               // push r15
+    as.emit({0x48, 0x83, 0xEC, 0x08});   // sub rsp, 8
+    as.emit({0x48, 0x89, 0xFB});         // mov rbx, rdi
+    as.emit({0x49, 0x89, 0xF7});         // mov r15, rsi
+    as.storeFlag(flagIndex, 0);
+
+    // depth counts stack entries; entry depth-1 lives in xmm0, the rest in
+    // frame[stackBase + i]
+    size_t depth = 0;
+    auto spill = [&]() {
+        if (depth > 0) as.storeXmm0(stackBase + depth - 1);
+    };
+
+    for (const Instruction& ins : program.getCode()) {
+        switch (ins.op) {
+            case OpCode::PUSH_CONST: {
+                spill();
+                double value = program.getConstant(ins.operand);
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                as.loadRax(bits);
+                as.moveRaxToXmm(0);
+                ++depth;
+                break;
+            }
+            case OpCode::LOAD_SLOT:
+                spill();
+                as.loadXmm(0, RBX, ins.operand);
+                ++depth;
+                break;
+            case OpCode::STORE_TEMP:
+                as.storeXmm0(tempBase + ins.operand);
+                break;
+            case OpCode::LOAD_TEMP:
+                spill();
+                as.loadXmm(0, R15, tempBase + ins.operand);
+                ++depth;
+                break;
+            case OpCode::ADD:
+                as.sseMemory(0xF2, 0x58, 0, R15, stackBase + depth - 2);   // addsd xmm0, [below]
+                --depth;
+                break;
+            case OpCode::MULTIPLY:
+                as.sseMemory(0xF2, 0x59, 0, R15, stackBase + depth - 2);   // mulsd xmm0, [below]
+                --depth;
+                break;
+            case OpCode::SUBTRACT:
+            case OpCode::DIVIDE:
+                if (ins.op == OpCode::DIVIDE) {
+                    as.flagUnless(JNE, flagIndex);
+                }
+                as.loadXmm(1, R15, stackBase + depth - 2);
+                as.emit({0xF2, 0x0F, static_cast<uint8_t>(ins.op == OpCode::DIVIDE ? 0x5E : 0x5C), 0xC8});   // xmm1 op= xmm0
+                as.emit({0x66, 0x0F, 0x28, 0xC1});                                                             // movapd xmm0, xmm1
+                --depth;
+                break;
+            case OpCode::POWER:
+                as.emit({0x66, 0x0F, 0x28, 0xC8});   // movapd xmm1, xmm0
+                as.loadXmm(0, R15, stackBase + depth - 2);
+                as.call(reinterpret_cast<const void*>(static_cast<BinaryFunction>(std::pow)));
+                --depth;
+                break;
+            case OpCode::NEGATE:
+                as.loadRax(0x8000000000000000ull);
+                as.moveRaxToXmm(1);
+                as.emit({0x66, 0x0F, 0x57, 0xC1});   // xorpd xmm0, xmm1
+                break;
+            case OpCode::ABS:
+                as.loadRax(0x7FFFFFFFFFFFFFFFull);
+                as.moveRaxToXmm(1);
+                as.emit({0x66, 0x0F, 0x54, 0xC1});   // andpd xmm0, xmm1
+                break;
+            case OpCode::SQRT:
+                as.flagUnless(JAE, flagIndex);
+                as.emit({0xF2, 0x0F, 0x51, 0xC0});   // sqrtsd xmm0, xmm0
+                break;
+            case OpCode::LOG:
+            case OpCode::LN:
+                as.flagUnless(JA, flagIndex);
+                as.call(reinterpret_cast<const void*>(unaryFunction(ins.op)));
+                break;
+            case OpCode::SIN:
+            case OpCode::COS:
+            case OpCode::TAN:
+                as.call(reinterpret_cast<const void*>(unaryFunction(ins.op)));
+                break;
+            default:
+                return false;
+        }
+    }
+
+    // Epilogue; the result is already in xmm0
+    as.emit({0x48, 0x83, 0xC4, 0x08});   // add rsp, 8
+    as.emit({0x41, 0x5F});               // pop r15
+    as.emit({0x5B});                     // pop rbx
+    as.emit({0xC3});                     // ret
+    return depth == 1;
+}
+
+} // namespace
+
+NativeCode::~NativeCode() {
+    if (memory) {
+        munmap(memory, mappedBytes);
+    }
+}
+
+bool NativeCode::supported() {
+    return true;
+}
+
+std::unique_ptr<NativeCode> NativeCode::compile(const CompiledExpression& program) {
+    if (program.empty()) {
+        return nullptr;
+    }
+
+    Assembler as;
+    size_t frameSlots = 0;
+    if (!generate(program, as, frameSlots)) {
+        return nullptr;
+    }
+
+    // Write, then flip to read+execute so the pages are never writable and
+    // executable at once
+    const std::vector<uint8_t>& code = as.code();
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t mapped = (code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, mapped);
+        return nullptr;
+    }
+
+    std::unique_ptr<NativeCode> native(new NativeCode());
+    native->memory = memory;
+    native->mappedBytes = mapped;
+    native->codeBytes = code.size();
+    native->frameSlots = frameSlots;
+    native->entry = reinterpret_cast<Entry>(memory);
+    return native;
+}
+
+#else
+
+// No code generator for this target: every program stays interpreted
+
+NativeCode::~NativeCode() {}
+
+bool NativeCode::supported() {
+    return false;
+}
+
+std::unique_ptr<NativeCode> NativeCode::compile(const CompiledExpression&) {
+    return nullptr;
+}
+
+#endif
+
+JitTier& JitTier::operator=(const JitTier&) {
+    reset();
+    return *this;
+}
+
+JitTier::~JitTier() {}
+
+const NativeCode* JitTier::hot(const CompiledExpression& program) const {
+    if (const NativeCode* code = native.load(std::memory_order_acquire)) {
+        return code;
+    }
+    if (failed.load(std::memory_order_relaxed) ||
+        evaluations.fetch_add(1, std::memory_order_relaxed) + 1 < threshold.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(compileMutex);
+    if (!native.load(std::memory_order_relaxed) && !failed.load(std::memory_order_relaxed)) {
+        owned = NativeCode::compile(program);
+        if (owned) {
+            native.store(owned.get(), std::memory_order_release);
+        } else {
+            failed.store(true, std::memory_order_relaxed);
+        }
+    }
+    return native.load(std::memory_order_acquire);
+}
+
+void JitTier::reset() {
+    native.store(nullptr, std::memory_order_relaxed);
+    owned.reset();
+    failed.store(false, std::memory_order_relaxed);
+    evaluations.store(0, std::memory_order_relaxed);
+}
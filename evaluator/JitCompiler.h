@@ -0,0 +1,93 @@
+#ifndef JIT_COMPILER_H
+#define JIT_COMPILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class CompiledExpression;
+
+// NativeCode - x86-64 (System V) machine code generated from one
+// CompiledExpression. The operand stack lives in a caller-provided frame with
+// its top cached in xmm0; arithmetic and sqrt are inline SSE2, the remaining
+// functions are direct calls into the same libm routines the interpreter
+// uses, so results are bit-identical. Domain checks do not throw from
+// generated code: they raise a flag and the caller re-runs the interpreter
+// to report the failure exactly as before.
+class NativeCode {
+private:
+    using Entry = double (*)(const double* slots, double* frame);
+
+    void* memory;
+    size_t mappedBytes;
+    size_t codeBytes;
+    size_t frameSlots;     // stack + temporaries + domain flag
+    Entry entry;
+
+    NativeCode() : memory(nullptr), mappedBytes(0), codeBytes(0), frameSlots(0), entry(nullptr) {}
+
+public:
+    NativeCode(const NativeCode&) = delete;
+    NativeCode& operator=(const NativeCode&) = delete;
+    ~NativeCode();
+
+    // True when this build can generate code for the host
+    static bool supported();
+
+    // Machine code for program; null when unsupported, the program is empty,
+    // calls a registered function (OpCode::CALL stays interpreted), or the OS
+    // refuses executable memory
+    static std::unique_ptr<NativeCode> compile(const CompiledExpression& program);
+
+    // frame must hold frameSize() doubles. domainError is set when any
+    // operation left its domain; the returned value is then meaningless.
+    double call(const double* slots, double* frame, bool& domainError) const {
+        double result = entry(slots, frame);
+        int64_t flag;
+        std::memcpy(&flag, &frame[frameSlots - 1], sizeof(flag));
+        domainError = flag != 0;
+        return result;
+    }
+
+    size_t frameSize() const { return frameSlots; }
+    size_t size() const { return codeBytes; }
+};
+
+// JitTier - per-program counter that swaps in native code once a program has
+// been evaluated often enough to repay compilation. Thread-safe; copies start
+// cold because generated code belongs to the program it was built from.
+class JitTier {
+private:
+    mutable std::atomic<size_t> evaluations{0};
+    mutable std::atomic<const NativeCode*> native{nullptr};
+    mutable std::atomic<bool> failed{false};
+    mutable std::mutex compileMutex;
+    mutable std::unique_ptr<NativeCode> owned;
+
+    static std::atomic<size_t> threshold;
+
+public:
+    JitTier() = default;
+    JitTier(const JitTier&) {}
+    JitTier& operator=(const JitTier&);
+    ~JitTier();
+
+    // Counts one evaluation of program; native code once the threshold is
+    // reached, otherwise null (keep interpreting)
+    const NativeCode* hot(const CompiledExpression& program) const;
+
+    // Native code if already compiled, without counting
+    const NativeCode* current() const { return native.load(std::memory_order_acquire); }
+
+    // Drop generated code, e.g. when the program is extended. Not safe
+    // against concurrent hot() calls; callers hold the program exclusively.
+    void reset();
+
+    static void setThreshold(size_t evaluations) { threshold.store(evaluations, std::memory_order_relaxed); }
+};
+
+#endif // JIT_COMPILER_H
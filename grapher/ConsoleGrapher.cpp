@@ -1,9 +1,12 @@
 #include "ConsoleGrapher.h"
+#include "../util/Instrumentation.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <limits>
 
 // Function constructor
 ConsoleGrapher::Function::Function(const std::string& expr, const std::string& funcName, char funcSymbol)
@@ -12,6 +15,11 @@ ConsoleGrapher::Function::Function(const std::string& expr, const std::string& f
         ExpressionParser parser;
         if (parser.parse(expr)) {
             ast = parser.cloneAST();
+            try {
+                program = parser.compile({"x"});
+            } catch (const std::exception&) {
+                // Leave the program empty; drawFunction skips it
+            }
         }
     }
 }
@@ -63,7 +71,8 @@ void ConsoleGrapher::setDisplaySize(int width, int height) {
     clearBuffer();
 }
 
-void ConsoleGrapher::plot() {
+void ConsoleGrapher::render() {
+    CAS_TIME_PHASE(RENDER);
     clearBuffer();
     
     if (settings.showGrid) {
@@ -76,25 +85,74 @@ void ConsoleGrapher::plot() {
     
     drawFunctions();
     drawLabels();
-    
+}
+
+void ConsoleGrapher::plot() {
+    render();
     printBuffer();
 }
 
 void ConsoleGrapher::plotToFile(const std::string& filename) {
-    clearBuffer();
-    
-    if (settings.showGrid) {
-        drawGrid();
-    }
-    
-    if (settings.showAxes) {
-        drawAxes();
+    render();
+    printBufferToFile(filename);
+}
+
+size_t ConsoleGrapher::plotIncremental(std::ostream& out) {
+    render();
+
+    std::string output;
+    auto moveTo = [&output](int row, int column) {
+        output += "\x1b[" + std::to_string(row + 1) + ";" + std::to_string(column + 1) + "H";
+    };
+
+    if (previousFrame.size() != displayBuffer.size()) {
+        // Clear the screen and send the whole frame
+        output = "\x1b[H\x1b[2J";
+        output.append(displayBuffer.data(), displayBuffer.size());
+    } else {
+        // A cursor move costs about as much as a few cells, so changes
+        // separated by short unchanged gaps are sent as one run
+        const int maxGap = 6;
+        const size_t stride = static_cast<size_t>(settings.width) + 1;
+        for (int y = 0; y < settings.height; ++y) {
+            const char* now = displayBuffer.data() + y * stride;
+            const char* before = previousFrame.data() + y * stride;
+            int x = 0;
+            while (x < settings.width) {
+                if (now[x] == before[x]) {
+                    ++x;
+                    continue;
+                }
+                int end = x + 1;
+                int unchanged = 0;
+                for (int next = end; next < settings.width && unchanged <= maxGap; ++next) {
+                    if (now[next] != before[next]) {
+                        end = next + 1;
+                        unchanged = 0;
+                    } else {
+                        ++unchanged;
+                    }
+                }
+                moveTo(y, x);
+                output.append(now + x, end - x);
+                x = end;
+            }
+        }
+        if (output.empty()) {
+            return 0;
+        }
     }
     
-    drawFunctions();
-    drawLabels();
-    
-    printBufferToFile(filename);
+    // Leave the cursor below the plot
+    moveTo(settings.height, 0);
+    out.write(output.data(), static_cast<std::streamsize>(output.size()));
+    out.flush();
+    previousFrame = displayBuffer;
+    return output.size();
+}
+
+void ConsoleGrapher::resetIncremental() {
+    previousFrame.clear();
 }
 
 double ConsoleGrapher::screenXToWorld(int screenX) const {
@@ -114,9 +172,10 @@ int ConsoleGrapher::worldYToScreen(double worldY) const {
 }
 
 void ConsoleGrapher::clearBuffer() {
-    displayBuffer.resize(settings.height);
-    for (auto& row : displayBuffer) {
-        row.resize(settings.width, ' ');
+    const size_t stride = static_cast<size_t>(std::max(settings.width, 0)) + 1;
+    displayBuffer.assign(stride * std::max(settings.height, 0), ' ');
+    for (size_t end = stride - 1; end < displayBuffer.size(); end += stride) {
+        displayBuffer[end] = '\n';
     }
 }
 
@@ -128,7 +187,7 @@ void ConsoleGrapher::drawGrid() {
         int screenX = worldXToScreen(x);
         if (screenX >= 0 && screenX < settings.width) {
             for (int y = 0; y < settings.height; ++y) {
-                displayBuffer[y][screenX] = settings.gridChar;
+                cell(screenX, y) = settings.gridChar;
             }
         }
     }
@@ -140,7 +199,7 @@ void ConsoleGrapher::drawGrid() {
         int screenY = worldYToScreen(y);
         if (screenY >= 0 && screenY < settings.height) {
             for (int x = 0; x < settings.width; ++x) {
-                displayBuffer[screenY][x] = settings.gridChar;
+                cell(x, screenY) = settings.gridChar;
             }
         }
     }
@@ -151,7 +210,7 @@ void ConsoleGrapher::drawAxes() {
     int yAxisScreenY = worldYToScreen(0);
     if (yAxisScreenY >= 0 && yAxisScreenY < settings.height) {
         for (int x = 0; x < settings.width; ++x) {
-            displayBuffer[yAxisScreenY][x] = settings.axesChar;
+            cell(x, yAxisScreenY) = settings.axesChar;
         }
     }
 
@@ -159,43 +218,54 @@ void ConsoleGrapher::drawAxes() {
     int xAxisScreenX = worldXToScreen(0);
     if (xAxisScreenX >= 0 && xAxisScreenX < settings.width) {
         for (int y = 0; y < settings.height; ++y) {
-            displayBuffer[y][xAxisScreenX] = settings.axesChar;
+            cell(xAxisScreenX, y) = settings.axesChar;
         }
     }
 }
 
 void ConsoleGrapher::drawFunctions() {
+    // Sample every function up front (in parallel), then rasterize in order.
+    // One sample per column, refined wherever neighbouring samples would
+    // leave a vertical gap of more than one cell.
+    std::vector<const CompiledExpression*> programs;
     for (const auto& func : functions) {
-        drawFunction(func);
+        programs.push_back(&func.program);
+    }
+    SampleViewport viewport{settings.xMin, settings.xMax, settings.yMin, settings.yMax,
+                            static_cast<double>(settings.width), static_cast<double>(settings.height)};
+    AdaptiveSampleOptions options;
+    options.tolerance = std::numeric_limits<double>::infinity();
+    options.maxStepPixels = 1.0;
+    options.initialSegments = static_cast<size_t>(std::max(settings.width, 1));
+    options.maxEvaluations = 8 * options.initialSegments + 1;
+    std::vector<SampleBuffer> samples;
+    {
+        CAS_TIME_PHASE(SAMPLE);
+        samples = Sampler::sampleAdaptive(programs, viewport, options);
     }
-}
-
-void ConsoleGrapher::drawFunction(const Function& func) {
-    if (!func.ast) return;
 
-    const int numPoints = settings.width;
-    const double step = (settings.xMax - settings.xMin) / numPoints;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        drawFunction(functions[i], samples[i]);
+    }
+}
 
-    for (int i = 0; i <= numPoints; ++i) {
-        double x = settings.xMin + i * step;
+void ConsoleGrapher::drawFunction(const Function& func, const SampleBuffer& samples) {
+    // Points with evaluation errors come back as NaN
+    CAS_COUNT_N(UNDEFINED_POINTS,
+                std::count_if(samples.ys.begin(), samples.ys.end(), [](double y) { return std::isnan(y); }));
+    for (size_t i = 0; i < samples.xs.size(); ++i) {
+        double x = samples.xs[i];
+        double y = samples.ys[i];
         
-        try {
-            std::map<std::string, double> variables = {{"x", x}};
-            double y = func.ast->evaluate(variables);
+        // Check if y is within the plot range
+        if (y >= settings.yMin && y <= settings.yMax && 
+            std::isfinite(y) && !std::isnan(y)) {
+            int screenX = worldXToScreen(x);
+            int screenY = worldYToScreen(y);
             
-            // Check if y is within the plot range
-            if (y >= settings.yMin && y <= settings.yMax && 
-                std::isfinite(y) && !std::isnan(y)) {
-                int screenX = worldXToScreen(x);
-                int screenY = worldYToScreen(y);
-                
-                if (isValidPoint(screenX, screenY)) {
-                    displayBuffer[screenY][screenX] = func.symbol;
-                }
+            if (isValidPoint(screenX, screenY)) {
+                cell(screenX, screenY) = func.symbol;
             }
-        } catch (const std::exception&) {
-            // Skip points that cause evaluation errors
-            continue;
         }
     }
 }
@@ -208,7 +278,7 @@ void ConsoleGrapher::drawLabels() {
             if (label.length() < settings.width) {
                 for (size_t j = 0; j < label.length(); ++j) {
                     if (j < settings.width) {
-                        displayBuffer[0][j] = label[j];
+                        cell(static_cast<int>(j), 0) = label[j];
                     }
                 }
             }
@@ -224,24 +294,14 @@ std::string ConsoleGrapher::formatNumber(double value) const {
 
 void ConsoleGrapher::printBuffer() {
     std::cout << "\n";
-    for (const auto& row : displayBuffer) {
-        for (char c : row) {
-            std::cout << c;
-        }
-        std::cout << "\n";
-    }
+    std::cout.write(displayBuffer.data(), static_cast<std::streamsize>(displayBuffer.size()));
     std::cout << "\n";
 }
 
 void ConsoleGrapher::printBufferToFile(const std::string& filename) {
     std::ofstream file(filename);
     if (file.is_open()) {
-        for (const auto& row : displayBuffer) {
-            for (char c : row) {
-                file << c;
-            }
-            file << "\n";
-        }
+        file.write(displayBuffer.data(), static_cast<std::streamsize>(displayBuffer.size()));
         file.close();
         std::cout << "Graph saved to " << filename << std::endl;
     } else {
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <ostream>
 #include <vector>
 #include <string>
 #include "../parser/ExpressionParser.h"
 #include "../cas/SymbolicEngine.h"
+#include "Sampler.h"
 
 class ConsoleGrapher {
 public:
@@ -27,6 +29,7 @@ public:
         std::string name;
         char symbol;
         std::unique_ptr<ASTNode> ast;
+        CompiledExpression program;   // bytecode over slot 0 = x
         
         Function(const std::string& expr, const std::string& funcName = "", char funcSymbol = '*');
     };
@@ -47,6 +50,16 @@ public:
     void plot();
     void plotToFile(const std::string& filename);
 
+    // Redraw in place on an ANSI terminal, sending only the cells that
+    // changed since the previous incremental frame (the first frame, and
+    // any frame after a resize or resetIncremental(), is sent whole).
+    // Returns the number of bytes written.
+    size_t plotIncremental(std::ostream& out);
+    void resetIncremental();
+
+    // Rendered frame: height rows of width cells, each row ending in '\n'
+    const std::vector<char>& getFrame() const { return displayBuffer; }
+
     // Utility functions
     double screenXToWorld(int screenX) const;
     double screenYToWorld(int screenY) const;
@@ -56,15 +69,19 @@ public:
 private:
     PlotSettings settings;
     std::vector<Function> functions;
-    std::vector<std::vector<char>> displayBuffer;
+    std::vector<char> displayBuffer;   // row-major, stride width + 1
+    std::vector<char> previousFrame;   // last frame sent by plotIncremental
+    
+    char& cell(int x, int y) { return displayBuffer[static_cast<size_t>(y) * (settings.width + 1) + x]; }
     
     // Drawing functions
     void clearBuffer();
+    void render();
     void drawGrid();
     void drawAxes();
     void drawFunctions();
     void drawLabels();
-    void drawFunction(const Function& func);
+    void drawFunction(const Function& func, const SampleBuffer& samples);
     
     // Helper functions
     std::string formatNumber(double value) const;
@@ -1,38 +1,64 @@
 #include "Grapher.h"
+#include "../util/Instrumentation.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <cmath>
 
-// Function constructor
+Grapher::RetainedGeometry::RetainedGeometry(sf::PrimitiveType type, sf::VertexBuffer::Usage usage)
+    : buffer(type, usage) {}
+
+void Grapher::RetainedGeometry::upload() {
+    dirty = false;
+    if (!sf::VertexBuffer::isAvailable() || vertices.empty()) {
+        return;
+    }
+    if (buffer.getVertexCount() != vertices.size()) {
+        buffer.create(vertices.size());
+    }
+    buffer.update(vertices.data());
+}
+
+void Grapher::RetainedGeometry::draw(sf::RenderTarget& target) const {
+    if (vertices.empty()) {
+        return;
+    }
+    if (sf::VertexBuffer::isAvailable()) {
+        target.draw(buffer);
+    } else {
+        target.draw(vertices.data(), vertices.size(), buffer.getPrimitiveType());
+    }
+}
+
+// Function constructor; curves are re-sampled on every pan and zoom and change
+// their vertex count, so their buffer is Dynamic (grid and axes stay Static)
 Grapher::Function::Function(const std::string& expr, const std::string& funcName, const sf::Color& funcColor)
-    : expression(expr), name(funcName), color(funcColor), ast(nullptr) {
+    : expression(expr), name(funcName), color(funcColor), ast(nullptr), curve(sf::Lines, sf::VertexBuffer::Dynamic) {
     if (!expr.empty()) {
         ExpressionParser parser;
         if (parser.parse(expr)) {
             ast = parser.cloneAST();
+            try {
+                program = parser.compile({"x"});
+            } catch (const std::exception&) {
+                // Leave the program empty; it is never sampled
+            }
         }
     }
 }
 
 // Grapher default constructor
-Grapher::Grapher() : settings(PlotSettings()) {
+Grapher::Grapher() : settings(PlotSettings()), nextFunctionId(1), labelsDirty(true), needsRedraw(true) {
     window.create(sf::VideoMode(settings.width, settings.height), settings.title);
     window.setFramerateLimit(60);
-    
-    if (!loadFont()) {
-        std::cerr << "Warning: Could not load font. Text rendering will be disabled." << std::endl;
-    }
 }
 
 // Grapher constructor with settings
-Grapher::Grapher(const PlotSettings& settings) : settings(settings) {
+Grapher::Grapher(const PlotSettings& settings)
+    : settings(settings), nextFunctionId(1), labelsDirty(true), needsRedraw(true) {
     window.create(sf::VideoMode(settings.width, settings.height), settings.title);
     window.setFramerateLimit(60);
-    
-    if (!loadFont()) {
-        std::cerr << "Warning: Could not load font. Text rendering will be disabled." << std::endl;
-    }
 }
 
 Grapher::~Grapher() {
@@ -47,6 +73,9 @@ bool Grapher::addFunction(const std::string& expression, const std::string& name
         if (parser.parse(expression)) {
             functions.emplace_back(expression, name, color);
             functions.back().ast = parser.cloneAST();
+            functions.back().id = nextFunctionId++;
+            labelsDirty = true;
+            needsRedraw = true;
             return true;
         }
     } catch (const std::exception& e) {
@@ -57,12 +86,18 @@ bool Grapher::addFunction(const std::string& expression, const std::string& name
 
 void Grapher::removeFunction(size_t index) {
     if (index < functions.size()) {
+        sampleCache.invalidate(functions[index].id);
         functions.erase(functions.begin() + index);
+        labelsDirty = true;
+        needsRedraw = true;
     }
 }
 
 void Grapher::clearFunctions() {
     functions.clear();
+    sampleCache.clear();
+    labelsDirty = true;
+    needsRedraw = true;
 }
 
 void Grapher::setPlotRange(double xMin, double xMax, double yMin, double yMax) {
@@ -70,6 +105,7 @@ void Grapher::setPlotRange(double xMin, double xMax, double yMin, double yMax) {
     settings.xMax = xMax;
     settings.yMin = yMin;
     settings.yMax = yMax;
+    invalidateGeometry();
 }
 
 void Grapher::setWindowSize(int width, int height) {
@@ -77,7 +113,20 @@ void Grapher::setWindowSize(int width, int height) {
     settings.height = height;
     if (window.isOpen()) {
         window.setSize(sf::Vector2u(width, height));
+        updateView();
     }
+    invalidateGeometry();
+}
+
+// Everything drawn depends on the world-to-screen mapping
+void Grapher::invalidateGeometry() {
+    gridGeometry.dirty = true;
+    axesGeometry.dirty = true;
+    for (auto& func : functions) {
+        func.curve.dirty = true;
+    }
+    labelsDirty = true;
+    needsRedraw = true;
 }
 
 void Grapher::setTitle(const std::string& title) {
@@ -89,16 +138,19 @@ void Grapher::setTitle(const std::string& title) {
 
 void Grapher::setGridVisible(bool visible) {
     settings.showGrid = visible;
+    needsRedraw = true;
 }
 
 void Grapher::setAxesVisible(bool visible) {
     settings.showAxes = visible;
+    needsRedraw = true;
 }
 
 void Grapher::plot() {
     if (!window.isOpen()) {
         return;
     }
+    CAS_TIME_PHASE(RENDER);
 
     window.clear(settings.backgroundColor);
 
@@ -114,6 +166,7 @@ void Grapher::plot() {
     drawLabels();
 
     window.display();
+    needsRedraw = false;
 }
 
 void Grapher::run() {
@@ -121,9 +174,18 @@ void Grapher::run() {
         return;
     }
 
+    // Static scenes sleep in waitEvent instead of redrawing every frame
     while (window.isOpen()) {
+        if (!needsRedraw) {
+            sf::Event event;
+            if (window.waitEvent(event)) {
+                handleEvent(event);
+            }
+        }
         handleEvents();
-        plot();
+        if (window.isOpen() && needsRedraw) {
+            plot();
+        }
     }
 }
 
@@ -140,134 +202,201 @@ sf::Vector2f Grapher::screenToWorld(int screenX, int screenY) const {
 }
 
 void Grapher::drawGrid() {
-    // Draw vertical grid lines
-    for (int x = static_cast<int>(settings.xMin); x <= static_cast<int>(settings.xMax); ++x) {
-        if (x == 0) continue; // Skip the y-axis
-        
-        int screenX = worldXToScreen(x);
-        sf::Vertex line[] = {
-            sf::Vertex(sf::Vector2f(static_cast<float>(screenX), 0), settings.gridColor),
-            sf::Vertex(sf::Vector2f(static_cast<float>(screenX), static_cast<float>(settings.height)), settings.gridColor)
-        };
-        window.draw(line, 2, sf::Lines);
-    }
+    if (gridGeometry.dirty) {
+        std::vector<sf::Vertex>& lines = gridGeometry.vertices;
+        lines.clear();
 
-    // Draw horizontal grid lines
-    for (int y = static_cast<int>(settings.yMin); y <= static_cast<int>(settings.yMax); ++y) {
-        if (y == 0) continue; // Skip the x-axis
-        
-        int screenY = worldYToScreen(y);
-        sf::Vertex line[] = {
-            sf::Vertex(sf::Vector2f(0, static_cast<float>(screenY)), settings.gridColor),
-            sf::Vertex(sf::Vector2f(static_cast<float>(settings.width), static_cast<float>(screenY)), settings.gridColor)
-        };
-        window.draw(line, 2, sf::Lines);
+        // Vertical grid lines
+        for (int x = static_cast<int>(settings.xMin); x <= static_cast<int>(settings.xMax); ++x) {
+            if (x == 0) continue; // Skip the y-axis
+            
+            int screenX = worldXToScreen(x);
+            lines.emplace_back(sf::Vector2f(static_cast<float>(screenX), 0), settings.gridColor);
+            lines.emplace_back(sf::Vector2f(static_cast<float>(screenX), static_cast<float>(settings.height)), settings.gridColor);
+        }
+
+        // Horizontal grid lines
+        for (int y = static_cast<int>(settings.yMin); y <= static_cast<int>(settings.yMax); ++y) {
+            if (y == 0) continue; // Skip the x-axis
+            
+            int screenY = worldYToScreen(y);
+            lines.emplace_back(sf::Vector2f(0, static_cast<float>(screenY)), settings.gridColor);
+            lines.emplace_back(sf::Vector2f(static_cast<float>(settings.width), static_cast<float>(screenY)), settings.gridColor);
+        }
+        gridGeometry.upload();
     }
+    gridGeometry.draw(window);
 }
 
 void Grapher::drawAxes() {
-    // Draw x-axis
-    int yAxisScreenY = worldYToScreen(0);
-    if (yAxisScreenY >= 0 && yAxisScreenY < settings.height) {
-        sf::Vertex xAxis[] = {
-            sf::Vertex(sf::Vector2f(0, static_cast<float>(yAxisScreenY)), settings.axesColor),
-            sf::Vertex(sf::Vector2f(static_cast<float>(settings.width), static_cast<float>(yAxisScreenY)), settings.axesColor)
-        };
-        window.draw(xAxis, 2, sf::Lines);
-    }
+    if (axesGeometry.dirty) {
+        std::vector<sf::Vertex>& lines = axesGeometry.vertices;
+        lines.clear();
+
+        // X-axis
+        int yAxisScreenY = worldYToScreen(0);
+        if (yAxisScreenY >= 0 && yAxisScreenY < settings.height) {
+            lines.emplace_back(sf::Vector2f(0, static_cast<float>(yAxisScreenY)), settings.axesColor);
+            lines.emplace_back(sf::Vector2f(static_cast<float>(settings.width), static_cast<float>(yAxisScreenY)), settings.axesColor);
+        }
 
-    // Draw y-axis
-    int xAxisScreenX = worldXToScreen(0);
-    if (xAxisScreenX >= 0 && xAxisScreenX < settings.width) {
-        sf::Vertex yAxis[] = {
-            sf::Vertex(sf::Vector2f(static_cast<float>(xAxisScreenX), 0), settings.axesColor),
-            sf::Vertex(sf::Vector2f(static_cast<float>(xAxisScreenX), static_cast<float>(settings.height)), settings.axesColor)
-        };
-        window.draw(yAxis, 2, sf::Lines);
+        // Y-axis
+        int xAxisScreenX = worldXToScreen(0);
+        if (xAxisScreenX >= 0 && xAxisScreenX < settings.width) {
+            lines.emplace_back(sf::Vector2f(static_cast<float>(xAxisScreenX), 0), settings.axesColor);
+            lines.emplace_back(sf::Vector2f(static_cast<float>(xAxisScreenX), static_cast<float>(settings.height)), settings.axesColor);
+        }
+        axesGeometry.upload();
     }
+    axesGeometry.draw(window);
 }
 
 void Grapher::drawFunctions() {
+    // Only curves whose geometry is stale are resampled. The tile cache
+    // supplies a coarse grid (a pan or zoom evaluates only tiles not seen
+    // before), which is then refined where the curve bends, jumps or leaves
+    // its domain: half-pixel tolerance with at most four new evaluations per
+    // pixel column. Refined points depend on the view and are not cached.
+    std::vector<SampleSource> sources;
+    std::vector<const CompiledExpression*> programs;
+    std::vector<Function*> stale;
+    for (auto& func : functions) {
+        if (func.curve.dirty) {
+            sources.push_back(SampleSource{func.id, &func.program});
+            programs.push_back(&func.program);
+            stale.push_back(&func);
+        }
+    }
+    if (!sources.empty()) {
+        std::vector<SampleBuffer> samples;
+        {
+            CAS_TIME_PHASE(SAMPLE);
+            const double pixels = static_cast<double>(std::max(settings.width, 1));
+            std::vector<SampleBuffer> tiles = sampleCache.sample(sources, settings.xMin, settings.xMax, pixels);
+            SampleViewport viewport{settings.xMin, settings.xMax, settings.yMin, settings.yMax,
+                                    pixels, static_cast<double>(settings.height)};
+            AdaptiveSampleOptions options;
+            options.maxEvaluations = 4 * static_cast<size_t>(std::max(settings.width, 1));
+            samples = Sampler::refine(programs, tiles, viewport, options);
+        }
+        for (size_t i = 0; i < stale.size(); ++i) {
+            buildCurve(*stale[i], samples[i]);
+        }
+    }
+
     for (const auto& func : functions) {
-        drawFunction(func);
+        func.curve.draw(window);
     }
 }
 
-void Grapher::drawFunction(const Function& func) {
-    if (!func.ast) return;
+void Grapher::buildCurve(Function& func, const SampleBuffer& samples) {
+    // Strips are stored as independent segments so one buffer holds every
+    // piece of the curve
+    std::vector<sf::Vertex>& segments = func.curve.vertices;
+    segments.clear();
+    CAS_COUNT_N(UNDEFINED_POINTS,
+                std::count_if(samples.ys.begin(), samples.ys.end(), [](double y) { return std::isnan(y); }));
+    segments.reserve(2 * samples.xs.size());
 
     std::vector<sf::Vertex> points;
-    const int numPoints = settings.width;
-    const double step = (settings.xMax - settings.xMin) / numPoints;
+    points.reserve(samples.xs.size());
 
-    for (int i = 0; i <= numPoints; ++i) {
-        double x = settings.xMin + i * step;
+    auto flush = [&]() {
+        for (size_t i = 1; i < points.size(); ++i) {
+            segments.push_back(points[i - 1]);
+            segments.push_back(points[i]);
+        }
+        points.clear();
+    };
+
+    // Off-screen points keep the curve running to the window edge (SFML
+    // clips them); strips break where the function is undefined (NaN) and
+    // where it jumps from beyond one edge to beyond the other, as at a pole
+    int previousSide = 0;
+    for (size_t i = 0; i < samples.xs.size(); ++i) {
+        double x = samples.xs[i];
+        double y = samples.ys[i];
         
-        try {
-            std::map<std::string, double> variables = {{"x", x}};
-            double y = func.ast->evaluate(variables);
-            
-            // Check if y is within the plot range
-            if (y >= settings.yMin && y <= settings.yMax && 
-                std::isfinite(y) && !std::isnan(y)) {
-                int screenX = worldXToScreen(x);
-                int screenY = worldYToScreen(y);
-                points.emplace_back(sf::Vector2f(static_cast<float>(screenX), static_cast<float>(screenY)), func.color);
-            }
-        } catch (const std::exception&) {
-            // Skip points that cause evaluation errors
+        if (!std::isfinite(y)) {
+            flush();
+            previousSide = 0;
             continue;
         }
-    }
+        int side = (y > settings.yMax) ? 1 : (y < settings.yMin) ? -1 : 0;
+        if (side != 0 && side == -previousSide) {
+            flush();
+        }
+        previousSide = side;
 
-    if (points.size() > 1) {
-        window.draw(points.data(), points.size(), sf::LineStrip);
+        double clamped = std::min(std::max(y, 2 * settings.yMin - settings.yMax), 2 * settings.yMax - settings.yMin);
+        int screenX = worldXToScreen(x);
+        int screenY = worldYToScreen(clamped);
+        points.emplace_back(sf::Vector2f(static_cast<float>(screenX), static_cast<float>(screenY)), func.color);
     }
+    flush();
+    func.curve.upload();
 }
 
 void Grapher::drawLabels() {
-    if (!font.getInfo().family.empty()) {
-        // Draw axis labels
-        sf::Text text;
-        text.setFont(font);
-        text.setCharacterSize(12);
-        text.setFillColor(settings.axesColor);
-
-        // X-axis label
-        text.setString("x");
-        text.setPosition(static_cast<float>(settings.width - 20), static_cast<float>(worldYToScreen(0) - 20));
+    if (labelsDirty) {
+        buildLabels();
+    }
+    for (const auto& text : labels) {
         window.draw(text);
+    }
+}
 
-        // Y-axis label
-        text.setString("y");
-        text.setPosition(static_cast<float>(worldXToScreen(0) + 5), 10.0f);
-        window.draw(text);
+void Grapher::buildLabels() {
+    labels.clear();
+    labelsDirty = false;
+    const sf::Font* font = sharedFont();
+    if (!font) {
+        return;
+    }
 
-        // Draw function names if available
-        text.setCharacterSize(10);
-        for (size_t i = 0; i < functions.size(); ++i) {
-            if (!functions[i].name.empty()) {
-                text.setString(functions[i].name);
-                text.setFillColor(functions[i].color);
-                text.setPosition(10.0f, static_cast<float>(20 + i * 20));
-                window.draw(text);
-            }
+    // Axis labels
+    sf::Text text;
+    text.setFont(*font);
+    text.setCharacterSize(12);
+    text.setFillColor(settings.axesColor);
+
+    // X-axis label
+    text.setString("x");
+    text.setPosition(static_cast<float>(settings.width - 20), static_cast<float>(worldYToScreen(0) - 20));
+    labels.push_back(text);
+
+    // Y-axis label
+    text.setString("y");
+    text.setPosition(static_cast<float>(worldXToScreen(0) + 5), 10.0f);
+    labels.push_back(text);
+
+    // Function names if available
+    text.setCharacterSize(10);
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (!functions[i].name.empty()) {
+            text.setString(functions[i].name);
+            text.setFillColor(functions[i].color);
+            text.setPosition(10.0f, static_cast<float>(20 + i * 20));
+            labels.push_back(text);
         }
     }
 }
 
-bool Grapher::loadFont() {
-    // Try to load a system font
-    if (font.loadFromFile("C:/Windows/Fonts/arial.ttf")) {
-        return true;
-    }
-    if (font.loadFromFile("C:/Windows/Fonts/calibri.ttf")) {
-        return true;
-    }
-    if (font.loadFromFile("C:/Windows/Fonts/tahoma.ttf")) {
-        return true;
-    }
-    return false;
+// System fonts are probed once per process, when labels are first drawn
+const sf::Font* Grapher::sharedFont() {
+    static const std::unique_ptr<sf::Font> font = [] {
+        auto loaded = std::make_unique<sf::Font>();
+        for (const char* path : {"C:/Windows/Fonts/arial.ttf", "C:/Windows/Fonts/calibri.ttf",
+                                 "C:/Windows/Fonts/tahoma.ttf", "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+                                 "/System/Library/Fonts/Supplemental/Arial.ttf"}) {
+            if (loaded->loadFromFile(path)) {
+                return loaded;
+            }
+        }
+        std::cerr << "Warning: Could not load font. Text rendering will be disabled." << std::endl;
+        return std::unique_ptr<sf::Font>();
+    }();
+    return font.get();
 }
 
 std::string Grapher::formatNumber(double value) const {
@@ -279,26 +408,66 @@ std::string Grapher::formatNumber(double value) const {
 void Grapher::handleEvents() {
     sf::Event event;
     while (window.pollEvent(event)) {
-        switch (event.type) {
-            case sf::Event::Closed:
-                window.close();
-                break;
-            case sf::Event::KeyPressed:
-                if (event.key.code == sf::Keyboard::Escape) {
-                    window.close();
-                }
-                break;
-            case sf::Event::Resized:
-                settings.width = event.size.width;
-                settings.height = event.size.height;
-                window.setView(sf::View(sf::FloatRect(0, 0, static_cast<float>(settings.width), static_cast<float>(settings.height))));
-                break;
-            default:
-                break;
-        }
+        handleEvent(event);
     }
 }
 
+void Grapher::handleEvent(const sf::Event& event) {
+    switch (event.type) {
+        case sf::Event::Closed:
+            window.close();
+            break;
+        case sf::Event::KeyPressed:
+            switch (event.key.code) {
+                case sf::Keyboard::Escape: window.close(); break;
+                case sf::Keyboard::Left: pan(-0.1, 0); break;
+                case sf::Keyboard::Right: pan(0.1, 0); break;
+                case sf::Keyboard::Up: pan(0, 0.1); break;
+                case sf::Keyboard::Down: pan(0, -0.1); break;
+                case sf::Keyboard::Add:
+                case sf::Keyboard::Equal:
+                    zoom(0.8, 0.5 * (settings.xMin + settings.xMax), 0.5 * (settings.yMin + settings.yMax));
+                    break;
+                case sf::Keyboard::Subtract:
+                case sf::Keyboard::Hyphen:
+                    zoom(1.25, 0.5 * (settings.xMin + settings.xMax), 0.5 * (settings.yMin + settings.yMax));
+                    break;
+                default: break;
+            }
+            break;
+        case sf::Event::MouseWheelScrolled:
+            if (event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel) {
+                // Zoom about the point under the cursor
+                zoom(event.mouseWheelScroll.delta > 0 ? 0.8 : 1.25,
+                     screenXToWorld(event.mouseWheelScroll.x), screenYToWorld(event.mouseWheelScroll.y));
+            }
+            break;
+        case sf::Event::Resized:
+            settings.width = event.size.width;
+            settings.height = event.size.height;
+            updateView();
+            invalidateGeometry();
+            break;
+        case sf::Event::GainedFocus:
+            // The window contents may have been lost while covered
+            needsRedraw = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void Grapher::pan(double dxFraction, double dyFraction) {
+    double dx = (settings.xMax - settings.xMin) * dxFraction;
+    double dy = (settings.yMax - settings.yMin) * dyFraction;
+    setPlotRange(settings.xMin + dx, settings.xMax + dx, settings.yMin + dy, settings.yMax + dy);
+}
+
+void Grapher::zoom(double factor, double worldX, double worldY) {
+    setPlotRange(worldX + (settings.xMin - worldX) * factor, worldX + (settings.xMax - worldX) * factor,
+                 worldY + (settings.yMin - worldY) * factor, worldY + (settings.yMax - worldY) * factor);
+}
+
 void Grapher::updateView() {
     window.setView(sf::View(sf::FloatRect(0, 0, static_cast<float>(settings.width), static_cast<float>(settings.height))));
 }
@@ -7,9 +7,24 @@
 #include <functional>
 #include "../parser/ExpressionParser.h"
 #include "../cas/SymbolicEngine.h"
+#include "Sampler.h"
+#include "SampleTileCache.h"
 
 class Grapher {
 public:
+    // Vertices kept on the CPU and mirrored in a GPU vertex buffer (when the
+    // driver supports them); rebuilt only after dirty is set
+    struct RetainedGeometry {
+        std::vector<sf::Vertex> vertices;
+        sf::VertexBuffer buffer;
+        bool dirty = true;
+
+        explicit RetainedGeometry(sf::PrimitiveType type = sf::Lines,
+                                  sf::VertexBuffer::Usage usage = sf::VertexBuffer::Static);
+        void upload();
+        void draw(sf::RenderTarget& target) const;
+    };
+
     struct PlotSettings {
         double xMin = -10.0;
         double xMax = 10.0;
@@ -31,6 +46,9 @@ public:
         std::string name;
         sf::Color color;
         std::unique_ptr<ASTNode> ast;
+        CompiledExpression program;   // bytecode over slot 0 = x
+        uint64_t id = 0;              // sample cache key, unique per added function
+        RetainedGeometry curve;       // line segments in screen coordinates
         
         Function(const std::string& expr, const std::string& funcName = "", 
                 const sf::Color& funcColor = sf::Color::Blue);
@@ -66,20 +84,36 @@ private:
     PlotSettings settings;
     std::vector<Function> functions;
     sf::RenderWindow window;
-    sf::Font font;
+    
+    // Samples reused across frames; only newly exposed tiles are evaluated
+    SampleTileCache sampleCache;
+    uint64_t nextFunctionId;
+    
+    // Geometry retained between frames, rebuilt when the view, window size
+    // or function set changes; frames with nothing dirty are not redrawn
+    RetainedGeometry gridGeometry;
+    RetainedGeometry axesGeometry;
+    std::vector<sf::Text> labels;
+    bool labelsDirty;
+    bool needsRedraw;
     
     // Drawing functions
     void drawGrid();
     void drawAxes();
     void drawFunctions();
     void drawLabels();
-    void drawFunction(const Function& func);
+    void buildCurve(Function& func, const SampleBuffer& samples);
+    void buildLabels();
+    void invalidateGeometry();
     
     // Helper functions
-    bool loadFont();
+    static const sf::Font* sharedFont();
     std::string formatNumber(double value) const;
     void handleEvents();
+    void handleEvent(const sf::Event& event);
     void updateView();
+    void pan(double dxFraction, double dyFraction);
+    void zoom(double factor, double worldX, double worldY);
     
     // Coordinate transformation
     double screenXToWorld(int screenX) const;
@@ -0,0 +1,481 @@
+#include "RasterRenderer.h"
+#include "Sampler.h"
+#include "../parser/ExpressionParser.h"
+#include "../util/ThreadPool.h"
+#include "../util/Instrumentation.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+struct ScreenPoint {
+    double x;
+    double y;
+};
+
+// Continuous pieces of one function's curve in pixel coordinates
+struct Curve {
+    RasterColor color;
+    std::string name;
+    std::vector<std::vector<ScreenPoint>> strips;
+};
+
+double toScreenX(const RasterPlot& plot, double x) {
+    return (x - plot.xMin) * plot.width / (plot.xMax - plot.xMin);
+}
+
+double toScreenY(const RasterPlot& plot, double y) {
+    return (plot.yMax - y) * plot.height / (plot.yMax - plot.yMin);
+}
+
+// Pixel columns of the vertical grid lines and rows of the horizontal ones,
+// at integer world coordinates like Grapher::drawGrid
+void gridLines(const RasterPlot& plot, std::vector<int>& columns, std::vector<int>& rows) {
+    for (int x = static_cast<int>(plot.xMin); x <= static_cast<int>(plot.xMax); ++x) {
+        if (x != 0) columns.push_back(static_cast<int>(toScreenX(plot, x)));
+    }
+    for (int y = static_cast<int>(plot.yMin); y <= static_cast<int>(plot.yMax); ++y) {
+        if (y != 0) rows.push_back(static_cast<int>(toScreenY(plot, y)));
+    }
+}
+
+std::vector<Curve> traceCurves(const RasterPlot& plot) {
+    SampleViewport viewport{plot.xMin, plot.xMax, plot.yMin, plot.yMax,
+                            static_cast<double>(plot.width), static_cast<double>(plot.height)};
+    double low = 2 * plot.yMin - plot.yMax;
+    double high = 2 * plot.yMax - plot.yMin;
+
+    std::vector<Curve> curves;
+    for (const auto& function : plot.functions) {
+        CompiledExpression program;
+        ExpressionParser parser;
+        if (!parser.parse(function.expression)) continue;
+        try {
+            program = parser.compile({"x"});
+        } catch (const std::exception&) {
+            continue;
+        }
+        if (!Sampler::isPlottable(program)) continue;
+
+        // Serial per plot; batches parallelize across plots instead
+        SampleBuffer samples;
+        {
+            CAS_TIME_PHASE(SAMPLE);
+            samples = Sampler::sampleAdaptive(program, viewport);
+        }
+        CAS_COUNT_N(UNDEFINED_POINTS,
+                    std::count_if(samples.ys.begin(), samples.ys.end(), [](double y) { return std::isnan(y); }));
+
+        Curve curve{function.color, function.name, {}};
+        std::vector<ScreenPoint> strip;
+        auto flush = [&]() {
+            if (strip.size() > 1) curve.strips.push_back(strip);
+            strip.clear();
+        };
+
+        // Same breaks as Grapher: at undefined points and where the curve
+        // leaves one edge of the view and returns past the other
+        int previousSide = 0;
+        for (size_t i = 0; i < samples.xs.size(); ++i) {
+            double y = samples.ys[i];
+            if (!std::isfinite(y)) {
+                flush();
+                previousSide = 0;
+                continue;
+            }
+            int side = (y > plot.yMax) ? 1 : (y < plot.yMin) ? -1 : 0;
+            if (side != 0 && side == -previousSide) {
+                flush();
+            }
+            previousSide = side;
+            double clamped = std::min(std::max(y, low), high);
+            strip.push_back(ScreenPoint{toScreenX(plot, samples.xs[i]), toScreenY(plot, clamped)});
+        }
+        flush();
+        curves.push_back(std::move(curve));
+    }
+    return curves;
+}
+
+class Canvas {
+private:
+    RasterImage& image;
+
+public:
+    explicit Canvas(RasterImage& target) : image(target) {}
+
+    void blend(int x, int y, const RasterColor& color, double coverage) {
+        if (x < 0 || y < 0 || x >= image.width || y >= image.height || coverage <= 0) return;
+        uint8_t* p = &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4];
+        double alpha = std::min(coverage, 1.0) * color.a / 255.0;
+        p[0] = static_cast<uint8_t>(std::lround(p[0] + (color.r - p[0]) * alpha));
+        p[1] = static_cast<uint8_t>(std::lround(p[1] + (color.g - p[1]) * alpha));
+        p[2] = static_cast<uint8_t>(std::lround(p[2] + (color.b - p[2]) * alpha));
+        p[3] = static_cast<uint8_t>(std::lround(p[3] + (255 - p[3]) * alpha));
+    }
+
+    void column(int x, const RasterColor& color) {
+        for (int y = 0; y < image.height; ++y) blend(x, y, color, 1.0);
+    }
+
+    void row(int y, const RasterColor& color) {
+        for (int x = 0; x < image.width; ++x) blend(x, y, color, 1.0);
+    }
+
+    // Xiaolin Wu's antialiased line; pixel centres sit at integer + 0.5
+    void line(ScreenPoint a, ScreenPoint b, const RasterColor& color) {
+        double x0 = a.x - 0.5, y0 = a.y - 0.5, x1 = b.x - 0.5, y1 = b.y - 0.5;
+        bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        double gradient = (x1 - x0) > 0 ? (y1 - y0) / (x1 - x0) : 0.0;
+
+        // Only the major-axis range that can land on the image
+        double limit = steep ? image.height : image.width;
+        long first = static_cast<long>(std::max(std::round(x0), -1.0));
+        long last = static_cast<long>(std::min(std::round(x1), limit));
+        for (long major = first; major <= last; ++major) {
+            double minor = y0 + gradient * (major - x0);
+            double base = std::floor(minor);
+            double fraction = minor - base;
+            int m = static_cast<int>(major);
+            int n = static_cast<int>(base);
+            if (steep) {
+                blend(n, m, color, 1 - fraction);
+                blend(n + 1, m, color, fraction);
+            } else {
+                blend(m, n, color, 1 - fraction);
+                blend(m, n + 1, color, fraction);
+            }
+        }
+    }
+};
+
+// PNG chunk CRC and zlib checksum
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t adler32(const std::vector<uint8_t>& data) {
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+// LSB-first bit stream as DEFLATE writes it
+class BitWriter {
+private:
+    std::vector<uint8_t>& out;
+    uint32_t buffer = 0;
+    int count = 0;
+
+public:
+    explicit BitWriter(std::vector<uint8_t>& target) : out(target) {}
+
+    void bits(uint32_t value, int length) {
+        buffer |= value << count;
+        count += length;
+        while (count >= 8) {
+            out.push_back(static_cast<uint8_t>(buffer));
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes are sent most significant bit first
+    void code(uint32_t value, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) reversed |= ((value >> i) & 1) << (length - 1 - i);
+        bits(reversed, length);
+    }
+
+    void finish() {
+        if (count > 0) out.push_back(static_cast<uint8_t>(buffer));
+        buffer = 0;
+        count = 0;
+    }
+};
+
+// One fixed-Huffman DEFLATE block whose only matches are runs (distance 1).
+// After the Sub filter, flat background becomes long runs of zeros, which
+// is nearly all of a chart.
+std::vector<uint8_t> deflateRuns(const std::vector<uint8_t>& data) {
+    static const int lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                        2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+    std::vector<uint8_t> out = {0x78, 0x01};
+    BitWriter writer(out);
+    writer.bits(1, 1);   // final block
+    writer.bits(1, 2);   // fixed Huffman codes
+
+    auto symbol = [&writer](int value) {
+        if (value < 144) writer.code(0x30 + value, 8);
+        else if (value < 256) writer.code(0x190 + value - 144, 9);
+        else if (value < 280) writer.code(value - 256, 7);
+        else writer.code(0xC0 + value - 280, 8);
+    };
+
+    size_t i = 0;
+    while (i < data.size()) {
+        size_t run = 0;
+        if (i > 0) {
+            while (run < 258 && i + run < data.size() && data[i + run] == data[i - 1]) ++run;
+        }
+        if (run < 3) {
+            symbol(data[i]);
+            ++i;
+            continue;
+        }
+        int code = 28;
+        while (lengthBase[code] > static_cast<int>(run)) --code;
+        symbol(257 + code);
+        writer.bits(static_cast<uint32_t>(run - lengthBase[code]), lengthExtra[code]);
+        writer.code(0, 5);   // distance 1
+        i += run;
+    }
+    symbol(256);
+    writer.finish();
+
+    uint32_t checksum = adler32(data);
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(checksum >> shift));
+    return out;
+}
+
+void appendChunk(std::string& png, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> body(type, type + 4);
+    body.insert(body.end(), data.begin(), data.end());
+    uint32_t length = static_cast<uint32_t>(data.size());
+    uint32_t crc = crc32(body.data(), body.size());
+    for (int shift = 24; shift >= 0; shift -= 8) png.push_back(static_cast<char>(length >> shift));
+    png.append(body.begin(), body.end());
+    for (int shift = 24; shift >= 0; shift -= 8) png.push_back(static_cast<char>(crc >> shift));
+}
+
+std::string svgColor(const RasterColor& color) {
+    char text[8];
+    std::snprintf(text, sizeof(text), "#%02x%02x%02x", color.r, color.g, color.b);
+    return text;
+}
+
+std::string svgOpacity(const RasterColor& color) {
+    if (color.a == 255) return "";
+    std::ostringstream oss;
+    oss << " stroke-opacity=\"" << color.a / 255.0 << "\"";
+    return oss.str();
+}
+
+std::string escapeXml(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '&': escaped += "&amp;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+RasterImage RasterRenderer::render(const RasterPlot& plot) {
+    CAS_TIME_PHASE(RENDER);
+    RasterImage image;
+    image.width = std::max(plot.width, 0);
+    image.height = std::max(plot.height, 0);
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+    for (size_t i = 0; i < image.pixels.size(); i += 4) {
+        image.pixels[i] = plot.backgroundColor.r;
+        image.pixels[i + 1] = plot.backgroundColor.g;
+        image.pixels[i + 2] = plot.backgroundColor.b;
+        image.pixels[i + 3] = plot.backgroundColor.a;
+    }
+    if (image.width == 0 || image.height == 0) {
+        return image;
+    }
+
+    Canvas canvas(image);
+    if (plot.showGrid) {
+        std::vector<int> columns, rows;
+        gridLines(plot, columns, rows);
+        for (int x : columns) canvas.column(x, plot.gridColor);
+        for (int y : rows) canvas.row(y, plot.gridColor);
+    }
+    if (plot.showAxes) {
+        canvas.row(static_cast<int>(toScreenY(plot, 0)), plot.axesColor);
+        canvas.column(static_cast<int>(toScreenX(plot, 0)), plot.axesColor);
+    }
+    for (const auto& curve : traceCurves(plot)) {
+        for (const auto& strip : curve.strips) {
+            for (size_t i = 1; i < strip.size(); ++i) {
+                canvas.line(strip[i - 1], strip[i], curve.color);
+            }
+        }
+    }
+    return image;
+}
+
+std::string RasterRenderer::renderSVG(const RasterPlot& plot) {
+    CAS_TIME_PHASE(RENDER);
+    std::ostringstream svg;
+    svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << plot.width << "\" height=\"" << plot.height
+        << "\" viewBox=\"0 0 " << plot.width << " " << plot.height << "\">\n";
+    svg << "<rect width=\"100%\" height=\"100%\" fill=\"" << svgColor(plot.backgroundColor) << "\"/>\n";
+
+    if (plot.showGrid) {
+        std::vector<int> columns, rows;
+        gridLines(plot, columns, rows);
+        svg << "<path stroke=\"" << svgColor(plot.gridColor) << "\"" << svgOpacity(plot.gridColor) << " d=\"";
+        for (int x : columns) svg << "M" << x + 0.5 << " 0V" << plot.height;
+        for (int y : rows) svg << "M0 " << y + 0.5 << "H" << plot.width;
+        svg << "\"/>\n";
+    }
+    if (plot.showAxes) {
+        svg << "<path stroke=\"" << svgColor(plot.axesColor) << "\"" << svgOpacity(plot.axesColor) << " d=\""
+            << "M0 " << static_cast<int>(toScreenY(plot, 0)) + 0.5 << "H" << plot.width
+            << "M" << static_cast<int>(toScreenX(plot, 0)) + 0.5 << " 0V" << plot.height << "\"/>\n";
+    }
+
+    svg.precision(2);
+    svg << std::fixed;
+    std::vector<Curve> curves = traceCurves(plot);
+    for (const auto& curve : curves) {
+        for (const auto& strip : curve.strips) {
+            svg << "<polyline fill=\"none\" stroke=\"" << svgColor(curve.color) << "\"" << svgOpacity(curve.color)
+                << " points=\"";
+            for (size_t i = 0; i < strip.size(); ++i) {
+                svg << (i ? " " : "") << strip[i].x << "," << strip[i].y;
+            }
+            svg << "\"/>\n";
+        }
+    }
+
+    // Legend, as Grapher draws it
+    int line = 0;
+    for (const auto& curve : curves) {
+        if (!curve.name.empty()) {
+            svg << "<text x=\"10\" y=\"" << 30 + 20 * line++ << "\" font-size=\"10\" fill=\""
+                << svgColor(curve.color) << "\">" << escapeXml(curve.name) << "</text>\n";
+        }
+    }
+    svg << "</svg>\n";
+    return svg.str();
+}
+
+std::string RasterRenderer::encodePNG(const RasterImage& image) {
+    // Scanlines with the Sub filter: each byte minus the same channel of
+    // the pixel to its left
+    const size_t stride = static_cast<size_t>(image.width) * 4;
+    std::vector<uint8_t> filtered;
+    filtered.reserve((stride + 1) * image.height);
+    for (int y = 0; y < image.height; ++y) {
+        const uint8_t* row = image.pixels.data() + y * stride;
+        filtered.push_back(1);
+        for (size_t i = 0; i < stride; ++i) {
+            filtered.push_back(static_cast<uint8_t>(row[i] - (i >= 4 ? row[i - 4] : 0)));
+        }
+    }
+
+    std::vector<uint8_t> header;
+    for (uint32_t value : {static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height)}) {
+        for (int shift = 24; shift >= 0; shift -= 8) header.push_back(static_cast<uint8_t>(value >> shift));
+    }
+    header.insert(header.end(), {8, 6, 0, 0, 0});   // 8-bit RGBA, no interlace
+
+    std::string png = "\x89PNG\r\n\x1a\n";
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", deflateRuns(filtered));
+    appendChunk(png, "IEND", {});
+    return png;
+}
+
+void RasterRenderer::writeFile(const RasterPlot& plot, const std::string& path, ImageFormat format) {
+    std::string contents;
+    switch (format) {
+        case ImageFormat::PNG:
+            contents = encodePNG(render(plot));
+            break;
+        case ImageFormat::SVG:
+            contents = renderSVG(plot);
+            break;
+        case ImageFormat::RGBA: {
+            RasterImage image = render(plot);
+            contents.assign(image.pixels.begin(), image.pixels.end());
+            break;
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file " + path + " for writing");
+    }
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!file) {
+        throw std::runtime_error("Could not write file " + path);
+    }
+}
+
+std::vector<RasterImage> RasterRenderer::renderMany(const std::vector<RasterPlot>& plots, ThreadPool* pool) {
+    std::vector<RasterImage> images(plots.size());
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(plots.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            images[i] = render(plots[i]);
+        }
+    });
+    return images;
+}
+
+void RasterRenderer::exportMany(const std::vector<RasterPlot>& plots, const std::vector<std::string>& paths,
+                                ImageFormat format, ThreadPool* pool) {
+    if (plots.size() != paths.size()) {
+        throw std::runtime_error("exportMany needs one path per plot");
+    }
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(plots.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            writeFile(plots[i], paths[i], format);
+        }
+    });
+}
+
+ImageFormat RasterRenderer::formatForPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == "png") return ImageFormat::PNG;
+    if (extension == "svg") return ImageFormat::SVG;
+    if (extension == "rgba") return ImageFormat::RGBA;
+    throw std::runtime_error("Unknown image format: " + path);
+}
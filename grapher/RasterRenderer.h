@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct RasterColor {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+};
+
+struct RasterFunction {
+    std::string expression;           // function of x
+    std::string name;                 // legend text (SVG only)
+    RasterColor color{0, 0, 255, 255};
+};
+
+// One chart: the same view and styling options as Grapher::PlotSettings
+struct RasterPlot {
+    double xMin = -10.0;
+    double xMax = 10.0;
+    double yMin = -10.0;
+    double yMax = 10.0;
+    int width = 800;
+    int height = 600;
+    bool showGrid = true;
+    bool showAxes = true;
+    RasterColor backgroundColor{255, 255, 255, 255};
+    RasterColor gridColor{200, 200, 200, 255};
+    RasterColor axesColor{0, 0, 0, 255};
+    std::vector<RasterFunction> functions;
+};
+
+// Row-major 8-bit RGBA pixels, top row first
+struct RasterImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    const uint8_t* pixel(int x, int y) const { return &pixels[(static_cast<size_t>(y) * width + x) * 4]; }
+};
+
+enum class ImageFormat {
+    PNG,
+    SVG,
+    RGBA      // raw pixels, no header
+};
+
+// RasterRenderer - headless chart output for batch jobs: no window, no GPU
+// and no font loading. Curves come from Sampler::sampleAdaptive like the
+// interactive graphers and are drawn as antialiased polylines, breaking
+// where the function is undefined or jumps across the view at a pole.
+// Raster output has no text; SVG output also carries the function names.
+// Functions that fail to parse or need variables other than x are skipped.
+class RasterRenderer {
+public:
+    static RasterImage render(const RasterPlot& plot);
+    static std::string renderSVG(const RasterPlot& plot);
+
+    // PNG file contents (filtered scanlines, run-length deflate)
+    static std::string encodePNG(const RasterImage& image);
+
+    // Throws std::runtime_error when the file cannot be written
+    static void writeFile(const RasterPlot& plot, const std::string& path, ImageFormat format);
+
+    // Batch mode: one plot per task on the pool (the shared pool when null);
+    // each plot is sampled on the thread that renders it. exportMany writes
+    // plots[i] to paths[i] and rethrows the first failure after the batch.
+    static std::vector<RasterImage> renderMany(const std::vector<RasterPlot>& plots, ThreadPool* pool = nullptr);
+    static void exportMany(const std::vector<RasterPlot>& plots, const std::vector<std::string>& paths,
+                           ImageFormat format, ThreadPool* pool = nullptr);
+
+    // Format implied by a file name's extension (.png, .svg, .rgba)
+    static ImageFormat formatForPath(const std::string& path);
+};
@@ -0,0 +1,139 @@
+#include "SampleTileCache.h"
+#include "../util/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+size_t SampleTileCache::TileKeyHash::operator()(const TileKey& key) const {
+    size_t seed = std::hash<uint64_t>()(key.function);
+    seed ^= std::hash<int>()(key.level) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<int64_t>()(key.index) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+SampleTileCache::SampleTileCache(size_t capacityTiles) : capacity(capacityTiles), clock(0) {}
+
+int SampleTileCache::levelFor(double worldWidth, double pixels) {
+    return std::ilogb(worldWidth / pixels);
+}
+
+std::vector<SampleBuffer> SampleTileCache::sample(const std::vector<SampleSource>& sources, double xMin,
+                                                  double xMax, double pixels, ThreadPool* pool) {
+    std::vector<SampleBuffer> buffers(sources.size());
+    if (!(xMax > xMin) || !(pixels >= 1)) {
+        return buffers;
+    }
+    ++clock;
+
+    const int level = levelFor(xMax - xMin, pixels);
+    const double spacing = std::ldexp(1.0, level);
+    const double tileWidth = spacing * static_cast<double>(kTileSegments);
+    const int64_t firstTile = static_cast<int64_t>(std::floor((xMin - spacing) / tileWidth));
+    const int64_t lastTile = static_cast<int64_t>(std::floor((xMax + spacing) / tileWidth));
+
+    // Find or create every tile the view needs; creation happens here, on
+    // the calling thread, so the parallel fill below never touches the map
+    struct Work {
+        const CompiledExpression* program;
+        int64_t index;
+        Tile* tile;
+    };
+    std::vector<Work> missing;
+    std::vector<std::vector<const Tile*>> views(sources.size());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        if (!sources[s].program || !Sampler::isPlottable(*sources[s].program)) {
+            continue;
+        }
+        for (int64_t index = firstTile; index <= lastTile; ++index) {
+            auto [it, inserted] = tiles.try_emplace(TileKey{sources[s].id, level, index});
+            it->second.lastUse = clock;
+            if (inserted) {
+                stats.misses++;
+                missing.push_back(Work{sources[s].program, index, &it->second});
+            } else {
+                stats.hits++;
+            }
+            views[s].push_back(&it->second);
+        }
+    }
+
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(missing.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<double> xs(kTileSegments + 1);
+        for (size_t w = begin; w < end; ++w) {
+            const Work& work = missing[w];
+            for (size_t j = 0; j <= kTileSegments; ++j) {
+                xs[j] = std::ldexp(static_cast<double>(work.index * static_cast<int64_t>(kTileSegments) +
+                                                       static_cast<int64_t>(j)), level);
+            }
+            work.tile->ys.resize(kTileSegments + 1);
+            const double* columns[] = {xs.data()};
+            work.program->evalBatch(columns, work.tile->ys.data(), xs.size());
+        }
+    });
+
+    // Stitch tiles into one buffer per source, trimmed to the view
+    const double low = xMin - spacing;
+    const double high = xMax + spacing;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        SampleBuffer& buffer = buffers[s];
+        for (size_t t = 0; t < views[s].size(); ++t) {
+            int64_t index = firstTile + static_cast<int64_t>(t);
+            const std::vector<double>& ys = views[s][t]->ys;
+            // Neighbouring tiles share their boundary sample
+            size_t count = (t + 1 == views[s].size()) ? kTileSegments + 1 : kTileSegments;
+            for (size_t j = 0; j < count; ++j) {
+                double x = std::ldexp(static_cast<double>(index * static_cast<int64_t>(kTileSegments) +
+                                                          static_cast<int64_t>(j)), level);
+                if (x >= low && x <= high) {
+                    buffer.xs.push_back(x);
+                    buffer.ys.push_back(ys[j]);
+                }
+            }
+        }
+    }
+
+    evict();
+    return buffers;
+}
+
+void SampleTileCache::evict() {
+    if (tiles.size() <= capacity) {
+        return;
+    }
+
+    // Oldest first; tiles used by the current call are never evicted
+    std::vector<std::pair<uint64_t, TileKey>> candidates;
+    for (const auto& entry : tiles) {
+        if (entry.second.lastUse != clock) {
+            candidates.emplace_back(entry.second.lastUse, entry.first);
+        }
+    }
+    size_t excess = std::min(tiles.size() - capacity, candidates.size());
+    std::nth_element(candidates.begin(), candidates.begin() + excess, candidates.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 0; i < excess; ++i) {
+        tiles.erase(candidates[i].second);
+    }
+    stats.evictions += excess;
+}
+
+void SampleTileCache::invalidate(uint64_t functionId) {
+    for (auto it = tiles.begin(); it != tiles.end();) {
+        if (it->first.function == functionId) {
+            it = tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SampleTileCache::clear() {
+    tiles.clear();
+    stats = TileCacheStats();
+}
+
+void SampleTileCache::setCapacity(size_t capacityTiles) {
+    capacity = capacityTiles;
+    evict();
+}
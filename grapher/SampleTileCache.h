@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Sampler.h"
+
+// One function to sample through the cache; id must change whenever the
+// function does, and program must stay valid for the call
+struct SampleSource {
+    uint64_t id;
+    const CompiledExpression* program;
+};
+
+// Tile counters since construction or the last clear()
+struct TileCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+// SampleTileCache - function samples kept in fixed x-range tiles so that
+// redrawing an unchanged view evaluates nothing and a pan evaluates only
+// the newly exposed tiles.
+//
+// A view of w world units over p pixels uses resolution level
+// L = floor(log2(w / p)): samples sit on multiples of 2^L, one or two per
+// pixel, and a tile holds kTileSegments consecutive segments. Sample
+// positions depend only on (level, tile index), so tiles line up exactly
+// however far the view moves. Tiles are keyed by (function id, level,
+// index); the least recently used ones are evicted past the capacity.
+class SampleTileCache {
+public:
+    static constexpr size_t kTileSegments = 256;
+
+private:
+    struct TileKey {
+        uint64_t function;
+        int level;
+        int64_t index;
+
+        bool operator==(const TileKey& other) const {
+            return function == other.function && level == other.level && index == other.index;
+        }
+    };
+    struct TileKeyHash {
+        size_t operator()(const TileKey& key) const;
+    };
+    struct Tile {
+        std::vector<double> ys;    // kTileSegments + 1 values
+        uint64_t lastUse = 0;
+    };
+
+    std::unordered_map<TileKey, Tile, TileKeyHash> tiles;
+    size_t capacity;
+    uint64_t clock;
+    TileCacheStats stats;
+
+    void evict();
+
+public:
+    explicit SampleTileCache(size_t capacityTiles = 4096);
+
+    // Samples of every source over [xMin, xMax] (plus one sample beyond
+    // each end) for a view pixels wide; missing tiles are evaluated in
+    // parallel on pool, or the shared pool when null
+    std::vector<SampleBuffer> sample(const std::vector<SampleSource>& sources, double xMin, double xMax,
+                                     double pixels, ThreadPool* pool = nullptr);
+
+    // Drop every tile of one function
+    void invalidate(uint64_t functionId);
+    void clear();
+
+    void setCapacity(size_t capacityTiles);
+    size_t size() const { return tiles.size(); }
+    const TileCacheStats& getStats() const { return stats; }
+
+    // Resolution level for a view of the given width in world units and pixels
+    static int levelFor(double worldWidth, double pixels);
+};
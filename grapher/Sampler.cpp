@@ -0,0 +1,241 @@
+#include "Sampler.h"
+#include "../util/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// Points per task; a chunk of one function is the unit of work
+constexpr size_t kSampleChunk = 1024;
+
+// Maps y values into clamped pixel rows so off-screen excursions (poles,
+// steep tails) count as at most one viewport height beyond the edge
+struct PixelScale {
+    double yMin;
+    double pixelsPerY;
+    double height;
+
+    double row(double y) const {
+        if (std::isnan(y)) return y;
+        return std::min(std::max((y - yMin) * pixelsPerY, -height), 2.0 * height);
+    }
+};
+
+// Segment between two samples (indices into the point arrays) waiting to be split
+struct Segment {
+    size_t left;
+    size_t right;
+    double score;    // how badly the parent segment missed, for budget cuts
+};
+
+// The refinement loop behind Sampler::sampleAdaptive and Sampler::refine.
+// xs and ys hold evaluated samples, sorted by x from index first to last;
+// the segments between those neighbours are split until they pass the
+// tests or xs holds limit points. New points are appended unsorted.
+void refineSegments(const CompiledExpression& program, const SampleViewport& viewport,
+                    const AdaptiveSampleOptions& options, std::vector<double>& xs, std::vector<double>& ys,
+                    size_t first, size_t last, size_t limit) {
+    const double pixelsPerX = viewport.width / (viewport.xMax - viewport.xMin);
+    const PixelScale scale{viewport.yMin, viewport.height / (viewport.yMax - viewport.yMin), viewport.height};
+    const double minWidth = options.minSegmentPixels / pixelsPerX;
+
+    // Every evaluated point is kept; rows caches the clamped pixel row
+    std::vector<double> rows(ys.size());
+    std::transform(ys.begin(), ys.end(), rows.begin(), [&](double y) { return scale.row(y); });
+
+    // Gap and domain-edge tests need only the ends of a segment
+    auto needsSplit = [&](size_t a, size_t b) {
+        if (std::isnan(rows[a]) != std::isnan(rows[b])) return true;
+        return std::abs(rows[a] - rows[b]) > options.maxStepPixels;
+    };
+    const bool curvatureTest = std::isfinite(options.tolerance);
+
+    std::vector<Segment> pending;
+    for (size_t i = first; i < last; ++i) {
+        if (curvatureTest || needsSplit(i, i + 1)) {
+            pending.push_back(Segment{i, i + 1, 0.0});
+        }
+    }
+
+    std::vector<double> midXs;
+    std::vector<double> midYs;
+    while (!pending.empty() && xs.size() < limit) {
+        size_t budget = limit - xs.size();
+        if (pending.size() > budget) {
+            std::nth_element(pending.begin(), pending.begin() + budget, pending.end(),
+                             [](const Segment& a, const Segment& b) { return a.score > b.score; });
+            pending.resize(budget);
+        }
+
+        // One batch per level
+        midXs.resize(pending.size());
+        midYs.resize(pending.size());
+        for (size_t i = 0; i < pending.size(); ++i) {
+            midXs[i] = 0.5 * (xs[pending[i].left] + xs[pending[i].right]);
+        }
+        const double* midColumns[] = {midXs.data()};
+        program.evalBatch(midColumns, midYs.data(), midXs.size());
+
+        std::vector<Segment> next;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            const Segment& segment = pending[i];
+            size_t mid = xs.size();
+            xs.push_back(midXs[i]);
+            ys.push_back(midYs[i]);
+            rows.push_back(scale.row(midYs[i]));
+
+            double deviation = 0.0;
+            bool bent = false;
+            if (curvatureTest) {
+                double chord = 0.5 * (rows[segment.left] + rows[segment.right]);
+                deviation = std::abs(rows[mid] - chord);
+                // NaN on any side counts as bent; needsSplit decides the domain edges
+                bent = !(deviation <= options.tolerance) &&
+                       !(std::isnan(rows[segment.left]) && std::isnan(rows[segment.right]));
+            }
+            if (0.5 * (xs[segment.right] - xs[segment.left]) < minWidth) {
+                continue;
+            }
+            double score = std::isnan(deviation) ? viewport.height : deviation;
+            if (bent || needsSplit(segment.left, mid)) {
+                next.push_back(Segment{segment.left, mid, score});
+            }
+            if (bent || needsSplit(mid, segment.right)) {
+                next.push_back(Segment{mid, segment.right, score});
+            }
+        }
+        pending.swap(next);
+    }
+}
+
+// The points ordered by x
+SampleBuffer sortedByX(const std::vector<double>& xs, const std::vector<double>& ys) {
+    std::vector<size_t> order(xs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return xs[a] < xs[b]; });
+    SampleBuffer result;
+    result.xs.reserve(order.size());
+    result.ys.reserve(order.size());
+    for (size_t index : order) {
+        result.xs.push_back(xs[index]);
+        result.ys.push_back(ys[index]);
+    }
+    return result;
+}
+
+} // namespace
+
+bool Sampler::isPlottable(const CompiledExpression& program) {
+    return !program.empty() && program.getSlotCount() == 1;
+}
+
+SampleBuffer Sampler::sampleAdaptive(const CompiledExpression& program, const SampleViewport& viewport,
+                                     const AdaptiveSampleOptions& options) {
+    if (!isPlottable(program) || !(viewport.xMax > viewport.xMin) || options.maxEvaluations < 2) {
+        return SampleBuffer();
+    }
+
+    size_t segments = options.initialSegments;
+    if (segments == 0) {
+        segments = std::max<size_t>(8, static_cast<size_t>(viewport.width / 8));
+    }
+    segments = std::min(segments, options.maxEvaluations - 1);
+
+    std::vector<double> xs(segments + 1);
+    std::vector<double> ys(segments + 1);
+    const double step = (viewport.xMax - viewport.xMin) / static_cast<double>(segments);
+    for (size_t i = 0; i <= segments; ++i) {
+        xs[i] = viewport.xMin + static_cast<double>(i) * step;
+    }
+    const double* columns[] = {xs.data()};
+    program.evalBatch(columns, ys.data(), xs.size());
+
+    refineSegments(program, viewport, options, xs, ys, 0, segments, options.maxEvaluations);
+    return sortedByX(xs, ys);
+}
+
+SampleBuffer Sampler::refine(const CompiledExpression& program, const SampleBuffer& coarse,
+                             const SampleViewport& viewport, const AdaptiveSampleOptions& options) {
+    if (!isPlottable(program) || !(viewport.xMax > viewport.xMin) || coarse.xs.size() < 2) {
+        return coarse;
+    }
+
+    // Segments from the last sample at or left of xMin to the first at or
+    // right of xMax; samples beyond them are kept as they are
+    auto lowest = std::upper_bound(coarse.xs.begin(), coarse.xs.end(), viewport.xMin);
+    size_t first = lowest == coarse.xs.begin() ? 0 : static_cast<size_t>(lowest - coarse.xs.begin()) - 1;
+    size_t last = static_cast<size_t>(std::lower_bound(coarse.xs.begin(), coarse.xs.end(), viewport.xMax) -
+                                      coarse.xs.begin());
+    last = std::min(last, coarse.xs.size() - 1);
+    if (first >= last) {
+        return coarse;
+    }
+
+    std::vector<double> xs = coarse.xs;
+    std::vector<double> ys = coarse.ys;
+    refineSegments(program, viewport, options, xs, ys, first, last, coarse.xs.size() + options.maxEvaluations);
+    return sortedByX(xs, ys);
+}
+
+std::vector<SampleBuffer> Sampler::sampleAdaptive(const std::vector<const CompiledExpression*>& programs,
+                                                  const SampleViewport& viewport,
+                                                  const AdaptiveSampleOptions& options, ThreadPool* pool) {
+    std::vector<SampleBuffer> buffers(programs.size());
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(programs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            if (programs[f]) {
+                buffers[f] = sampleAdaptive(*programs[f], viewport, options);
+            }
+        }
+    });
+    return buffers;
+}
+
+std::vector<SampleBuffer> Sampler::refine(const std::vector<const CompiledExpression*>& programs,
+                                          const std::vector<SampleBuffer>& coarse, const SampleViewport& viewport,
+                                          const AdaptiveSampleOptions& options, ThreadPool* pool) {
+    std::vector<SampleBuffer> buffers(programs.size());
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(programs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            buffers[f] = programs[f] ? refine(*programs[f], coarse[f], viewport, options) : coarse[f];
+        }
+    });
+    return buffers;
+}
+
+std::vector<SampleBuffer> Sampler::sampleUniform(const std::vector<const CompiledExpression*>& programs,
+                                                 double xMin, double xMax, size_t count, ThreadPool* pool) {
+    std::vector<SampleBuffer> buffers(programs.size());
+    const size_t points = count + 1;
+    const double step = (xMax - xMin) / static_cast<double>(count);
+    for (size_t f = 0; f < programs.size(); ++f) {
+        if (programs[f] && isPlottable(*programs[f])) {
+            buffers[f].xs.resize(points);
+            buffers[f].ys.resize(points);
+        }
+    }
+
+    // Task t covers chunk t % chunksPerFunction of function t / chunksPerFunction
+    const size_t chunksPerFunction = (points + kSampleChunk - 1) / kSampleChunk;
+    const size_t tasks = programs.size() * chunksPerFunction;
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(tasks, 1, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; ++task) {
+            SampleBuffer& buffer = buffers[task / chunksPerFunction];
+            if (buffer.xs.empty()) {
+                continue;
+            }
+            size_t first = (task % chunksPerFunction) * kSampleChunk;
+            size_t last = std::min(first + kSampleChunk, points);
+            for (size_t i = first; i < last; ++i) {
+                buffer.xs[i] = xMin + static_cast<double>(i) * step;
+            }
+            const double* columns[] = {buffer.xs.data() + first};
+            programs[task / chunksPerFunction]->evalBatch(columns, buffer.ys.data() + first, last - first);
+        }
+    });
+    return buffers;
+}
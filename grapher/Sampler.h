@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "../evaluator/CompiledExpression.h"
+
+class ThreadPool;
+
+// Samples of one function: ys[i] = f(xs[i]), NaN where f is undefined
+struct SampleBuffer {
+    std::vector<double> xs;
+    std::vector<double> ys;
+};
+
+// Plot area that adaptive sampling measures its errors in
+struct SampleViewport {
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+    double width;    // pixels (or character cells)
+    double height;
+};
+
+// Refinement limits for Sampler::sampleAdaptive
+struct AdaptiveSampleOptions {
+    // Largest distance, in pixels, between a segment's midpoint and the
+    // straight line through its ends; infinity disables the curvature test
+    double tolerance = 0.5;
+    // Largest vertical gap, in pixels, between neighbouring samples;
+    // renderers that draw points rather than lines set this to one cell
+    double maxStepPixels = std::numeric_limits<double>::infinity();
+    // Segments narrower than this, in pixels, are never split
+    double minSegmentPixels = 1.0 / 16.0;
+    // Uniform segments before refinement; 0 picks one per 8 pixels
+    size_t initialSegments = 0;
+    // Hard cap on evaluations per function
+    size_t maxEvaluations = 4096;
+};
+
+// Sampler - evaluates plotted functions ahead of rasterization. Work is
+// split by function and by x-range chunk and run on a ThreadPool, so many
+// curves at high resolution keep every core busy. Shared by ConsoleGrapher
+// and Grapher; no SFML dependency.
+class Sampler {
+public:
+    // count + 1 evenly spaced points from xMin to xMax for every program
+    // (slot 0 = x), using the shared pool when pool is null. Programs that
+    // are empty or need variables other than x get an empty buffer.
+    static std::vector<SampleBuffer> sampleUniform(const std::vector<const CompiledExpression*>& programs,
+                                                   double xMin, double xMax, size_t count,
+                                                   ThreadPool* pool = nullptr);
+
+    // Samples concentrated where the curve bends, jumps or leaves its domain.
+    // Starting from a uniform grid, each segment's midpoint is evaluated and
+    // the segment is split again while the midpoint deviates from the chord
+    // by more than tolerance, neighbouring samples are more than
+    // maxStepPixels apart, or exactly one end is undefined. Values are
+    // clamped to a band around the viewport first, so curves far off screen
+    // are not refined. Each refinement level is one batch evaluation; when a
+    // level would exceed maxEvaluations, the worst segments are split first.
+    // xs comes back sorted.
+    static std::vector<SampleBuffer> sampleAdaptive(const std::vector<const CompiledExpression*>& programs,
+                                                    const SampleViewport& viewport,
+                                                    const AdaptiveSampleOptions& options = AdaptiveSampleOptions(),
+                                                    ThreadPool* pool = nullptr);
+    static SampleBuffer sampleAdaptive(const CompiledExpression& program, const SampleViewport& viewport,
+                                       const AdaptiveSampleOptions& options = AdaptiveSampleOptions());
+
+    // sampleAdaptive starting from samples already taken (sorted by x, such
+    // as a cached coarse grid) instead of a fresh uniform grid. Only the
+    // segments overlapping the viewport's x range are split; maxEvaluations
+    // caps the new evaluations, and initialSegments is unused. Returns the
+    // coarse samples plus the new ones, sorted.
+    static std::vector<SampleBuffer> refine(const std::vector<const CompiledExpression*>& programs,
+                                            const std::vector<SampleBuffer>& coarse, const SampleViewport& viewport,
+                                            const AdaptiveSampleOptions& options = AdaptiveSampleOptions(),
+                                            ThreadPool* pool = nullptr);
+    static SampleBuffer refine(const CompiledExpression& program, const SampleBuffer& coarse,
+                               const SampleViewport& viewport,
+                               const AdaptiveSampleOptions& options = AdaptiveSampleOptions());
+
+    // True when program is a function of x alone and can be sampled
+    static bool isPlottable(const CompiledExpression& program);
+};
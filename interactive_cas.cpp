@@ -1,12 +1,24 @@
 #include "cas/SymbolicEngine.h"
 #include "parser/ExpressionParser.h"
+#include "util/Instrumentation.h"
+#ifdef SFML_AVAILABLE
 #include "grapher/Grapher.h"
+#else
+#include "grapher/ConsoleGrapher.h"
+#endif
 #include <iostream>
 #include <string>
 #include <map>
 #include <sstream>
 #include <limits>
 #include <cmath>
+#include <vector>
+
+#ifdef SFML_AVAILABLE
+using GraphSettings = Grapher::PlotSettings;
+#else
+using GraphSettings = ConsoleGrapher::PlotSettings;
+#endif
 
 void printHelp() {
     std::cout << "\n=== Interactive CAS Menu ===" << std::endl;
@@ -19,6 +31,8 @@ void printHelp() {
     std::cout << "  all <expr>             - Show parse, derivative, and integral" << std::endl;
     std::cout << "  graph <expr>           - Graph function in a GUI window" << std::endl;
     std::cout << "  graph <expr> [options] - Graph with custom range/size (GUI)" << std::endl;
+    std::cout << "  stats                  - Show counters and phase timings" << std::endl;
+    std::cout << "  stats reset            - Clear the counters and timings" << std::endl;
     std::cout << "  help                   - Show this menu" << std::endl;
     std::cout << "  quit/exit              - Exit program" << std::endl;
     std::cout << "\nGraph options (after expression):" << std::endl;
@@ -74,6 +88,14 @@ int main() {
         else if (command == "help") {
             printHelp();
         }
+        else if (command == "stats") {
+            if (expression == "reset") {
+                Instrumentation::reset();
+                std::cout << "  Statistics cleared" << std::endl;
+            } else {
+                Instrumentation::report(std::cout, Instrumentation::snapshot());
+            }
+        }
         else if (command == "parse") {
             if (expression.empty()) {
                 std::cout << "Error: Please provide an expression" << std::endl;
@@ -120,7 +142,7 @@ int main() {
                     std::cout << "  d/dx of (" << expression << "):" << std::endl;
                     std::cout << "  = " << derivative->toString() << std::endl;
                     
-                    auto simplified = derivative->simplify();
+                    auto simplified = engine.simplify(*derivative);
                     std::cout << "  Simplified: " << simplified->toString() << std::endl;
                 } else {
                     std::cout << "✗ Parse error" << std::endl;
@@ -142,7 +164,7 @@ int main() {
                     std::cout << "  ∫(" << expression << ")dx:" << std::endl;
                     std::cout << "  = " << integral->toString() << std::endl;
                     
-                    auto simplified = integral->simplify();
+                    auto simplified = engine.simplify(*integral);
                     std::cout << "  Simplified: " << simplified->toString() << " + C" << std::endl;
                 } else {
                     std::cout << "✗ Parse error" << std::endl;
@@ -195,7 +217,7 @@ int main() {
                     auto derivative = engine.differentiate("x");
                     std::cout << "\n2. Derivative (d/dx):" << std::endl;
                     std::cout << "   " << derivative->toString() << std::endl;
-                    auto simplifiedDeriv = derivative->simplify();
+                    auto simplifiedDeriv = engine.simplify(*derivative);
                     std::cout << "   Simplified: " << simplifiedDeriv->toString() << std::endl;
                 } catch (const std::exception& e) {
                     std::cout << "\n2. Derivative: Error - " << e.what() << std::endl;
@@ -206,7 +228,7 @@ int main() {
                     auto integral = engine.integrate("x");
                     std::cout << "\n3. Integral (∫dx):" << std::endl;
                     std::cout << "   " << integral->toString() << std::endl;
-                    auto simplifiedIntegral = integral->simplify();
+                    auto simplifiedIntegral = engine.simplify(*integral);
                     std::cout << "   Simplified: " << simplifiedIntegral->toString() << " + C" << std::endl;
                 } catch (const std::exception& e) {
                     std::cout << "\n3. Integral: Error - " << e.what() << std::endl;
@@ -225,7 +247,7 @@ int main() {
             
             try {
                 // Parse graph options from the rest of the line
-                Grapher::PlotSettings settings;
+                GraphSettings settings;
                 settings.width = 80;
                 settings.height = 25;
                 settings.xMin = -10.0;
@@ -297,22 +319,25 @@ int main() {
                         double maxY = std::numeric_limits<double>::lowest();
                         int samples = 100;
                         
-                        // Sample the function across the x-range
+                        // Sample the function across the x-range in one batch
+                        std::vector<double> xs(samples + 1);
+                        std::vector<double> ys(samples + 1);
                         for (int i = 0; i <= samples; i++) {
-                            double x = settings.xMin + (settings.xMax - settings.xMin) * (i / static_cast<double>(samples));
-                            std::map<std::string, double> vars = {{"x", x}};
+                            xs[i] = settings.xMin + (settings.xMax - settings.xMin) * (i / static_cast<double>(samples));
+                        }
+                        
+                        try {
+                            parser.evaluateBatch(xs.data(), ys.data(), xs.size());
                             
-                            try {
-                                double y = parser.evaluate(vars);
-                                
-                                // Skip inf and nan values
+                            for (double y : ys) {
+                                // Skip inf and nan values (domain errors come back as nan)
                                 if (std::isfinite(y)) {
                                     minY = std::min(minY, y);
                                     maxY = std::max(maxY, y);
                                 }
-                            } catch (...) {
-                                // Skip evaluation errors (e.g., domain issues)
                             }
+                        } catch (...) {
+                            // Skip evaluation errors (e.g., undefined variables)
                         }
                         
                         // Add padding to the y-range
@@ -330,6 +355,7 @@ int main() {
                     }
                 }
                 
+#ifdef SFML_AVAILABLE
                 // Create and use GUI grapher (SFML)
                 Grapher::PlotSettings gsettings;
                 gsettings.width = settings.width * 10; // scale console cols->pixels
@@ -352,6 +378,15 @@ int main() {
                 } else {
                     std::cout << "✗ Failed to add function to GUI grapher" << std::endl;
                 }
+#else
+                // No SFML: fall back to the console grapher
+                ConsoleGrapher grapher(settings);
+                if (grapher.addFunction(expr, expr)) {
+                    grapher.plot();
+                } else {
+                    std::cout << "✗ Failed to add function to console grapher" << std::endl;
+                }
+#endif
             } catch (const std::exception& e) {
                 std::cout << "✗ Graphing error: " << e.what() << std::endl;
             }
@@ -5,11 +5,34 @@
 #include <cctype>
 #include <stdexcept>
 #include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <system_error>
+#include "../util/ThreadPool.h"
+#include "../util/Instrumentation.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CAS_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // ============================================================================
 // AST Node Implementations
 // ============================================================================
 
+namespace {
+// Status-mode failure: keep the first status and yield NaN
+double statusNaN(EvalStatus& status, EvalStatus failure) {
+    recordStatus(status, failure);
+    return std::numeric_limits<double>::quiet_NaN();
+}
+}
+
 // BinaryOpNode implementation
 std::string BinaryOpNode::toString() const {
     std::string opStr;
@@ -39,10 +62,40 @@ double BinaryOpNode::evaluate(const std::map<std::string, double>& variables) co
     }
 }
 
+double BinaryOpNode::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    double leftVal = left->evaluate(variables, status);
+    double rightVal = right->evaluate(variables, status);
+    
+    switch (op) {
+        case OpType::ADD: return leftVal + rightVal;
+        case OpType::SUBTRACT: return leftVal - rightVal;
+        case OpType::MULTIPLY: return leftVal * rightVal;
+        case OpType::DIVIDE: 
+            if (rightVal == 0) return statusNaN(status, EvalStatus::DIVISION_BY_ZERO);
+            return leftVal / rightVal;
+        case OpType::POWER: return std::pow(leftVal, rightVal);
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
 std::unique_ptr<ASTNode> BinaryOpNode::clone() const {
     return std::make_unique<BinaryOpNode>(op, left->clone(), right->clone());
 }
 
+void BinaryOpNode::compile(CompiledExpression& program) const {
+    left->compile(program);
+    right->compile(program);
+    
+    switch (op) {
+        case OpType::ADD: program.emit(OpCode::ADD); break;
+        case OpType::SUBTRACT: program.emit(OpCode::SUBTRACT); break;
+        case OpType::MULTIPLY: program.emit(OpCode::MULTIPLY); break;
+        case OpType::DIVIDE: program.emit(OpCode::DIVIDE); break;
+        case OpType::POWER: program.emit(OpCode::POWER); break;
+        default: throw std::runtime_error("Unknown binary operation");
+    }
+}
+
 // UnaryOpNode implementation
 std::string UnaryOpNode::toString() const {
     std::string opStr;
@@ -83,10 +136,50 @@ double UnaryOpNode::evaluate(const std::map<std::string, double>& variables) con
     }
 }
 
+double UnaryOpNode::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    double val = operand->evaluate(variables, status);
+    
+    switch (op) {
+        case OpType::POSITIVE: return val;
+        case OpType::NEGATIVE: return -val;
+        case OpType::SIN: return std::sin(val);
+        case OpType::COS: return std::cos(val);
+        case OpType::TAN: return std::tan(val);
+        case OpType::LOG: 
+            if (val <= 0) return statusNaN(status, EvalStatus::LOG_DOMAIN);
+            return std::log10(val);
+        case OpType::LN: 
+            if (val <= 0) return statusNaN(status, EvalStatus::LN_DOMAIN);
+            return std::log(val);
+        case OpType::SQRT: 
+            if (val < 0) return statusNaN(status, EvalStatus::SQRT_DOMAIN);
+            return std::sqrt(val);
+        case OpType::ABS: return std::abs(val);
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
 std::unique_ptr<ASTNode> UnaryOpNode::clone() const {
     return std::make_unique<UnaryOpNode>(op, operand->clone());
 }
 
+void UnaryOpNode::compile(CompiledExpression& program) const {
+    operand->compile(program);
+    
+    switch (op) {
+        case OpType::POSITIVE: break;
+        case OpType::NEGATIVE: program.emit(OpCode::NEGATE); break;
+        case OpType::SIN: program.emit(OpCode::SIN); break;
+        case OpType::COS: program.emit(OpCode::COS); break;
+        case OpType::TAN: program.emit(OpCode::TAN); break;
+        case OpType::LOG: program.emit(OpCode::LOG); break;
+        case OpType::LN: program.emit(OpCode::LN); break;
+        case OpType::SQRT: program.emit(OpCode::SQRT); break;
+        case OpType::ABS: program.emit(OpCode::ABS); break;
+        default: throw std::runtime_error("Unknown unary operation");
+    }
+}
+
 // NumberNode implementation
 std::string NumberNode::toString() const {
     std::ostringstream oss;
@@ -99,8 +192,20 @@ double NumberNode::evaluate(const std::map<std::string, double>& variables) cons
     return value;
 }
 
+double NumberNode::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    (void)variables;
+    (void)status;
+    return value;
+}
+
 std::unique_ptr<ASTNode> NumberNode::clone() const {
-    return std::make_unique<NumberNode>(value);
+    auto copy = std::make_unique<NumberNode>(exact);
+    copy->value = value;
+    return copy;
+}
+
+void NumberNode::compile(CompiledExpression& program) const {
+    program.emitConstant(value);
 }
 
 // VariableNode implementation
@@ -116,10 +221,22 @@ double VariableNode::evaluate(const std::map<std::string, double>& variables) co
     return it->second;
 }
 
+double VariableNode::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    auto it = variables.find(name);
+    if (it == variables.end()) {
+        return statusNaN(status, EvalStatus::UNDEFINED_VARIABLE);
+    }
+    return it->second;
+}
+
 std::unique_ptr<ASTNode> VariableNode::clone() const {
     return std::make_unique<VariableNode>(name);
 }
 
+void VariableNode::compile(CompiledExpression& program) const {
+    program.emitVariable(name);
+}
+
 // FunctionNode implementation
 std::string FunctionNode::toString() const {
     std::string result = functionName + "(";
@@ -132,32 +249,28 @@ std::string FunctionNode::toString() const {
 }
 
 double FunctionNode::evaluate(const std::map<std::string, double>& variables) const {
-    // For now, we'll handle basic functions here
-    // In a more sophisticated CAS, this would be handled by the symbolic engine
-    if (arguments.size() != 1) {
-        throw std::runtime_error("Function " + functionName + " expects 1 argument");
-    }
+    FunctionRegistry::checkCall(functionId, functionName, arguments.size());
     
-    double arg = arguments[0]->evaluate(variables);
-    
-    if (functionName == "sin") return std::sin(arg);
-    if (functionName == "cos") return std::cos(arg);
-    if (functionName == "tan") return std::tan(arg);
-    if (functionName == "log") {
-        if (arg <= 0) throw std::runtime_error("Log of non-positive number");
-        return std::log10(arg);
+    double args[FunctionRegistry::kMaxArity];
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        args[i] = arguments[i]->evaluate(variables);
     }
-    if (functionName == "ln") {
-        if (arg <= 0) throw std::runtime_error("Natural log of non-positive number");
-        return std::log(arg);
+    return FunctionRegistry::call(functionId, args, nullptr);
+}
+
+double FunctionNode::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    if (functionId == FunctionRegistry::kUnknown) {
+        return statusNaN(status, EvalStatus::UNKNOWN_FUNCTION);
     }
-    if (functionName == "sqrt") {
-        if (arg < 0) throw std::runtime_error("Square root of negative number");
-        return std::sqrt(arg);
+    if (arguments.size() != FunctionRegistry::arity(functionId)) {
+        return statusNaN(status, EvalStatus::WRONG_ARITY);
     }
-    if (functionName == "abs") return std::abs(arg);
     
-    throw std::runtime_error("Unknown function: " + functionName);
+    double args[FunctionRegistry::kMaxArity];
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        args[i] = arguments[i]->evaluate(variables, status);
+    }
+    return FunctionRegistry::call(functionId, args, &status);
 }
 
 std::unique_ptr<ASTNode> FunctionNode::clone() const {
@@ -165,14 +278,53 @@ std::unique_ptr<ASTNode> FunctionNode::clone() const {
     for (const auto& arg : arguments) {
         clonedArgs.push_back(arg->clone());
     }
-    return std::make_unique<FunctionNode>(functionName, std::move(clonedArgs));
+    return std::make_unique<FunctionNode>(functionName, functionId, std::move(clonedArgs));
+}
+
+void FunctionNode::compile(CompiledExpression& program) const {
+    FunctionRegistry::checkCall(functionId, functionName, arguments.size());
+    
+    for (const auto& arg : arguments) {
+        arg->compile(program);
+    }
+    program.emitCall(functionId);
+}
+
+// ============================================================================
+// Symbol Table Implementation
+// ============================================================================
+
+SymbolTable::SymbolTable() : functions(FunctionRegistry::size()) {
+    names.reserve(functions + 8);
+    for (uint32_t id = 0; id < functions; ++id) {
+        names.push_back(FunctionRegistry::name(id));
+        if (!FunctionRegistry::isBuiltin(id)) {
+            ids.emplace(names.back(), id);
+        }
+    }
+}
+
+uint32_t SymbolTable::intern(std::string_view name) {
+    uint32_t builtin = FunctionRegistry::builtin(name);
+    if (builtin != FunctionRegistry::kUnknown) {
+        return builtin;
+    }
+    
+    auto found = ids.find(name);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    ids.emplace(name, id);
+    return id;
 }
 
 // ============================================================================
 // Lexer Implementation
 // ============================================================================
 
-Lexer::Lexer(const std::string& expression) 
+Lexer::Lexer(std::string_view expression) 
     : input(expression), position(0), length(expression.length()) {}
 
 void Lexer::skipWhitespace() {
@@ -207,8 +359,17 @@ Token Lexer::readNumber() {
         }
     }
     
-    std::string numberStr = input.substr(start, position - start);
-    return Token(TokenType::NUMBER, numberStr, start);
+    // Parse in place; like std::stod, a dangling exponent such as "2e" is
+    // ignored rather than rejected
+    Token token(TokenType::NUMBER, input.substr(start, position - start), start);
+    auto [end, error] = std::from_chars(input.data() + start, input.data() + position, token.number);
+    if (error == std::errc::invalid_argument) {
+        return fail(token, "Invalid number '" + std::string(token.text) + "' at position " + std::to_string(start));
+    }
+    if (error == std::errc::result_out_of_range) {
+        return fail(token, "Number out of range at position " + std::to_string(start));
+    }
+    return token;
 }
 
 Token Lexer::readIdentifier() {
@@ -217,23 +378,18 @@ Token Lexer::readIdentifier() {
         position++;
     }
     
-    std::string identifier = input.substr(start, position - start);
-    TokenType type = isFunction(identifier) ? TokenType::FUNCTION : TokenType::VARIABLE;
-    return Token(type, identifier, start);
-}
-
-bool Lexer::isFunction(const std::string& identifier) {
-    static const std::vector<std::string> functions = {
-        "sin", "cos", "tan", "log", "ln", "sqrt", "abs"
-    };
-    return std::find(functions.begin(), functions.end(), identifier) != functions.end();
+    std::string_view identifier = input.substr(start, position - start);
+    uint32_t symbol = symbols.intern(identifier);
+    Token token(symbols.isFunction(symbol) ? TokenType::FUNCTION : TokenType::VARIABLE, identifier, start);
+    token.symbol = symbol;
+    return token;
 }
 
 Token Lexer::getNextToken() {
     skipWhitespace();
     
     if (position >= length) {
-        return Token(TokenType::END_OF_FILE, "", position);
+        return Token(TokenType::END_OF_FILE, {}, position);
     }
     
     char current = input[position];
@@ -261,31 +417,63 @@ Token Lexer::getNextToken() {
         case ',': position++; return Token(TokenType::COMMA, ",", currentPos);
         default:
             position++;
-            return Token(TokenType::INVALID, std::string(1, current), currentPos);
+            return Token(TokenType::INVALID, input.substr(currentPos, 1), currentPos);
     }
 }
 
+Token Lexer::fail(Token token, const std::string& message) {
+    if (error.empty()) {
+        error = message;
+    }
+    token.type = TokenType::INVALID;
+    return token;
+}
+
 void Lexer::reset() {
     position = 0;
+    error.clear();
 }
 
 // ============================================================================
 // Parser Implementation
 // ============================================================================
 
-Parser::Parser(const std::string& expression) : lexer(expression), currentToken(TokenType::INVALID, "", 0) {
+// Errors are recorded rather than thrown: fail() keeps the first message and
+// every parse method returns null as soon as failed is set, unwinding the
+// recursion without exceptions. parse() turns a recorded error back into a
+// std::runtime_error for callers that expect one.
+
+Parser::Parser(std::string_view expression) 
+    : lexer(expression), currentToken(TokenType::INVALID, {}, 0), failed(false) {
     advance();
 }
 
 void Parser::advance() {
+    CAS_TIME_PHASE(LEX);
     currentToken = lexer.getNextToken();
+    if (lexer.hasError()) {
+        fail(lexer.getError());
+    }
 }
 
-void Parser::expect(TokenType type, const std::string& message) {
+bool Parser::expect(TokenType type, const std::string& message) {
+    if (failed) {
+        return false;
+    }
     if (currentToken.type != type) {
         std::string expected = message.empty() ? "Unexpected token" : message;
-        throwError(expected + " at position " + std::to_string(currentToken.position));
+        fail(expected + " at position " + std::to_string(currentToken.position));
+        return false;
+    }
+    return true;
+}
+
+std::nullptr_t Parser::fail(const std::string& message) {
+    if (!failed) {
+        failed = true;
+        errorMessage = message;
     }
+    return nullptr;
 }
 
 int Parser::getPrecedence(TokenType type) {
@@ -308,13 +496,27 @@ bool Parser::isRightAssociative(TokenType type) {
 }
 
 std::unique_ptr<ASTNode> Parser::parse() {
+    auto result = tryParse();
+    if (failed) {
+        throwError(errorMessage);
+    }
+    return result;
+}
+
+std::unique_ptr<ASTNode> Parser::tryParse() {
+    CAS_TIME_PHASE(PARSE);
+    if (failed) {
+        return nullptr;
+    }
     try {
         auto result = parseExpression();
-        expect(TokenType::END_OF_FILE, "Expected end of expression");
+        if (!expect(TokenType::END_OF_FILE, "Expected end of expression")) {
+            return nullptr;
+        }
         return result;
     } catch (const std::exception& e) {
-        throwError(e.what());
-        return nullptr;
+        // Only allocation failures and the like reach here
+        return fail(e.what());
     }
 }
 
@@ -324,6 +526,7 @@ std::unique_ptr<ASTNode> Parser::parseExpression() {
 
 std::unique_ptr<ASTNode> Parser::parseTerm() {
     auto left = parseFactor();
+    if (failed) return nullptr;
     
     while (currentToken.type == TokenType::PLUS || currentToken.type == TokenType::MINUS) {
         BinaryOpNode::OpType op = (currentToken.type == TokenType::PLUS) ? 
@@ -331,6 +534,7 @@ std::unique_ptr<ASTNode> Parser::parseTerm() {
         
         advance();
         auto right = parseFactor();
+        if (failed) return nullptr;
         left = std::make_unique<BinaryOpNode>(op, std::move(left), std::move(right));
     }
     
@@ -339,6 +543,7 @@ std::unique_ptr<ASTNode> Parser::parseTerm() {
 
 std::unique_ptr<ASTNode> Parser::parseFactor() {
     auto left = parsePower();
+    if (failed) return nullptr;
     
     while (currentToken.type == TokenType::MULTIPLY || currentToken.type == TokenType::DIVIDE ||
            currentToken.type == TokenType::NUMBER || currentToken.type == TokenType::VARIABLE || 
@@ -356,6 +561,7 @@ std::unique_ptr<ASTNode> Parser::parseFactor() {
         }
         
         auto right = parsePower();
+        if (failed) return nullptr;
         left = std::make_unique<BinaryOpNode>(op, std::move(left), std::move(right));
     }
     
@@ -364,10 +570,12 @@ std::unique_ptr<ASTNode> Parser::parseFactor() {
 
 std::unique_ptr<ASTNode> Parser::parsePower() {
     auto left = parsePrimary();
+    if (failed) return nullptr;
     
     if (currentToken.type == TokenType::POWER) {
         advance();
         auto right = parsePower(); // Right associative
+        if (failed) return nullptr;
         left = std::make_unique<BinaryOpNode>(BinaryOpNode::OpType::POWER, std::move(left), std::move(right));
     }
     
@@ -375,15 +583,19 @@ std::unique_ptr<ASTNode> Parser::parsePower() {
 }
 
 std::unique_ptr<ASTNode> Parser::parsePrimary() {
+    if (failed) return nullptr;
+    
     switch (currentToken.type) {
         case TokenType::NUMBER: {
-            double value = std::stod(currentToken.value);
+            // Exact decimal value alongside the correctly rounded double
+            auto node = std::make_unique<NumberNode>(Number::parse(currentToken.text));
+            node->value = currentToken.number;
             advance();
-            return std::make_unique<NumberNode>(value);
+            return node;
         }
         
         case TokenType::VARIABLE: {
-            std::string varName = currentToken.value;
+            std::string varName(lexer.getSymbols().name(currentToken.symbol));
             advance();
             return std::make_unique<VariableNode>(varName);
         }
@@ -395,7 +607,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
         case TokenType::LEFT_PAREN: {
             advance();
             auto expr = parseExpression();
-            expect(TokenType::RIGHT_PAREN, "Expected closing parenthesis");
+            if (!expect(TokenType::RIGHT_PAREN, "Expected closing parenthesis")) return nullptr;
             advance();
             return expr;
         }
@@ -406,20 +618,21 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
                 UnaryOpNode::OpType::POSITIVE : UnaryOpNode::OpType::NEGATIVE;
             advance();
             auto operand = parsePrimary();
+            if (failed) return nullptr;
             return std::make_unique<UnaryOpNode>(op, std::move(operand));
         }
         
         default:
-            throwError("Unexpected token: " + currentToken.value);
-            return nullptr;
+            return fail("Unexpected token: " + std::string(currentToken.text));
     }
 }
 
 std::unique_ptr<ASTNode> Parser::parseFunction() {
-    std::string funcName = currentToken.value;
+    std::string funcName(lexer.getSymbols().name(currentToken.symbol));
+    uint32_t functionId = currentToken.symbol;
     advance();
     
-    expect(TokenType::LEFT_PAREN, "Expected opening parenthesis after function name");
+    if (!expect(TokenType::LEFT_PAREN, "Expected opening parenthesis after function name")) return nullptr;
     advance();
     
     std::vector<std::unique_ptr<ASTNode>> arguments;
@@ -427,16 +640,17 @@ std::unique_ptr<ASTNode> Parser::parseFunction() {
     if (currentToken.type != TokenType::RIGHT_PAREN) {
         arguments.push_back(parseExpression());
         
-        while (currentToken.type == TokenType::COMMA) {
+        while (!failed && currentToken.type == TokenType::COMMA) {
             advance();
             arguments.push_back(parseExpression());
         }
     }
     
-    expect(TokenType::RIGHT_PAREN, "Expected closing parenthesis");
+    if (!expect(TokenType::RIGHT_PAREN, "Expected closing parenthesis")) return nullptr;
     advance();
     
-    return std::make_unique<FunctionNode>(funcName, std::move(arguments));
+    // Function symbols are their registry ids
+    return std::make_unique<FunctionNode>(funcName, functionId, std::move(arguments));
 }
 
 void Parser::throwError(const std::string& message) {
@@ -444,11 +658,11 @@ void Parser::throwError(const std::string& message) {
 }
 
 bool Parser::hasError() const {
-    return false; // Errors are thrown as exceptions
+    return failed;
 }
 
 std::string Parser::getErrorMessage() const {
-    return ""; // Errors are thrown as exceptions
+    return errorMessage;
 }
 
 // ============================================================================
@@ -457,28 +671,158 @@ std::string Parser::getErrorMessage() const {
 
 ExpressionParser::ExpressionParser() : hasParsingError(false) {}
 
-bool ExpressionParser::parse(const std::string& expression) {
-    try {
-        Parser parser(expression);
-        ast = parser.parse();
-        hasParsingError = false;
-        lastError.clear();
-        return true;
-    } catch (const std::exception& e) {
-        hasParsingError = true;
-        lastError = e.what();
+bool ExpressionParser::parse(std::string_view expression) {
+    Parser parser(expression);
+    ast = parser.tryParse();
+    hasParsingError = parser.hasError();
+    if (hasParsingError) {
+        lastError = parser.getErrorMessage();
         ast.reset();
         return false;
     }
+    lastError.clear();
+    return true;
+}
+
+namespace {
+// Expressions per task; large enough to amortize scheduling, small enough
+// that lines of uneven length still balance across threads
+constexpr size_t kParseGrain = 256;
+
+// Read-only view of a whole file, memory-mapped where the platform allows
+class MappedFile {
+private:
+    const char* bytes;
+    size_t length;
+#if defined(CAS_HAVE_MMAP)
+    bool mapped;
+#endif
+    std::string buffer;
+
+public:
+    explicit MappedFile(const std::string& path) : bytes(nullptr), length(0) {
+#if defined(CAS_HAVE_MMAP)
+        mapped = false;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot read file: " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + path);
+            }
+            ::madvise(address, length, MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(address);
+            mapped = true;
+        }
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+#endif
+    }
+    
+    ~MappedFile() {
+#if defined(CAS_HAVE_MMAP)
+        if (mapped) {
+            ::munmap(const_cast<char*>(bytes), length);
+        }
+#endif
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    std::string_view view() const { return std::string_view(bytes, length); }
+};
+}
+
+std::vector<ExpressionParser> ExpressionParser::parseMany(const std::vector<std::string_view>& expressions,
+                                                          ThreadPool* pool) {
+    std::vector<ExpressionParser> results(expressions.size());
+    ThreadPool& workers = pool ? *pool : ThreadPool::shared();
+    workers.parallelFor(expressions.size(), kParseGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i].parse(expressions[i]);
+        }
+    });
+    return results;
+}
+
+std::vector<ParsedLine> ExpressionParser::parseFile(const std::string& path, ThreadPool* pool) {
+    MappedFile file(path);
+    std::string_view text = file.view();
+    
+    // Split into lines without copying; the views stay valid while file is mapped
+    std::vector<std::string_view> expressions;
+    std::vector<size_t> lineNumbers;
+    size_t line = 0;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        ++line;
+        std::string_view expression = text.substr(start, end - start);
+        if (!expression.empty() && expression.back() == '\r') {
+            expression.remove_suffix(1);
+        }
+        bool blank = std::all_of(expression.begin(), expression.end(),
+                                 [](char c) { return std::isspace(static_cast<unsigned char>(c)); });
+        if (!blank) {
+            expressions.push_back(expression);
+            lineNumbers.push_back(line);
+        }
+        start = end + 1;
+    }
+    
+    std::vector<ExpressionParser> parsed = parseMany(expressions, pool);
+    std::vector<ParsedLine> results;
+    results.reserve(parsed.size());
+    for (size_t i = 0; i < parsed.size(); ++i) {
+        results.push_back(ParsedLine{lineNumbers[i], std::move(parsed[i])});
+    }
+    return results;
 }
 
 double ExpressionParser::evaluate(const std::map<std::string, double>& variables) const {
     if (!ast) {
         throw std::runtime_error("No expression parsed");
     }
+    CAS_COUNT(EVALUATE_CALLS);
     return ast->evaluate(variables);
 }
 
+double ExpressionParser::evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const {
+    if (!ast) {
+        return statusNaN(status, EvalStatus::NO_EXPRESSION);
+    }
+    CAS_COUNT(EVALUATE_CALLS);
+    return ast->evaluate(variables, status);
+}
+
+void ExpressionParser::evaluateBatch(const double* xs, double* out, size_t n, const std::string& variable) const {
+    CompiledExpression program = compile({variable});
+    if (program.getSlotCount() > 1) {
+        throw std::runtime_error("Undefined variable: " + program.getSlotNames()[1]);
+    }
+    program.evalBatch(&xs, out, n);
+}
+
 std::string ExpressionParser::toString() const {
     if (!ast) {
         return "No expression parsed";
@@ -496,3 +840,13 @@ std::unique_ptr<ASTNode> ExpressionParser::cloneAST() const {
     }
     return ast->clone();
 }
+
+CompiledExpression ExpressionParser::compile(const std::vector<std::string>& slots) const {
+    if (!ast) {
+        throw std::runtime_error("No expression parsed");
+    }
+    CAS_TIME_PHASE(COMPILE);
+    CompiledExpression program(slots);
+    ast->compile(program);
+    return program;
+}
@@ -2,12 +2,20 @@
 #define EXPRESSION_PARSER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <unordered_map>
+#include <cstdint>
 #include <memory>
 #include <map>
 #include <functional>
+#include <stdexcept>
+#include "../evaluator/CompiledExpression.h"
+#include "../evaluator/FunctionRegistry.h"
+#include "../util/Number.h"
 
 // Forward declarations
+class ThreadPool;
 class ASTNode;
 class BinaryOpNode;
 class UnaryOpNode;
@@ -32,28 +40,78 @@ enum class TokenType {
     INVALID
 };
 
-// Token structure
+// Token structure; text is a view into the lexer's input, so tokens never
+// allocate and stay valid only while that input does
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view text;
+    double number;           // NUMBER only
+    uint32_t symbol;         // VARIABLE / FUNCTION only: id in the lexer's SymbolTable
     size_t position;
     
-    Token(TokenType t, const std::string& v = "", size_t pos = 0) 
-        : type(t), value(v), position(pos) {}
+    Token(TokenType t, std::string_view v = {}, size_t pos = 0) 
+        : type(t), text(v), number(0.0), symbol(0), position(pos) {}
+};
+
+// SymbolTable - interns identifiers into dense ids. Functions occupy ids
+// 0..functionCount()-1, which are their FunctionRegistry ids: the builtins,
+// recognized by the registry's perfect hash, then the functions registered
+// when the table was created. Other names are numbered in order of first
+// appearance. Stored names are views into the text being lexed (or into the
+// registry, for functions).
+class SymbolTable {
+private:
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    uint32_t functions;
+    
+public:
+    SymbolTable();
+    
+    uint32_t intern(std::string_view name);
+    std::string_view name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+    
+    bool isFunction(uint32_t id) const { return id < functions; }
+    uint32_t functionCount() const { return functions; }
+};
+
+// Concrete AST node type, for switch-based dispatch without RTTI
+enum class ASTKind : uint8_t {
+    NUMBER,
+    VARIABLE,
+    BINARY_OP,
+    UNARY_OP,
+    FUNCTION
 };
 
 // Abstract Syntax Tree Node base class
 class ASTNode {
+private:
+    ASTKind nodeKind;
+
+protected:
+    explicit ASTNode(ASTKind kind) : nodeKind(kind) {}
+
 public:
     virtual ~ASTNode() = default;
+    ASTKind kind() const { return nodeKind; }
     virtual std::string toString() const = 0;
     virtual double evaluate(const std::map<std::string, double>& variables = {}) const = 0;
+    
+    // Status mode: domain errors yield NaN and set status instead of throwing
+    virtual double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const = 0;
     virtual std::unique_ptr<ASTNode> clone() const = 0;
+    
+    // Lower this subtree into postfix bytecode
+    virtual void compile(CompiledExpression& program) const = 0;
 };
 
 // Binary operation node (+, -, *, /, ^)
 class BinaryOpNode : public ASTNode {
 public:
+    static constexpr ASTKind kKind = ASTKind::BINARY_OP;
+    
     enum class OpType {
         ADD,
         SUBTRACT,
@@ -67,16 +125,20 @@ public:
     std::unique_ptr<ASTNode> right;
     
     BinaryOpNode(OpType operation, std::unique_ptr<ASTNode> l, std::unique_ptr<ASTNode> r)
-        : op(operation), left(std::move(l)), right(std::move(r)) {}
+        : ASTNode(kKind), op(operation), left(std::move(l)), right(std::move(r)) {}
     
     std::string toString() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const override;
     std::unique_ptr<ASTNode> clone() const override;
+    void compile(CompiledExpression& program) const override;
 };
 
 // Unary operation node (+, -, functions)
 class UnaryOpNode : public ASTNode {
 public:
+    static constexpr ASTKind kKind = ASTKind::UNARY_OP;
+    
     enum class OpType {
         POSITIVE,
         NEGATIVE,
@@ -93,68 +155,116 @@ public:
     std::unique_ptr<ASTNode> operand;
     
     UnaryOpNode(OpType operation, std::unique_ptr<ASTNode> op)
-        : op(operation), operand(std::move(op)) {}
+        : ASTNode(kKind), op(operation), operand(std::move(op)) {}
     
     std::string toString() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const override;
     std::unique_ptr<ASTNode> clone() const override;
+    void compile(CompiledExpression& program) const override;
 };
 
 // Number literal node
 class NumberNode : public ASTNode {
 public:
+    static constexpr ASTKind kKind = ASTKind::NUMBER;
+    
     double value;
+    Number exact;           // the literal's exact value; value is its double
     
-    NumberNode(double val) : value(val) {}
+    NumberNode(double val) : ASTNode(kKind), value(val), exact(Number::fromDouble(val)) {}
+    explicit NumberNode(Number val) : ASTNode(kKind), value(val.toDouble()), exact(std::move(val)) {}
     
     std::string toString() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const override;
     std::unique_ptr<ASTNode> clone() const override;
+    void compile(CompiledExpression& program) const override;
 };
 
 // Variable node
 class VariableNode : public ASTNode {
 public:
+    static constexpr ASTKind kKind = ASTKind::VARIABLE;
+    
     std::string name;
     
-    VariableNode(const std::string& varName) : name(varName) {}
+    VariableNode(const std::string& varName) : ASTNode(kKind), name(varName) {}
     
     std::string toString() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const override;
     std::unique_ptr<ASTNode> clone() const override;
+    void compile(CompiledExpression& program) const override;
 };
 
 // Function call node
 class FunctionNode : public ASTNode {
 public:
+    static constexpr ASTKind kKind = ASTKind::FUNCTION;
+    
     std::string functionName;
+    uint32_t functionId;   // FunctionRegistry id, or FunctionRegistry::kUnknown
     std::vector<std::unique_ptr<ASTNode>> arguments;
     
     FunctionNode(const std::string& funcName, std::vector<std::unique_ptr<ASTNode>> args)
-        : functionName(funcName), arguments(std::move(args)) {}
+        : FunctionNode(funcName, FunctionRegistry::find(funcName), std::move(args)) {}
+    FunctionNode(const std::string& funcName, uint32_t id, std::vector<std::unique_ptr<ASTNode>> args)
+        : ASTNode(kKind), functionName(funcName), functionId(id), arguments(std::move(args)) {}
     
     std::string toString() const override;
     double evaluate(const std::map<std::string, double>& variables = {}) const override;
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const override;
     std::unique_ptr<ASTNode> clone() const override;
+    void compile(CompiledExpression& program) const override;
 };
 
+// Checked downcast through the kind tag; returns null when the kind differs
+template <typename T>
+const T* astCast(const ASTNode* node) {
+    return (node && node->kind() == T::kKind) ? static_cast<const T*>(node) : nullptr;
+}
+
+// Calls visitor with the node downcast to its concrete type
+template <typename Visitor>
+decltype(auto) visitAST(const ASTNode& node, Visitor&& visitor) {
+    switch (node.kind()) {
+        case ASTKind::NUMBER: return visitor(static_cast<const NumberNode&>(node));
+        case ASTKind::VARIABLE: return visitor(static_cast<const VariableNode&>(node));
+        case ASTKind::BINARY_OP: return visitor(static_cast<const BinaryOpNode&>(node));
+        case ASTKind::UNARY_OP: return visitor(static_cast<const UnaryOpNode&>(node));
+        case ASTKind::FUNCTION: return visitor(static_cast<const FunctionNode&>(node));
+    }
+    throw std::runtime_error("Unknown AST node type");
+}
+
 // Lexer class for tokenization
+//
+// The lexer does not copy its input: the caller keeps the expression alive
+// for as long as the lexer and its tokens are in use. Malformed numbers come
+// back as INVALID tokens and leave a message in getError().
 class Lexer {
 private:
-    std::string input;
+    std::string_view input;
     size_t position;
     size_t length;
+    SymbolTable symbols;
+    std::string error;
     
     void skipWhitespace();
     Token readNumber();
     Token readIdentifier();
-    bool isFunction(const std::string& identifier);
+    Token fail(Token token, const std::string& message);
     
 public:
-    Lexer(const std::string& expression);
+    Lexer(std::string_view expression);
     Token getNextToken();
     void reset();
     size_t getPosition() const { return position; }
+    const SymbolTable& getSymbols() const { return symbols; }
+    
+    bool hasError() const { return !error.empty(); }
+    const std::string& getError() const { return error; }
 };
 
 // Parser class for building AST
@@ -162,9 +272,14 @@ class Parser {
 private:
     Lexer lexer;
     Token currentToken;
+    bool failed;
+    std::string errorMessage;
     
     void advance();
-    void expect(TokenType type, const std::string& message = "");
+    bool expect(TokenType type, const std::string& message = "");
+    
+    // Record the first error; returns null so parse methods can return it
+    std::nullptr_t fail(const std::string& message);
     
     // Recursive descent parsing methods
     std::unique_ptr<ASTNode> parseExpression();
@@ -179,11 +294,15 @@ private:
     bool isRightAssociative(TokenType type);
     
 public:
-    Parser(const std::string& expression);
+    // expression must outlive the parser
+    Parser(std::string_view expression);
     
-    // Main parsing method
+    // Main parsing method; throws std::runtime_error on a syntax error
     std::unique_ptr<ASTNode> parse();
     
+    // As parse(), but returns null and sets hasError() instead of throwing
+    std::unique_ptr<ASTNode> tryParse();
+    
     // Error handling
     void throwError(const std::string& message);
     
@@ -192,6 +311,8 @@ public:
     std::string getErrorMessage() const;
 };
 
+struct ParsedLine;
+
 // ExpressionParser - main interface
 class ExpressionParser {
 private:
@@ -202,12 +323,29 @@ private:
 public:
     ExpressionParser();
     
-    // Parse an expression string into an AST
-    bool parse(const std::string& expression);
+    // Parse an expression string into an AST; syntax errors are reported
+    // through the return value and getError() without throwing
+    bool parse(std::string_view expression);
+    
+    // Parse many expressions on a thread pool (the shared pool when null).
+    // Result i holds the AST or the error for expressions[i].
+    static std::vector<ExpressionParser> parseMany(const std::vector<std::string_view>& expressions,
+                                                   ThreadPool* pool = nullptr);
+    
+    // Memory-map a file and parse one expression per line, skipping blank
+    // lines. Throws std::runtime_error only when the file cannot be read.
+    static std::vector<ParsedLine> parseFile(const std::string& path, ThreadPool* pool = nullptr);
     
     // Evaluate the parsed expression
     double evaluate(const std::map<std::string, double>& variables = {}) const;
     
+    // Status mode: returns NaN and sets status instead of throwing
+    double evaluate(const std::map<std::string, double>& variables, EvalStatus& status) const;
+    
+    // Evaluate at n values of a single variable in one pass;
+    // points with domain errors come back as NaN
+    void evaluateBatch(const double* xs, double* out, size_t n, const std::string& variable = "x") const;
+    
     // Get string representation of the AST
     std::string toString() const;
     
@@ -220,6 +358,16 @@ public:
     
     // Utility methods
     std::unique_ptr<ASTNode> cloneAST() const;
+    
+    // Compile the parsed expression to bytecode; slots lists variables whose
+    // slot indices the caller wants fixed (remaining variables are appended)
+    CompiledExpression compile(const std::vector<std::string>& slots = {}) const;
+};
+
+// One non-blank line of a file loaded by ExpressionParser::parseFile
+struct ParsedLine {
+    size_t line;                  // 1-based line number
+    ExpressionParser expression;  // AST, or the error for this line
 };
 
 #endif // EXPRESSION_PARSER_H
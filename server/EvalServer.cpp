@@ -0,0 +1,269 @@
+#include "EvalServer.h"
+#include "../cas/RootFinder.h"
+#include "../cas/Simplifier.h"
+#include "../evaluator/FunctionRegistry.h"
+#include "../util/ThreadPool.h"
+#include <cctype>
+#include <charconv>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Shortest text that reads back as the same double
+std::string formatNumber(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+}
+
+bool parseNumber(const std::string& text, double& value) {
+    const char* last = text.data() + text.size();
+    auto result = std::from_chars(text.data(), last, value);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+// "x=1, y=2.5" or "x=1 y=2.5"
+std::map<std::string, double> parseBindings(const std::string& text) {
+    std::map<std::string, double> variables;
+    std::string spaced = text;
+    for (char& c : spaced) {
+        if (c == ',') c = ' ';
+    }
+    std::istringstream iss(spaced);
+    std::string binding;
+    while (iss >> binding) {
+        size_t equals = binding.find('=');
+        if (equals == std::string::npos || equals == 0 || equals + 1 == binding.size()) {
+            throw std::runtime_error("Bad binding '" + binding + "', expected name=value");
+        }
+        std::string name = binding.substr(0, equals);
+        double value = 0.0;
+        if (!parseNumber(binding.substr(equals + 1), value)) {
+            throw std::runtime_error("Bad value in binding '" + binding + "'");
+        }
+        variables[name] = value;
+    }
+    return variables;
+}
+
+// "[variable] lo hi [name=value ...]" -> "ok r1 r2 ..." (just "ok" when none)
+std::string findRoots(const CompiledExpression& program, const std::string& arguments) {
+    std::istringstream iss(arguments);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token) tokens.push_back(token);
+
+    size_t next = 0;
+    std::string variable = "x";
+    double lo = 0.0;
+    double hi = 0.0;
+    if (!tokens.empty() && tokens[0].find('=') == std::string::npos && !parseNumber(tokens[0], lo)) {
+        variable = tokens[next++];
+    }
+    if (tokens.size() < next + 2 || !parseNumber(tokens[next], lo) || !parseNumber(tokens[next + 1], hi)) {
+        throw std::runtime_error("Expected: roots <expr> ; [variable] <lo> <hi> [name=value ...]");
+    }
+    std::string bindings;
+    for (size_t i = next + 2; i < tokens.size(); ++i) bindings += tokens[i] + " ";
+
+    RootFinder finder(program, variable, parseBindings(bindings));
+    std::string response = "ok";
+    for (const Root& root : finder.findAll(lo, hi)) {
+        response += " " + formatNumber(root.x);
+    }
+    return response;
+}
+
+} // namespace
+
+EvalServer::EvalServer(const ServerOptions& options)
+    : options(options), cache(options.cacheCapacity), requests(0), batches(0) {}
+
+std::shared_ptr<EvalServer::CachedExpression> EvalServer::lookup(const std::string& text) {
+    // Keyed by the registry size too: a newly registered function changes
+    // how the text parses
+    std::string key = text + '\n' + std::to_string(FunctionRegistry::size());
+    if (auto cached = cache.find(key)) {
+        return cached;
+    }
+
+    // Parse and compile outside the cache lock; if another thread raced us
+    // to the same text, its entry wins
+    auto entry = std::make_shared<CachedExpression>();
+    ExpressionParser parser;
+    if (!parser.parse(text)) {
+        entry->error = "Parse error: " + parser.getError();
+    } else if (!entry->engine.parseFromAST(parser.getAST())) {
+        entry->error = "Cannot convert expression";
+    } else {
+        entry->parsed = parser.toString();
+        try {
+            entry->program = entry->engine.compile();
+        } catch (const std::exception& e) {
+            entry->error = e.what();
+        }
+    }
+
+    return cache.insert(key, entry, sizeof(CachedExpression) + key.size());
+}
+
+std::string EvalServer::symbolic(CachedExpression& entry, const std::string& operation, const std::string& variable) {
+    std::string key = operation + " " + variable;
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    auto it = entry.results.find(key);
+    if (it != entry.results.end()) {
+        return it->second;
+    }
+
+    SymbolicEngine& engine = entry.engine;
+    const ExprNode* result = nullptr;
+    if (operation == "diff") {
+        result = engine.getSimplifier().simplify(engine.differentiateNode(variable));
+    } else if (operation == "integrate") {
+        result = engine.getSimplifier().simplify(engine.integrateNode(variable));
+    } else {
+        result = engine.simplifyNode();
+    }
+    return entry.results[key] = engine.getStore().toString(result);
+}
+
+std::string EvalServer::handle(const std::string& request) {
+    requests++;
+    std::string line = trim(request);
+    size_t space = line.find_first_of(" \t");
+    std::string operation = line.substr(0, space);
+    std::string rest = space == std::string::npos ? "" : line.substr(space + 1);
+
+    if (operation == "stats") {
+        ServerStats stats = getStats();
+        std::ostringstream oss;
+        double lookups = static_cast<double>(stats.cacheHits + stats.cacheMisses);
+        oss << "ok requests=" << stats.requests << " batches=" << stats.batches << " hits=" << stats.cacheHits
+            << " misses=" << stats.cacheMisses << " hit_rate=" << (lookups > 0 ? stats.cacheHits / lookups : 0.0)
+            << " evictions=" << stats.cacheEvictions << " cached=" << stats.cachedExpressions;
+        return oss.str();
+    }
+    if (operation != "eval" && operation != "diff" && operation != "integrate" && operation != "simplify" &&
+        operation != "parse" && operation != "roots") {
+        return "error Unknown request '" + operation + "'";
+    }
+
+    size_t semicolon = rest.find(';');
+    std::string expression = trim(rest.substr(0, semicolon));
+    std::string arguments = semicolon == std::string::npos ? "" : trim(rest.substr(semicolon + 1));
+    if (expression.empty()) {
+        return "error Missing expression";
+    }
+
+    try {
+        std::shared_ptr<CachedExpression> entry = lookup(expression);
+        if (!entry->error.empty()) {
+            return "error " + entry->error;
+        }
+        if (operation == "eval") {
+            return "ok " + formatNumber(entry->program.evaluate(parseBindings(arguments)));
+        }
+        if (operation == "roots") {
+            return findRoots(entry->program, arguments);
+        }
+        if (operation == "parse") {
+            return "ok " + entry->parsed;
+        }
+        std::string variable = arguments.empty() ? "x" : arguments;
+        return "ok " + symbolic(*entry, operation, variable);
+    } catch (const std::exception& e) {
+        return std::string("error ") + e.what();
+    }
+}
+
+std::vector<std::string> EvalServer::handleBatch(const std::vector<std::string>& requests) {
+    batches++;
+    std::vector<std::string> responses(requests.size());
+    ThreadPool& workers = options.pool ? *options.pool : ThreadPool::shared();
+    workers.parallelFor(requests.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            responses[i] = handle(requests[i]);
+        }
+    });
+    return responses;
+}
+
+void EvalServer::serve(std::istream& in, std::ostream& out) {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string request = trim(line);
+        if (request.empty()) {
+            continue;
+        }
+        if (request == "quit" || request == "exit") {
+            break;
+        }
+
+        std::vector<std::string> responses;
+        if (request.compare(0, 6, "batch ") == 0) {
+            size_t count = 0;
+            std::string size = trim(request.substr(6));
+            auto result = std::from_chars(size.data(), size.data() + size.size(), count);
+            if (result.ec != std::errc() || result.ptr != size.data() + size.size()) {
+                out << "error Bad batch size '" << size << "'\n" << std::flush;
+                continue;
+            }
+            if (count > options.maxBatch) {
+                out << "error Batch size " << count << " exceeds the limit of " << options.maxBatch << "\n"
+                    << std::flush;
+                continue;
+            }
+            // Grown as lines arrive, not reserved from the client's count
+            std::vector<std::string> group;
+            while (group.size() < count && std::getline(in, line)) {
+                group.push_back(line);
+            }
+            // handle() answers its own errors; this catches allocation
+            // failures so one group cannot end the connection
+            try {
+                responses = handleBatch(group);
+            } catch (const std::exception& e) {
+                responses.assign(group.size(), std::string("error ") + e.what());
+            }
+        } else {
+            try {
+                responses.push_back(handle(request));
+            } catch (const std::exception& e) {
+                responses.assign(1, std::string("error ") + e.what());
+            }
+        }
+
+        std::string text;
+        for (const auto& response : responses) {
+            text += response;
+            text += '\n';
+        }
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out.flush();
+    }
+}
+
+ServerStats EvalServer::getStats() const {
+    ServerStats stats;
+    stats.requests = requests;
+    stats.batches = batches;
+    LruCacheStats cacheStats = cache.getStats();
+    stats.cacheHits = cacheStats.hits;
+    stats.cacheMisses = cacheStats.misses;
+    stats.cacheEvictions = cacheStats.evictions;
+    stats.cachedExpressions = cacheStats.entries;
+    return stats;
+}
+
+void EvalServer::clearCache() {
+    cache.clear();
+}
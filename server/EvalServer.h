@@ -0,0 +1,95 @@
+#ifndef EVAL_SERVER_H
+#define EVAL_SERVER_H
+
+#include "../cas/SymbolicEngine.h"
+#include "../evaluator/CompiledExpression.h"
+#include "../util/LruCache.h"
+#include <atomic>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+struct ServerOptions {
+    size_t cacheCapacity = 4096;   // cached expressions; least recently used are evicted
+    ThreadPool* pool = nullptr;    // batch workers; null uses the shared pool
+    size_t maxBatch = 65536;       // larger batch requests are refused
+};
+
+struct ServerStats {
+    size_t requests = 0;
+    size_t batches = 0;
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+    size_t cacheEvictions = 0;
+    size_t cachedExpressions = 0;
+};
+
+// EvalServer - long-lived request loop for evaluate / differentiate /
+// integrate / simplify, so callers pay process startup and parsing once.
+//
+// Expressions are cached by source text: the first request for a formula
+// parses it, converts it to the symbolic DAG and compiles it; later requests
+// reuse all three, and symbolic results are memoized per entry. Batches are
+// spread over a thread pool. Evaluation only reads the compiled program and
+// runs concurrently; symbolic operations on one entry take its lock.
+//
+// Protocol (one request or response per line):
+//   eval <expr> [; name=value ...]      -> ok <number>
+//   diff <expr> [; variable]            -> ok <simplified derivative>
+//   integrate <expr> [; variable]       -> ok <simplified integral>
+//   simplify <expr>                     -> ok <canonical form>
+//   parse <expr>                        -> ok <parsed form>
+//   roots <expr> ; [var] lo hi [name=value ...]  -> ok <root> <root> ...
+//   stats                               -> ok requests=... hit_rate=... ...
+//   batch <n>   followed by n requests  -> n responses, in request order
+//                                          (error when n > maxBatch)
+//   quit                                -> ends serve()
+// Failures answer "error <message>"; variables default to x.
+class EvalServer {
+private:
+    struct CachedExpression {
+        std::string error;                 // parse failure; empty when usable
+        CompiledExpression program;        // every variable gets a slot
+        std::string parsed;
+
+        std::mutex mutex;                  // guards engine and results
+        SymbolicEngine engine;
+        std::unordered_map<std::string, std::string> results;   // "diff x" -> text
+    };
+
+    ServerOptions options;
+    LruCache<std::string, CachedExpression> cache;
+
+    std::atomic<size_t> requests;
+    std::atomic<size_t> batches;
+
+    std::shared_ptr<CachedExpression> lookup(const std::string& text);
+    std::string symbolic(CachedExpression& entry, const std::string& operation, const std::string& variable);
+
+public:
+    explicit EvalServer(const ServerOptions& options = ServerOptions());
+    EvalServer(const EvalServer&) = delete;
+    EvalServer& operator=(const EvalServer&) = delete;
+
+    // One request line to one response line (no trailing newline)
+    std::string handle(const std::string& request);
+
+    // Responses in request order; requests run in parallel on the pool
+    std::vector<std::string> handleBatch(const std::vector<std::string>& requests);
+
+    // Reads framed requests until EOF or quit, flushing after every response
+    // group. Safe to call from several threads (one per connection).
+    void serve(std::istream& in, std::ostream& out);
+
+    ServerStats getStats() const;
+    void clearCache();
+};
+
+#endif // EVAL_SERVER_H
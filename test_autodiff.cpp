@@ -0,0 +1,130 @@
+#include "cas/AutoDiff.h"
+#include "cas/Expression.h"
+#include "test_harness.h"
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+
+bool close(double expected, double actual) {
+    return (std::isnan(expected) && std::isnan(actual)) ||
+           std::abs(expected - actual) <= 1e-9 * std::max(1.0, std::abs(expected));
+}
+
+// Dual numbers against the symbolic derivative at a few points
+void testAgainstSymbolic(const std::string& text) {
+    std::cout << "Testing: " << text << std::endl;
+    Expression f = Expression::parse(text);
+    Expression df = f.differentiate("x");
+    bool values = true;
+    bool slopes = true;
+    for (double x : {-1.7, -0.3, 0.4, 1.0, 2.5}) {
+        std::map<std::string, double> vars{{"x", x}, {"y", 0.75}};
+        EvalStatus fStatus = EvalStatus::OK;
+        EvalStatus dfStatus = EvalStatus::OK;
+        f.evaluate(vars, fStatus);
+        double expectedSlope = df.evaluate(vars, dfStatus);
+        if (fStatus != EvalStatus::OK || dfStatus != EvalStatus::OK) continue;
+        DualValue dual = f.derivativeAt(vars, "x");
+        values = values && dual.value == f.symbolic().evaluate(vars);
+        slopes = slopes && close(expectedSlope, dual.derivative);
+    }
+    expect("value matches evaluate exactly", values);
+    expect("derivative matches differentiate", slopes);
+}
+
+void testDual() {
+    std::cout << "Testing forward mode" << std::endl;
+    testAgainstSymbolic("3*x^4 - 2*x^2 + x - 7");
+    testAgainstSymbolic("sin(x) * cos(2*x) / (x^2 + 1)");
+    testAgainstSymbolic("ln(x^2 + 1) * cos(x) - ln(y)");
+    testAgainstSymbolic("sin(x / 3) * x - -x * y");
+    testAgainstSymbolic("(x*y - 1)^3 / (y + x^2)");
+
+    Expression f = Expression::parse("x^x");
+    DualValue dual = f.derivativeAt({{"x", 2.0}}, "x");
+    expect("variable exponent value", dual.value == 4.0);
+    expect("variable exponent slope", close(4.0 * (std::log(2.0) + 1), dual.derivative));
+
+    bool threw = false;
+    try {
+        f.differentiate("x");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    std::cout << "  (symbolic differentiate " << (threw ? "rejects" : "accepts") << " x^x)" << std::endl;
+
+    dual = Expression::parse("log(x^2)").derivativeAt({{"x", 5.0}}, "x");
+    expect("log10 (no symbolic rule)", close(2 / (5 * std::log(10.0)), dual.derivative));
+    dual = Expression::parse("sqrt(x) + tan(x) + abs(x)").derivativeAt({{"x", 0.25}}, "x");
+    expect("sqrt, tan, abs", close(1.0 + 1 / std::pow(std::cos(0.25), 2) + 1, dual.derivative));
+
+    dual = Expression::parse("x^3").derivativeAt({{"x", -2.0}}, "x");
+    expect("negative base, constant exponent", dual.value == -8.0 && dual.derivative == 12.0);
+
+    dual = Expression::parse("2^x * y").derivativeAt({{"x", 3.0}, {"y", 5.0}}, "y");
+    expect("derivative along another variable", dual.value == 40.0 && dual.derivative == 8.0);
+
+    dual = Expression::parse("sqrt(x)").derivativeAt({{"x", 0.0}}, "x");
+    expect("non-differentiable point gives inf", dual.value == 0 && std::isinf(dual.derivative));
+}
+
+void testGradient() {
+    std::cout << "Testing reverse mode" << std::endl;
+    Expression f = Expression::parse("x^2 * y + sin(x * z) - z / y");
+    std::map<std::string, double> vars{{"x", 1.5}, {"y", -2.0}, {"z", 0.5}};
+
+    GradientValue g = f.gradientAt(vars);
+    expect("variables in map order", g.variables == std::vector<std::string>({"x", "y", "z"}));
+    expect("value", g.value == f.symbolic().evaluate(vars));
+    bool partials = true;
+    for (size_t i = 0; i < g.variables.size(); ++i) {
+        partials = partials && close(f.derivativeAt(vars, g.variables[i]).derivative, g.partials[i]);
+    }
+    expect("partials match forward mode", partials);
+
+    g = f.gradientAt(vars, {"z", "w"});
+    expect("selected variables", g.partials.size() == 2 && close(1.5 * std::cos(0.75) + 0.5, g.partials[0]) &&
+                                     g.partials[1] == 0);
+
+    // Shared subtrees are visited once per occurrence, like evaluate()
+    g = Expression::parse("(x + 1) * (x + 1) * (x + 1)").gradientAt({{"x", 1.0}});
+    expect("repeated subexpressions accumulate", g.value == 8.0 && g.partials[0] == 12.0);
+
+    g = Expression::parse("(-2)^3 * x").gradientAt({{"x", 1.0}});
+    expect("constant subtrees stay out of the sweep", g.value == -8.0 && g.partials[0] == -8.0);
+}
+
+void testErrors() {
+    std::cout << "Testing errors" << std::endl;
+    auto message = [](const std::string& text, const std::map<std::string, double>& vars) {
+        try {
+            Expression::parse(text).derivativeAt(vars, "x");
+        } catch (const std::runtime_error& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    expect("division by zero", message("1 / x", {{"x", 0.0}}) == "Division by zero");
+    expect("log domain", message("ln(x)", {{"x", -1.0}}) == "Natural log of non-positive number");
+    expect("undefined variable", message("x + y", {{"x", 1.0}}) == "Undefined variable: y");
+
+    bool threw = false;
+    try {
+        Expression::parse("1 / (x - 1)").gradientAt({{"x", 1.0}});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    expect("gradient throws too", threw);
+}
+
+int main() {
+    std::cout << "=== AutoDiff Test ===\n\n";
+
+    testDual();
+    testGradient();
+    testErrors();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+#include "parser/ExpressionParser.h"
+#include "cas/SymbolicEngine.h"
+#include "cas/ExpressionStore.h"
+#include "test_harness.h"
+#include <iostream>
+#include <map>
+#include <cmath>
+
+void check(const std::string& label, double expected, double actual) {
+    bool ok = (std::isnan(expected) && std::isnan(actual)) ||
+              std::abs(expected - actual) <= 1e-9 * std::max(1.0, std::abs(expected));
+    std::cout << "  " << (ok ? "ok   " : "FAIL ") << label << ": expected " << expected
+              << ", got " << actual << std::endl;
+    if (!ok) failures++;
+}
+
+void testCompiledAST(const std::string& expr, const std::map<std::string, double>& vars) {
+    std::cout << "Testing: " << expr << std::endl;
+
+    ExpressionParser parser;
+    if (!parser.parse(expr)) {
+        std::cout << "  Parse error: " << parser.getError() << std::endl;
+        failures++;
+        return;
+    }
+
+    CompiledExpression program = parser.compile();
+    std::vector<double> slots;
+    for (const auto& name : program.getSlotNames()) {
+        slots.push_back(vars.at(name));
+    }
+    check("AST bytecode", parser.evaluate(vars), program.eval(slots.data()));
+    check("map evaluate", parser.evaluate(vars), program.evaluate(vars));
+}
+
+void testCompiledSymbolic(const std::string& expr, const std::map<std::string, double>& vars) {
+    std::cout << "Testing symbolic: " << expr << std::endl;
+
+    SymbolicEngine engine;
+    if (!engine.parseFromString(expr)) {
+        std::cout << "  Parse error" << std::endl;
+        failures++;
+        return;
+    }
+
+    auto derivative = engine.differentiate("x");
+    CompiledExpression program(std::vector<std::string>{"x", "y"});
+    derivative->compile(program);
+    double slots[] = {vars.at("x"), vars.at("y")};
+    check("d/dx bytecode", derivative->evaluate(vars), program.eval(slots));
+    check("engine compile", engine.evaluate(vars), engine.compile().evaluate(vars));
+}
+
+void testBatch(const std::string& expr, double xMin, double xMax) {
+    std::cout << "Testing batch: " << expr << std::endl;
+
+    ExpressionParser parser;
+    if (!parser.parse(expr)) {
+        std::cout << "  Parse error: " << parser.getError() << std::endl;
+        failures++;
+        return;
+    }
+
+    const size_t n = 1001;
+    std::vector<double> xs(n), ys(n);
+    for (size_t i = 0; i < n; ++i) {
+        xs[i] = xMin + (xMax - xMin) * static_cast<double>(i) / (n - 1);
+    }
+    parser.evaluateBatch(xs.data(), ys.data(), n);
+
+    // Points that throw in scalar evaluation must come back as NaN
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double expected;
+        try {
+            expected = parser.evaluate({{"x", xs[i]}});
+        } catch (const std::exception&) {
+            expected = std::nan("");
+        }
+        bool ok = (std::isnan(expected) && std::isnan(ys[i])) || expected == ys[i] ||
+                  std::abs(expected - ys[i]) <= 1e-12 * std::max(1.0, std::abs(expected));
+        if (!ok) {
+            if (mismatches == 0) {
+                std::cout << "  first mismatch at x=" << xs[i] << ": expected " << expected
+                          << ", got " << ys[i] << std::endl;
+            }
+            mismatches++;
+        }
+    }
+    std::cout << "  " << (mismatches == 0 ? "ok   " : "FAIL ") << n << " points, "
+              << mismatches << " mismatches" << std::endl;
+    if (mismatches) failures++;
+}
+
+// Status mode must agree with the throwing evaluators: the same value where
+// they succeed, and NaN with the matching status where they throw
+void testStatusMode(const std::string& expr, double xMin, double xMax) {
+    std::cout << "Testing status mode: " << expr << std::endl;
+
+    ExpressionParser parser;
+    if (!parser.parse(expr)) {
+        std::cout << "  Parse error: " << parser.getError() << std::endl;
+        failures++;
+        return;
+    }
+    CompiledExpression program = parser.compile({"x"});
+
+    const size_t n = 401;
+    size_t mismatches = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double x = xMin + (xMax - xMin) * static_cast<double>(i) / (n - 1);
+        std::string thrown;
+        double expected = 0;
+        try {
+            expected = parser.evaluate({{"x", x}});
+        } catch (const std::exception& e) {
+            thrown = e.what();
+        }
+
+        EvalStatus treeStatus = EvalStatus::OK;
+        EvalStatus compiledStatus = EvalStatus::OK;
+        double tree = parser.evaluate({{"x", x}}, treeStatus);
+        double compiled = program.eval(&x, compiledStatus);
+
+        bool ok;
+        if (thrown.empty()) {
+            ok = treeStatus == EvalStatus::OK && compiledStatus == EvalStatus::OK &&
+                 std::abs(expected - tree) <= 1e-12 * std::max(1.0, std::abs(expected)) &&
+                 std::abs(expected - compiled) <= 1e-12 * std::max(1.0, std::abs(expected));
+        } else {
+            failed++;
+            ok = std::isnan(tree) && std::isnan(compiled) &&
+                 thrown == evalStatusMessage(treeStatus) && thrown == evalStatusMessage(compiledStatus);
+        }
+        if (!ok) {
+            if (mismatches == 0) {
+                std::cout << "  first mismatch at x=" << x << ": threw '" << thrown << "', statuses '"
+                          << evalStatusMessage(treeStatus) << "' / '" << evalStatusMessage(compiledStatus)
+                          << "'" << std::endl;
+            }
+            mismatches++;
+        }
+    }
+    std::cout << "  " << (mismatches == 0 ? "ok   " : "FAIL ") << n << " points, " << failed
+              << " domain errors, " << mismatches << " mismatches" << std::endl;
+    if (mismatches) failures++;
+}
+
+size_t countTranscendentals(const CompiledExpression& program) {
+    size_t count = 0;
+    for (const Instruction& ins : program.getCode()) {
+        switch (ins.op) {
+            case OpCode::SIN: case OpCode::COS: case OpCode::TAN:
+            case OpCode::LOG: case OpCode::LN: case OpCode::SQRT: case OpCode::POWER:
+                count++;
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+void testCommonSubexpressions(const std::string& expr, int order, double maxRatio) {
+    std::cout << "Testing CSE: order " << order << " derivative of " << expr << std::endl;
+
+    SymbolicEngine engine;
+    if (!engine.parseFromString(expr)) {
+        std::cout << "  Parse error" << std::endl;
+        failures++;
+        return;
+    }
+
+    const ExpressionStore& store = engine.getStore();
+    const ExprNode* derivative = engine.differentiateNode("x", order);
+    auto tree = store.toSymbolic(derivative);
+
+    CompiledExpression plain(std::vector<std::string>{"x", "y"});
+    tree->compile(plain);
+    CompiledExpression shared = store.compile(derivative, {"x", "y"});
+
+    size_t plainCalls = countTranscendentals(plain);
+    size_t sharedCalls = countTranscendentals(shared);
+    std::cout << "  transcendental ops: " << plainCalls << " -> " << sharedCalls
+              << ", instructions: " << plain.size() << " -> " << shared.size()
+              << ", temps: " << shared.getTempCount() << std::endl;
+    if (sharedCalls > maxRatio * plainCalls) {
+        std::cout << "  FAIL expected at most " << maxRatio << " of the transcendental ops" << std::endl;
+        failures++;
+    }
+
+    std::vector<double> xs, ys;
+    for (int i = 0; i < 600; ++i) {
+        xs.push_back(0.05 + i * 0.011);
+        ys.push_back(-0.4);
+    }
+    const double* columns[] = {xs.data(), ys.data()};
+    std::vector<double> out(xs.size());
+    shared.evalBatch(columns, out.data(), xs.size());
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        double slots[] = {xs[i], ys[i]};
+        double expected = tree->evaluate({{"x", xs[i]}, {"y", ys[i]}});
+        double scalar = shared.eval(slots);
+        double tolerance = 1e-9 * std::max(1.0, std::abs(expected));
+        if (std::abs(expected - scalar) > tolerance || std::abs(expected - out[i]) > tolerance) {
+            mismatches++;
+        }
+    }
+    check("points differing from the tree", 0.0, static_cast<double>(mismatches));
+}
+
+void testErrors() {
+    std::cout << "Testing error propagation" << std::endl;
+
+    ExpressionParser parser;
+    parser.parse("1 / (x - 2)");
+    CompiledExpression program = parser.compile({"x"});
+    double x = 2.0;
+    try {
+        program.eval(&x);
+        std::cout << "  FAIL expected division by zero" << std::endl;
+        failures++;
+    } catch (const std::exception& e) {
+        std::cout << "  ok    caught: " << e.what() << std::endl;
+    }
+
+    try {
+        program.evaluate({});
+        std::cout << "  FAIL expected undefined variable" << std::endl;
+        failures++;
+    } catch (const std::exception& e) {
+        std::cout << "  ok    caught: " << e.what() << std::endl;
+    }
+
+    // Status mode keeps the first failure and still finishes
+    EvalStatus status = EvalStatus::OK;
+    double result = program.evaluate({}, status);
+    std::cout << "  " << (std::isnan(result) && status == EvalStatus::UNDEFINED_VARIABLE ? "ok   " : "FAIL ")
+              << "status: " << evalStatusMessage(status) << std::endl;
+    if (!std::isnan(result) || status != EvalStatus::UNDEFINED_VARIABLE) failures++;
+
+    parser.parse("sqrt(x - 3) + ln(x)");
+    status = EvalStatus::OK;
+    parser.evaluate({{"x", -1.0}}, status);
+    std::cout << "  " << (status == EvalStatus::SQRT_DOMAIN ? "ok   " : "FAIL ")
+              << "first failure wins: " << evalStatusMessage(status) << std::endl;
+    if (status != EvalStatus::SQRT_DOMAIN) failures++;
+
+    status = EvalStatus::OK;
+    ExpressionParser().evaluate({}, status);
+    if (status != EvalStatus::NO_EXPRESSION) failures++;
+}
+
+int main() {
+    std::cout << "=== Compiled Expression Test ===\n\n";
+
+    std::map<std::string, double> vars = {{"x", 1.7}, {"y", -0.4}};
+
+    testCompiledAST("2 + 3 * 4", vars);
+    testCompiledAST("2 ^ 3 ^ 2", vars);
+    testCompiledAST("x ^ 2 + 2 * x + 1", vars);
+    testCompiledAST("-x + +y", vars);
+    testCompiledAST("sin(x) * cos(y) + tan(x / 3)", vars);
+    testCompiledAST("sqrt(x * x + y * y) - abs(y)", vars);
+    testCompiledAST("log(x * 100) + ln(x)", vars);
+    testCompiledAST("2x sin(y)", vars);
+
+    testCompiledSymbolic("x^3 * sin(x)", vars);
+    testCompiledSymbolic("x / (x + y)", vars);
+    testCompiledSymbolic("ln(x) + cos(x) * y", vars);
+
+    testBatch("x^3 - 2*x + 1", -10, 10);
+    testBatch("sin(x) * cos(2x) + tan(x / 7)", -50, 50);
+    testBatch("1 / x + x^-2", -3, 3);
+    testBatch("ln(x) + log(x^2) - sqrt(x)", -5, 1e6);
+    testBatch("abs(x)^1.5 - 2^x", -20, 20);
+    testBatch("sin(x) + cos(x)", -1e7, 1e7);
+
+    testStatusMode("1 / x + ln(x)", -2, 2);
+    testStatusMode("sqrt(4 - x^2) / (x - 1)", -3, 3);
+    testStatusMode("log(x) * sqrt(x) - 1 / (x^2 - 1)", -2, 2);
+
+    testCommonSubexpressions("sin(x) * cos(x) / x", 1, 0.75);
+    testCommonSubexpressions("x^3 * sin(x) * y", 2, 0.5);
+    testCommonSubexpressions("ln(x) / (x + y)", 3, 0.5);
+
+    testErrors();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include "grapher/ConsoleGrapher.h"
+#include "test_harness.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal terminal: applies cursor moves, clears and printed characters to a
+// screen of rows, so incremental output can be checked against the frame
+struct Terminal {
+    std::vector<std::string> rows;
+    int row = 0;
+    int column = 0;
+
+    Terminal(int width, int height) : rows(height + 1, std::string(width, ' ')) {}
+
+    void apply(const std::string& output) {
+        for (size_t i = 0; i < output.size(); ++i) {
+            char c = output[i];
+            if (c == '\x1b' && i + 1 < output.size() && output[i + 1] == '[') {
+                size_t end = output.find_first_of("HJ", i + 2);
+                std::string args = output.substr(i + 2, end - i - 2);
+                if (output[end] == 'J') {
+                    for (auto& line : rows) line.assign(line.size(), ' ');
+                } else if (args.empty()) {
+                    row = column = 0;
+                } else {
+                    size_t semicolon = args.find(';');
+                    row = std::stoi(args.substr(0, semicolon)) - 1;
+                    column = std::stoi(args.substr(semicolon + 1)) - 1;
+                }
+                i = end;
+            } else if (c == '\n') {
+                ++row;
+                column = 0;
+            } else {
+                rows[row][column++] = c;
+            }
+        }
+    }
+
+    std::string screen(int height) const {
+        std::string text;
+        for (int y = 0; y < height; ++y) text += rows[y] + "\n";
+        return text;
+    }
+};
+
+ConsoleGrapher::PlotSettings smallSettings() {
+    ConsoleGrapher::PlotSettings settings;
+    settings.width = 60;
+    settings.height = 20;
+    settings.xMin = -6.0;
+    settings.xMax = 6.0;
+    settings.yMin = -2.0;
+    settings.yMax = 2.0;
+    return settings;
+}
+
+void testFrameLayout() {
+    std::cout << "Testing frame layout" << std::endl;
+
+    ConsoleGrapher grapher(smallSettings());
+    grapher.addFunction("sin(x)", "sine", '*');
+    std::ostringstream sink;
+    grapher.plotIncremental(sink);
+    const std::vector<char>& frame = grapher.getFrame();
+
+    expect("one contiguous buffer of height rows", frame.size() == 20 * 61);
+    bool rowsEnd = true;
+    for (size_t i = 60; i < frame.size(); i += 61) rowsEnd = rowsEnd && frame[i] == '\n';
+    expect("every row ends in a newline", rowsEnd);
+
+    grapher.clearFunctions();
+    grapher.plotIncremental(sink);
+    std::string text(grapher.getFrame().begin(), grapher.getFrame().end());
+    expect("replotting starts from a clear buffer", text.find('*') == std::string::npos);
+}
+
+void testIncrementalRedraw() {
+    std::cout << "Testing incremental redraw" << std::endl;
+
+    ConsoleGrapher grapher(smallSettings());
+    grapher.addFunction("sin(x)", "sine", '*');
+    Terminal terminal(60, 20);
+
+    std::ostringstream first;
+    size_t fullBytes = grapher.plotIncremental(first);
+    terminal.apply(first.str());
+    std::string frame(grapher.getFrame().begin(), grapher.getFrame().end());
+    expect("first frame is sent whole", fullBytes == first.str().size() && fullBytes > frame.size());
+    expect("terminal shows the first frame", terminal.screen(20) == frame);
+
+    std::ostringstream unchanged;
+    expect("unchanged frame sends nothing", grapher.plotIncremental(unchanged) == 0 && unchanged.str().empty());
+
+    grapher.setPlotRange(-5.8, 6.2, -2.0, 2.0);
+    std::ostringstream panned;
+    size_t diffBytes = grapher.plotIncremental(panned);
+    terminal.apply(panned.str());
+    frame.assign(grapher.getFrame().begin(), grapher.getFrame().end());
+    std::cout << "  full frame: " << fullBytes << " bytes, small pan: " << diffBytes << " bytes" << std::endl;
+    expect("small pan sends less than a full frame", diffBytes > 0 && diffBytes < fullBytes);
+    expect("terminal shows the panned frame", terminal.screen(20) == frame);
+
+    grapher.addFunction("x^2 - 1", "parabola", '#');
+    std::ostringstream added;
+    grapher.plotIncremental(added);
+    terminal.apply(added.str());
+    frame.assign(grapher.getFrame().begin(), grapher.getFrame().end());
+    expect("terminal shows an added function", terminal.screen(20) == frame);
+
+    grapher.setDisplaySize(40, 10);
+    std::ostringstream resized;
+    grapher.plotIncremental(resized);
+    expect("resize sends a full frame", resized.str().find("\x1b[2J") != std::string::npos);
+
+    grapher.resetIncremental();
+    std::ostringstream reset;
+    grapher.plotIncremental(reset);
+    expect("reset sends a full frame", reset.str().find("\x1b[2J") != std::string::npos);
+}
+
+int main() {
+    std::cout << "=== Console Frame Test ===\n\n";
+
+    testFrameLayout();
+    testIncrementalRedraw();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "cas/ExpressionCache.h"
+#include "cas/SymbolicEngine.h"
+#include "util/LruCache.h"
+#include "test_harness.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+void testLruCache() {
+    std::cout << "Testing LRU cache" << std::endl;
+
+    LruCache<std::string, int> cache(3);
+    cache.insert("a", std::make_shared<int>(1), 10);
+    std::shared_ptr<int> held = cache.insert("b", std::make_shared<int>(2), 10);
+    cache.insert("c", std::make_shared<int>(3), 10);
+    expect("hit returns the value", cache.find("a") && *cache.find("a") == 1);
+
+    cache.insert("d", std::make_shared<int>(4), 10);
+    expect("least recently used entry is evicted", !cache.find("b") && cache.find("a") && cache.find("c"));
+    expect("evicted values stay alive for holders", held && *held == 2);
+
+    std::shared_ptr<int> first = cache.insert("a", std::make_shared<int>(99), 10);
+    expect("racing insert keeps the existing value", *first == 1);
+
+    LruCacheStats stats = cache.getStats();
+    expect("counts entries and bytes", stats.entries == 3 && stats.bytes == 30);
+    expect("counts evictions", stats.evictions == 1);
+    expect("hit rate", stats.hits == 4 && stats.misses == 1 && std::abs(stats.hitRate() - 0.8) < 1e-12);
+
+    cache.setCapacity(10, 15);
+    expect("byte limit evicts", cache.getStats().entries == 1);
+    cache.clear();
+    expect("clear resets", cache.getStats().entries == 0 && cache.getStats().hits == 0);
+}
+
+void testNormalize() {
+    std::cout << "Testing normalization" << std::endl;
+
+    expect("spaces around operators dropped", ExpressionCache::normalize("  x  +  2 * y ") == "x+2*y");
+    expect("spaces between words kept", ExpressionCache::normalize("2   x") == "2 x");
+    expect("tabs and newlines", ExpressionCache::normalize("sin (\tx )\n") == "sin(x)");
+}
+
+void testExpressionCache() {
+    std::cout << "Testing expression cache" << std::endl;
+
+    ExpressionCache cache(100);
+    auto a = cache.get("x^2 + sin(x)");
+    auto b = cache.get("x^2+sin( x )");
+    expect("equivalent spellings share one bundle", a && a == b);
+    expect("bundle holds every form", a->ast && a->symbolic && !a->program.empty());
+    expect("bundle evaluates", a->program.evaluate({{"x", 2.0}}) == 4 + std::sin(2.0));
+    expect("bundle has a size", a->bytes > sizeof(ParsedExpression));
+
+    std::string error;
+    auto bad = cache.get("  2 + * x", &error);
+    std::cout << "  error: " << error << std::endl;
+    expect("parse failure returns null", bad == nullptr);
+    expect("parser error is reported", error == "Unexpected token: *");
+    expect("failures are not cached", cache.getStats().entries == 1);
+
+    LruCacheStats stats = cache.getStats();
+    std::cout << "  hits " << stats.hits << ", misses " << stats.misses << ", " << stats.bytes << " bytes" << std::endl;
+    expect("stats report hits and bytes", stats.hits == 1 && stats.misses == 2 && stats.bytes == a->bytes);
+}
+
+void testEngineUsesCache() {
+    std::cout << "Testing SymbolicEngine::parseFromString" << std::endl;
+
+    ExpressionCache::shared().clear();
+    SymbolicEngine first, second;
+    first.parseFromString("x^3 - 2*x");
+    second.parseFromString("x^3 - 2 * x");
+    expect("engines share the parsed tree", first.getExpression() == second.getExpression());
+    expect("second parse is a hit", ExpressionCache::shared().getStats().hits == 1);
+    expect("results are unchanged", second.differentiate("x")->toString() == first.differentiate("x")->toString());
+
+    SymbolicEngine failed;
+    expect("parse errors still fail", !failed.parseFromString("x +") && !failed.hasExpression());
+}
+
+void testConcurrentLookups() {
+    std::cout << "Testing concurrent lookups" << std::endl;
+
+    ExpressionCache cache(64);
+    std::vector<std::string> formulas;
+    for (int i = 0; i < 200; ++i) {
+        formulas.push_back("x^" + std::to_string(i % 50) + " + " + std::to_string(i % 7));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> wrong(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < 20; ++round) {
+                for (size_t i = t; i < formulas.size(); i += 3) {
+                    auto parsed = cache.get(formulas[i]);
+                    double x = 1.5;
+                    double expected = std::pow(x, static_cast<double>(i % 50)) + static_cast<double>(i % 7);
+                    if (!parsed || std::abs(parsed->program.evaluate({{"x", x}}) - expected) > 1e-9 * expected) {
+                        wrong[t]++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    expect("every lookup is correct", wrong == std::vector<int>(4, 0));
+    expect("capacity holds under contention", cache.getStats().entries <= 64 && cache.getStats().evictions > 0);
+}
+
+int main() {
+    std::cout << "=== Expression Cache Test ===\n\n";
+
+    testLruCache();
+    testNormalize();
+    testExpressionCache();
+    testEngineUsesCache();
+    testConcurrentLookups();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
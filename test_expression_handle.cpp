@@ -0,0 +1,115 @@
+#include "cas/Expression.h"
+#include "cas/SymbolicEngine.h"
+#include "test_harness.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+bool sameValue(double a, double b) {
+    return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+void testHandle() {
+    std::cout << "Testing expression handles" << std::endl;
+
+    Expression f = Expression::parse("x^2 * sin(y) + 1");
+    Expression copy = f;
+    expect("copies share one bundle", &copy.symbolic() == &f.symbolic() && f.useCount() >= 2);
+    expect("evaluates", f.evaluate({{"x", 2.0}, {"y", 0.5}}) == 4 * std::sin(0.5) + 1);
+    expect("keeps the normalized text", f.text() == "x^2*sin(y)+1");
+
+    EvalStatus status = EvalStatus::OK;
+    double value = Expression::parse("1 / x").evaluate({{"x", 0.0}}, status);
+    expect("status mode", std::isnan(value) && status == EvalStatus::DIVISION_BY_ZERO);
+
+    bool threw = false;
+    try {
+        Expression::parse("2 * (x");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    expect("syntax errors throw", threw);
+
+    Expression out;
+    std::string error;
+    expect("tryParse reports errors", !Expression::tryParse("sin(", out, &error) && !out.valid() && !error.empty());
+
+    threw = false;
+    try {
+        Expression().evaluate();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    expect("empty handle throws", threw);
+
+    Expression d = f.differentiate("x");
+    expect("derivative handle", d.evaluate({{"x", 3.0}, {"y", 0.5}}) == SymbolicEngine::convertASTToSymbolic(
+        Expression::parse("2 * x * sin(y)").ast())->evaluate({{"x", 3.0}, {"y", 0.5}}));
+    expect("derivative has no AST", d.ast() == nullptr && !d.program().empty());
+
+    SymbolicEngine engine;
+    expect("engine loads a handle without parsing", engine.parseFromExpression(f) && engine.getExpression() == &f.symbolic());
+    expect("engine calculus on the shared tree", engine.differentiate("y")->evaluate({{"x", 2.0}, {"y", 0.0}}) == 4.0);
+
+    ExpressionCache::shared().clear();
+    expect("handles outlive the cache", f.evaluate({{"x", 1.0}, {"y", 0.0}}) == 1.0);
+}
+
+void testConcurrentEvaluation() {
+    std::cout << "Testing concurrent evaluation of one handle" << std::endl;
+
+    Expression f = Expression::parse("sin(x) * x^3 - ln(x + 5) / (x - 2)");
+    const size_t n = 20000;
+    std::vector<double> xs(n);
+    for (size_t i = 0; i < n; ++i) xs[i] = -4.0 + 8.0 * i / n;
+
+    std::vector<double> expected(n);
+    for (size_t i = 0; i < n; ++i) {
+        EvalStatus status = EvalStatus::OK;
+        expected[i] = f.evaluate({{"x", xs[i]}}, status);
+    }
+    std::vector<double> batchExpected(n);
+    f.evaluateBatch(xs.data(), batchExpected.data(), n);
+
+    const int threadCount = 8;
+    std::vector<int> mismatches(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            Expression local = f;   // a reference count, not a clone
+            std::vector<double> batch(n);
+            local.evaluateBatch(xs.data(), batch.data(), n);
+            for (size_t i = t; i < n; i += threadCount) {
+                EvalStatus status = EvalStatus::OK;
+                if (!sameValue(local.evaluate({{"x", xs[i]}}, status), expected[i])) mismatches[t]++;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (!sameValue(batch[i], batchExpected[i])) mismatches[t]++;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    expect("every thread matches serial evaluation", mismatches == std::vector<int>(threadCount, 0));
+    expect("threads released their copies", f.useCount() == 2);   // f and the cache entry
+
+    bool threw = false;
+    try {
+        double x = 1.0, y;
+        Expression::parse("x + y").evaluateBatch(&x, &y, 1);
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()) == "Undefined variable: y";
+    }
+    expect("batch rejects other variables", threw);
+}
+
+int main() {
+    std::cout << "=== Expression Handle Test ===\n\n";
+
+    testHandle();
+    testConcurrentEvaluation();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+#include "cas/SymbolicEngine.h"
+#include "cas/ExpressionStore.h"
+#include "test_harness.h"
+#include <iostream>
+#include <map>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+void testInterning() {
+    std::cout << "Testing interning" << std::endl;
+
+    ExpressionStore store;
+    const ExprNode* a = store.binary(SymbolicBinaryOp::OpType::ADD, store.variable("x"), store.number(1.0));
+    const ExprNode* b = store.binary(SymbolicBinaryOp::OpType::ADD, store.variable("x"), store.number(1.0));
+    const ExprNode* c = store.binary(SymbolicBinaryOp::OpType::ADD, store.number(1.0), store.variable("x"));
+
+    expect("identical structure shares one node", a == b);
+    expect("different structure gets a different node", a != c);
+    expect("store holds 4 unique nodes", store.nodeCount() == 4);
+    expect("0.0 and -0.0 stay distinct", store.number(0.0) != store.number(-0.0));
+}
+
+// Counts nodes through visitSymbolic, exercising every concrete type
+struct NodeCounter {
+    size_t operator()(const SymbolicNumber&) const { return 1; }
+    size_t operator()(const SymbolicVariable&) const { return 1; }
+    size_t operator()(const SymbolicBinaryOp& op) const {
+        return 1 + visitSymbolic(*op.left, *this) + visitSymbolic(*op.right, *this);
+    }
+    size_t operator()(const SymbolicUnaryOp& op) const { return 1 + visitSymbolic(*op.operand, *this); }
+    size_t operator()(const SymbolicFunction& func) const {
+        size_t total = 1;
+        for (const auto& arg : func.arguments) total += visitSymbolic(*arg, *this);
+        return total;
+    }
+};
+
+void testKindDispatch() {
+    std::cout << "Testing kind-tagged dispatch" << std::endl;
+
+    ExpressionParser parser;
+    parser.parse("2 * sin(x) - -y");
+    const ASTNode* ast = parser.getAST();
+    expect("AST root is a binary op", ast->kind() == ASTKind::BINARY_OP);
+    expect("astCast matches the kind", astCast<BinaryOpNode>(ast) != nullptr);
+    expect("astCast rejects other kinds", astCast<NumberNode>(ast) == nullptr);
+
+    SymbolicEngine engine;
+    engine.parseFromString("2 * sin(x) - -y");
+    const SymbolicExpression* expr = engine.getExpression();
+    const SymbolicBinaryOp* root = symbolicCast<SymbolicBinaryOp>(expr);
+    expect("symbolic root is a binary op", root && root->op == SymbolicBinaryOp::OpType::SUBTRACT);
+    expect("symbolicCast rejects other kinds", symbolicCast<SymbolicFunction>(expr) == nullptr);
+    expect("visitor reaches every node", visitSymbolic(*expr, NodeCounter{}) == 7);
+}
+
+void testDerivativeMatchesTree(const std::string& expr) {
+    std::cout << "Testing DAG derivative: " << expr << std::endl;
+
+    SymbolicEngine engine;
+    if (!engine.parseFromString(expr)) {
+        std::cout << "  Parse error" << std::endl;
+        failures++;
+        return;
+    }
+
+    auto treeDerivative = engine.differentiate("x");
+    const ExprNode* dagDerivative = engine.differentiateNode("x");
+    std::string dagString = engine.getStore().toString(dagDerivative);
+    std::cout << "  d/dx: " << dagString << std::endl;
+    expect("matches tree derivative", dagString == treeDerivative->toString());
+
+    std::map<std::string, double> vars = {{"x", 0.7}, {"y", 1.3}};
+    double expected = treeDerivative->evaluate(vars);
+    double actual = engine.getStore().toSymbolic(dagDerivative)->evaluate(vars);
+    expect("evaluates to the same value", std::abs(expected - actual) < 1e-12);
+}
+
+void testRepeatedDerivativeGrowth() {
+    std::cout << "Testing fifth derivative of sin(x)*cos(x)/x" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("sin(x)*cos(x)/x");
+
+    const ExprNode* derivative = engine.differentiateNode("x", 5);
+    const ExpressionStore& store = engine.getStore();
+    double treeNodes = ExpressionStore::treeSize(derivative);
+    size_t dagNodes = ExpressionStore::dagSize(derivative);
+
+    std::cout << "  tree nodes: " << treeNodes << std::endl;
+    std::cout << "  DAG nodes:  " << dagNodes << std::endl;
+    std::cout << "  store:      " << store.nodeCount() << " nodes, "
+              << store.bytesUsed() << " bytes used" << std::endl;
+
+    expect("DAG is far smaller than the tree", dagNodes * 10 < treeNodes);
+    expect("store stays under 64 KB", store.bytesUsed() < 64 * 1024);
+
+    // Spot-check against the tree derivative, which is built by cloning
+    auto tree = engine.getExpression()->clone();
+    for (int i = 0; i < 5; ++i) {
+        tree = tree->differentiate("x");
+    }
+    std::map<std::string, double> vars = {{"x", 1.1}};
+    double expected = tree->evaluate(vars);
+    double actual = store.toSymbolic(derivative)->evaluate(vars);
+    expect("fifth derivative evaluates like the tree", std::abs(expected - actual) < 1e-9 * std::abs(expected));
+}
+
+// Runs op and returns its result string, or the exception message prefixed with "error: "
+template <typename Op>
+std::string outcome(Op op) {
+    try {
+        return op();
+    } catch (const std::exception& e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+void testCalculusMatchesTree(const std::string& expr) {
+    std::cout << "Testing DAG simplify/integrate: " << expr << std::endl;
+
+    SymbolicEngine engine;
+    if (!engine.parseFromString(expr)) {
+        std::cout << "  Parse error" << std::endl;
+        failures++;
+        return;
+    }
+
+    const SymbolicExpression* tree = engine.getExpression();
+    ExpressionStore& store = engine.getStore();
+
+    std::string treeSimplified = outcome([&] { return tree->simplify()->toString(); });
+    std::string dagSimplified = outcome([&] { return store.toString(store.simplify(engine.getNode())); });
+    std::cout << "  simplify:  " << dagSimplified << std::endl;
+    expect("simplify matches tree", dagSimplified == treeSimplified);
+
+    std::string treeIntegral = outcome([&] { return tree->integrate("x")->toString(); });
+    std::string dagIntegral = outcome([&] { return store.toString(engine.integrateNode("x")); });
+    std::cout << "  integrate: " << dagIntegral << std::endl;
+    expect("integrate matches tree", dagIntegral == treeIntegral);
+}
+
+void testMemoCache() {
+    std::cout << "Testing memo cache counters" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("sin(x^2) * cos(x^2) + sin(x^2)");
+    const ExpressionStore& store = engine.getStore();
+
+    // The shared x^2 and sin(x^2) subtrees are differentiated once
+    const ExprNode* first = engine.differentiateNode("x");
+    ExpressionStore::CacheStats afterFirst = store.getCacheStats();
+    std::cout << "  first derivative:  " << afterFirst.differentiate.hits << " hits, "
+              << afterFirst.differentiate.misses << " misses" << std::endl;
+    expect("shared subtrees hit the cache", afterFirst.differentiate.hits > 0);
+
+    // Asking again is a single lookup
+    const ExprNode* second = engine.differentiateNode("x");
+    ExpressionStore::CacheStats afterSecond = store.getCacheStats();
+    expect("repeated derivative returns the same node", first == second);
+    expect("repeated derivative is one hit", afterSecond.differentiate.hits == afterFirst.differentiate.hits + 1);
+    expect("repeated derivative adds no misses", afterSecond.differentiate.misses == afterFirst.differentiate.misses);
+
+    // Variables are part of the key
+    engine.differentiateNode("y");
+    expect("other variable misses", store.getCacheStats().differentiate.misses > afterSecond.differentiate.misses);
+
+    engine.getStore().simplify(engine.getNode());
+    engine.getStore().simplify(engine.getNode());
+    expect("repeated simplify hits", store.getCacheStats().simplify.hits > 0);
+
+    engine.getStore().clearCache();
+    expect("clearCache resets counters", store.getCacheStats().entries == 0 &&
+                                         store.getCacheStats().differentiate.hits == 0);
+}
+
+// const members share the engine's store; concurrent callers must see the
+// answers a single caller gets
+void testConstEngineIsShareable() {
+    std::cout << "Testing concurrent const calls on one engine" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("3 * x^2 + cos(x) + y");
+    const SymbolicEngine& shared = engine;
+    std::vector<std::string> variables = {"x", "y"};
+
+    std::vector<std::string> results(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            const std::string& variable = variables[t % 2];
+            std::string text;
+            for (int i = 0; i < 20; ++i) {
+                text = shared.differentiate(variable)->toString() + " | " + shared.simplify()->toString() + " | " +
+                       shared.integrate("x")->toString();
+                shared.compile({"x", "y"});
+            }
+            results[t] = text;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    SymbolicEngine serial;
+    serial.parseFromString("3 * x^2 + cos(x) + y");
+    bool same = true;
+    for (size_t t = 0; t < results.size(); ++t) {
+        const std::string& variable = variables[t % 2];
+        same = same && results[t] == serial.differentiate(variable)->toString() + " | " +
+                                         serial.simplify()->toString() + " | " + serial.integrate("x")->toString();
+    }
+    expect("concurrent results match a serial engine", same);
+}
+
+int main() {
+    std::cout << "=== Expression Store Test ===\n\n";
+
+    testInterning();
+    testKindDispatch();
+    testDerivativeMatchesTree("x^3 * sin(x)");
+    testDerivativeMatchesTree("x / (x + y)");
+    testDerivativeMatchesTree("ln(x) + cos(x) * y");
+    testDerivativeMatchesTree("x^2 / (1 + x) - sin(2x)");
+    testRepeatedDerivativeGrowth();
+    testCalculusMatchesTree("0 + x * 1");
+    testCalculusMatchesTree("--x + 2 * 3");
+    testCalculusMatchesTree("x^2 + 3x - 5");
+    testCalculusMatchesTree("sin(x) + cos(x) + ln(x)");
+    testCalculusMatchesTree("2 / x");
+    testCalculusMatchesTree("x^-1");
+    testCalculusMatchesTree("y * x + sin(0)");
+    testCalculusMatchesTree("x * x");
+    testCalculusMatchesTree("x / 0");
+    testMemoCache();
+    testConstEngineIsShareable();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+#include "cas/FormulaPack.h"
+#include "cas/ExpressionStore.h"
+#include "test_harness.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const std::vector<std::string> kFormulas = {
+    "x^2 + 3x",
+    "sin(x) * y + x^2",
+    "sqrt(x) / 0.5",
+    "1/3 + x",
+    "2^10",
+    "ln(x) * (x + 1) + (x + 1)^2",
+};
+
+std::vector<char> buildImage() {
+    FormulaPackWriter writer;
+    for (const std::string& text : kFormulas) writer.add(text);
+    return writer.serialize();
+}
+
+bool throwsOnOpen(std::vector<char> image) {
+    try {
+        FormulaPack::fromBytes(std::move(image));
+        return false;
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+}
+
+void testRoundTrip() {
+    std::cout << "Testing round trip" << std::endl;
+    FormulaPack pack = FormulaPack::fromBytes(buildImage());
+    expect("all formulas present", pack.size() == kFormulas.size());
+
+    bool sources = true;
+    bool values = true;
+    for (size_t i = 0; i < kFormulas.size(); ++i) {
+        sources = sources && pack.source(i) == kFormulas[i];
+        SymbolicEngine engine;
+        engine.parseFromString(kFormulas[i]);
+        CompiledExpression reference = engine.compile();
+        std::map<std::string, double> point = {{"x", 1.75}, {"y", -0.5}};
+        values = values && pack.evaluate(i, point) == reference.evaluate(point);
+    }
+    expect("sources kept", sources);
+    expect("values match the compiled expressions", values);
+    expect("slot names", pack.slotCount(1) == 2 && pack.slotName(1, 0) == "x" && pack.slotName(1, 1) == "y");
+    expect("constant formula", pack.slotCount(4) == 0 && pack.eval(4, nullptr) == 1024);
+
+    EvalStatus status = EvalStatus::OK;
+    double x = -1;
+    double value = pack.eval(5, &x, status);
+    expect("status mode in place", std::isnan(value) && status == EvalStatus::LN_DOMAIN);
+
+    // Whole batches run on the mapped bytecode too
+    std::vector<double> xs = {0.5, 1, 2, 4};
+    std::vector<double> out(xs.size());
+    const double* columns[] = {xs.data()};
+    pack.program(2).evalBatch(columns, out.data(), xs.size());
+    expect("batch evaluation", out[3] == 4 && out[0] == std::sqrt(0.5) / 0.5);
+
+    size_t treeNodes = 0;
+    for (const std::string& text : kFormulas) {
+        ExpressionStore store;
+        SymbolicEngine engine;
+        engine.parseFromString(text);
+        treeNodes += ExpressionStore::dagSize(store.intern(engine.getExpression()));
+    }
+    expect("shared subexpressions stored once", pack.nodeCount() < treeNodes);
+}
+
+void testLoad() {
+    std::cout << "Testing DAG loading" << std::endl;
+    FormulaPack pack = FormulaPack::fromBytes(buildImage());
+    ExpressionStore store;
+    bool same = true;
+    for (size_t i = 0; i < pack.size(); ++i) {
+        SymbolicEngine engine;
+        engine.parseFromString(kFormulas[i]);
+        ExpressionStore reference;
+        same = same && store.toString(pack.load(i, store)) == reference.toString(reference.intern(engine.getExpression()));
+    }
+    expect("loaded DAGs print like the originals", same);
+
+    const ExprNode* half = pack.load(2, store)->child(1);
+    expect("exact constants survive", half->kind == ExprNode::Kind::NUMBER && half->exact &&
+                                          *half->exact == Number::rational(1, 2) && half->exact->isExact());
+    expect("loading twice gives the same node", pack.load(5, store) == pack.load(5, store));
+    expect("derivatives from a loaded DAG",
+           store.evaluate(store.differentiate(pack.load(0, store), "x"), {{"x", 2}}) == 7);
+}
+
+void testFileAndRelocation() {
+    std::cout << "Testing mapped files and relocation" << std::endl;
+    std::string path = "test_formula_pack.bin";
+    {
+        FormulaPackWriter writer;
+        for (const std::string& text : kFormulas) writer.add(text);
+        writer.write(path);
+    }
+    FormulaPack mapped = FormulaPack::open(path);
+    expect("mapped pack", mapped.size() == kFormulas.size() && mapped.evaluate(0, {{"x", 2}}) == 10);
+    FormulaPack copy = mapped;
+    expect("copies share the mapping", copy.byteSize() == mapped.byteSize() && copy.evaluate(3, {{"x", 0}}) == 1.0 / 3);
+    std::remove(path.c_str());
+
+    // Position independent: the same bytes anywhere else evaluate alike
+    std::vector<char> image = buildImage();
+    std::vector<uint64_t> elsewhere(image.size() / sizeof(uint64_t));
+    std::memcpy(elsewhere.data(), image.data(), image.size());
+    FormulaPack moved = FormulaPack::view(elsewhere.data(), image.size());
+    expect("relocated image", moved.evaluate(1, {{"x", 1}, {"y", 2}}) == std::sin(1.0) * 2 + 1);
+
+    bool missing = false;
+    try {
+        FormulaPack::open("no_such_formula_pack.bin");
+    } catch (const std::runtime_error&) {
+        missing = true;
+    }
+    expect("missing file throws", missing);
+}
+
+void testValidation() {
+    std::cout << "Testing validation" << std::endl;
+    std::vector<char> image = buildImage();
+    FormulaPackHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    std::vector<char> badMagic = image;
+    badMagic[0] = 'X';
+    expect("bad magic rejected", throwsOnOpen(badMagic));
+
+    std::vector<char> truncated(image.begin(), image.begin() + image.size() / 2);
+    expect("truncated image rejected", throwsOnOpen(truncated));
+
+    std::vector<char> future = image;
+    uint32_t version = 99;
+    std::memcpy(future.data() + offsetof(FormulaPackHeader, version), &version, sizeof(version));
+    expect("unknown version rejected", throwsOnOpen(future));
+
+    std::vector<char> badOperand = image;
+    uint32_t operand = 1000;
+    std::memcpy(badOperand.data() + header.instructionOffset + offsetof(Instruction, operand), &operand,
+                sizeof(operand));
+    expect("out-of-range operand rejected", throwsOnOpen(badOperand));
+
+    std::vector<char> badOpcode = image;
+    badOpcode[header.instructionOffset] = static_cast<char>(200);
+    expect("unknown opcode rejected", throwsOnOpen(badOpcode));
+
+    std::vector<char> badChild = image;
+    uint32_t child = header.nodeCount;
+    std::memcpy(badChild.data() + header.childOffset, &child, sizeof(child));
+    expect("forward child reference rejected", throwsOnOpen(badChild));
+
+    expect("empty pack", FormulaPack().size() == 0 && FormulaPack::fromBytes(FormulaPackWriter().serialize()).size() == 0);
+
+    bool parseError = false;
+    try {
+        FormulaPackWriter().add("x +");
+    } catch (const std::runtime_error&) {
+        parseError = true;
+    }
+    expect("parse errors throw", parseError);
+}
+
+int main() {
+    std::cout << "=== Formula Pack Test ===\n\n";
+
+    testRoundTrip();
+    testLoad();
+    testFileAndRelocation();
+    testValidation();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include "evaluator/FunctionRegistry.h"
+#include "cas/SymbolicEngine.h"
+#include "cas/ExpressionStore.h"
+#include "cas/AutoDiff.h"
+#include "cas/Expression.h"
+#include "cas/FormulaPack.h"
+#include "cas/LiveExpression.h"
+#include "test_harness.h"
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Message of the exception thrown by f, or "" when it does not throw
+template <typename F>
+std::string errorOf(F f) {
+    try {
+        f();
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return "";
+}
+
+std::unique_ptr<SymbolicExpression> parse(const std::string& text) {
+    ExpressionParser parser;
+    parser.parse(text);
+    return SymbolicEngine::convertASTToSymbolic(parser.getAST());
+}
+
+size_t cubeBatchPoints = 0;
+uint32_t cubeId = 0;
+uint32_t hypotId = 0;
+uint32_t rlogId = 0;
+
+// cube(x) with a batch kernel and a derivative rule, hyp(a, b) with
+// partials but no batch kernel, and rlog(x), defined for x > 0 only and
+// without a derivative
+void registerFunctions() {
+    using BinOp = SymbolicBinaryOp::OpType;
+
+    FunctionRegistry::UserFunction cube;
+    cube.name = "cube";
+    cube.kernel = [](const double* args) { return args[0] * args[0] * args[0]; };
+    cube.batch = [](const double* const* args, double* out, size_t n) {
+        cubeBatchPoints += n;
+        for (size_t i = 0; i < n; ++i) out[i] = args[0][i] * args[0][i] * args[0][i];
+    };
+    cube.derivative = [](ExpressionStore& store, const ExprNode* const* args, uint32_t) {
+        return store.binary(BinOp::MULTIPLY, store.number(3.0), store.binary(BinOp::POWER, args[0], store.number(2.0)));
+    };
+    cubeId = FunctionRegistry::add(cube);
+
+    FunctionRegistry::UserFunction hyp;
+    hyp.name = "hyp";
+    hyp.arity = 2;
+    hyp.kernel = [](const double* args) { return std::hypot(args[0], args[1]); };
+    hyp.derivative = [](ExpressionStore& store, const ExprNode* const* args, uint32_t argument) {
+        return store.binary(BinOp::DIVIDE, args[argument], store.function("hyp", {args[0], args[1]}));
+    };
+    hypotId = FunctionRegistry::add(hyp);
+
+    FunctionRegistry::UserFunction rlog;
+    rlog.name = "rlog";
+    rlog.kernel = [](const double* args) { return args[0] > 0 ? std::log(args[0]) : std::nan(""); };
+    rlogId = FunctionRegistry::add(rlog);
+}
+
+void testBuiltins() {
+    std::cout << "Testing builtins" << std::endl;
+    expect("builtin ids", FunctionRegistry::find("sin") == 0 && FunctionRegistry::find("abs") == 6 &&
+                              FunctionRegistry::find("ln") == static_cast<uint32_t>(FunctionRegistry::Builtin::LN));
+    expect("names and arity", FunctionRegistry::name(5) == "sqrt" && FunctionRegistry::arity(3) == 1);
+    expect("opcodes", FunctionRegistry::opcode(FunctionRegistry::find("tan")) == OpCode::TAN);
+    expect("unknown", FunctionRegistry::find("sinh") == FunctionRegistry::kUnknown &&
+                          FunctionRegistry::builtin("cube") == FunctionRegistry::kUnknown);
+
+    double u = 2;
+    EvalStatus status = EvalStatus::OK;
+    double negative = -1;
+    expect("call", FunctionRegistry::call(FunctionRegistry::find("ln"), &u, nullptr) == std::log(2.0));
+    expect("domain error in status mode",
+           std::isnan(FunctionRegistry::call(FunctionRegistry::find("sqrt"), &negative, &status)) &&
+               status == EvalStatus::SQRT_DOMAIN);
+    expect("domain error throws", errorOf([&] { FunctionRegistry::call(4, &negative, nullptr); }) ==
+                                      "Natural log of non-positive number");
+    expect("exact slopes", FunctionRegistry::slope(0, &u, 0) == std::cos(2.0) &&
+                               FunctionRegistry::slope(5, &u, 0) == 0.5 / std::sqrt(2.0));
+}
+
+void testRegistration() {
+    std::cout << "Testing registration" << std::endl;
+    expect("ids follow the builtins", cubeId == FunctionRegistry::kBuiltinCount && hypotId == cubeId + 1 &&
+                                          FunctionRegistry::size() == rlogId + 1);
+    expect("found by name", FunctionRegistry::find("hyp") == hypotId && FunctionRegistry::arity(hypotId) == 2);
+
+    FunctionRegistry::UserFunction function;
+    function.kernel = [](const double* args) { return args[0]; };
+    function.name = "cube";
+    expect("duplicate rejected", errorOf([&] { FunctionRegistry::add(function); }) ==
+                                     "Function already registered: cube");
+    function.name = "sin";
+    expect("builtin name rejected", !errorOf([&] { FunctionRegistry::add(function); }).empty());
+    function.name = "2x";
+    expect("invalid name rejected", !errorOf([&] { FunctionRegistry::add(function); }).empty());
+    function.name = "nullary";
+    function.arity = 0;
+    expect("arity checked", !errorOf([&] { FunctionRegistry::add(function); }).empty());
+    function.arity = 1;
+    function.kernel = nullptr;
+    expect("kernel required", !errorOf([&] { FunctionRegistry::add(function); }).empty());
+    expect("failed registrations leave no trace", FunctionRegistry::size() == rlogId + 1);
+}
+
+void testParsing() {
+    std::cout << "Testing parse-time resolution" << std::endl;
+    Lexer lexer("hyp(x, 3) + sin(y)");
+    Token first = lexer.getNextToken();
+    expect("registered name lexes as a function", first.type == TokenType::FUNCTION && first.symbol == hypotId);
+    expect("symbol table covers the registry", lexer.getSymbols().functionCount() == FunctionRegistry::size());
+
+    ExpressionParser parser;
+    parser.parse("cube(x) + hyp(x, 4) * sin(x)");
+    auto function = astCast<FunctionNode>(astCast<BinaryOpNode>(parser.getAST())->left.get());
+    expect("AST node carries the id", function && function->functionId == cubeId);
+    double x = 3;
+    double expected = 27 + 5 * std::sin(3.0);
+    expect("AST evaluate", near(expected, parser.evaluate({{"x", x}})));
+
+    auto expr = SymbolicEngine::convertASTToSymbolic(parser.getAST());
+    expect("symbolic evaluate", near(expected, expr->evaluate({{"x", x}})));
+    expect("clone keeps the id", near(expected, expr->clone()->evaluate({{"x", x}})));
+    expect("constant folding", near(9, parse("cube(2) + x")->simplify()->evaluate({{"x", 1}})));
+
+    expect("wrong arity", errorOf([] { parse("hyp(1)")->evaluate(); }) == "Function hyp expects 2 arguments");
+    ExpressionParser wrong;
+    wrong.parse("cube(1, 2)");
+    EvalStatus status = EvalStatus::OK;
+    expect("wrong arity in status mode", std::isnan(wrong.evaluate({}, status)) && status == EvalStatus::WRONG_ARITY);
+}
+
+void testCompiled() {
+    std::cout << "Testing bytecode" << std::endl;
+    SymbolicEngine engine;
+    engine.parseFromString("cube(x) + hyp(x, 4)");
+    CompiledExpression program = engine.compile({"x"});
+    expect("CALL instructions", program.toString().find("CALL cube") != std::string::npos &&
+                                    program.toString().find("CALL hyp") != std::string::npos);
+    double x = 3;
+    expect("eval", near(32, program.eval(&x)));
+
+    double derivative = 0;
+    EvalStatus status = EvalStatus::OK;
+    double value = program.evalDerivative(&x, 0, derivative, status);
+    expect("dual numbers through a central difference", near(32, value) && near(27 + 3.0 / 5, derivative, 1e-6));
+
+    std::vector<double> xs = {0, 1, 2, 3};
+    std::vector<double> out(xs.size());
+    const double* columns[] = {xs.data()};
+    cubeBatchPoints = 0;
+    program.evalBatch(columns, out.data(), xs.size());
+    expect("batch", near(1 + std::hypot(1.0, 4.0), out[1]) && near(32, out[3]));
+    expect("batch kernel used", cubeBatchPoints == xs.size());
+
+    SymbolicEngine undefined;
+    undefined.parseFromString("rlog(x)");
+    CompiledExpression rlog = undefined.compile({"x"});
+    double negative = -2;
+    expect("domain error throws", errorOf([&] { rlog.eval(&negative); }) == "Argument outside the domain of rlog");
+    status = EvalStatus::OK;
+    expect("domain error status", std::isnan(rlog.eval(&negative, status)) && status == EvalStatus::FUNCTION_DOMAIN);
+    const double* negatives[] = {&negative};
+    rlog.evalBatch(negatives, out.data(), 1);
+    expect("per-point kernel in batches", std::isnan(out[0]));
+}
+
+void testCalculus() {
+    std::cout << "Testing derivative rules" << std::endl;
+    auto expr = parse("cube(x^2) + hyp(x, 4)");
+    auto variables = std::map<std::string, double>{{"x", 3}};
+    double expected = 6 * std::pow(3.0, 5) + 3.0 / 5;
+
+    expect("tree differentiate", near(expected, expr->differentiate("x")->evaluate(variables)));
+    ExpressionStore store;
+    const ExprNode* derivative = store.differentiate(store.intern(expr.get()), "x");
+    expect("DAG differentiate", near(expected, store.evaluate(derivative, variables)));
+    expect("DAG compile", near(expected, store.compile(derivative, {"x"}).eval(&variables["x"])));
+
+    DualValue dual = AutoDiff::derivative(*parse("cube(sin(x))"), variables, "x");
+    expect("autodiff", near(3 * std::pow(std::sin(3.0), 2) * std::cos(3.0), dual.derivative, 1e-6));
+    expect("no rule", errorOf([] { parse("rlog(x)")->differentiate("x"); }) ==
+                          "Differentiation not implemented for function: rlog");
+    expect("builtins unchanged", errorOf([] { parse("tan(x)")->differentiate("x"); }) ==
+                                     "Differentiation not implemented for function: tan");
+
+    LiveExpression live(*expr, variables);
+    live.set("x", 2);
+    expect("live expression", near(64 + std::hypot(2.0, 4.0), live.value()));
+
+    FormulaPackWriter writer;
+    expect("packs reject registered functions", !errorOf([&] { writer.add("cube(x)"); }).empty());
+    writer.add("sin(x)");
+    expect("builtins still pack", writer.size() == 1);
+}
+
+void testLateRegistration() {
+    std::cout << "Testing registration after parsing" << std::endl;
+    SymbolicEngine engine;
+    engine.parseFromString("twice(x)");
+    expect("unregistered name reads as a variable",
+           near(15, Expression::parse("twice(x)").evaluate({{"twice", 5}, {"x", 3}})));
+
+    FunctionRegistry::UserFunction twice;
+    twice.name = "twice";
+    twice.kernel = [](const double* args) { return 2 * args[0]; };
+    FunctionRegistry::add(twice);
+
+    expect("cached parse not reused by the engine",
+           engine.parseFromString("twice(x)") && near(6, engine.getExpression()->evaluate({{"x", 3}})));
+    expect("cached parse not reused by Expression", near(6, Expression::parse("twice(x)").evaluate({{"x", 3}})));
+}
+
+int main() {
+    std::cout << "=== Function Registry Test ===\n\n";
+
+    registerFunctions();
+    testBuiltins();
+    testRegistration();
+    testParsing();
+    testCompiled();
+    testCalculus();
+    testLateRegistration();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
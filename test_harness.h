@@ -0,0 +1,23 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+// Checks shared by the test_*.cpp executables: each prints an ok or FAIL
+// line and counts failures, which main() turns into the exit status
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+inline int failures = 0;
+
+inline void expect(const std::string& label, bool condition) {
+    std::cout << "  " << (condition ? "ok   " : "FAIL ") << label << std::endl;
+    if (!condition) failures++;
+}
+
+// Within tolerance relative to expected (absolute below 1)
+inline bool near(double expected, double actual, double tolerance = 1e-9) {
+    return std::abs(expected - actual) <= tolerance * std::max(1.0, std::abs(expected));
+}
+
+#endif // TEST_HARNESS_H
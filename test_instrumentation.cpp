@@ -0,0 +1,113 @@
+#include "util/Instrumentation.h"
+#include "cas/SymbolicEngine.h"
+#include "grapher/ConsoleGrapher.h"
+#include "test_harness.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using Counter = Instrumentation::Counter;
+using Phase = Instrumentation::Phase;
+
+bool allZero(const Instrumentation::Snapshot& stats) {
+    for (size_t i = 0; i < Instrumentation::kCounters; ++i) {
+        if (stats.counters[i]) return false;
+    }
+    for (size_t i = 0; i < Instrumentation::kPhases; ++i) {
+        if (stats.phases[i].calls || stats.phases[i].nanoseconds) return false;
+    }
+    return true;
+}
+
+// One pass through the pipeline: parse, convert, differentiate, simplify,
+// evaluate and a console plot with undefined points (sqrt of negatives)
+void runPipeline() {
+    SymbolicEngine engine;
+    engine.parseFromString("sin(x) * x^3 + ln(x + 7)");
+    engine.differentiate("x");
+    engine.simplify();
+    engine.evaluate({{"x", 1}});
+
+    ConsoleGrapher grapher;
+    grapher.addFunction("sqrt(x)");
+    std::ostringstream frame;
+    grapher.plotIncremental(frame);
+}
+
+void testPipeline() {
+    std::cout << "Testing pipeline counters" << std::endl;
+    Instrumentation::reset();
+    expect("reset clears everything", allZero(Instrumentation::snapshot()));
+
+    runPipeline();
+    Instrumentation::Snapshot stats = Instrumentation::snapshot();
+    if (!Instrumentation::enabled) {
+        expect("compiled out: nothing recorded", allZero(stats));
+        return;
+    }
+
+    expect("nodes created", stats.counter(Counter::NODES_CREATED) > 0 && stats.counter(Counter::ARENA_BYTES) > 0);
+    expect("one differentiate call", stats.counter(Counter::DIFFERENTIATE_CALLS) == 1);
+    uint64_t derivativeNodes = stats.counter(Counter::DIFFERENTIATE_NODES);
+    expect("differentiate nodes", derivativeNodes > 0 && derivativeNodes <= stats.counter(Counter::NODES_CREATED));
+    expect("simplify calls", stats.counter(Counter::SIMPLIFY_CALLS) == 1);
+    expect("evaluate calls", stats.counter(Counter::EVALUATE_CALLS) == 1);
+    expect("undefined plot points", stats.counter(Counter::UNDEFINED_POINTS) > 0);
+
+    expect("lex and parse timed", stats.phase(Phase::LEX).calls > 0 && stats.phase(Phase::PARSE).calls >= 2);
+    expect("recursive conversion timed once per expression", stats.phase(Phase::CONVERT).calls == 1);
+    expect("differentiate and simplify timed", stats.phase(Phase::DIFFERENTIATE).calls == 1 &&
+                                                   stats.phase(Phase::SIMPLIFY).calls == 1);
+    const Instrumentation::PhaseStats& sample = stats.phase(Phase::SAMPLE);
+    const Instrumentation::PhaseStats& render = stats.phase(Phase::RENDER);
+    expect("sample and render timed", sample.calls == 1 && render.calls == 1 && render.nanoseconds >= sample.nanoseconds);
+}
+
+void testClones() {
+    std::cout << "Testing clone counting" << std::endl;
+    SymbolicEngine engine;
+    engine.parseFromString("x * y + 2");
+    Instrumentation::reset();
+    auto copy = engine.getExpression()->clone();
+    uint64_t clones = Instrumentation::snapshot().counter(Counter::CLONES);
+    expect("one count per cloned node", clones == (Instrumentation::enabled ? 5u : 0u));
+}
+
+void testScopes() {
+    std::cout << "Testing scopes" << std::endl;
+    Instrumentation::reset();
+    {
+        Instrumentation::ScopedPhase outer(Phase::COMPILE);
+        Instrumentation::ScopedPhase inner(Phase::COMPILE);
+        Instrumentation::ScopedPhase other(Phase::SAMPLE);
+    }
+    Instrumentation::Snapshot stats = Instrumentation::snapshot();
+    expect("nested scopes of one phase count once", stats.phase(Phase::COMPILE).calls == 1);
+    expect("other phases nest", stats.phase(Phase::SAMPLE).calls == 1);
+
+    size_t size = 3;
+    {
+        auto growth = Instrumentation::growth(Counter::SIMPLIFY_NODES, [&]() -> uint64_t { return size; });
+        size = 10;
+    }
+    expect("growth counter", Instrumentation::snapshot().counter(Counter::SIMPLIFY_NODES) == 7);
+
+    std::ostringstream report;
+    Instrumentation::report(report, Instrumentation::snapshot());
+    expect("report", report.str().find(Instrumentation::enabled ? "differentiate calls" : "compiled out") !=
+                         std::string::npos);
+    expect("names", std::string(Instrumentation::name(Phase::LEX)) == "lex" &&
+                        std::string(Instrumentation::name(Counter::CLONES)) == "clones");
+}
+
+int main() {
+    std::cout << "=== Instrumentation Test ===\n\n";
+    std::cout << "(instrumentation " << (Instrumentation::enabled ? "enabled" : "compiled out") << ")\n\n";
+
+    testPipeline();
+    testClones();
+    testScopes();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
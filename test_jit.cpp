@@ -0,0 +1,173 @@
+#include "parser/ExpressionParser.h"
+#include "cas/SymbolicEngine.h"
+#include "test_harness.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+bool sameBits(double a, double b) {
+    return (std::isnan(a) && std::isnan(b)) || std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Result of one scalar evaluation in both modes
+struct Outcome {
+    double value;
+    std::string error;
+    double statusValue;
+    EvalStatus status;
+};
+
+Outcome evaluate(const CompiledExpression& program, const double* slots) {
+    Outcome outcome;
+    try {
+        outcome.value = program.eval(slots);
+    } catch (const std::exception& e) {
+        outcome.value = 0;
+        outcome.error = e.what();
+    }
+    outcome.status = EvalStatus::OK;
+    outcome.statusValue = program.eval(slots, outcome.status);
+    return outcome;
+}
+
+bool sameOutcome(const Outcome& a, const Outcome& b) {
+    return sameBits(a.value, b.value) && a.error == b.error && sameBits(a.statusValue, b.statusValue) &&
+           a.status == b.status;
+}
+
+// Interprets program (threshold never reached), then forces native code and
+// checks every point gives the same bits, exceptions and statuses
+void checkProgram(const std::string& label, const CompiledExpression& interpreted, const CompiledExpression& jitted,
+                  const std::vector<std::vector<double>>& points) {
+    std::vector<Outcome> expected;
+    for (const auto& slots : points) expected.push_back(evaluate(interpreted, slots.data()));
+
+    bool same = true;
+    for (size_t i = 0; i < points.size(); ++i) {
+        same = same && sameOutcome(expected[i], evaluate(jitted, points[i].data()));
+    }
+    expect(label + " matches the interpreter", same);
+    expect(label + (CompiledExpression::jitAvailable() ? " runs natively" : " stays interpreted"),
+           jitted.isNative() == CompiledExpression::jitAvailable());
+}
+
+void testExpression(const std::string& expr, const std::vector<std::vector<double>>& points,
+                    const std::string& label = "") {
+    ExpressionParser parser;
+    if (!parser.parse(expr)) {
+        std::cout << "  Parse error: " << parser.getError() << std::endl;
+        failures++;
+        return;
+    }
+    CompiledExpression::setJitThreshold(std::numeric_limits<size_t>::max());
+    CompiledExpression interpreted = parser.compile();
+    CompiledExpression::setJitThreshold(0);
+    CompiledExpression jitted = parser.compile();
+    checkProgram(label.empty() ? expr : label, interpreted, jitted, points);
+}
+
+std::vector<std::vector<double>> grid(double lo, double hi, size_t count) {
+    std::vector<std::vector<double>> points;
+    for (size_t i = 0; i <= count; ++i) points.push_back({lo + (hi - lo) * i / count});
+    return points;
+}
+
+void testScalar() {
+    std::cout << "Testing scalar evaluation" << std::endl;
+
+    testExpression("3*x^2 - 2*x + 1", grid(-5, 5, 40));
+    testExpression("sin(x) * cos(x) / tan(x)", grid(-3, 3, 48));
+    testExpression("1 / x", grid(-2, 2, 8));                       // x = 0 divides by zero
+    testExpression("ln(x) + log(x) - sqrt(x)", grid(-2, 4, 12));   // domain errors below 0
+    testExpression("abs(-x) + -(x^0.5)", grid(-1, 9, 10));
+    testExpression("(x - 1)^(x + 1) / (x*x - 4)", grid(-3, 3, 24));
+    testExpression("x*y - z/y + 2^z", {{1, 2, 3}, {-1.5, 0, 2}, {0.25, -4, -1}});
+
+    std::string deep = "x";
+    for (int i = 0; i < 80; ++i) deep = "(x + " + deep + ") * 0.5";
+    testExpression(deep, grid(-1, 1, 4), "80-deep stack");
+    testExpression("sqrt(" + deep + ")", grid(-1, 1, 4), "sqrt of an 80-deep stack");
+}
+
+void testTemporaries() {
+    std::cout << "Testing programs with temporaries" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("sin(x^2) * cos(x^2) + ln(x^2 + 1)");
+    auto derivative = engine.differentiate("x");
+    CompiledExpression::setJitThreshold(std::numeric_limits<size_t>::max());
+    CompiledExpression interpreted = engine.compile(*derivative, {"x"});
+    CompiledExpression::setJitThreshold(0);
+    CompiledExpression jitted = engine.compile(*derivative, {"x"});
+    expect("derivative reuses temporaries", jitted.getTempCount() > 0);
+    checkProgram("d/dx", interpreted, jitted, grid(-2, 2, 32));
+}
+
+void testBatch() {
+    std::cout << "Testing batch evaluation" << std::endl;
+
+    ExpressionParser parser;
+    parser.parse("x^3 - 1/x + sqrt(x + 1)");
+
+    std::vector<double> xs;
+    for (int i = 0; i <= 1000; ++i) xs.push_back(-2.0 + 4.0 * i / 1000);
+    const double* columns[] = {xs.data()};
+
+    CompiledExpression::setJitThreshold(0);
+    CompiledExpression program = parser.compile();
+    std::vector<double> batch(xs.size());
+    program.evalBatch(columns, batch.data(), xs.size());
+    expect("batches do not count towards the threshold", !program.isNative());
+
+    // Batches stay on the vector kernels, which may differ from scalar
+    // evaluation in the last bits
+    bool close = true;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        EvalStatus status = EvalStatus::OK;
+        double scalar = program.eval(&xs[i], status);
+        close = close && (sameBits(batch[i], scalar) ||
+                          std::abs(batch[i] - scalar) <= 1e-12 * std::max(1.0, std::abs(scalar)));
+    }
+    expect("batch matches native scalar evaluation", close);
+}
+
+void testTiering() {
+    std::cout << "Testing the hotness threshold" << std::endl;
+
+    ExpressionParser parser;
+    parser.parse("x * (x + 1)");
+    CompiledExpression::setJitThreshold(3);
+    CompiledExpression program = parser.compile();
+    double x = 2;
+    program.eval(&x);
+    program.eval(&x);
+    expect("cold below the threshold", !program.isNative());
+    program.eval(&x);
+    expect("hot at the threshold", program.isNative() == CompiledExpression::jitAvailable());
+
+    CompiledExpression copy = program;
+    expect("copies start cold", !copy.isNative() && copy.eval(&x) == 6);
+
+    program.emitConstant(1);
+    program.emit(OpCode::ADD);
+    expect("extending the program drops native code", !program.isNative() && program.eval(&x) == 7);
+
+    CompiledExpression::setJitThreshold(64);
+}
+
+int main() {
+    std::cout << "=== JIT Test ===\n";
+    std::cout << "Native code generation " << (CompiledExpression::jitAvailable() ? "enabled" : "unavailable")
+              << "\n\n";
+
+    testScalar();
+    testTemporaries();
+    testBatch();
+    testTiering();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
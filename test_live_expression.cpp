@@ -0,0 +1,153 @@
+#include "cas/LiveExpression.h"
+#include "test_harness.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+std::unique_ptr<SymbolicExpression> parse(const std::string& text) {
+    SymbolicEngine engine;
+    engine.parseFromString(text);
+    return engine.getExpression()->clone();
+}
+
+// a0*x0 + a1*x1 + ... : one slow-moving parameter pair per term
+std::string wideSum(int terms) {
+    std::string text;
+    for (int i = 0; i < terms; ++i) {
+        if (i) text += " + ";
+        text += "a" + std::to_string(i) + " * sin(x" + std::to_string(i) + ")";
+    }
+    return text;
+}
+
+void testBasics() {
+    std::cout << "Testing evaluation" << std::endl;
+    auto expr = parse("x^2 + 3*x*y - ln(y)");
+    LiveExpression live(*expr, {{"x", 2}, {"y", 1}});
+    expect("initial value", live.value() == 10);
+    expect("first value computes every node", live.lastRecomputed() == live.nodeCount());
+    expect("variables sorted", live.variables() == std::vector<std::string>({"x", "y"}));
+    expect("dependsOn", live.dependsOn("y") && !live.dependsOn("z"));
+
+    live.set("y", 2);
+    expect("update", live.value() == expr->evaluate({{"x", 2}, {"y", 2}}));
+    expect("unchanged value recomputes nothing", live.value() == expr->evaluate({{"x", 2}, {"y", 2}}) &&
+                                                     live.lastRecomputed() == 0);
+    live.set("y", 2);
+    live.set("z", 5);
+    live.value();
+    expect("same binding and unused names are ignored", live.lastRecomputed() == 0);
+}
+
+void testIncremental() {
+    std::cout << "Testing incremental updates" << std::endl;
+    const int terms = 64;
+    auto expr = parse(wideSum(terms));
+    std::map<std::string, double> bindings;
+    for (int i = 0; i < terms; ++i) {
+        bindings["a" + std::to_string(i)] = 1.0 + i;
+        bindings["x" + std::to_string(i)] = 0.01 * i;
+    }
+    LiveExpression live(*expr, bindings);
+    live.value();
+
+    bindings["x17"] = 0.5;
+    live.set("x17", 0.5);
+    double value = live.value();
+    expect("wide sum matches full evaluation", std::abs(value - expr->evaluate(bindings)) < 1e-9);
+    expect("only the path to the root is recomputed", live.lastRecomputed() <= live.affectedBy("x17") &&
+                                                          live.lastRecomputed() < live.nodeCount() / 2);
+    expect("affectedBy counts the path", live.affectedBy("x17") < 70 && live.affectedBy("nope") == 0);
+
+    // Random ticks changing a couple of parameters at a time
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, terms - 1);
+    std::uniform_real_distribution<double> amount(-2, 2);
+    bool agree = true;
+    for (int tick = 0; tick < 200; ++tick) {
+        for (int k = 0; k < 2; ++k) {
+            std::string name = (k ? "a" : "x") + std::to_string(pick(rng));
+            bindings[name] = amount(rng);
+            live.set(name, bindings[name]);
+        }
+        agree = agree && std::abs(live.value() - expr->evaluate(bindings)) < 1e-9;
+    }
+    expect("random ticks agree with evaluate", agree);
+}
+
+void testCutoff() {
+    std::cout << "Testing early cutoff" << std::endl;
+    auto expr = parse("abs(x) * y + y^2");
+    LiveExpression live(*expr, {{"x", -2}, {"y", 3}});
+    live.value();
+    live.set("x", 2);
+    expect("unchanged abs keeps the old value", live.value() == 15);
+    expect("propagation stops at abs", live.lastRecomputed() == 2);
+
+    // Shared subexpressions are recomputed once
+    auto shared = parse("(x + 1)^2 + sin(x + 1) * (x + 1)");
+    LiveExpression dag(*shared, {{"x", 0}});
+    dag.value();
+    dag.set("x", 1);
+    expect("shared value", dag.value() == shared->evaluate({{"x", 1}}));
+    expect("each node at most once", dag.lastRecomputed() == dag.nodeCount() - 2);
+}
+
+void testErrors() {
+    std::cout << "Testing errors" << std::endl;
+    auto expr = parse("sqrt(x) + y");
+    LiveExpression live(*expr, {{"x", 4}});
+    bool undefined = false;
+    try {
+        live.value();
+    } catch (const std::runtime_error& e) {
+        undefined = std::string(e.what()) == "Undefined variable: y";
+    }
+    expect("unbound variable throws", undefined);
+    live.set("y", 1);
+    expect("value after binding", live.value() == 3);
+
+    live.set("x", -1);
+    bool domain = false;
+    try {
+        live.value();
+    } catch (const std::runtime_error&) {
+        domain = true;
+    }
+    expect("domain error throws", domain);
+    live.set("y", 10);
+    live.set("x", 9);
+    expect("recovers once the binding is valid", live.value() == 13);
+}
+
+void testStore() {
+    std::cout << "Testing DAGs from a store" << std::endl;
+    ExpressionStore store;
+    auto expr = parse("sin(x * y) * x^3");
+    const ExprNode* root = store.intern(expr.get());
+    const ExprNode* derivative = store.differentiate(root, "x");
+    LiveExpression live(derivative, {{"x", 0.5}, {"y", 2}});
+    expect("derivative DAG", live.value() == store.evaluate(derivative, {{"x", 0.5}, {"y", 2}}));
+    live.set("y", -1);
+    expect("derivative DAG update", live.value() == store.evaluate(derivative, {{"x", 0.5}, {"y", -1}}));
+
+    LiveExpression copy = live;
+    copy.set("x", 2);
+    expect("copies update independently",
+           copy.value() == store.evaluate(derivative, {{"x", 2}, {"y", -1}}) &&
+               live.value() == store.evaluate(derivative, {{"x", 0.5}, {"y", -1}}));
+}
+
+int main() {
+    std::cout << "=== Live Expression Test ===\n\n";
+
+    testBasics();
+    testIncremental();
+    testCutoff();
+    testErrors();
+    testStore();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
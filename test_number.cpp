@@ -0,0 +1,139 @@
+#include "util/Number.h"
+#include "cas/SymbolicEngine.h"
+#include "cas/ExpressionStore.h"
+#include "cas/Simplifier.h"
+#include "test_harness.h"
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+
+bool throws(void (*action)()) {
+    try {
+        action();
+        return false;
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+}
+
+// Simplified text of an expression through the canonical simplifier
+std::string simplified(const std::string& text) {
+    ExpressionParser parser;
+    parser.parse(text);
+    auto expr = SymbolicEngine::convertASTToSymbolic(parser.getAST());
+    ExpressionStore store;
+    Simplifier simplifier(store);
+    return store.toSymbolic(simplifier.simplify(store.intern(expr.get())))->toString();
+}
+
+void testInline() {
+    std::cout << "Testing inline integers and rationals" << std::endl;
+    Number a = Number(6) + Number(7);
+    expect("6 + 7 = 13", a.kind() == Number::Kind::INTEGER && a == 13);
+    expect("integers reduce", Number::rational(6, -4).toString() == "-3/2");
+    expect("1/3 + 1/6 = 1/2", Number::rational(1, 3) + Number::rational(1, 6) == Number::rational(1, 2));
+    expect("2/3 * 3/2 = 1", (Number::rational(2, 3) * Number::rational(3, 2)).kind() == Number::Kind::INTEGER);
+    expect("division is exact", (Number(1) / Number(3)).toString() == "1/3");
+    expect("reciprocal of -2/5", Number::rational(-2, 5).reciprocal().toString() == "-5/2");
+    expect("ordering", Number::rational(1, 3) < Number::rational(1, 2) && Number(-1) < Number::rational(-1, 2));
+    expect("abs and sign", Number::rational(-7, 3).abs() == Number::rational(7, 3) && Number(-4).sign() == -1);
+    expect("isInteger", Number(4).isInteger() && !Number::rational(1, 2).isInteger());
+    expect("division by zero throws", throws([] { Number(1) / Number(0); }));
+    expect("zero denominator throws", throws([] { Number::rational(1, 0); }));
+}
+
+void testParse() {
+    std::cout << "Testing literal parsing" << std::endl;
+    expect("0.1 is 1/10", Number::parse("0.1") == Number::rational(1, 10));
+    expect("2.50 is 5/2", Number::parse("2.50").toString() == "5/2");
+    expect("2.5e-3 is 1/400", Number::parse("2.5e-3") == Number::rational(1, 400));
+    expect("1e3 is 1000", Number::parse("1e3").kind() == Number::Kind::INTEGER && Number::parse("1e3") == 1000);
+    expect("dangling exponent ignored", Number::parse("2e") == 2);
+    expect("huge exponent is REAL", !Number::parse("1e500").isExact());
+    expect("bad literal throws", throws([] { Number::parse("."); }));
+
+    expect("0.1 + 0.2 == 0.3 exactly", Number::parse("0.1") + Number::parse("0.2") == Number::parse("0.3"));
+    expect("the doubles differ", 0.1 + 0.2 != 0.3);
+}
+
+void testReal() {
+    std::cout << "Testing inexact values" << std::endl;
+    Number half = Number::fromDouble(0.5);
+    expect("0.5 from a double is REAL", half.kind() == Number::Kind::REAL);
+    expect("integral doubles are INTEGER", Number::fromDouble(-3.0).kind() == Number::Kind::INTEGER);
+    expect("1/2 equals 0.5 but is not identical", half == Number::rational(1, 2) && !half.identical(Number::rational(1, 2)));
+    expect("REAL contaminates", !(half + Number(1)).isExact() && (half + Number(1)).toDouble() == 1.5);
+    expect("sqrt(2) is REAL", !Number(2).pow(Number::rational(1, 2)).isExact());
+    expect("sqrt(9/4) = 3/2", Number::rational(9, 4).pow(Number::rational(1, 2)) == Number::rational(3, 2));
+    expect("8^(2/3) = 4", Number(8).pow(Number::rational(2, 3)).kind() == Number::Kind::INTEGER &&
+                              Number(8).pow(Number::rational(2, 3)) == 4);
+    expect("2^-3 = 1/8", Number(2).pow(Number(-3)) == Number::rational(1, 8));
+    expect("0^-1 throws", throws([] { Number(0).pow(Number(-1)); }));
+    expect("identical hashes", Number::rational(3, 4).hash() == (Number(3) / Number(4)).hash());
+}
+
+void testNaN() {
+    std::cout << "Testing NaN" << std::endl;
+    Number nan = Number::fromDouble(std::numeric_limits<double>::quiet_NaN());
+    expect("NaN is REAL", nan.isNaN() && nan.kind() == Number::Kind::REAL && !Number(1).isNaN());
+    expect("NaN equals nothing", !(nan == Number(-1)) && !(nan == nan) && nan != Number(-1) && nan != nan);
+    expect("NaN is unordered", !(nan < Number(1)) && !(nan > Number(1)) && !(Number(1) < nan) && !(nan >= nan));
+    expect("compare sorts NaN last", Number::compare(nan, Number(1)) > 0 && Number::compare(Number(-1), nan) < 0 &&
+                                         Number::compare(nan, nan) == 0);
+}
+
+void testBig() {
+    std::cout << "Testing overflow" << std::endl;
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    Number over = Number(max) + Number(1);
+    Number back = over - Number(1);
+    expect("back to inline after overflow", back.isSmall() && back == Number(max));
+
+    Number power = Number(2).pow(Number(100));
+#ifdef GMP_AVAILABLE
+    expect("INT64_MIN is representable", Number(std::numeric_limits<int64_t>::min()) < Number(-max));
+    expect("2^100 is BIG", power.kind() == Number::Kind::BIG && power.heapBytes() > 0);
+    expect("2^100 digits", power.toString() == "1267650600228229401496703205376");
+    expect("overflow is exact", over.toString() == "9223372036854775808");
+    Number ratio = Number(1) / power;
+    expect("1/2^100 is exact", ratio.isExact() && ratio * power == 1);
+    Number shared = power;
+    expect("copies share the value", shared.identical(power) && shared.hash() == power.hash());
+    expect("3^200 / 3^199 = 3", Number(3).pow(Number(200)) / Number(3).pow(Number(199)) == 3);
+#else
+    expect("2^100 approximated without GMP", !power.isExact() && power.toDouble() == 1267650600228229401496703205376.0);
+#endif
+}
+
+void testSymbolic() {
+    std::cout << "Testing symbolic constants" << std::endl;
+    SymbolicEngine engine;
+    engine.parseFromString("0.1 + 0.2");
+    auto folded = engine.simplify();
+    expect("0.1 + 0.2 folds to 0.3", folded->toString() == "0.3");
+    auto number = symbolicCast<SymbolicNumber>(folded.get());
+    expect("folded constant is exact", number && number->exact == Number::rational(3, 10));
+
+    engine.parseFromString("1/3");
+    expect("1/3 prints as a fraction", engine.simplify()->toString() == "(1/3)");
+
+    expect("simplifier keeps thirds exact", simplified("x/3 + x/6") == simplified("x/2"));
+    expect("simplifier folds rationals", simplified("(2/3) * (3/4)") == "0.5");
+    expect("exact powers", simplified("2^100 - 2^99 * 2") == "0");
+    expect("0.1 * 10 = 1", simplified("0.1 * 10 * x") == "x");
+}
+
+int main() {
+    std::cout << "=== Number Test ===\n\n";
+
+    testInline();
+    testParse();
+    testReal();
+    testNaN();
+    testBig();
+    testSymbolic();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -1,7 +1,12 @@
 #include "parser/ExpressionParser.h"
+#include "util/ThreadPool.h"
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <map>
 
+int failures = 0;
+
 void testExpression(const std::string& expr, const std::map<std::string, double>& vars = {}) {
     std::cout << "Testing: " << expr << std::endl;
     
@@ -21,6 +26,100 @@ void testExpression(const std::string& expr, const std::map<std::string, double>
     std::cout << std::endl;
 }
 
+void testTokens(const std::string& expr) {
+    std::cout << "Tokens: " << expr << std::endl;
+    
+    Lexer lexer(expr);
+    uint32_t firstX = 0;
+    bool seenX = false;
+    bool stableIds = true;
+    for (Token token = lexer.getNextToken(); token.type != TokenType::END_OF_FILE; token = lexer.getNextToken()) {
+        std::cout << "  [" << token.position << "] '" << token.text << "'";
+        if (token.type == TokenType::NUMBER) {
+            std::cout << " number " << token.number;
+        } else if (token.type == TokenType::FUNCTION || token.type == TokenType::VARIABLE) {
+            std::cout << (token.type == TokenType::FUNCTION ? " function #" : " variable #") << token.symbol;
+        }
+        std::cout << std::endl;
+        
+        if (token.type == TokenType::FUNCTION && lexer.getSymbols().name(token.symbol) != token.text) {
+            stableIds = false;
+        }
+        if (token.type == TokenType::VARIABLE && token.text == "x") {
+            if (seenX && token.symbol != firstX) stableIds = false;
+            firstX = token.symbol;
+            seenX = true;
+        }
+    }
+    
+    if (!stableIds) {
+        std::cout << "  FAIL identifiers did not resolve to stable ids" << std::endl;
+        failures++;
+    }
+    std::cout << std::endl;
+}
+
+void testParseMany() {
+    std::cout << "Bulk parsing" << std::endl;
+    
+    std::vector<std::string> sources;
+    for (int i = 0; i < 5000; ++i) {
+        switch (i % 4) {
+            case 0: sources.push_back(std::to_string(i) + " * x + sin(x)"); break;
+            case 1: sources.push_back("(x + " + std::to_string(i) + ") ^ 2"); break;
+            case 2: sources.push_back("sqrt(x * " + std::to_string(i) + ") / ln(y)"); break;
+            default: sources.push_back("x + * " + std::to_string(i)); break;
+        }
+    }
+    std::vector<std::string_view> views(sources.begin(), sources.end());
+    
+    ThreadPool pool(4);
+    std::vector<ExpressionParser> results = ExpressionParser::parseMany(views, &pool);
+    size_t mismatches = 0;
+    size_t errors = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        ExpressionParser single;
+        bool ok = single.parse(sources[i]);
+        if (!ok) errors++;
+        if (ok == results[i].hasError() || single.toString() != results[i].toString() ||
+            single.getError() != results[i].getError()) {
+            mismatches++;
+        }
+    }
+    std::cout << "  " << results.size() << " expressions, " << errors << " errors, "
+              << mismatches << " mismatches against single parses" << std::endl;
+    if (mismatches != 0 || errors != sources.size() / 4) failures++;
+    
+    const char* path = "test_parser_formulas.txt";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "x + 1\n\n  \r\nsin(x) * 2\r\n(x + \n3x^2";
+    }
+    std::vector<ParsedLine> lines = ExpressionParser::parseFile(path, &pool);
+    std::remove(path);
+    for (const auto& line : lines) {
+        std::cout << "  line " << line.line << ": "
+                  << (line.expression.hasError() ? "error: " + line.expression.getError() : line.expression.toString())
+                  << std::endl;
+    }
+    bool layoutOk = lines.size() == 4 && lines[0].line == 1 && lines[1].line == 4 && lines[2].line == 5 &&
+                    lines[3].line == 6 && lines[2].expression.hasError() && !lines[3].expression.hasError();
+    if (!layoutOk) {
+        std::cout << "  FAIL unexpected line numbers or errors" << std::endl;
+        failures++;
+    }
+    
+    bool threw = false;
+    try {
+        ExpressionParser::parseFile("no/such/file.txt", &pool);
+    } catch (const std::exception& e) {
+        threw = true;
+        std::cout << "  missing file: " << e.what() << std::endl;
+    }
+    if (!threw) failures++;
+    std::cout << std::endl;
+}
+
 int main() {
     std::cout << "=== Expression Parser Test ===\n\n";
     
@@ -66,5 +165,18 @@ int main() {
     testExpression("sqrt(-1)"); // Invalid operation
     testExpression("unknown(5)"); // Unknown function
     
-    return 0;
+    // Test number forms parsed in place
+    testExpression("2.5e-3x", vars);
+    testExpression(".5 + 1.");
+    testExpression("2e");     // Dangling exponent is ignored
+    testExpression("1e999");  // Out of range
+    testExpression(".");      // Not a number
+    
+    // Test the lexer directly
+    testTokens("sin(x) + x * sqrt(xy) - ln(x_1)");
+    testTokens("abs(2) tan cosx");
+    
+    testParseMany();
+    
+    return failures == 0 ? 0 : 1;
 }
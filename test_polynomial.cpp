@@ -0,0 +1,176 @@
+#include "cas/Polynomial.h"
+#include "cas/SymbolicEngine.h"
+#include "test_harness.h"
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+Polynomial poly(const std::string& text) {
+    ExpressionParser parser;
+    parser.parse(text);
+    return Polynomial::fromSymbolic(*SymbolicEngine::convertASTToSymbolic(parser.getAST()));
+}
+
+bool throws(const std::string& text) {
+    try {
+        poly(text);
+        return false;
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+}
+
+void testArithmetic() {
+    std::cout << "Testing arithmetic and conversion" << std::endl;
+    expect("(x + 1)(x - 1) = x^2 - 1", poly("(x + 1) * (x - 1)") == poly("x^2 - 1"));
+    expect("like terms cancel", poly("x*y - y*x + 3").isConstant() && poly("x*y - y*x + 3").leadingCoefficient() == 3);
+    expect("x - x is zero", poly("x - x").isZero() && poly("x - x").degree() == -1);
+    expect("division by a constant", poly("(4x^2 + 2) / 2") == poly("2x^2 + 1"));
+    expect("constant subtrees fold", poly("sqrt(4) * x + 2^3") == poly("2x + 8"));
+
+    Polynomial p = poly("(x + y)^2 - x*y");
+    expect("terms combined", p.termCount() == 3 && p.degree() == 2 && p.degree("y") == 2);
+    expect("evaluate", p.evaluate({{"x", 2}, {"y", 3}}) == 19);
+    expect("derivative", p.derivative("x") == poly("2x + y"));
+    expect("variables sorted", p.variables() == std::vector<std::string>({"x", "y"}));
+
+    Polynomial back = Polynomial::fromSymbolic(*p.toSymbolic());
+    expect("toSymbolic round trip", back == p);
+    expect("toSymbolic evaluates alike", p.toSymbolic()->evaluate({{"x", -1.5}, {"y", 0.25}}) ==
+                                             p.evaluate({{"x", -1.5}, {"y", 0.25}}));
+
+    expect("sin(x) rejected", throws("sin(x)"));
+    expect("1 / x rejected", throws("1 / x"));
+    expect("x^y rejected", throws("x^y"));
+    expect("x^0.5 rejected", throws("x^0.5"));
+}
+
+void testExpand() {
+    std::cout << "Testing expansion" << std::endl;
+    std::vector<double> c = poly("(x + 1)^50").coefficients("x");
+    bool exact = c.size() == 51;
+    int64_t binomial = 1;
+    for (int k = 0; exact && k <= 50; ++k) {
+        exact = c[k] == static_cast<double>(binomial);
+        binomial = binomial * (50 - k) / (k + 1);
+    }
+    expect("(x + 1)^50 has the exact binomial coefficients", exact);
+    expect("C(50, 25) = 126410606437752", c.size() == 51 && c[25] == 126410606437752.0);
+
+    Polynomial big = poly("(x - 2)^200");
+    expect("(x - 2)^200 has 201 terms", big.termCount() == 201 && big.degree() == 200);
+    std::vector<double> d = big.coefficients("x");
+    expect("(x - 2)^200 low coefficients", d[0] == std::ldexp(1.0, 200) && d[1] == -200 * std::ldexp(1.0, 199));
+
+    Polynomial trinomial = poly("(x + y + z)^10");
+    expect("(x + y + z)^10 has 66 terms", trinomial.termCount() == 66);
+    expect("multinomial sum is 3^10", trinomial.evaluate({{"x", 1}, {"y", 1}, {"z", 1}}) == 59049);
+
+    Polynomial sparse = poly("(x^1000 + y^1000 + 1) * (x^999 - y^500 + 2)");
+    expect("sparse product of high powers", sparse.termCount() == 9 && sparse.degree() == 1999);
+
+    ExpressionParser parser;
+    parser.parse("(x + 1)^3");
+    SymbolicEngine engine;
+    engine.parseFromAST(parser.getAST());
+    expect("engine expand", Polynomial::fromSymbolic(*engine.expand()) == poly("x^3 + 3x^2 + 3x + 1"));
+}
+
+void testGcd() {
+    std::cout << "Testing GCD and square-free decomposition" << std::endl;
+    expect("gcd((x - 1)(x + 2)^2, (x + 2)(x - 3)) = x + 2",
+           Polynomial::gcd(poly("(x - 1)(x + 2)^2"), poly("(x + 2)(x - 3)")) == poly("x + 2"));
+    expect("integer content kept", Polynomial::gcd(poly("6x^2 + 12x + 6"), poly("4x + 4")) == poly("2x + 2"));
+    expect("coprime", Polynomial::gcd(poly("x^2 + 1"), poly("x^3 - 2")) == Polynomial::constant(1));
+    expect("gcd with zero", Polynomial::gcd(Polynomial(), poly("-3x + 6")) == poly("3x - 6"));
+    expect("high degree", Polynomial::gcd(poly("(x + 1)^20 * (x - 5)"), poly("(x + 1)^15 * (x + 7)")) ==
+                              poly("(x + 1)^15"));
+
+    bool rejected = false;
+    try {
+        Polynomial::gcd(poly("x + y"), poly("x"));
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    expect("multivariate gcd rejected", rejected);
+
+    auto parts = poly("(x - 1) * (x + 2)^2 * (x^2 + 1)^3").squareFree();
+    expect("three square-free parts", parts.size() == 3);
+    if (parts.size() == 3) {
+        expect("multiplicity 1", parts[0].first == poly("x - 1") && parts[0].second == 1);
+        expect("multiplicity 2", parts[1].first == poly("x + 2") && parts[1].second == 2);
+        expect("multiplicity 3", parts[2].first == poly("x^2 + 1") && parts[2].second == 3);
+    }
+}
+
+void checkFactor(const std::string& text, double content, const std::vector<std::pair<std::string, unsigned>>& expected) {
+    Polynomial p = poly(text);
+    PolynomialFactorization f = p.factor();
+    bool ok = f.content == content && f.factors.size() == expected.size() && f.expand() == p;
+    for (size_t i = 0; ok && i < expected.size(); ++i) {
+        ok = f.factors[i].first == poly(expected[i].first) && f.factors[i].second == expected[i].second;
+    }
+    expect("factor " + text, ok);
+    if (!ok) {
+        std::cout << "    got " << f.content;
+        for (const auto& [factor, multiplicity] : f.factors) {
+            std::cout << " * [" << factor.toString() << "]^" << multiplicity;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void testFactor() {
+    std::cout << "Testing factorization" << std::endl;
+    checkFactor("x^2 + x", 1, {{"x", 1}, {"x + 1", 1}});
+    checkFactor("6x^3 - 6x", 6, {{"x", 1}, {"x - 1", 1}, {"x + 1", 1}});
+    checkFactor("2x^2 - x - 1", 1, {{"x - 1", 1}, {"2x + 1", 1}});
+    checkFactor("4 - x^2", -1, {{"x - 2", 1}, {"x + 2", 1}});
+    checkFactor("(x^2 + 1) * (x - 3)^2", 1, {{"x - 3", 2}, {"x^2 + 1", 1}});
+    checkFactor("x^4 + 1", 1, {{"x^4 + 1", 1}});
+    checkFactor("x^2*y + x*y^2", 1, {{"x", 1}, {"x + y", 1}, {"y", 1}});
+    checkFactor("(3x - 2)^5 * (x + 4)^3 * x^2", 1, {{"x", 2}, {"x + 4", 3}, {"3x - 2", 5}});
+
+    // Coefficients past 2^53: factor() gives up quietly, squareFree() throws
+    Polynomial inexact = poly("(x + 1)^60");
+    PolynomialFactorization whole = inexact.factor();
+    expect("inexact coefficients left whole", whole.factors.size() == 1 && whole.factors[0].first == inexact);
+    bool threw = false;
+    try {
+        inexact.squareFree();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    expect("squareFree rejects inexact coefficients", threw);
+}
+
+void testEngineFactor() {
+    std::cout << "Testing SymbolicEngine::factor" << std::endl;
+    auto factorText = [](const std::string& text) {
+        SymbolicEngine engine;
+        engine.parseFromString(text);
+        std::string joined;
+        for (const auto& factor : engine.factor()) joined += (joined.empty() ? "" : " * ") + factor->toString();
+        return joined;
+    };
+    expect("x^2 + x", factorText("x^2 + x") == "x * (x + 1)");
+    expect("x^2 stays a power", factorText("x^2") == "(x ^ 2)");
+    expect("x^3 - x", factorText("x^3 - x") == "x * (x - 1) * (x + 1)");
+    expect("content first", factorText("4x^2 - 4") == "4 * (x - 1) * (x + 1)");
+    expect("repeated factor as a power", factorText("x^2 + 2x + 1") == "((x + 1) ^ 2)");
+    expect("non-polynomial unchanged", factorText("sin(x)") == "sin(x)");
+}
+
+int main() {
+    std::cout << "=== Polynomial Test ===\n\n";
+
+    testArithmetic();
+    testExpand();
+    testGcd();
+    testFactor();
+    testEngineFactor();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "cas/Quadrature.h"
+#include "cas/SymbolicEngine.h"
+#include "test_harness.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+
+CompiledExpression compile(const std::string& text) {
+    ExpressionParser parser;
+    parser.parse(text);
+    return parser.compile({"x"});
+}
+
+QuadratureResult integrate(const std::string& text, double a, double b,
+                           const QuadratureOptions& options = QuadratureOptions()) {
+    return Quadrature::integrate(compile(text), "x", {}, a, b, options);
+}
+
+void checkIntegral(const std::string& text, double a, double b, double expected, double tolerance = 1e-9) {
+    QuadratureResult result = integrate(text, a, b);
+    bool ok = result.converged && std::abs(result.value - expected) <= tolerance * std::max(1.0, std::abs(expected));
+    expect(text + " over [" + std::to_string(a) + ", " + std::to_string(b) + "]", ok);
+    if (!ok) {
+        std::cout << "    got " << result.value << " (error " << result.errorEstimate << "), expected " << expected
+                  << std::endl;
+    }
+}
+
+void testQuadrature() {
+    std::cout << "Testing adaptive Gauss-Kronrod" << std::endl;
+    checkIntegral("x^2", 0, 3, 9);
+    checkIntegral("x * sin(x)", 0, M_PI, M_PI);
+    checkIntegral("1 / (1 + x^2)", -10, 10, 2 * std::atan(10.0));
+    checkIntegral("sin(50 * x)^2", 0, 1, 0.5 - std::sin(100.0) / 200);
+    checkIntegral("x^3 - x", 1, -1, 0);
+    checkIntegral("2^x", 0, 1, 1 / std::log(2.0));
+    checkIntegral("1 / sqrt(x)", 0, 1, 2, 1e-6);   // integrable endpoint singularity
+    checkIntegral("abs(x - 0.3)", -1, 1, (1.3 * 1.3 + 0.7 * 0.7) / 2);
+
+    QuadratureResult smooth = integrate("cos(x)", 0, 1);
+    expect("smooth integrands need one interval", smooth.intervals == 1 && smooth.evaluations == 15);
+
+    QuadratureResult empty = integrate("x", 2, 2);
+    expect("empty interval", empty.converged && empty.value == 0 && empty.evaluations == 0);
+
+    QuadratureOptions tight;
+    tight.maxIntervals = 8;
+    QuadratureResult capped = integrate("sin(1 / (x + 0.001))", 0, 1, tight);
+    expect("interval cap reports non-convergence", !capped.converged && capped.intervals <= 8);
+
+    QuadratureResult hole = integrate("sqrt(x)", -1, 1);
+    expect("domain holes give NaN", !hole.converged && std::isnan(hole.value));
+
+    ExpressionParser parser;
+    parser.parse("a * x^2 + b");
+    CompiledExpression program = parser.compile();
+    QuadratureResult bound = Quadrature::integrate(program, "x", {{"a", 3}, {"b", 1}}, 0, 2);
+    expect("parameters are bound", bound.converged && std::abs(bound.value - 10) < 1e-12);
+    bool threw = false;
+    try {
+        Quadrature::integrate(program, "x", {{"a", 3}}, 0, 2);
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()) == "Undefined variable: b";
+    }
+    expect("unbound parameters throw", threw);
+}
+
+void testParallel() {
+    std::cout << "Testing parallel rounds" << std::endl;
+    CompiledExpression program = compile("sin(1 / (x + 0.01)) * x");
+    QuadratureOptions serial;
+    serial.parallelPoints = static_cast<size_t>(-1);
+    QuadratureOptions parallel;
+    parallel.parallelPoints = 1;
+    ThreadPool pool(4);
+    QuadratureResult a = Quadrature::integrate(program, "x", {}, 0, 1, serial, pool);
+    QuadratureResult b = Quadrature::integrate(program, "x", {}, 0, 1, parallel, pool);
+    expect("oscillatory integrand converges", a.converged && a.intervals > 16);
+    expect("thread count does not change the result", a.value == b.value && a.intervals == b.intervals);
+}
+
+void testEngine() {
+    std::cout << "Testing SymbolicEngine::integrateNumeric" << std::endl;
+    SymbolicEngine engine;
+    engine.parseFromString("x^2");
+    QuadratureResult result = engine.integrateNumeric("x", 0, 3);
+    expect("symbolic path first", result.symbolic && std::abs(result.value - 9) < 1e-12);
+
+    engine.parseFromString("x * sin(x)");
+    result = engine.integrateNumeric("x", 0, M_PI);
+    expect("numeric fallback for products", !result.symbolic && result.converged &&
+                                                std::abs(result.value - M_PI) < 1e-9);
+
+    engine.parseFromString("1 / x");
+    result = engine.integrateNumeric("x", -2, -1);
+    expect("fallback when the antiderivative is undefined", !result.symbolic && result.converged &&
+                                                                std::abs(result.value + std::log(2.0)) < 1e-9);
+
+    engine.parseFromString("x^-2");
+    result = engine.integrateNumeric("x", -1, 1);
+    expect("no antiderivative across a pole", !result.symbolic && !result.converged);
+    result = engine.integrateNumeric("x", -1, 2);
+    expect("pole off the centre diverges too", !result.symbolic && !result.converged);
+    result = engine.integrateNumeric("x", 1, 2);
+    expect("antiderivative away from the pole", result.symbolic && std::abs(result.value - 0.5) < 1e-12);
+
+    engine.parseFromString("x^(-0.5)");
+    result = engine.integrateNumeric("x", 0, 1);
+    expect("integrable singularity at an end", result.symbolic && result.converged && result.value == 2);
+
+    engine.parseFromString("k * cos(x)");
+    result = engine.integrateNumeric("x", 0, M_PI / 2, 1e-12, {{"k", 4}});
+    expect("parameters", std::abs(result.value - 4) < 1e-10);
+}
+
+int main() {
+    std::cout << "=== Quadrature Test ===\n\n";
+
+    testQuadrature();
+    testParallel();
+    testEngine();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
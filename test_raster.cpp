@@ -0,0 +1,164 @@
+#include "grapher/RasterRenderer.h"
+#include "util/ThreadPool.h"
+#include "test_harness.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+bool isColor(const uint8_t* p, uint8_t r, uint8_t g, uint8_t b) {
+    return p[0] == r && p[1] == g && p[2] == b && p[3] == 255;
+}
+
+RasterPlot samplePlot() {
+    RasterPlot plot;
+    plot.width = 200;
+    plot.height = 100;
+    plot.xMin = -5;
+    plot.xMax = 5;
+    plot.yMin = -2.5;
+    plot.yMax = 2.5;
+    plot.functions.push_back(RasterFunction{"sin(x)", "sine", RasterColor{255, 0, 0, 255}});
+    return plot;
+}
+
+// Darkest red-dominant pixel in column x, or -1
+int curveRow(const RasterImage& image, int x) {
+    int best = -1;
+    int bestCoverage = 0;
+    for (int y = 0; y < image.height; ++y) {
+        const uint8_t* p = image.pixel(x, y);
+        int coverage = p[0] - p[1];
+        if (coverage > bestCoverage) {
+            bestCoverage = coverage;
+            best = y;
+        }
+    }
+    return best;
+}
+
+void testRender() {
+    std::cout << "Testing raster rendering" << std::endl;
+
+    RasterPlot plot = samplePlot();
+    RasterImage image = RasterRenderer::render(plot);
+    expect("image has the plot size", image.width == 200 && image.height == 100 && image.pixels.size() == 200 * 100 * 4);
+    expect("background is white", isColor(image.pixel(3, 3), 255, 255, 255));
+    expect("x-axis is black", isColor(image.pixel(150, 50), 0, 0, 0));
+    expect("y-axis is black", isColor(image.pixel(100, 10), 0, 0, 0));
+    expect("grid line at x = 1", isColor(image.pixel(120, 5), 200, 200, 200));
+
+    // The curve passes within a pixel of sin(x) in every column
+    bool follows = true;
+    for (int x = 5; x < 195; x += 7) {
+        if (x == 100) continue;
+        double worldX = -5 + (x + 0.5) * 10.0 / 200;
+        double expected = (2.5 - std::sin(worldX)) * 100.0 / 5.0 - 0.5;
+        int row = curveRow(image, x);
+        if (row < 0 || std::abs(row - expected) > 1.0) follows = false;
+    }
+    expect("curve follows sin(x)", follows);
+
+    plot.functions[0].expression = "1/x";
+    plot.showGrid = false;
+    image = RasterRenderer::render(plot);
+    bool poleBridged = false;
+    for (int y = 5; y < 95; ++y) {
+        const uint8_t* p = image.pixel(100, y);
+        if (p[0] > 128 && p[1] < 128) poleBridged = true;
+    }
+    expect("no line across the pole of 1/x", !poleBridged);
+
+    plot.functions.push_back(RasterFunction{"y + x", "", RasterColor{}});
+    plot.functions.push_back(RasterFunction{"sin(", "", RasterColor{}});
+    RasterImage skipped = RasterRenderer::render(plot);
+    expect("unplottable functions are skipped", skipped.pixels == image.pixels);
+}
+
+uint32_t readBig(const std::string& data, size_t at) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(data[at])) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(data[at + 1])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(data[at + 2])) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(data[at + 3]));
+}
+
+void testFormats() {
+    std::cout << "Testing PNG and SVG output" << std::endl;
+
+    RasterPlot plot = samplePlot();
+    RasterImage image = RasterRenderer::render(plot);
+    std::string png = RasterRenderer::encodePNG(image);
+    std::cout << "  PNG: " << png.size() << " bytes for " << image.pixels.size() << " bytes of pixels" << std::endl;
+    expect("PNG signature", png.compare(0, 8, "\x89PNG\r\n\x1a\n") == 0);
+    expect("IHDR holds the size", png.compare(12, 4, "IHDR") == 0 && readBig(png, 16) == 200 && readBig(png, 20) == 100);
+    expect("ends with IEND", png.compare(png.size() - 8, 4, "IEND") == 0);
+    expect("run-length deflate compresses the chart", png.size() * 4 < image.pixels.size());
+
+    std::string svg = RasterRenderer::renderSVG(plot);
+    expect("SVG has a polyline per strip", svg.find("<polyline") != std::string::npos);
+    expect("SVG uses the function color", svg.find("stroke=\"#ff0000\"") != std::string::npos);
+    expect("SVG carries the legend", svg.find(">sine</text>") != std::string::npos);
+
+    expect("format from extension", RasterRenderer::formatForPath("chart.PNG") == ImageFormat::PNG &&
+                                    RasterRenderer::formatForPath("a/b.svg") == ImageFormat::SVG);
+    bool threw = false;
+    try {
+        RasterRenderer::formatForPath("chart.gif");
+    } catch (const std::exception&) {
+        threw = true;
+    }
+    expect("unknown extension throws", threw);
+}
+
+void testBatch() {
+    std::cout << "Testing batch rendering" << std::endl;
+
+    std::vector<RasterPlot> plots;
+    const char* expressions[] = {"sin(x)", "x^2 - 1", "1/x", "sqrt(x)", "cos(3x) * x / 4"};
+    for (int i = 0; i < 40; ++i) {
+        RasterPlot plot = samplePlot();
+        plot.functions[0].expression = expressions[i % 5];
+        plot.xMin = -5 - i * 0.1;
+        plots.push_back(plot);
+    }
+
+    ThreadPool pool(4);
+    std::vector<RasterImage> images = RasterRenderer::renderMany(plots, &pool);
+    bool same = images.size() == plots.size();
+    for (size_t i = 0; same && i < plots.size(); ++i) {
+        same = images[i].pixels == RasterRenderer::render(plots[i]).pixels;
+    }
+    expect("batch matches one-at-a-time rendering", same);
+
+    std::vector<RasterPlot> two(plots.begin(), plots.begin() + 2);
+    std::vector<std::string> paths = {"test_raster_0.png", "test_raster_1.png"};
+    RasterRenderer::exportMany(two, paths, ImageFormat::PNG, &pool);
+    std::ifstream file(paths[1], std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    expect("exportMany writes each file",
+           contents == RasterRenderer::encodePNG(RasterRenderer::render(two[1])));
+    for (const auto& path : paths) std::remove(path.c_str());
+
+    bool threw = false;
+    try {
+        RasterRenderer::exportMany(two, {"missing_directory/chart.png", "test_raster_ok.svg"}, ImageFormat::SVG, &pool);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    std::remove("test_raster_ok.svg");
+    expect("unwritable path throws after the batch", threw);
+}
+
+int main() {
+    std::cout << "=== Raster Renderer Test ===\n\n";
+
+    testRender();
+    testFormats();
+    testBatch();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "cas/RootFinder.h"
+#include "cas/SymbolicEngine.h"
+#include "server/EvalServer.h"
+#include "test_harness.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+bool rootsMatch(const std::vector<Root>& roots, const std::vector<double>& expected, double tolerance = 1e-9) {
+    if (roots.size() != expected.size()) {
+        std::cout << "    found " << roots.size() << " roots:";
+        for (const Root& r : roots) std::cout << " " << r.x;
+        std::cout << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < roots.size(); ++i) {
+        if (!near(expected[i], roots[i].x, tolerance)) return false;
+    }
+    return true;
+}
+
+std::vector<Root> findAll(const std::string& text, double lo, double hi) {
+    Expression f = Expression::parse(text);
+    return RootFinder(f.program()).findAll(lo, hi);
+}
+
+void testDualBytecode() {
+    std::cout << "Testing bytecode derivatives" << std::endl;
+    Expression f = Expression::parse("x^3 * sin(y) + ln(x) / x");
+    double slots[] = {2.0, 0.5};   // slot order of first use: x, y
+    double dx = 0, dy = 0;
+    EvalStatus status = EvalStatus::OK;
+    double value = f.program().evalDerivative(slots, 0, dx, status);
+    f.program().evalDerivative(slots, 1, dy, status);
+    expect("value matches eval", value == f.program().eval(slots));
+    expect("d/dx", near(12 * std::sin(0.5) + (1 - std::log(2.0)) / 4, dx));
+    expect("d/dy", near(8 * std::cos(0.5), dy));
+
+    double x = 0;
+    expect("domain errors give NaN and a status",
+           std::isnan(Expression::parse("ln(x)").program().evalDerivative(&x, 0, dx, status)) &&
+               status == EvalStatus::LN_DOMAIN);
+}
+
+void testFindAll() {
+    std::cout << "Testing findAll" << std::endl;
+    expect("cubic", rootsMatch(findAll("x^3 - 6*x^2 + 11*x - 6", -10, 10), {1, 2, 3}));
+    expect("sin over several periods", rootsMatch(findAll("sin(x)", -7, 7), {-2 * M_PI, -M_PI, 0, M_PI, 2 * M_PI}));
+    expect("root on the interval ends", rootsMatch(findAll("x^2 - 4", -2, 2), {-2, 2}));
+    const double pi = 3.14159265358979;   // sin(pi) is about 3e-15
+    expect("near-zero residual at the ends", rootsMatch(findAll("sin(x)", 0, pi), {0, pi}) &&
+                                                 rootsMatch(findAll("sin(x)", -pi, -1), {-pi}));
+    expect("touching root", rootsMatch(findAll("(x - 1.3)^2", -5, 5), {1.3}, 1e-6));
+    expect("no roots", findAll("x^2 + 1", -5, 5).empty());
+    expect("poles are not roots", findAll("1 / (x - 0.3)", -2, 2).empty());
+    expect("tan: roots but no poles", rootsMatch(findAll("tan(x)", -4, 4), {-M_PI, 0, M_PI}));
+    expect("domain holes are skipped", rootsMatch(findAll("ln(x) - 1", -3, 5), {std::exp(1.0)}));
+    expect("variable exponent", rootsMatch(findAll("x^x - 2", 0.5, 3), {1.5596104694623694}));
+
+    std::vector<Root> roots = findAll("x^2 - 2", 0, 2);
+    expect("sign changes are refined in a bracket", roots.size() == 1 && roots[0].bracketed &&
+                                                        std::abs(roots[0].residual) < 1e-14 &&
+                                                        roots[0].iterations < 10);
+}
+
+void testErrors() {
+    std::cout << "Testing errors" << std::endl;
+    Expression f = Expression::parse("a*x^2 - b");
+    bool threw = false;
+    try {
+        RootFinder finder(f.program(), "x", {{"a", 1}});
+    } catch (const std::runtime_error& e) {
+        threw = std::string(e.what()) == "Undefined variable: b";
+    }
+    expect("unbound parameters throw", threw);
+    expect("parameters are bound", rootsMatch(RootFinder(f.program(), "x", {{"a", 2}, {"b", 8}}).findAll(-5, 5),
+                                               {-2, 2}));
+    expect("solving for another variable", rootsMatch(RootFinder(f.program(), "b", {{"a", 2}, {"x", 3}}).findAll(0, 100),
+                                                      {18}));
+
+    SymbolicEngine engine;
+    engine.parseFromString("x^2 - 3*x");
+    std::vector<double> roots = engine.solveNumeric("x", -10, 10);
+    expect("SymbolicEngine::solveNumeric", roots.size() == 2 && near(0, roots[0]) && near(3, roots[1]));
+    engine.parseFromString("sin(x)");
+    roots = engine.solveNumeric("x", 0, 3.14159265358979);
+    expect("solveNumeric keeps a root at hi", roots.size() == 2 && roots[1] == 3.14159265358979);
+}
+
+void testSolveMany() {
+    std::cout << "Testing solveMany" << std::endl;
+    Expression f = Expression::parse("x^2 - c");
+    std::vector<RootQuery> queries;
+    for (int i = 1; i <= 500; ++i) {
+        RootQuery query;
+        query.equation = f;
+        query.lo = 0;
+        query.hi = 40;
+        query.parameters["c"] = i;
+        queries.push_back(query);
+    }
+    RootQuery broken;
+    broken.equation = f;
+    broken.lo = 0;
+    broken.hi = 1;
+    queries.push_back(broken);
+
+    ThreadPool pool(4);
+    std::vector<RootResult> results = RootFinder::solveMany(queries, RootOptions(), pool);
+    bool all = results.size() == queries.size();
+    for (int i = 1; i <= 500 && all; ++i) {
+        all = results[i - 1].error.empty() && rootsMatch(results[i - 1].roots, {std::sqrt(static_cast<double>(i))});
+    }
+    expect("parameter sweep in parallel", all);
+    expect("failed queries report errors", results.back().error == "Undefined variable: c");
+}
+
+void testServer() {
+    std::cout << "Testing the roots request" << std::endl;
+    EvalServer server;
+    double first = 0, second = 0;
+    std::string response = server.handle("roots x^2 - 2 ; -3 3");
+    expect("roots", std::sscanf(response.c_str(), "ok %lf %lf", &first, &second) == 2 && near(-std::sqrt(2.0), first) &&
+                        near(std::sqrt(2.0), second));
+    expect("named variable and bindings", server.handle("roots y - k ; y 0 10 k=4") == "ok 4");
+    expect("no roots", server.handle("roots x^2 + 1 ; -1 1") == "ok");
+    expect("bad arguments", server.handle("roots x ; 1").rfind("error Expected", 0) == 0);
+}
+
+int main() {
+    std::cout << "=== Root Finder Test ===\n\n";
+
+    testDualBytecode();
+    testFindAll();
+    testErrors();
+    testSolveMany();
+    testServer();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
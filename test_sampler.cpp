@@ -0,0 +1,312 @@
+#include "grapher/Sampler.h"
+#include "grapher/SampleTileCache.h"
+#include "parser/ExpressionParser.h"
+#include "util/ThreadPool.h"
+#include "test_harness.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+bool sameSample(double a, double b) {
+    return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+void testPoolCoversEveryIndex() {
+    std::cout << "Testing work-stealing pool" << std::endl;
+
+    ThreadPool pool(4);
+    const size_t n = 10000;
+    std::vector<std::atomic<int>> hits(n);
+
+    // The first chunks are slow, so other threads must steal them to finish
+    pool.parallelFor(n, 16, [&](size_t begin, size_t end) {
+        if (begin < 160) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        for (size_t i = begin; i < end; ++i) {
+            hits[i]++;
+        }
+    });
+    bool exactlyOnce = true;
+    for (auto& h : hits) {
+        if (h != 1) exactlyOnce = false;
+    }
+    expect("every index runs exactly once", exactlyOnce);
+
+    bool rethrown = false;
+    try {
+        pool.parallelFor(n, 16, [](size_t begin, size_t) {
+            if (begin == 4096) throw std::runtime_error("chunk failed");
+        });
+    } catch (const std::runtime_error& e) {
+        rethrown = std::string(e.what()) == "chunk failed";
+    }
+    expect("body exceptions reach the caller", rethrown);
+
+    std::atomic<size_t> total{0};
+    pool.parallelFor(3, 1, [&](size_t begin, size_t end) { total += end - begin; });
+    expect("pool is reusable after an exception", total == 3);
+}
+
+void testUniformMatchesSerial() {
+    std::cout << "Testing parallel uniform sampling" << std::endl;
+
+    std::vector<std::string> expressions = {"x", "0"};
+    for (int k = 1; k <= 22; ++k) {
+        expressions.push_back("sin(" + std::to_string(k) + "x) / x + ln(x + " + std::to_string(k) + ")");
+    }
+    expressions.push_back("x + y");
+
+    std::vector<CompiledExpression> compiled;
+    for (const auto& expr : expressions) {
+        ExpressionParser parser;
+        parser.parse(expr);
+        compiled.push_back(parser.compile({"x"}));
+    }
+    std::vector<const CompiledExpression*> programs;
+    for (const auto& program : compiled) {
+        programs.push_back(&program);
+    }
+    compiled.push_back(CompiledExpression());
+    programs.push_back(&compiled.back());
+
+    ThreadPool pool(4);
+    const size_t count = 5000;
+    const double xMin = -30, xMax = 30;
+    std::vector<SampleBuffer> samples = Sampler::sampleUniform(programs, xMin, xMax, count, &pool);
+
+    bool allMatch = true;
+    for (size_t f = 0; f + 2 < programs.size(); ++f) {
+        const SampleBuffer& buffer = samples[f];
+        if (buffer.xs.size() != count + 1) {
+            allMatch = false;
+            continue;
+        }
+        std::vector<double> xs(count + 1), ys(count + 1);
+        for (size_t i = 0; i <= count; ++i) {
+            xs[i] = xMin + static_cast<double>(i) * ((xMax - xMin) / count);
+        }
+        const double* columns[] = {xs.data()};
+        programs[f]->evalBatch(columns, ys.data(), xs.size());
+        for (size_t i = 0; i <= count; ++i) {
+            if (buffer.xs[i] != xs[i] || !sameSample(buffer.ys[i], ys[i])) allMatch = false;
+        }
+    }
+    expect("24 functions match serial batch evaluation", allMatch);
+    expect("functions of other variables are skipped", samples[programs.size() - 2].xs.empty());
+    expect("empty programs are skipped", samples.back().xs.empty());
+}
+
+CompiledExpression compileX(const std::string& expr) {
+    ExpressionParser parser;
+    parser.parse(expr);
+    return parser.compile({"x"});
+}
+
+// Largest distance, in pixels, between the curve and the polyline through the samples
+double worstLineError(const CompiledExpression& program, const SampleBuffer& samples, const SampleViewport& view) {
+    const double pixelsPerY = view.height / (view.yMax - view.yMin);
+    double worst = 0;
+    for (size_t i = 0; i + 1 < samples.xs.size(); ++i) {
+        for (int k = 1; k < 8; ++k) {
+            double t = k / 8.0;
+            double x = samples.xs[i] + t * (samples.xs[i + 1] - samples.xs[i]);
+            double line = samples.ys[i] + t * (samples.ys[i + 1] - samples.ys[i]);
+            worst = std::max(worst, std::abs(program.eval(&x) - line) * pixelsPerY);
+        }
+    }
+    return worst;
+}
+
+void testAdaptive() {
+    std::cout << "Testing adaptive sampling" << std::endl;
+
+    SampleViewport view{-10, 10, -10, 10, 800, 600};
+    AdaptiveSampleOptions options;
+
+    CompiledExpression flat = compileX("3");
+    SampleBuffer flatSamples = Sampler::sampleAdaptive(flat, view, options);
+    std::cout << "  constant: " << flatSamples.xs.size() << " evaluations" << std::endl;
+    expect("flat curves use a fraction of uniform sampling", flatSamples.xs.size() < 801 / 3);
+
+    CompiledExpression wave = compileX("sin(x) * 8");
+    SampleBuffer waveSamples = Sampler::sampleAdaptive(wave, view, options);
+    double waveError = worstLineError(wave, waveSamples, view);
+    std::cout << "  sin(x) * 8: " << waveSamples.xs.size() << " evaluations, worst error "
+              << waveError << " px" << std::endl;
+    expect("smooth curve stays within a pixel of its polyline", waveError < 1.0);
+    expect("smooth curve needs fewer evaluations than pixels", waveSamples.xs.size() < 800);
+    expect("samples are sorted", std::is_sorted(waveSamples.xs.begin(), waveSamples.xs.end()));
+
+    CompiledExpression pole = compileX("1 / x");
+    SampleBuffer poleSamples = Sampler::sampleAdaptive(pole, view, options);
+    double nearest = 1e9;
+    for (double x : poleSamples.xs) {
+        if (x != 0) nearest = std::min(nearest, std::abs(x));
+    }
+    std::cout << "  1 / x: " << poleSamples.xs.size() << " evaluations, nearest sample to the pole "
+              << nearest << std::endl;
+    expect("samples crowd the pole", nearest < 0.01);
+    expect("evaluation count stays bounded", poleSamples.xs.size() <= options.maxEvaluations);
+
+    CompiledExpression edge = compileX("sqrt(x)");
+    SampleBuffer edgeSamples = Sampler::sampleAdaptive(edge, view, options);
+    double firstDefined = 1e9;
+    for (size_t i = 0; i < edgeSamples.xs.size(); ++i) {
+        if (!std::isnan(edgeSamples.ys[i])) firstDefined = std::min(firstDefined, edgeSamples.xs[i]);
+    }
+    expect("domain edge is located to within a pixel", firstDefined < 20.0 / 800);
+
+    AdaptiveSampleOptions tight = options;
+    tight.maxEvaluations = 300;
+    SampleBuffer capped = Sampler::sampleAdaptive(compileX("sin(20x) * 9"), view, tight);
+    expect("maxEvaluations is a hard cap", capped.xs.size() <= 300);
+
+    // Point-plotting mode: no vertical gaps bigger than one cell
+    SampleViewport cells{-10, 10, -10, 10, 80, 24};
+    AdaptiveSampleOptions gaps;
+    gaps.tolerance = std::numeric_limits<double>::infinity();
+    gaps.maxStepPixels = 1.0;
+    gaps.initialSegments = 80;
+    CompiledExpression cubic = compileX("x^3 - 2x");
+    SampleBuffer cubicSamples = Sampler::sampleAdaptive(cubic, cells, gaps);
+    bool gapFree = true;
+    for (size_t i = 0; i + 1 < cubicSamples.xs.size(); ++i) {
+        double a = cubicSamples.ys[i], b = cubicSamples.ys[i + 1];
+        bool onScreen = std::abs(a) <= 10 && std::abs(b) <= 10;
+        if (onScreen && std::abs(a - b) * 24 / 20 > 1.0) gapFree = false;
+    }
+    expect("point mode leaves no vertical gaps on screen", gapFree);
+    expect("point mode keeps one sample per column", cubicSamples.xs.size() > 80);
+}
+
+// Every cached sample must match a direct evaluation at the same x (batch
+// kernels may differ from scalar evaluation in the last bit)
+bool matchesDirect(const CompiledExpression& program, const SampleBuffer& samples) {
+    for (size_t i = 0; i < samples.xs.size(); ++i) {
+        double x = samples.xs[i];
+        EvalStatus status = EvalStatus::OK;
+        double expected = program.eval(&x, status);
+        if (!sameSample(expected, samples.ys[i]) &&
+            !(std::abs(expected - samples.ys[i]) <= 1e-12 * std::max(1.0, std::abs(expected)))) {
+            return false;
+        }
+    }
+    return !samples.xs.empty();
+}
+
+void testTileCache() {
+    std::cout << "Testing sample tile cache" << std::endl;
+
+    CompiledExpression wave = compileX("sin(3x) / x");
+    CompiledExpression root = compileX("sqrt(x) * 2");
+    std::vector<SampleSource> sources = {{1, &wave}, {2, &root}};
+    ThreadPool pool(4);
+    SampleTileCache cache;
+
+    std::vector<SampleBuffer> first = cache.sample(sources, -10, 10, 800, &pool);
+    size_t firstMisses = cache.getStats().misses;
+    const SampleBuffer& waveSamples = first[0];
+    double widest = 0;
+    for (size_t i = 0; i + 1 < waveSamples.xs.size(); ++i) {
+        widest = std::max(widest, waveSamples.xs[i + 1] - waveSamples.xs[i]);
+    }
+    std::cout << "  first frame: " << firstMisses << " tiles evaluated, " << waveSamples.xs.size()
+              << " samples per function" << std::endl;
+    expect("samples match direct evaluation", matchesDirect(wave, first[0]) && matchesDirect(root, first[1]));
+    expect("samples are at most one pixel apart", widest <= 20.0 / 800);
+    expect("samples cover the view", waveSamples.xs.front() <= -10 && waveSamples.xs.back() >= 10);
+    expect("samples are sorted", std::is_sorted(waveSamples.xs.begin(), waveSamples.xs.end()));
+
+    std::vector<SampleBuffer> again = cache.sample(sources, -10, 10, 800, &pool);
+    expect("unchanged view evaluates nothing", cache.getStats().misses == firstMisses);
+    expect("unchanged view returns the same samples", again[0].xs == first[0].xs);
+
+    cache.sample(sources, -8, 12, 800, &pool);
+    size_t panMisses = cache.getStats().misses - firstMisses;
+    std::cout << "  pan by 10%: " << panMisses << " new tiles" << std::endl;
+    expect("pan evaluates only newly exposed tiles", panMisses > 0 && panMisses <= 2 * sources.size());
+
+    std::vector<SampleBuffer> zoomed = cache.sample(sources, -5, 5, 800, &pool);
+    expect("zoom samples at the finer level", matchesDirect(wave, zoomed[0]) && zoomed[0].xs.size() >= 800);
+
+    size_t before = cache.size();
+    cache.invalidate(1);
+    expect("invalidate drops one function's tiles", cache.size() < before);
+    size_t missesBefore = cache.getStats().misses;
+    cache.sample(sources, -5, 5, 800, &pool);
+    expect("invalidated function is evaluated again", cache.getStats().misses > missesBefore);
+
+    cache.setCapacity(16);
+    cache.sample(sources, 100, 120, 800, &pool);
+    expect("capacity evicts the least recently used tiles", cache.size() <= 16 && cache.getStats().evictions > 0);
+
+    CompiledExpression other = compileX("x + y");
+    expect("non-plottable sources get no samples",
+           cache.sample({{3, &other}}, -1, 1, 100, &pool)[0].xs.empty());
+}
+
+double nearestToZero(const SampleBuffer& samples) {
+    double nearest = 1e9;
+    for (double x : samples.xs) {
+        if (x != 0) nearest = std::min(nearest, std::abs(x));
+    }
+    return nearest;
+}
+
+void testRefineTiles() {
+    std::cout << "Testing refinement of cached tiles" << std::endl;
+
+    CompiledExpression pole = compileX("1 / x");
+    CompiledExpression edge = compileX("sqrt(x - 0.003)");
+    SampleTileCache cache;
+    std::vector<SampleBuffer> coarse = cache.sample({{1, &pole}, {2, &edge}}, -10, 10, 800);
+
+    SampleViewport view{-10, 10, -10, 10, 800, 600};
+    AdaptiveSampleOptions options;
+    options.maxEvaluations = 3200;
+    std::vector<SampleBuffer> refined = Sampler::refine({&pole, &edge}, coarse, view, options);
+    std::cout << "  1 / x: " << coarse[0].xs.size() << " tile samples, " << refined[0].xs.size()
+              << " after refinement, nearest sample to the pole " << nearestToZero(refined[0]) << std::endl;
+
+    bool keepsTiles = std::all_of(coarse[0].xs.begin(), coarse[0].xs.end(), [&](double x) {
+        return std::binary_search(refined[0].xs.begin(), refined[0].xs.end(), x);
+    });
+    expect("tile samples are kept", keepsTiles);
+    expect("refined samples are sorted", std::is_sorted(refined[0].xs.begin(), refined[0].xs.end()));
+    expect("refined samples match direct evaluation", matchesDirect(pole, refined[0]) && matchesDirect(edge, refined[1]));
+    expect("samples crowd the pole", nearestToZero(refined[0]) <= nearestToZero(coarse[0]) / 16);
+    expect("new evaluations stay within maxEvaluations",
+           refined[0].xs.size() <= coarse[0].xs.size() + options.maxEvaluations);
+
+    double firstDefined = 1e9;
+    for (size_t i = 0; i < refined[1].xs.size(); ++i) {
+        if (!std::isnan(refined[1].ys[i])) firstDefined = std::min(firstDefined, refined[1].xs[i]);
+    }
+    expect("domain edge between tile samples is located", firstDefined - 0.003 < 20.0 / 800 / 8);
+
+    // Only the part of the tiles inside the view is refined
+    SampleViewport right{1, 10, -10, 10, 360, 600};
+    SampleBuffer partial = Sampler::refine(pole, coarse[0], right, options);
+    expect("segments outside the view are not split",
+           std::count_if(partial.xs.begin(), partial.xs.end(), [](double x) { return x < 1; }) ==
+               std::count_if(coarse[0].xs.begin(), coarse[0].xs.end(), [](double x) { return x < 1; }));
+}
+
+int main() {
+    std::cout << "=== Sampler Test ===\n\n";
+
+    testPoolCoversEveryIndex();
+    testUniformMatchesSerial();
+    testAdaptive();
+    testTileCache();
+    testRefineTiles();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
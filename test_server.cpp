@@ -0,0 +1,137 @@
+#include "server/EvalServer.h"
+#include "util/ThreadPool.h"
+#include "test_harness.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+void expectResponse(EvalServer& server, const std::string& request, const std::string& expected) {
+    std::string response = server.handle(request);
+    std::cout << "  " << request << " -> " << response << std::endl;
+    expect("answers \"" + expected + "\"", response == expected);
+}
+
+void testRequests() {
+    std::cout << "Testing requests" << std::endl;
+
+    EvalServer server;
+    expectResponse(server, "eval 2 + 3 * 4", "ok 14");
+    expectResponse(server, "eval x^2 + y ; x=3, y=0.5", "ok 9.5");
+    expectResponse(server, "eval 0.1 + 0.2", "ok 0.30000000000000004");
+    expectResponse(server, "diff x^3", "ok 3((x ^ 2))");
+    expectResponse(server, "diff x * y ; y", "ok x");
+    expectResponse(server, "simplify x + x + x", "ok 3x");
+    expectResponse(server, "integrate 2 * x", "ok (x ^ 2)");
+    expectResponse(server, "parse 2 * x + 1", "ok ((2 * x) + 1)");
+
+    expectResponse(server, "eval 1 / 0", "error Division by zero");
+    expectResponse(server, "eval x + y ; x=1", "error Undefined variable: y");
+    expectResponse(server, "eval x ; x=abc", "error Bad value in binding 'x=abc'");
+    expectResponse(server, "eval 2 + )", "error Parse error: Unexpected token: )");
+    expectResponse(server, "solve x", "error Unknown request 'solve'");
+    expectResponse(server, "eval", "error Missing expression");
+}
+
+void testCache() {
+    std::cout << "Testing expression cache" << std::endl;
+
+    ServerOptions options;
+    options.cacheCapacity = 3;
+    EvalServer server(options);
+    server.handle("eval x^2 ; x=1");
+    server.handle("eval x^2 ; x=2");
+    server.handle("diff x^2");
+    server.handle("diff x^2");
+    ServerStats stats = server.getStats();
+    expect("one parse for repeated text", stats.cacheMisses == 1 && stats.cacheHits == 3);
+    expect("one cached expression", stats.cachedExpressions == 1);
+
+    server.handle("eval 1");
+    server.handle("eval 2");
+    server.handle("eval 3");
+    expect("cache stays within capacity", server.getStats().cachedExpressions <= 3);
+    expect("least recently used entries are evicted", server.getStats().cacheEvictions == 1);
+    server.handle("eval 3");
+    expect("recently used entry is a hit", server.getStats().cacheMisses == 4);
+    expect("stats request", server.handle("stats").compare(0, 12, "ok requests=") == 0);
+}
+
+void testBatch() {
+    std::cout << "Testing batches" << std::endl;
+
+    std::vector<std::string> requests;
+    const char* kinds[] = {"eval sin(x) * x ; x=", "diff x^3 + sin(x) ; x", "simplify x + 2*x + y*0 ; ", "eval 1/(x-3) ; x="};
+    for (int i = 0; i < 400; ++i) {
+        std::string request = kinds[i % 4];
+        if (request.back() == '=') request += std::to_string(i % 7);
+        requests.push_back(request);
+    }
+
+    ThreadPool pool(4);
+    ServerOptions options;
+    options.pool = &pool;
+    EvalServer parallel(options);
+    EvalServer serial;
+    std::vector<std::string> responses = parallel.handleBatch(requests);
+    bool same = responses.size() == requests.size();
+    for (size_t i = 0; same && i < requests.size(); ++i) {
+        same = responses[i] == serial.handle(requests[i]);
+    }
+    expect("batch answers in request order", same);
+    expect("batch parses each text once", parallel.getStats().cachedExpressions <= 4 + 7 * 2);
+}
+
+void testServe() {
+    std::cout << "Testing stream framing" << std::endl;
+
+    EvalServer server;
+    std::istringstream in("eval 1 + 1\n\nbatch 3\ndiff x^2\neval x ; x=4\nbogus\r\nbatch two\nquit\neval 5\n");
+    std::ostringstream out;
+    server.serve(in, out);
+    expect("responses in order, quit stops", out.str() ==
+           "ok 2\nok 2x\nok 4\nerror Unknown request 'bogus'\nerror Bad batch size 'two'\n");
+
+    ServerOptions limited;
+    limited.maxBatch = 2;
+    EvalServer small(limited);
+    std::istringstream oversized("batch 99999999999999999\nbatch 3\neval 1\nbatch 2\neval 2\neval 3\n");
+    std::ostringstream refused;
+    small.serve(oversized, refused);
+    expect("oversized batches are refused", refused.str() ==
+           "error Batch size 99999999999999999 exceeds the limit of 2\n"
+           "error Batch size 3 exceeds the limit of 2\nok 1\nok 2\nok 3\n");
+
+    // Several connections share one server
+    std::vector<std::thread> clients;
+    std::vector<std::string> outputs(4);
+    for (int c = 0; c < 4; ++c) {
+        clients.emplace_back([&server, &outputs, c]() {
+            std::string script;
+            for (int i = 0; i < 50; ++i) {
+                script += "batch 2\neval x * 2 ; x=" + std::to_string(i) + "\ndiff x^" + std::to_string(i % 5 + 2) + "\n";
+            }
+            std::istringstream clientIn(script);
+            std::ostringstream clientOut;
+            server.serve(clientIn, clientOut);
+            outputs[c] = clientOut.str();
+        });
+    }
+    for (auto& client : clients) client.join();
+    bool consistent = true;
+    for (int c = 1; c < 4; ++c) consistent = consistent && outputs[c] == outputs[0];
+    expect("concurrent connections get the same answers", consistent && outputs[0].find("ok 98\n") != std::string::npos);
+}
+
+int main() {
+    std::cout << "=== Evaluation Server Test ===\n\n";
+
+    testRequests();
+    testCache();
+    testBatch();
+    testServe();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
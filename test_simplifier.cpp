@@ -0,0 +1,190 @@
+#include "cas/SymbolicEngine.h"
+#include "cas/ExpressionStore.h"
+#include "cas/Simplifier.h"
+#include "test_harness.h"
+#include <iostream>
+#include <map>
+#include <cmath>
+
+bool sameValue(double a, double b) {
+    if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(a));
+}
+
+// Simplified form must evaluate like the original wherever the original is defined
+bool agreesNumerically(const ExpressionStore& store, const ExprNode* original, const ExprNode* simplified) {
+    for (double x : {-2.3, -0.7, 0.4, 1.1, 2.9}) {
+        std::map<std::string, double> vars = {{"x", x}, {"y", 0.8}};
+        double expected;
+        try {
+            expected = store.evaluate(original, vars);
+        } catch (const std::exception&) {
+            continue;
+        }
+        if (!sameValue(expected, store.evaluate(simplified, vars))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testCanonicalForm(const std::string& expr, const std::string& expected) {
+    std::cout << "Testing " << expr << std::endl;
+
+    SymbolicEngine engine;
+    if (!engine.parseFromString(expr)) {
+        std::cout << "  Parse error" << std::endl;
+        failures++;
+        return;
+    }
+
+    const ExprNode* simplified = engine.simplifyNode();
+    std::string result = engine.getStore().toString(simplified);
+    std::cout << "  -> " << result << std::endl;
+    expect("canonical form is " + expected, result == expected);
+    expect("evaluates like the original", agreesNumerically(engine.getStore(), engine.getNode(), simplified));
+    expect("reaches a fixed point", engine.getSimplifier().getLastRun().converged);
+}
+
+void testEquivalentFormsShareANode() {
+    std::cout << "Testing equivalent inputs share one canonical node" << std::endl;
+
+    SymbolicEngine engine;
+    ExpressionStore& store = engine.getStore();
+    Simplifier& simplifier = engine.getSimplifier();
+
+    auto canonical = [&](const std::string& expr) {
+        SymbolicEngine parser;
+        parser.parseFromString(expr);
+        return simplifier.simplify(store.intern(parser.getExpression()));
+    };
+
+    expect("x + x == 2x", canonical("x + x") == canonical("2x"));
+    expect("a*b == b*a", canonical("x * y") == canonical("y * x"));
+    expect("(x+1)+y == y+(1+x)", canonical("(x + 1) + y") == canonical("y + (1 + x)"));
+    expect("x*x*x == x^3", canonical("x * x * x") == canonical("x^3"));
+    expect("x^2/x == x", canonical("x^2 / x") == canonical("x"));
+    expect("-(x - y) == y - x", canonical("-(x - y)") == canonical("y - x"));
+}
+
+void testDerivativeShrinks() {
+    std::cout << "Testing simplified derivatives are smaller" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("x^3 * sin(x) + x^2 / (1 + x)");
+    ExpressionStore& store = engine.getStore();
+
+    const ExprNode* derivative = engine.differentiateNode("x", 2);
+    const ExprNode* simplified = engine.getSimplifier().simplify(derivative);
+
+    double before = ExpressionStore::treeSize(derivative);
+    double after = ExpressionStore::treeSize(simplified);
+    std::cout << "  second derivative: " << before << " -> " << after << " tree nodes" << std::endl;
+    expect("simplified tree is smaller", after < before);
+    expect("evaluates like the original", agreesNumerically(store, derivative, simplified));
+
+    const ExprNode* again = engine.getSimplifier().simplify(simplified);
+    expect("simplify is idempotent", again == simplified);
+    expect("second call is answered from the cache", engine.getSimplifier().getLastRun().cacheHits > 0);
+}
+
+void testStepBudget() {
+    std::cout << "Testing step budget" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("sin(x) * cos(x) / x");
+    const ExprNode* derivative = engine.differentiateNode("x", 3);
+
+    Simplifier limited(engine.getStore(), SimplifierOptions{16, 10});
+    const ExprNode* partial = limited.simplify(derivative);
+    expect("budget stops before convergence", !limited.getLastRun().converged);
+    expect("step count respects the budget", limited.getLastRun().steps <= 10);
+    expect("partial result is still equivalent", agreesNumerically(engine.getStore(), derivative, partial));
+}
+
+// Value at x, NaN where evaluation fails
+double valueAt(const ExpressionStore& store, const ExprNode* node, double x) {
+    try {
+        return store.evaluate(node, {{"x", x}});
+    } catch (const std::exception&) {
+        return std::nan("");
+    }
+}
+
+// Merging powers must not define the result where the original is undefined
+void testDomainKept() {
+    std::cout << "Testing powers keep their domain" << std::endl;
+
+    for (const char* expr : {"x^(1/2) * x^(1/2)", "x^(1/2) * x^(-1/2)", "(x^(1/2))^2", "x * x^(1/2)",
+                             "x^(1/3) * x^(1/3) * x^(1/3)", "sqrt(x) * sqrt(x)"}) {
+        SymbolicEngine engine;
+        engine.parseFromString(expr);
+        const ExprNode* simplified = engine.simplifyNode();
+        std::cout << "  " << expr << " -> " << engine.getStore().toString(simplified) << std::endl;
+        bool same = true;
+        for (double x : {-2.0, -0.5, 0.25, 3.0}) {
+            same = same && sameValue(valueAt(engine.getStore(), engine.getNode(), x),
+                                     valueAt(engine.getStore(), simplified, x));
+        }
+        expect(std::string(expr) + " keeps its values and domain", same);
+    }
+    testCanonicalForm("x * x^(1/2)", "(x ^ 1.5)");
+    testCanonicalForm("x^3 / x", "(x ^ 2)");
+}
+
+// An undefined constant is NaN, which must not pass for -1 or cancel out
+void testUndefinedConstants() {
+    std::cout << "Testing undefined constants" << std::endl;
+
+    for (const char* expr : {"(-8)^(1/3)*x", "(0-8)^0.5*x", "x*(-8)^(1/3) + x"}) {
+        SymbolicEngine engine;
+        engine.parseFromString(expr);
+        const ExprNode* simplified = engine.simplifyNode();
+        std::string result = engine.getStore().toString(simplified);
+        std::cout << "  " << expr << " -> " << result << std::endl;
+        expect(std::string(expr) + " is not -x or 0", result != "-x" && result != "0");
+        expect(std::string(expr) + " stays undefined", std::isnan(engine.getStore().evaluate(simplified, {{"x", 2.0}})));
+    }
+}
+
+void testErrors() {
+    std::cout << "Testing errors" << std::endl;
+
+    SymbolicEngine engine;
+    engine.parseFromString("x / (2 - 2)");
+    bool threw = false;
+    try {
+        engine.simplifyNode();
+    } catch (const std::exception& e) {
+        threw = std::string(e.what()) == "Division by zero";
+    }
+    expect("division by a zero constant throws", threw);
+}
+
+int main() {
+    std::cout << "=== Simplifier Test ===\n\n";
+
+    testCanonicalForm("x + x + x", "3x");
+    testCanonicalForm("0 + x * 1", "x");
+    testCanonicalForm("2*x + 3*x - x", "4x");
+    testCanonicalForm("x^2 + 3x - 5", "(((x ^ 2) + 3x) - 5)");
+    testCanonicalForm("x * x^2 * 2", "2((x ^ 3))");
+    testCanonicalForm("(x^2)^3", "(x ^ 6)");
+    testCanonicalForm("(2x)^2", "4((x ^ 2))");
+    testCanonicalForm("2 / x", "(2 / x)");
+    testCanonicalForm("x^-1 * y", "(y / x)");
+    testCanonicalForm("--x", "x");
+    testCanonicalForm("sin(0) + cos(0)", "1");
+    testCanonicalForm("y*x - x*y", "0");
+    testCanonicalForm("x - (1 - x)", "(2x - 1)");
+    testCanonicalForm("x^3 / 3 - x / 2", "(((x ^ 3) / 3) - (x / 2))");
+    testEquivalentFormsShareANode();
+    testDerivativeShrinks();
+    testStepBudget();
+    testUndefinedConstants();
+    testDomainKept();
+    testErrors();
+
+    std::cout << "\n" << (failures == 0 ? "All tests passed" : "Some tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
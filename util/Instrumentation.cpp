@@ -0,0 +1,89 @@
+#include "Instrumentation.h"
+#include <iomanip>
+
+Instrumentation::Snapshot Instrumentation::snapshot() {
+    Snapshot stats;
+    for (size_t i = 0; i < kCounters; ++i) {
+        stats.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kPhases; ++i) {
+        stats.phases[i].calls = phaseCalls[i].load(std::memory_order_relaxed);
+        stats.phases[i].nanoseconds = phaseNanoseconds[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void Instrumentation::reset() {
+    for (auto& value : counters) value.store(0, std::memory_order_relaxed);
+    for (auto& value : phaseCalls) value.store(0, std::memory_order_relaxed);
+    for (auto& value : phaseNanoseconds) value.store(0, std::memory_order_relaxed);
+}
+
+const char* Instrumentation::name(Counter counter) {
+    switch (counter) {
+        case Counter::NODES_CREATED: return "nodes created";
+        case Counter::ARENA_BYTES: return "arena bytes";
+        case Counter::CLONES: return "clones";
+        case Counter::DIFFERENTIATE_CALLS: return "differentiate calls";
+        case Counter::DIFFERENTIATE_NODES: return "differentiate nodes";
+        case Counter::SIMPLIFY_CALLS: return "simplify calls";
+        case Counter::SIMPLIFY_NODES: return "simplify nodes";
+        case Counter::EVALUATE_CALLS: return "evaluate calls";
+        case Counter::POINTS_EVALUATED: return "batch points";
+        case Counter::UNDEFINED_POINTS: return "undefined points";
+        case Counter::COUNT: break;
+    }
+    return "unknown";
+}
+
+const char* Instrumentation::name(Phase phase) {
+    switch (phase) {
+        case Phase::LEX: return "lex";
+        case Phase::PARSE: return "parse";
+        case Phase::CONVERT: return "convert";
+        case Phase::DIFFERENTIATE: return "differentiate";
+        case Phase::SIMPLIFY: return "simplify";
+        case Phase::COMPILE: return "compile";
+        case Phase::SAMPLE: return "sample";
+        case Phase::RENDER: return "render";
+        case Phase::COUNT: break;
+    }
+    return "unknown";
+}
+
+void Instrumentation::report(std::ostream& out, const Snapshot& stats) {
+    if (!enabled) {
+        out << "  Instrumentation is compiled out (configure with -DCAS_ENABLE_INSTRUMENTATION=ON)" << std::endl;
+        return;
+    }
+
+    auto perCall = [](uint64_t total, uint64_t calls) { return calls ? static_cast<double>(total) / calls : 0.0; };
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << "  Counters" << std::endl;
+    for (size_t i = 0; i < kCounters; ++i) {
+        Counter counter = static_cast<Counter>(i);
+        out << "    " << std::left << std::setw(22) << name(counter) << std::right << std::setw(12)
+            << stats.counters[i];
+        if (counter == Counter::DIFFERENTIATE_NODES) {
+            out << "  (" << perCall(stats.counters[i], stats.counter(Counter::DIFFERENTIATE_CALLS)) << " per call)";
+        } else if (counter == Counter::SIMPLIFY_NODES) {
+            out << "  (" << perCall(stats.counters[i], stats.counter(Counter::SIMPLIFY_CALLS)) << " per call)";
+        }
+        out << std::endl;
+    }
+
+    out << "  Phases" << std::setw(30) << "calls" << std::setw(12) << "total ms" << std::setw(12) << "avg us"
+        << std::endl;
+    for (size_t i = 0; i < kPhases; ++i) {
+        const PhaseStats& phase = stats.phases[i];
+        out << "    " << std::left << std::setw(22) << name(static_cast<Phase>(i)) << std::right << std::setw(12)
+            << phase.calls << std::setprecision(3) << std::setw(12) << phase.milliseconds() << std::setprecision(1)
+            << std::setw(12) << perCall(phase.nanoseconds, phase.calls) / 1e3 << std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
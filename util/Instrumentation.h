@@ -0,0 +1,160 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Instrumentation - opt-in hot-path counters and phase timers.
+//
+// The CAS_COUNT / CAS_COUNT_N / CAS_COUNT_GROWTH / CAS_TIME_PHASE macros
+// compile to nothing, without evaluating their arguments, unless the build
+// defines CAS_ENABLE_INSTRUMENTATION (cmake -DCAS_ENABLE_INSTRUMENTATION=ON).
+// The snapshot API is always available and reads zeros otherwise.
+//
+// Counters are process-wide relaxed atomics, safe to bump from worker
+// threads. A phase records one call per outermost scope on each thread, so
+// recursive entry points (convertASTToSymbolic) and nested ones
+// (SymbolicEngine::simplify into Simplifier::simplify) are timed once.
+// Different phases do nest: parse time includes lex time, and render time
+// includes sampling. Phase times from several threads add up.
+class Instrumentation {
+public:
+    enum class Counter : uint8_t {
+        NODES_CREATED,          // unique DAG nodes interned by any store
+        ARENA_BYTES,            // node arena memory reserved
+        CLONES,                 // SymbolicExpression::clone() calls, per node
+        DIFFERENTIATE_CALLS,
+        DIFFERENTIATE_NODES,    // DAG nodes created by those calls
+        SIMPLIFY_CALLS,
+        SIMPLIFY_NODES,         // DAG nodes created by those calls
+        EVALUATE_CALLS,         // evaluate(variables) calls
+        POINTS_EVALUATED,       // points through batch evaluation
+        UNDEFINED_POINTS,       // plotted samples that failed to evaluate
+        COUNT
+    };
+
+    enum class Phase : uint8_t {
+        LEX,
+        PARSE,
+        CONVERT,
+        DIFFERENTIATE,
+        SIMPLIFY,
+        COMPILE,
+        SAMPLE,
+        RENDER,
+        COUNT
+    };
+
+    static constexpr size_t kCounters = static_cast<size_t>(Counter::COUNT);
+    static constexpr size_t kPhases = static_cast<size_t>(Phase::COUNT);
+
+    struct PhaseStats {
+        uint64_t calls = 0;
+        uint64_t nanoseconds = 0;
+
+        double milliseconds() const { return nanoseconds / 1e6; }
+    };
+
+    struct Snapshot {
+        uint64_t counters[kCounters] = {};
+        PhaseStats phases[kPhases] = {};
+
+        uint64_t counter(Counter c) const { return counters[static_cast<size_t>(c)]; }
+        const PhaseStats& phase(Phase p) const { return phases[static_cast<size_t>(p)]; }
+    };
+
+#ifdef CAS_ENABLE_INSTRUMENTATION
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    // Totals since start-up or the last reset()
+    static Snapshot snapshot();
+    static void reset();
+
+    static const char* name(Counter counter);
+    static const char* name(Phase phase);
+
+    // Readable table of a snapshot, with nodes per call for differentiate
+    // and simplify
+    static void report(std::ostream& out, const Snapshot& stats);
+
+    static void add(Counter counter, uint64_t amount) {
+        counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    // Times the enclosing scope as one call of a phase
+    class ScopedPhase {
+    private:
+        size_t index;
+        bool outermost;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit ScopedPhase(Phase phase) : index(static_cast<size_t>(phase)), outermost(depth[index]++ == 0) {
+            if (outermost) start = std::chrono::steady_clock::now();
+        }
+        ~ScopedPhase() {
+            --depth[index];
+            if (!outermost) return;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            phaseCalls[index].fetch_add(1, std::memory_order_relaxed);
+            phaseNanoseconds[index].fetch_add(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                std::memory_order_relaxed);
+        }
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+    };
+
+    // Adds how much measure() grew across the enclosing scope to a counter
+    template <typename Measure>
+    class ScopedGrowth {
+    private:
+        Counter counter;
+        Measure measure;
+        uint64_t start;
+
+    public:
+        ScopedGrowth(Counter counter, Measure measure) : counter(counter), measure(measure), start(measure()) {}
+        ~ScopedGrowth() { add(counter, this->measure() - start); }
+        ScopedGrowth(const ScopedGrowth&) = delete;
+        ScopedGrowth& operator=(const ScopedGrowth&) = delete;
+    };
+
+    template <typename Measure>
+    static ScopedGrowth<Measure> growth(Counter counter, Measure measure) {
+        return ScopedGrowth<Measure>(counter, measure);
+    }
+
+private:
+    static inline std::atomic<uint64_t> counters[kCounters] = {};
+    static inline std::atomic<uint64_t> phaseCalls[kPhases] = {};
+    static inline std::atomic<uint64_t> phaseNanoseconds[kPhases] = {};
+    static inline thread_local uint32_t depth[kPhases] = {};
+};
+
+#define CAS_INSTRUMENT_CONCAT_(a, b) a##b
+#define CAS_INSTRUMENT_NAME_(base, line) CAS_INSTRUMENT_CONCAT_(base, line)
+
+#ifdef CAS_ENABLE_INSTRUMENTATION
+#define CAS_COUNT(counter) ::Instrumentation::add(::Instrumentation::Counter::counter, 1)
+#define CAS_COUNT_N(counter, amount) \
+    ::Instrumentation::add(::Instrumentation::Counter::counter, static_cast<uint64_t>(amount))
+#define CAS_COUNT_GROWTH(counter, measure)                                                          \
+    auto CAS_INSTRUMENT_NAME_(casGrowth, __LINE__) = ::Instrumentation::growth(                     \
+        ::Instrumentation::Counter::counter, [&]() -> uint64_t { return static_cast<uint64_t>(measure); })
+#define CAS_TIME_PHASE(phase) \
+    ::Instrumentation::ScopedPhase CAS_INSTRUMENT_NAME_(casPhase, __LINE__)(::Instrumentation::Phase::phase)
+#else
+#define CAS_COUNT(counter) ((void)0)
+#define CAS_COUNT_N(counter, amount) ((void)0)
+#define CAS_COUNT_GROWTH(counter, measure) ((void)0)
+#define CAS_TIME_PHASE(phase) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_H
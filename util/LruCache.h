@@ -0,0 +1,113 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+struct LruCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;           // sum of the sizes given to insert()
+
+    double hitRate() const { return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+
+// LruCache - bounded map from keys to shared values, evicting the least
+// recently used entries once either the entry count or the byte total
+// exceeds its limit. Every member takes one mutex, so the cache can be
+// shared between threads; values are handed out as shared_ptr and stay
+// alive for holders after eviction.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+private:
+    struct Entry {
+        Key key;
+        std::shared_ptr<Value> value;
+        size_t bytes;
+    };
+    using Order = std::list<Entry>;   // most recently used first
+
+    mutable std::mutex mutex;
+    Order order;
+    std::unordered_map<Key, typename Order::iterator, Hash> index;
+    size_t maxEntries;
+    size_t maxBytes;
+    LruCacheStats stats;
+
+    void evict() {
+        while (!order.empty() && (order.size() > maxEntries || stats.bytes > maxBytes)) {
+            stats.bytes -= order.back().bytes;
+            index.erase(order.back().key);
+            order.pop_back();
+            stats.evictions++;
+        }
+    }
+
+public:
+    explicit LruCache(size_t maxEntries, size_t maxBytes = std::numeric_limits<size_t>::max())
+        : maxEntries(maxEntries), maxBytes(maxBytes) {}
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    // Value for key, marked most recently used; null (a miss) when absent
+    std::shared_ptr<Value> find(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            stats.misses++;
+            return nullptr;
+        }
+        stats.hits++;
+        order.splice(order.begin(), order, it->second);
+        return it->second->value;
+    }
+
+    // Adds value under key and returns it. When another thread inserted the
+    // key first, the existing value is kept and returned instead.
+    std::shared_ptr<Value> insert(const Key& key, std::shared_ptr<Value> value, size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            order.splice(order.begin(), order, it->second);
+            return it->second->value;
+        }
+        order.push_front(Entry{key, std::move(value), bytes});
+        index.emplace(key, order.begin());
+        stats.bytes += bytes;
+        std::shared_ptr<Value> result = order.front().value;
+        evict();
+        return result;
+    }
+
+    void setCapacity(size_t entries, size_t bytes = std::numeric_limits<size_t>::max()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxEntries = entries;
+        maxBytes = bytes;
+        evict();
+    }
+
+    // Drops every entry and resets the counters
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.clear();
+        index.clear();
+        stats = LruCacheStats();
+    }
+
+    LruCacheStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        LruCacheStats current = stats;
+        current.entries = order.size();
+        return current;
+    }
+};
+
+#endif // LRU_CACHE_H
@@ -0,0 +1,598 @@
+#include "Number.h"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef GMP_AVAILABLE
+#include <gmp.h>
+#endif
+
+namespace {
+
+// Exact powers whose result would need more bits than this give REAL
+constexpr double kMaxExactBits = 1 << 20;
+
+// Decimal exponents beyond this are parsed as doubles
+constexpr int64_t kMaxDecimalExponent = 400;
+
+int64_t gcd64(int64_t a, int64_t b) {
+    a = a < 0 ? -a : a;
+    b = b < 0 ? -b : b;
+    while (b != 0) {
+        int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+int bitLength(int64_t value) {
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    int bits = 0;
+    while (magnitude) {
+        bits++;
+        magnitude >>= 1;
+    }
+    return bits;
+}
+
+size_t combineHash(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+} // namespace
+
+// ============================================================================
+// Heap rationals
+// ============================================================================
+
+// Nested so the GMP helpers can reach Number's representation
+struct Number::Big {
+    std::atomic<long> refs{1};
+#ifdef GMP_AVAILABLE
+    mpq_t value;
+
+    Big() { mpq_init(value); }
+    ~Big() { mpq_clear(value); }
+
+    static void setInt64(mpz_t z, int64_t v) {
+        if (v >= LONG_MIN && v <= LONG_MAX) {
+            mpz_set_si(z, static_cast<long>(v));
+            return;
+        }
+        uint64_t magnitude = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+        mpz_import(z, 1, 1, sizeof(magnitude), 0, 0, &magnitude);
+        if (v < 0) mpz_neg(z, z);
+    }
+
+    // |z| < 2^63, so the value fits int64 and is not INT64_MIN
+    static bool fitsInt64(mpz_srcptr z) { return mpz_sizeinbase(z, 2) <= 63; }
+
+    static int64_t getInt64(mpz_srcptr z) {
+        if (mpz_fits_slong_p(z)) return mpz_get_si(z);
+        uint64_t magnitude = 0;
+        mpz_export(&magnitude, nullptr, 1, sizeof(magnitude), 0, 0, z);
+        int64_t v = static_cast<int64_t>(magnitude);
+        return mpz_sgn(z) < 0 ? -v : v;
+    }
+
+    // out = n (exact kinds only); out must be initialized
+    static void load(const Number& n, mpq_t out) {
+        switch (n.tag) {
+            case Kind::INTEGER:
+                setInt64(mpq_numref(out), n.small);
+                mpz_set_ui(mpq_denref(out), 1);
+                break;
+            case Kind::RATIONAL:
+                setInt64(mpq_numref(out), n.ratio.num);
+                setInt64(mpq_denref(out), n.ratio.den);
+                break;
+            case Kind::BIG:
+                mpq_set(out, n.big->value);
+                break;
+            case Kind::REAL:
+                mpq_set_d(out, n.real);
+                break;
+        }
+    }
+
+    // Canonical q as a Number, inline when it fits
+    static Number wrap(const mpq_t q) {
+        if (fitsInt64(mpq_numref(q)) && fitsInt64(mpq_denref(q))) {
+            return makeRatio(getInt64(mpq_numref(q)), getInt64(mpq_denref(q)));
+        }
+        Number result;
+        result.tag = Kind::BIG;
+        result.big = new Big();
+        mpq_set(result.big->value, q);
+        return result;
+    }
+
+    // a op b for exact operands
+    static Number apply(const Number& a, const Number& b, void (*op)(mpq_ptr, mpq_srcptr, mpq_srcptr)) {
+        mpq_t x, y;
+        mpq_init(x);
+        mpq_init(y);
+        load(a, x);
+        load(b, y);
+        op(x, x, y);
+        Number result = wrap(x);
+        mpq_clear(x);
+        mpq_clear(y);
+        return result;
+    }
+#endif
+};
+
+void Number::release() {
+    if (big->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete big;
+    }
+}
+
+void Number::spillMinimum() {
+#ifdef GMP_AVAILABLE
+    mpq_t q;
+    mpq_init(q);
+    Big::setInt64(mpq_numref(q), small);
+    big = new Big();
+    mpq_set(big->value, q);
+    tag = Kind::BIG;
+    mpq_clear(q);
+#else
+    real = static_cast<double>(small);
+    tag = Kind::REAL;
+#endif
+}
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+Number::Number(const Number& other) : tag(other.tag), ratio(other.ratio) {
+    if (tag == Kind::BIG) big->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+Number::Number(Number&& other) noexcept : tag(other.tag), ratio(other.ratio) {
+    other.tag = Kind::INTEGER;
+    other.small = 0;
+}
+
+Number& Number::operator=(const Number& other) {
+    if (this != &other) {
+        if (other.tag == Kind::BIG) other.big->refs.fetch_add(1, std::memory_order_relaxed);
+        if (tag == Kind::BIG) release();
+        tag = other.tag;
+        ratio = other.ratio;
+    }
+    return *this;
+}
+
+Number& Number::operator=(Number&& other) noexcept {
+    if (this != &other) {
+        if (tag == Kind::BIG) release();
+        tag = other.tag;
+        ratio = other.ratio;
+        other.tag = Kind::INTEGER;
+        other.small = 0;
+    }
+    return *this;
+}
+
+Number Number::makeReal(double value) {
+    // Integral results collapse to INTEGER, so 0.5 * 4 and 2 are the same
+    // number; 2^63 bounds the int64 range (-2^63 is excluded like INT64_MIN)
+    // and -0.0 stays REAL so it keeps its sign
+    if (std::isfinite(value) && value == std::floor(value) && std::abs(value) < 9223372036854775808.0 &&
+        !(value == 0.0 && std::signbit(value))) {
+        return Number(static_cast<long long>(value));
+    }
+    Number result;
+    result.tag = Kind::REAL;
+    result.real = value;
+    return result;
+}
+
+Number Number::makeRatio(int64_t num, int64_t den) {
+    int64_t g = gcd64(num, den);
+    if (g > 1) {
+        num /= g;
+        den /= g;
+    }
+    if (den == 1 || num == 0) return Number(static_cast<long long>(num));
+    Number result;
+    result.tag = Kind::RATIONAL;
+    result.ratio = Ratio{num, den};
+    return result;
+}
+
+Number Number::rational(int64_t num, int64_t den) {
+    if (den == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    if (den > 0 && num != std::numeric_limits<int64_t>::min()) {
+        return makeRatio(num, den);
+    }
+    return Number(static_cast<long long>(num)) / Number(static_cast<long long>(den));
+}
+
+Number Number::fromDouble(double value) {
+    return makeReal(value);
+}
+
+Number Number::parse(std::string_view text) {
+    size_t i = 0;
+    bool digits = false;
+    int64_t scale = 0;
+
+    // Digits accumulate in an int64 until it would overflow
+    int64_t fast = 0;
+    bool isFast = true;
+    Number mantissa;
+    auto pushDigit = [&](int digit) {
+        if (isFast) {
+            int64_t shifted;
+            if (!mulOverflows(fast, 10, shifted) && !addOverflows(shifted, digit, shifted)) {
+                fast = shifted;
+                return;
+            }
+            mantissa = Number(static_cast<long long>(fast));
+            isFast = false;
+        }
+        mantissa = mantissa * Number(10) + Number(digit);
+    };
+
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+        pushDigit(text[i] - '0');
+        digits = true;
+    }
+    if (i < text.size() && text[i] == '.') {
+        for (++i; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+            pushDigit(text[i] - '0');
+            scale--;
+            digits = true;
+        }
+    }
+    if (!digits) {
+        throw std::runtime_error("Invalid number: " + std::string(text));
+    }
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        size_t j = i + 1;
+        int64_t exponentSign = 1;
+        if (j < text.size() && (text[j] == '+' || text[j] == '-')) {
+            exponentSign = text[j] == '-' ? -1 : 1;
+            j++;
+        }
+        int64_t exponent = 0;
+        bool exponentDigits = false;
+        for (; j < text.size() && text[j] >= '0' && text[j] <= '9'; ++j) {
+            if (exponent < 100000) exponent = exponent * 10 + (text[j] - '0');
+            exponentDigits = true;
+        }
+        if (exponentDigits) scale += exponentSign * exponent;
+    }
+
+    Number value = isFast ? Number(static_cast<long long>(fast)) : mantissa;
+    if (scale == 0 || value.isZero()) return value;
+    if (scale > kMaxDecimalExponent || scale < -kMaxDecimalExponent) {
+        return makeReal(std::strtod(std::string(text).c_str(), nullptr));
+    }
+    Number power = Number(10).pow(Number(static_cast<long long>(scale < 0 ? -scale : scale)));
+    return scale > 0 ? value * power : value / power;
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+bool Number::isInteger() const {
+    switch (tag) {
+        case Kind::INTEGER: return true;
+        case Kind::RATIONAL: return false;
+        case Kind::BIG:
+#ifdef GMP_AVAILABLE
+            return mpz_cmp_ui(mpq_denref(big->value), 1) == 0;
+#else
+            return false;
+#endif
+        case Kind::REAL: return std::isfinite(real) && real == std::floor(real);
+    }
+    return false;
+}
+
+int Number::sign() const {
+    switch (tag) {
+        case Kind::INTEGER: return (small > 0) - (small < 0);
+        case Kind::RATIONAL: return (ratio.num > 0) - (ratio.num < 0);
+        case Kind::BIG:
+#ifdef GMP_AVAILABLE
+            return mpq_sgn(big->value);
+#else
+            return 0;
+#endif
+        case Kind::REAL: return (real > 0) - (real < 0);
+    }
+    return 0;
+}
+
+double Number::toDouble() const {
+    switch (tag) {
+        case Kind::INTEGER: return static_cast<double>(small);
+        case Kind::RATIONAL: return static_cast<double>(ratio.num) / static_cast<double>(ratio.den);
+        case Kind::BIG:
+#ifdef GMP_AVAILABLE
+            return mpq_get_d(big->value);
+#else
+            return 0.0;
+#endif
+        case Kind::REAL: return real;
+    }
+    return 0.0;
+}
+
+std::string Number::toString() const {
+    switch (tag) {
+        case Kind::INTEGER: return std::to_string(small);
+        case Kind::RATIONAL: return std::to_string(ratio.num) + "/" + std::to_string(ratio.den);
+        case Kind::BIG: {
+#ifdef GMP_AVAILABLE
+            char* digits = mpq_get_str(nullptr, 10, big->value);
+            std::string text(digits);
+            void (*freeFunction)(void*, size_t);
+            mp_get_memory_functions(nullptr, nullptr, &freeFunction);
+            freeFunction(digits, text.size() + 1);
+            return text;
+#else
+            return "";
+#endif
+        }
+        case Kind::REAL: {
+            std::ostringstream oss;
+            oss << real;
+            return oss.str();
+        }
+    }
+    return "";
+}
+
+bool Number::identical(const Number& other) const {
+    if (tag != other.tag) return false;
+    switch (tag) {
+        case Kind::INTEGER: return small == other.small;
+        case Kind::RATIONAL: return ratio.num == other.ratio.num && ratio.den == other.ratio.den;
+        case Kind::BIG:
+#ifdef GMP_AVAILABLE
+            return mpq_equal(big->value, other.big->value) != 0;
+#else
+            return big == other.big;
+#endif
+        case Kind::REAL: return std::memcmp(&real, &other.real, sizeof(real)) == 0;
+    }
+    return false;
+}
+
+size_t Number::hash() const {
+    size_t seed = static_cast<size_t>(tag);
+    switch (tag) {
+        case Kind::INTEGER: return combineHash(seed, std::hash<int64_t>()(small));
+        case Kind::RATIONAL:
+            return combineHash(combineHash(seed, std::hash<int64_t>()(ratio.num)), std::hash<int64_t>()(ratio.den));
+        case Kind::BIG:
+#ifdef GMP_AVAILABLE
+            // Low limbs and sizes; equal values always agree
+            seed = combineHash(seed, mpz_get_ui(mpq_numref(big->value)));
+            seed = combineHash(seed, mpz_get_ui(mpq_denref(big->value)));
+            return combineHash(seed, mpz_size(mpq_numref(big->value)) * (mpq_sgn(big->value) + 2));
+#else
+            return seed;
+#endif
+        case Kind::REAL: {
+            uint64_t bits;
+            std::memcpy(&bits, &real, sizeof(bits));
+            return combineHash(seed, std::hash<uint64_t>()(bits));
+        }
+    }
+    return seed;
+}
+
+size_t Number::heapBytes() const {
+#ifdef GMP_AVAILABLE
+    if (tag == Kind::BIG) {
+        return sizeof(Big) +
+               (mpz_size(mpq_numref(big->value)) + mpz_size(mpq_denref(big->value))) * sizeof(mp_limb_t);
+    }
+#endif
+    return 0;
+}
+
+int Number::compare(const Number& a, const Number& b) {
+    if (a.tag == Kind::INTEGER && b.tag == Kind::INTEGER) {
+        return (a.small > b.small) - (a.small < b.small);
+    }
+    if (a.tag == Kind::REAL || b.tag == Kind::REAL) {
+        double x = a.toDouble();
+        double y = b.toDouble();
+        if (x != x || y != y) {
+            return (x != x) - (y != y);
+        }
+        return (x > y) - (x < y);
+    }
+    return (a - b).sign();
+}
+
+// ============================================================================
+// Arithmetic
+// ============================================================================
+
+Number Number::addSlow(const Number& a, const Number& b) {
+    if (a.tag == Kind::REAL || b.tag == Kind::REAL) {
+        return makeReal(a.toDouble() + b.toDouble());
+    }
+    if (a.tag != Kind::BIG && b.tag != Kind::BIG) {
+        Ratio x = a.tag == Kind::INTEGER ? Ratio{a.small, 1} : a.ratio;
+        Ratio y = b.tag == Kind::INTEGER ? Ratio{b.small, 1} : b.ratio;
+        // Over the lcm of the denominators
+        int64_t g = gcd64(x.den, y.den);
+        int64_t den, left, right, num;
+        if (!mulOverflows(x.den / g, y.den, den) && !mulOverflows(x.num, y.den / g, left) &&
+            !mulOverflows(y.num, x.den / g, right) && !addOverflows(left, right, num)) {
+            return makeRatio(num, den);
+        }
+    }
+#ifdef GMP_AVAILABLE
+    return Big::apply(a, b, mpq_add);
+#else
+    return makeReal(a.toDouble() + b.toDouble());
+#endif
+}
+
+Number Number::mulSlow(const Number& a, const Number& b) {
+    if (a.tag == Kind::REAL || b.tag == Kind::REAL) {
+        return makeReal(a.toDouble() * b.toDouble());
+    }
+    if (a.tag != Kind::BIG && b.tag != Kind::BIG) {
+        Ratio x = a.tag == Kind::INTEGER ? Ratio{a.small, 1} : a.ratio;
+        Ratio y = b.tag == Kind::INTEGER ? Ratio{b.small, 1} : b.ratio;
+        // Cross-reduce first so the products stay as small as possible
+        int64_t g1 = gcd64(x.num, y.den);
+        int64_t g2 = gcd64(y.num, x.den);
+        if (g1 == 0) g1 = 1;
+        if (g2 == 0) g2 = 1;
+        int64_t num, den;
+        if (!mulOverflows(x.num / g1, y.num / g2, num) && !mulOverflows(x.den / g2, y.den / g1, den)) {
+            return makeRatio(num, den);
+        }
+    }
+#ifdef GMP_AVAILABLE
+    return Big::apply(a, b, mpq_mul);
+#else
+    return makeReal(a.toDouble() * b.toDouble());
+#endif
+}
+
+Number Number::operator/(const Number& other) const {
+    if (other.isZero()) {
+        throw std::runtime_error("Division by zero");
+    }
+    if (tag == Kind::REAL || other.tag == Kind::REAL) {
+        return makeReal(toDouble() / other.toDouble());
+    }
+    if (other.tag == Kind::INTEGER || other.tag == Kind::RATIONAL) {
+        // Multiply by the reciprocal, which always fits inline
+        Ratio y = other.tag == Kind::INTEGER ? Ratio{other.small, 1} : other.ratio;
+        int64_t num = y.num < 0 ? -y.den : y.den;
+        int64_t den = y.num < 0 ? -y.num : y.num;
+        return *this * makeRatio(num, den);
+    }
+#ifdef GMP_AVAILABLE
+    return Big::apply(*this, other, mpq_div);
+#else
+    return makeReal(toDouble() / other.toDouble());
+#endif
+}
+
+Number Number::operator-() const {
+    switch (tag) {
+        case Kind::INTEGER: return Number(static_cast<long long>(-small));
+        case Kind::RATIONAL: {
+            Number result = *this;
+            result.ratio.num = -ratio.num;
+            return result;
+        }
+        case Kind::BIG: {
+#ifdef GMP_AVAILABLE
+            mpq_t q;
+            mpq_init(q);
+            mpq_neg(q, big->value);
+            Number result = Big::wrap(q);
+            mpq_clear(q);
+            return result;
+#else
+            return *this;
+#endif
+        }
+        case Kind::REAL: return makeReal(-real);
+    }
+    return *this;
+}
+
+namespace {
+
+// r with r^q = n for n > 0, if there is one
+bool exactRoot(int64_t n, int64_t q, int64_t& root) {
+    int64_t guess = std::llround(std::pow(static_cast<double>(n), 1.0 / static_cast<double>(q)));
+    for (int64_t candidate = std::max<int64_t>(1, guess - 1); candidate <= guess + 1; ++candidate) {
+        int64_t power = 1;
+        bool fits = true;
+        for (int64_t i = 0; i < q && fits; ++i) {
+            fits = power <= std::numeric_limits<int64_t>::max() / candidate;
+            power *= candidate;
+        }
+        if (fits && power == n) {
+            root = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+Number Number::pow(const Number& exponent) const {
+    if (exponent.tag == Kind::INTEGER && isExact()) {
+        int64_t e = exponent.small;
+        if (e == 0) return Number(1);
+        if (isZero()) {
+            if (e < 0) throw std::runtime_error("Division by zero");
+            return Number(0);
+        }
+        if (isOne()) return Number(1);
+
+        double bits;
+        if (tag == Kind::INTEGER) {
+            bits = bitLength(small);
+        } else if (tag == Kind::RATIONAL) {
+            bits = bitLength(ratio.num) + bitLength(ratio.den);
+        } else {
+#ifdef GMP_AVAILABLE
+            bits = static_cast<double>(mpz_sizeinbase(mpq_numref(big->value), 2) +
+                                       mpz_sizeinbase(mpq_denref(big->value), 2));
+#else
+            bits = 64;
+#endif
+        }
+        uint64_t magnitude = e < 0 ? 0 - static_cast<uint64_t>(e) : static_cast<uint64_t>(e);
+        if (bits > 1 && bits * static_cast<double>(magnitude) > kMaxExactBits) {
+            return makeReal(std::pow(toDouble(), exponent.toDouble()));
+        }
+
+        Number result(1);
+        Number base = *this;
+        while (magnitude) {
+            if (magnitude & 1) result *= base;
+            magnitude >>= 1;
+            if (magnitude) base *= base;
+        }
+        return e < 0 ? result.reciprocal() : result;
+    }
+
+    if (exponent.tag == Kind::RATIONAL && exponent.ratio.den <= 64 && sign() > 0 &&
+        (tag == Kind::INTEGER || tag == Kind::RATIONAL)) {
+        Ratio b = tag == Kind::INTEGER ? Ratio{small, 1} : ratio;
+        int64_t num, den;
+        if (exactRoot(b.num, exponent.ratio.den, num) && exactRoot(b.den, exponent.ratio.den, den)) {
+            return makeRatio(num, den).pow(Number(static_cast<long long>(exponent.ratio.num)));
+        }
+    }
+
+    double x = toDouble();
+    double y = exponent.toDouble();
+    if (x == 0.0 && y < 0.0) {
+        throw std::runtime_error("Division by zero");
+    }
+    return makeReal(std::pow(x, y));
+}
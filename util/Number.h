@@ -0,0 +1,198 @@
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+// Number - exact-when-possible scalar for symbolic constants.
+//
+// Four kinds share one 24-byte value:
+//   INTEGER   int64 stored inline
+//   RATIONAL  reduced int64 numerator / denominator > 1, inline
+//   BIG       reference-counted GMP rational on the heap, only for values
+//             that do not fit the inline kinds (shared by copies)
+//   REAL      non-integral double (or -0.0), for inexact results (functions,
+//             irrational powers); integral doubles are stored as INTEGER
+//
+// Integer +, - and * with no overflow run inline without a call; everything
+// else goes through out-of-line paths that try 64-bit rationals first and
+// spill to BIG on overflow, demoting results that fit back to the inline
+// kinds. Arithmetic with a REAL operand is plain double arithmetic. Built
+// without GMP (GMP_AVAILABLE undefined), overflowing results become REAL
+// instead. Values are immutable, so copies may be shared between threads.
+class Number {
+public:
+    enum class Kind : uint8_t {
+        INTEGER,
+        RATIONAL,
+        BIG,
+        REAL
+    };
+
+private:
+    struct Ratio {
+        int64_t num;
+        int64_t den;
+    };
+    struct Big;
+
+    Kind tag;
+    union {
+        int64_t small;
+        Ratio ratio;
+        double real;
+        Big* big;
+    };
+
+    // True on overflow; INT64_MIN counts as overflow so negation is always safe
+    static bool addOverflows(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_add_overflow(a, b, &out) || out == std::numeric_limits<int64_t>::min();
+#else
+        if ((b > 0 && a > std::numeric_limits<int64_t>::max() - b) ||
+            (b < 0 && a <= std::numeric_limits<int64_t>::min() - b)) return true;
+        out = a + b;
+        return false;
+#endif
+    }
+    static bool subOverflows(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_sub_overflow(a, b, &out) || out == std::numeric_limits<int64_t>::min();
+#else
+        if ((b < 0 && a > std::numeric_limits<int64_t>::max() + b) ||
+            (b > 0 && a <= std::numeric_limits<int64_t>::min() + b)) return true;
+        out = a - b;
+        return false;
+#endif
+    }
+    static bool mulOverflows(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_mul_overflow(a, b, &out) || out == std::numeric_limits<int64_t>::min();
+#else
+        if (a != 0 && b != 0) {
+            int64_t limit = std::numeric_limits<int64_t>::max();
+            int64_t ua = a < 0 ? -a : a;
+            int64_t ub = b < 0 ? -b : b;
+            if (a == std::numeric_limits<int64_t>::min() || b == std::numeric_limits<int64_t>::min() ||
+                ua > limit / ub) return true;
+        }
+        out = a * b;
+        return false;
+#endif
+    }
+
+    static Number addSlow(const Number& a, const Number& b);
+    static Number mulSlow(const Number& a, const Number& b);
+    static Number makeReal(double value);
+    static Number makeRatio(int64_t num, int64_t den);   // den > 0, reduces
+
+    void release();
+    void spillMinimum();   // INT64_MIN does not fit INTEGER
+    bool ordered(const Number& other) const { return !isNaN() && !other.isNaN(); }
+
+public:
+    Number() : tag(Kind::INTEGER), small(0) {}
+    Number(int value) : tag(Kind::INTEGER), small(value) {}
+    Number(long value) : Number(static_cast<long long>(value)) {}
+    Number(long long value) : tag(Kind::INTEGER), small(value) {
+        if (value == std::numeric_limits<int64_t>::min()) spillMinimum();
+    }
+
+    Number(const Number& other);
+    Number(Number&& other) noexcept;
+    Number& operator=(const Number& other);
+    Number& operator=(Number&& other) noexcept;
+    ~Number() { if (tag == Kind::BIG) release(); }
+
+    // num / den reduced; throws std::runtime_error when den is 0
+    static Number rational(int64_t num, int64_t den);
+
+    // INTEGER for integral doubles in the int64 range, REAL otherwise
+    static Number fromDouble(double value);
+
+    // Exact value of a decimal literal such as 12, 0.1 or 2.5e-3 (so 0.1 is
+    // 1/10, not the nearest double). A dangling exponent ("2e") is ignored
+    // like std::stod does; exponents beyond +-400 give REAL. Throws
+    // std::runtime_error when text does not start with a digit or '.'.
+    static Number parse(std::string_view text);
+
+    Kind kind() const { return tag; }
+    bool isExact() const { return tag != Kind::REAL; }
+    bool isSmall() const { return tag != Kind::BIG; }
+    // Integer valued, including integral REALs
+    bool isInteger() const;
+    bool isZero() const { return (tag == Kind::INTEGER && small == 0) || (tag == Kind::REAL && real == 0.0); }
+    bool isOne() const { return (tag == Kind::INTEGER && small == 1) || (tag == Kind::REAL && real == 1.0); }
+    int sign() const;
+    // A REAL that is not a number, e.g. from (-8)^(1/3)
+    bool isNaN() const { return tag == Kind::REAL && real != real; }
+
+    // Value as a double, within an ulp of the exact value
+    double toDouble() const;
+
+    // INTEGER and BIG integers as digits, rationals as n/d, REAL via the
+    // default ostream format (6 significant digits)
+    std::string toString() const;
+
+    Number operator+(const Number& other) const {
+        int64_t out;
+        if (tag == Kind::INTEGER && other.tag == Kind::INTEGER && !addOverflows(small, other.small, out)) {
+            return Number(static_cast<long long>(out));
+        }
+        return addSlow(*this, other);
+    }
+    Number operator-(const Number& other) const {
+        int64_t out;
+        if (tag == Kind::INTEGER && other.tag == Kind::INTEGER && !subOverflows(small, other.small, out)) {
+            return Number(static_cast<long long>(out));
+        }
+        return addSlow(*this, -other);
+    }
+    Number operator*(const Number& other) const {
+        int64_t out;
+        if (tag == Kind::INTEGER && other.tag == Kind::INTEGER && !mulOverflows(small, other.small, out)) {
+            return Number(static_cast<long long>(out));
+        }
+        return mulSlow(*this, other);
+    }
+    // Throws std::runtime_error("Division by zero") for a zero divisor
+    Number operator/(const Number& other) const;
+    Number operator-() const;
+
+    Number& operator+=(const Number& other) { return *this = *this + other; }
+    Number& operator-=(const Number& other) { return *this = *this - other; }
+    Number& operator*=(const Number& other) { return *this = *this * other; }
+
+    Number abs() const { return sign() < 0 ? -*this : *this; }
+    Number reciprocal() const { return Number(1) / *this; }
+
+    // Exact for exact bases with integer exponents (within a size bound),
+    // and for rational exponents p/q when the base is a perfect q-th power;
+    // REAL std::pow otherwise. Throws std::runtime_error("Division by zero")
+    // for zero to a negative power.
+    Number pow(const Number& exponent) const;
+
+    // -1, 0 or 1 by value; REAL operands compare as doubles. A total order
+    // for sorting: NaN comes after every number and equals only NaN.
+    static int compare(const Number& a, const Number& b);
+    // By value like double: false whenever NaN is involved (and != true)
+    bool operator==(const Number& other) const { return ordered(other) && compare(*this, other) == 0; }
+    bool operator!=(const Number& other) const { return !(*this == other); }
+    bool operator<(const Number& other) const { return ordered(other) && compare(*this, other) < 0; }
+    bool operator>(const Number& other) const { return ordered(other) && compare(*this, other) > 0; }
+    bool operator<=(const Number& other) const { return ordered(other) && compare(*this, other) <= 0; }
+    bool operator>=(const Number& other) const { return ordered(other) && compare(*this, other) >= 0; }
+
+    // Same kind and value (REAL by bit pattern), for hash-consing: 1/2 and
+    // the double 0.5 are equal numbers but not identical ones
+    bool identical(const Number& other) const;
+    size_t hash() const;
+
+    // Heap bytes held by a BIG value, 0 for the inline kinds
+    size_t heapBytes() const;
+};
+
+#endif // NUMBER_H
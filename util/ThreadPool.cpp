@@ -0,0 +1,167 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+uint64_t packRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(end) << 32) | begin;
+}
+
+uint32_t rangeBegin(uint64_t bounds) { return static_cast<uint32_t>(bounds); }
+uint32_t rangeEnd(uint64_t bounds) { return static_cast<uint32_t>(bounds >> 32); }
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads)
+    : job(nullptr), jobCount(0), jobGrain(1), busy(0), generation(0), stopping(false) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ranges = std::make_unique<ChunkRange[]>(threads);
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        // A worker that wakes after the caller finished sees no job
+        if (!job) {
+            continue;
+        }
+
+        const Body* body = job;
+        size_t count = jobCount;
+        size_t grain = jobGrain;
+        ++busy;
+        lock.unlock();
+        runChunks(*body, count, grain, self);
+        lock.lock();
+        if (--busy == 0) {
+            done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::claimFront(size_t participant, uint32_t& chunk) {
+    std::atomic<uint64_t>& bounds = ranges[participant].bounds;
+    uint64_t current = bounds.load(std::memory_order_relaxed);
+    while (rangeBegin(current) < rangeEnd(current)) {
+        uint64_t next = packRange(rangeBegin(current) + 1, rangeEnd(current));
+        if (bounds.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+            chunk = rangeBegin(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::claimBack(size_t participant, uint32_t& chunk) {
+    std::atomic<uint64_t>& bounds = ranges[participant].bounds;
+    uint64_t current = bounds.load(std::memory_order_relaxed);
+    while (rangeBegin(current) < rangeEnd(current)) {
+        uint64_t next = packRange(rangeBegin(current), rangeEnd(current) - 1);
+        if (bounds.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+            chunk = rangeEnd(current) - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runChunks(const Body& body, size_t count, size_t grain, size_t self) {
+    const size_t participants = size();
+    while (true) {
+        uint32_t chunk;
+        bool found = claimFront(self, chunk);
+        for (size_t offset = 1; !found && offset < participants; ++offset) {
+            found = claimBack((self + offset) % participants, chunk);
+        }
+        if (!found) {
+            return;
+        }
+
+        size_t begin = static_cast<size_t>(chunk) * grain;
+        try {
+            body(begin, std::min(begin + grain, count));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const Body& body) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    if (workers.empty() || count <= grain) {
+        body(0, count);
+        return;
+    }
+
+    // Chunk indices must fit the packed ranges
+    const size_t maxChunks = std::numeric_limits<uint32_t>::max();
+    if ((count + grain - 1) / grain > maxChunks) {
+        grain = (count + maxChunks - 1) / maxChunks;
+    }
+    const size_t chunks = (count + grain - 1) / grain;
+    const size_t participants = size();
+
+    std::lock_guard<std::mutex> call(callMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t p = 0; p < participants; ++p) {
+            uint32_t begin = static_cast<uint32_t>(chunks * p / participants);
+            uint32_t end = static_cast<uint32_t>(chunks * (p + 1) / participants);
+            ranges[p].bounds.store(packRange(begin, end), std::memory_order_relaxed);
+        }
+        job = &body;
+        jobCount = count;
+        jobGrain = grain;
+        error = nullptr;
+        ++generation;
+    }
+    wake.notify_all();
+
+    runChunks(body, count, grain, 0);
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return busy == 0; });
+        job = nullptr;
+        failure = error;
+        error = nullptr;
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
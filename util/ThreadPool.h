@@ -0,0 +1,71 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool - fixed set of worker threads for data-parallel loops.
+//
+// parallelFor splits [0, count) into chunks of grain indices and deals each
+// participant (the workers plus the calling thread) a contiguous block of
+// chunks. A participant takes chunks from the front of its own block, which
+// keeps neighbouring indices on one thread, and once its block is empty it
+// steals single chunks from the back of the others. The call returns once
+// every chunk is done; the first exception thrown by the body is rethrown in
+// the caller. Calls from different threads are serialized; calling
+// parallelFor from inside a body is not supported.
+class ThreadPool {
+private:
+    using Body = std::function<void(size_t begin, size_t end)>;
+
+    // Unclaimed chunks [begin, end) of one participant, packed into one word
+    // (end in the high half) so owner and thieves claim with a single CAS
+    struct alignas(64) ChunkRange {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<ChunkRange[]> ranges;   // index 0 is the calling thread
+    std::mutex mutex;
+    std::mutex callMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Current job; job is null between calls
+    const Body* job;
+    size_t jobCount;
+    size_t jobGrain;
+    std::exception_ptr error;
+    size_t busy;
+    uint64_t generation;
+    bool stopping;
+
+    void workerLoop(size_t self);
+    void runChunks(const Body& body, size_t count, size_t grain, size_t self);
+    bool claimFront(size_t participant, uint32_t& chunk);
+    bool claimBack(size_t participant, uint32_t& chunk);
+
+public:
+    // threads counts the calling thread; 0 uses one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    void parallelFor(size_t count, size_t grain, const Body& body);
+
+    // Process-wide pool sized to the hardware
+    static ThreadPool& shared();
+};
+
+#endif // THREAD_POOL_H